@@ -0,0 +1,85 @@
+#!/bin/sh
+# times --check on generated programs of N, 2N, 4N and 8N declarations
+# and uses, in shapes that would show a lookup that is not O(1): flat
+# globals, procedures whose locals shadow globals, uses a thousand scopes
+# deep, a chain of record types and a record of many fields. Prints the
+# checking time at each size and how much longer 8N took than N: 8x for
+# a linear pass, somewhat more once the tables outgrow the caches, 64x for
+# a quadratic one. The run fails past 24x.
+#
+#   bench/check_bench.sh build/bin/main_o2 [N]
+MAIN=${1:-build/bin/main_o2}
+N=${2:-20000}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+gen() {
+    shape=$1
+    n=$2
+    awk -v n="$n" -v shape="$shape" 'BEGIN {
+        print "PROGRAM IS"
+        if (shape == "globals") {
+            for (i = 0; i < n; i++) print "VAR X" i " : INTEGER := " i ";"
+            print "BEGIN"
+            for (i = 1; i < n; i++) print "X" i " := X" i - 1 " + X" i ";"
+        } else if (shape == "shadowing") {
+            print "VAR X, Y : INTEGER := 0;"
+            for (i = 0; i < n; i++)
+                print "PROCEDURE P" i "(X : INTEGER) : REAL IS VAR Y : REAL := X; " \
+                      "BEGIN RETURN Y + X + P" (i + 1) % n "(X); END;"
+            print "BEGIN"
+            for (i = 0; i < n; i++) print "Y := P" i "(X) + X;"
+        } else if (shape == "nested") {
+            print "VAR G : INTEGER := 0;"
+            for (i = 0; i < 1000; i++) print "PROCEDURE P" i "() IS VAR L" i " : INTEGER := G;"
+            print "BEGIN"
+            for (i = 0; i < n; i++) print "L" i % 1000 " := G + L" (i * 7) % 1000 ";"
+            for (i = 0; i < 1000; i++) print "END; BEGIN"
+        } else if (shape == "types") {
+            for (i = 0; i < n; i++) print "TYPE T" i " IS RECORD V : INTEGER; NEXT : T" (i + 1) % n "; END;"
+            for (i = 0; i < n; i++) print "VAR X" i " : T" i " := T" i " { V := " i "; NEXT := NIL };"
+            print "BEGIN"
+            for (i = 0; i < n; i++) print "X" i ".NEXT := X" (i + 1) % n ";"
+        } else {
+            printf "TYPE R IS RECORD"
+            for (i = 0; i < n; i++) printf " F%d : INTEGER;", i
+            print " END; VAR X : R := NIL;"
+            print "BEGIN"
+            for (i = 0; i < n; i++) print "X.F" i " := X.F" (i * 13) % n " + 1;"
+        }
+        print "END;"
+    }' > "$DIR/$shape.pcat"
+}
+
+status=0
+for shape in globals shadowing nested types fields; do
+    printf "%-10s" "$shape"
+    first=""
+    for n in $N $((N * 2)) $((N * 4)) $((N * 8)); do
+        gen $shape $n
+        # best of three, in microseconds
+        best=""
+        for run in 1 2 3; do
+            us=$("$MAIN" --check-stats "$DIR/$shape.pcat" 2>&1 >/dev/null |
+                 awk '/ s \(/ { for (i = 1; i < NF; i++) if ($(i + 1) == "s") printf "%d", $i * 1e6 }')
+            if [ -z "$us" ]; then
+                echo " $n: check failed"
+                status=1
+                break 3
+            fi
+            if [ -z "$best" ] || [ "$us" -lt "$best" ]; then
+                best=$us
+            fi
+        done
+        printf "  %6d: %7d us" "$n" "$best"
+        [ -n "$first" ] || first=$best
+    done
+    growth=$(awk -v a="$best" -v b="$first" 'BEGIN { printf "%.1f", a / (b > 0 ? b : 1) }')
+    printf "  8x the input: %sx the time" "$growth"
+    if awk -v g="$growth" 'BEGIN { exit !(g > 24) }'; then
+        printf ", superlinear!"
+        status=1
+    fi
+    echo
+done
+exit $status
@@ -0,0 +1,47 @@
+#!/bin/sh
+# times the tree dump on the tests/ corpus scaled up: every test program
+# that parses gets SCALE procedures holding a copy of its main statements.
+# Pass a second binary to compare against.
+#
+#   bench/dump_bench.sh build/bin/main [old/main] [SCALE]
+MAIN=${1:-build/bin/main}
+BASE=$2
+SCALE=${3:-1000}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+for f in tests/*.pcat; do
+    "$MAIN" "$f" > /dev/null 2>&1 || continue
+    awk -v n="$SCALE" '
+        /^PROGRAM/ { part = 1; next }
+        part == 1 && /^BEGIN/ { part = 2; next }
+        part == 2 && /^END;/ { body_end = nb }
+        part == 1 { decls[nd++] = $0 }
+        part == 2 { body[nb++] = $0 }
+        END {
+            print "PROGRAM IS"
+            for (i = 0; i < nd; i++) print decls[i]
+            for (r = 0; r < n; r++) {
+                print "PROCEDURE COPY" r "() IS BEGIN"
+                for (i = 0; i < body_end; i++) print body[i]
+                print "END;"
+            }
+            print "BEGIN"
+            for (i = 0; i < body_end; i++) print body[i]
+            print "END;"
+        }' "$f" > "$DIR/$(basename "$f")"
+done
+
+run() {
+    start=$(date +%s.%N)
+    for f in "$DIR"/*.pcat; do
+        "$1" "$f" > /dev/null
+    done
+    end=$(date +%s.%N)
+    awk "BEGIN { print $end - $start }"
+}
+
+echo "corpus: $(cat "$DIR"/*.pcat | wc -c) bytes in $(ls "$DIR" | wc -l) files"
+echo "$MAIN: $(run "$MAIN") s"
+[ -n "$BASE" ] && echo "$BASE: $(run "$BASE") s"
+exit 0
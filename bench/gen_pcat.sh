@@ -0,0 +1,133 @@
+#!/bin/sh
+# writes a valid PCAT program of a given shape to stdout, N scaling its
+# size; the same N and SEED always give the same program:
+#   expr      N statements, each assigning an expression nested 64 deep
+#   block     one body of N statements of every kind, loops and ifs nested
+#   procs     N procedures with parameters and locals, calling each other
+#   literals  N array and record values, [< n OF v >] and { F := v } with
+#             up to a hundred entries each
+#   mixed     a quarter of each
+#
+#   bench/gen_pcat.sh expr|block|procs|literals|mixed N [SEED]
+SHAPE=${1:-mixed}
+N=${2:-1000}
+SEED=${3:-1}
+
+awk -v shape="$SHAPE" -v n="$N" -v seed="$SEED" '
+function pick(k) {
+    return int(rand() * k)
+}
+
+function var() {
+    return "V" pick(8)
+}
+
+# an integer expression d levels deep
+function expr(d,    r) {
+    if (d <= 0)
+        return pick(2) ? var() : pick(1000)
+    r = pick(6)
+    if (r == 0)
+        return "(" expr(d - 1) " + " expr(0) ")"
+    if (r == 1)
+        return "(" expr(0) " * " expr(d - 1) ")"
+    if (r == 2)
+        return "(" expr(d - 1) " - " var() ")"
+    if (r == 3)
+        return "-" "(" expr(d - 1) ")"
+    if (r == 4)
+        return "(" expr(d - 1) " DIV (" var() " * " var() " + 1))"
+    return "(" expr(d - 1) " MOD 97)"
+}
+
+function cond() {
+    return expr(1) " " (pick(2) ? "<" : ">=") " " expr(1)
+}
+
+# a statement at nesting depth d, indented by ind
+function stat(d, ind,    r, s) {
+    r = pick(d < 3 ? 8 : 5)
+    if (r == 0)
+        return ind "WRITE(\"v = \", " var() ", " expr(1) ");"
+    if (r <= 3)
+        return ind var() " := " expr(2) ";"
+    if (r == 4)
+        return ind "A[" var() " MOD 10] := " expr(1) ";"
+    if (r == 5) {
+        s = ind "IF " cond() " THEN\n" stat(d + 1, ind "    ") "\n"
+        if (pick(2))
+            s = s ind "ELSIF " cond() " THEN\n" stat(d + 1, ind "    ") "\n"
+        return s ind "ELSE\n" stat(d + 1, ind "    ") "\n" ind "END;"
+    }
+    if (r == 6)
+        return ind "FOR I" d " := 1 TO " 1 + pick(10) " DO\n" stat(d + 1, ind "    ") "\n" \
+               stat(d + 1, ind "    ") "\n" ind "END;"
+    return ind "WHILE " cond() " DO\n" stat(d + 1, ind "    ") "\n" \
+           ind "    " var() " := " var() " + 1;\n" ind "END;"
+}
+
+function globals() {
+    print "    TYPE ROW IS ARRAY OF INTEGER;"
+    print "    TYPE GRID IS ARRAY OF ROW;"
+    printf "    TYPE REC IS RECORD"
+    for (i = 0; i < 100; i++)
+        printf " F%d : INTEGER;", i
+    print " END;"
+    print "    VAR V0, V1, V2, V3, V4, V5, V6, V7 : INTEGER := 1;"
+    print "    VAR I0, I1, I2, I3 : INTEGER := 0;"
+    print "    VAR A : ROW := ROW [< 10 OF 0 >];"
+    print "    VAR G : GRID := GRID [< 10 OF ROW [< 10 OF 0 >] >];"
+    print "    VAR R : REC := NIL;"
+}
+
+function procs(k,    i, j, m) {
+    for (i = 0; i < k; i++) {
+        print "    PROCEDURE P" i "(X, Y : INTEGER) : INTEGER IS"
+        print "        VAR L" i ", M : INTEGER := X + Y;"
+        print "    BEGIN"
+        m = 3 + pick(6)
+        for (j = 0; j < m; j++)
+            print "        M := " (pick(3) ? "M + X * " pick(100) : "L" i " - Y") ";"
+        if (i > 0)
+            print "        M := M + P" pick(i) "(M, X);"
+        print "        RETURN M;"
+        print "    END;"
+    }
+}
+
+function literal(    k, i, s) {
+    k = 1 + pick(100)
+    if (pick(2)) {
+        s = "A := ROW [< "
+        for (i = 0; i < k; i++)
+            s = s (i ? ", " : "") (pick(3) ? pick(50) " OF " expr(0) : expr(1))
+        return "    " s " >];"
+    }
+    s = "R := REC { "
+    for (i = 0; i < k; i++)
+        s = s (i ? "; " : "") "F" i " := " expr(1)
+    return "    " s " };"
+}
+
+BEGIN {
+    srand(seed)
+    q = shape == "mixed" ? int(n / 4) : n
+    print "PROGRAM IS"
+    globals()
+    if (shape == "procs" || shape == "mixed")
+        procs(q)
+    print "BEGIN"
+    if (shape == "expr" || shape == "mixed")
+        for (i = 0; i < q; i++)
+            print "    " var() " := " expr(64) ";"
+    if (shape == "block" || shape == "mixed")
+        for (i = 0; i < q; i++)
+            print stat(0, "    ")
+    if (shape == "literals" || shape == "mixed")
+        for (i = 0; i < q; i++)
+            print literal()
+    if (shape == "procs" || shape == "mixed")
+        for (i = 0; i < q; i++)
+            print "    V" i % 8 " := P" i "(V1, " i ");"
+    print "END;"
+}'
@@ -0,0 +1,22 @@
+#!/bin/sh
+# runs the programs in bench/interp and reports how many statements per
+# second each executes. Pass a second binary to compare against.
+#
+#   bench/interp_bench.sh build/bin/main [old/main]
+MAIN=${1:-build/bin/main}
+BASE=$2
+
+run() {
+    for f in bench/interp/*.pcat; do
+        stats=$("$1" --exec-stats "$f" 2>&1 >/dev/null | tail -n 1)
+        printf "  %-12s %s\n" "$(basename "$f" .pcat)" "$stats"
+    done
+}
+
+echo "$MAIN:"
+run "$MAIN"
+if [ -n "$BASE" ]; then
+    echo "$BASE:"
+    run "$BASE"
+fi
+exit 0
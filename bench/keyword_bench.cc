@@ -0,0 +1,124 @@
+// microbenchmark for keyword/delimiter classification in the lexer:
+// the old linear scan over bison's token name table against the perfect
+// hash in keywords.h, on the tokens of the given PCAT files
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#define YYSTYPE void*
+#include "keywords.h"
+
+using namespace std;
+
+// the terminals in the order bison numbers them, as yytname spells them
+static const char* const old_tname[] = {
+    "$end", "error", "$undefined", "TYPES", "INTEGER", "REAL", "OPERATOR",
+    "STRING", "IDENTIFIER", "\"AND\"", "\"ELSIF\"", "\"LOOP\"",
+    "\"PROGRAM\"", "\"VAR\"", "\"ARRAY\"", "\"END\"", "\"MOD\"", "\"READ\"",
+    "\"WHILE\"", "\"BEGIN\"", "\"EXIT\"", "\"NOT\"", "\"RECORD\"",
+    "\"WRITE\"", "\"BY\"", "\"FOR\"", "\"OF\"", "\"RETURN\"", "\"DIV\"",
+    "\"IF\"", "\"OR\"", "\"THEN\"", "\"DO\"", "\"IN\"", "\"OUT\"", "\"TO\"",
+    "\"ELSE\"", "\"IS\"", "\"PROCEDURE\"", "\"TYPE\"", "\":=\"", "\":\"",
+    "\";\"", "\",\"", "\".\"", "\"(\"", "\")\"", "\"[\"", "\"]\"", "\"{\"",
+    "\"}\"", "\"[<\"", "\">]\"", "\"\\\\\""
+};
+static const int old_ntokens = sizeof(old_tname) / sizeof(old_tname[0]);
+
+// what the lexer used to call for every keyword and delimiter
+static int old_find_token_code(const char* token_buffer) {
+    int i;
+    for (i = 0; i < old_ntokens; i++) {
+        if (old_tname[i] != 0
+            && old_tname[i][0] == '"'
+            && ! strncmp (old_tname[i] + 1, token_buffer,
+                          strlen (token_buffer))
+            && old_tname[i][strlen (token_buffer) + 1] == '"'
+            && old_tname[i][strlen (token_buffer) + 2] == 0)
+          break;
+    }
+    return 255 + i;
+}
+
+struct Tok {
+    string text;
+    bool word;
+};
+
+static void split(const string& src, vector<Tok>& out) {
+    size_t i = 0;
+    while (i < src.size()) {
+        char c = src[i];
+        if (isalpha((unsigned char)c)) {
+            size_t j = i;
+            while (j < src.size() && isalnum((unsigned char)src[j]))
+                ++j;
+            Tok t = { src.substr(i, j - i), true };
+            out.push_back(t);
+            i = j;
+        } else if (strchr(":;,.()[]{}", c)) {
+            size_t n = 1;
+            if ((c == ':' && src[i+1] == '=') || (c == '[' && src[i+1] == '<'))
+                n = 2;
+            Tok t = { src.substr(i, n), false };
+            out.push_back(t);
+            i += n;
+        } else {
+            ++i;
+        }
+    }
+}
+
+static double seconds_since(chrono::steady_clock::time_point t) {
+    return chrono::duration<double>(chrono::steady_clock::now() - t).count();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cout << "usage: keyword_bench file.pcat..." << endl;
+        return -1;
+    }
+    vector<Tok> toks;
+    for (int i = 1; i < argc; ++i) {
+        ifstream in(argv[i]);
+        stringstream ss;
+        ss << in.rdbuf();
+        split(ss.str(), toks);
+    }
+    if (toks.empty()) {
+        cout << "no tokens" << endl;
+        return -1;
+    }
+
+    const int rounds = 2000;
+    long sink = 0;
+
+    // before: keywords and delimiters went through the linear scan,
+    // identifiers were told apart by the DFA
+    chrono::steady_clock::time_point t = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < toks.size(); ++i)
+            if (!toks[i].word || keyword_code(toks[i].text.data(), toks[i].text.size()))
+                sink += old_find_token_code(toks[i].text.c_str());
+    double before = seconds_since(t);
+
+    // after: delimiters come straight from their own rule, every
+    // identifier-shaped token takes one probe
+    t = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < toks.size(); ++i)
+            if (toks[i].word)
+                sink += keyword_code(toks[i].text.data(), toks[i].text.size());
+    double after = seconds_since(t);
+
+    double n = (double)toks.size() * rounds;
+    printf("tokens: %zu x %d rounds\n", toks.size(), rounds);
+    printf("linear scan:  %12.0f tokens/sec\n", n / before);
+    printf("perfect hash: %12.0f tokens/sec\n", n / after);
+    printf("(checksum %ld)\n", sink);
+    return 0;
+}
@@ -0,0 +1,168 @@
+#!/bin/sh
+# runs kernels on large arrays and many records, by walking the tree and
+# on the bytecode VM, and reports the execution time of each and the bytes
+# of records and arrays it made: arrays filled with [< n OF v >], passes
+# over arrays of integers, reals and booleans in and out of order, rows of
+# a grid read down its columns, and fields of records reached through an
+# array. Pass a second binary to compare against.
+#
+#   bench/layout_bench.sh build/bin/main [old/main]
+MAIN=${1:-build/bin/main}
+BASE=$2
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+cat > "$DIR/fill.pcat" <<'END'
+PROGRAM IS
+    TYPE INTS IS ARRAY OF INTEGER;
+    TYPE REALS IS ARRAY OF REAL;
+    TYPE FLAGS IS ARRAY OF BOOLEAN;
+    VAR N : INTEGER := 1000000;
+    VAR ROUND : INTEGER := 0;
+    VAR A : INTS := NIL;
+    VAR X : REALS := NIL;
+    VAR F : FLAGS := NIL;
+BEGIN
+    FOR ROUND := 1 TO 10 DO
+        A := INTS [< N OF ROUND >];
+        X := REALS [< N OF 0.5 >];
+        F := FLAGS [< N OF TRUE >];
+    END;
+    WRITE (A[N - 1], " ", X[N - 1], " ", F[N - 1]);
+END;
+END
+
+cat > "$DIR/ints.pcat" <<'END'
+PROGRAM IS
+    TYPE INTS IS ARRAY OF INTEGER;
+    VAR N : INTEGER := 1000000;
+    VAR A : INTS := INTS [< 1000000 OF 0 >];
+    VAR I, J, ROUND, SUM : INTEGER := 0;
+BEGIN
+    FOR ROUND := 1 TO 3 DO
+        FOR I := 0 TO N - 1 DO
+            J := (I * 7919) MOD N;
+            A[J] := A[J] + I MOD 13;
+        END;
+    END;
+    FOR I := 0 TO N - 1 DO SUM := SUM + A[I]; END;
+    WRITE ("SUM: ", SUM);
+END;
+END
+
+cat > "$DIR/reals.pcat" <<'END'
+PROGRAM IS
+    TYPE REALS IS ARRAY OF REAL;
+    VAR N : INTEGER := 1000000;
+    VAR X : REALS := REALS [< 1000000 OF 1.0 >];
+    VAR Y : REALS := REALS [< 1000000 OF 0.25 >];
+    VAR I, ROUND : INTEGER := 0;
+    VAR SUM : REAL := 0.0;
+BEGIN
+    FOR ROUND := 1 TO 3 DO
+        FOR I := 0 TO N - 1 DO X[I] := X[I] * 0.5 + Y[I]; END;
+    END;
+    FOR I := 0 TO N - 1 DO SUM := SUM + X[I]; END;
+    WRITE ("SUM: ", SUM);
+END;
+END
+
+cat > "$DIR/flags.pcat" <<'END'
+PROGRAM IS
+    TYPE FLAGS IS ARRAY OF BOOLEAN;
+    VAR N : INTEGER := 2000000;
+    VAR PRIME : FLAGS := FLAGS [< 2000000 OF TRUE >];
+    VAR COUNT, I, J : INTEGER := 0;
+BEGIN
+    FOR I := 2 TO N - 1 DO
+        IF PRIME[I] THEN
+            COUNT := COUNT + 1;
+            J := I * 2;
+            WHILE J < N DO
+                PRIME[J] := FALSE;
+                J := J + I;
+            END;
+        END;
+    END;
+    WRITE ("PRIMES BELOW ", N, ": ", COUNT);
+END;
+END
+
+cat > "$DIR/grid.pcat" <<'END'
+PROGRAM IS
+    TYPE ROW IS ARRAY OF REAL;
+    TYPE GRID IS ARRAY OF ROW;
+    VAR N : INTEGER := 700;
+    VAR G : GRID := GRID [< 700 OF NIL >];
+    VAR I, J, ROUND : INTEGER := 0;
+    VAR SUM : REAL := 0.0;
+BEGIN
+    FOR I := 0 TO N - 1 DO G[I] := ROW [< N OF 0.5 >]; END;
+    FOR ROUND := 1 TO 2 DO
+        FOR J := 0 TO N - 1 DO
+            FOR I := 0 TO N - 1 DO SUM := SUM + G[I][J]; END;
+        END;
+    END;
+    WRITE ("SUM: ", SUM);
+END;
+END
+
+cat > "$DIR/records.pcat" <<'END'
+PROGRAM IS
+    TYPE POINT IS RECORD
+        X : REAL; Y : REAL; ID : INTEGER; LIVE : BOOLEAN; NEXT : POINT;
+    END;
+    TYPE POINTS IS ARRAY OF POINT;
+    VAR N : INTEGER := 200000;
+    VAR P : POINTS := POINTS [< 200000 OF NIL >];
+    VAR Q : POINT := NIL;
+    VAR I, ROUND, LIVE : INTEGER := 0;
+    VAR SUM : REAL := 0.0;
+BEGIN
+    FOR I := 0 TO N - 1 DO
+        P[I] := POINT { X := I; Y := 0.5; ID := I; LIVE := I MOD 3 <> 0; NEXT := Q };
+        Q := P[I];
+    END;
+    FOR ROUND := 1 TO 5 DO
+        FOR I := 0 TO N - 1 DO
+            Q := P[(I * 7919) MOD N];
+            IF Q.LIVE THEN
+                SUM := SUM + Q.X * Q.Y;
+                LIVE := LIVE + 1;
+            END;
+        END;
+    END;
+    WRITE ("LIVE: ", LIVE, " SUM: ", SUM);
+END;
+END
+
+# seconds and bytes from --exec-stats
+stats() {
+    "$@" 2>&1 >/dev/null </dev/null |
+        awk '/ in .* s \(/ { print $4, (/bytes/ ? $(NF - 5) : "-") }'
+}
+
+status=0
+run() {
+    printf "%-10s %10s %10s %12s\n" program tree vm bytes
+    for f in fill ints reals flags grid records; do
+        "$1" --run "$DIR/$f.pcat" > "$DIR/tree.out" 2>&1 </dev/null
+        "$1" --vm "$DIR/$f.pcat" > "$DIR/vm.out" 2>&1 </dev/null
+        if ! cmp -s "$DIR/tree.out" "$DIR/vm.out"; then
+            echo "$f: the VM prints something else"
+            status=1
+            continue
+        fi
+        tree=$(stats "$1" --run --exec-stats "$DIR/$f.pcat")
+        vm=$(stats "$1" --vm --exec-stats "$DIR/$f.pcat")
+        echo "$f $tree $vm" | awk '{ printf "%-10s %10.6f %10.6f %12s\n", $1, $2, $4, $5 }'
+    done
+}
+
+echo "$MAIN:"
+run "$MAIN"
+if [ -n "$BASE" ]; then
+    echo "$BASE:"
+    run "$BASE"
+fi
+exit $status
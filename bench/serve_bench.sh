@@ -0,0 +1,68 @@
+#!/bin/sh
+# times --serve on a generated program of about LINES lines: opening it,
+# then, R times over, typing a statement into its body and taking it out
+# again, breaking a statement inside a procedure and asking for the
+# diagnostics and the outline, and fixing it. Prints the median time of
+# each command as --serve reports it and fails if an edit or diagnostics
+# took more than LIMIT ms in the median.
+#
+#   bench/serve_bench.sh build/bin/main_o2 [LINES [R]]
+#   LIMIT=10 bench/serve_bench.sh ...
+MAIN=${1:-build/bin/main_o2}
+LINES=${2:-100000}
+R=${3:-20}
+LIMIT=${LIMIT:-10}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+# bench/gen_pcat.sh mixed writes about 4.6 lines per N
+sh bench/gen_pcat.sh mixed $((LINES * 10 / 46)) > "$DIR/big.pcat"
+lines=$(wc -l < "$DIR/big.pcat")
+body=$(grep -n "^BEGIN$" "$DIR/big.pcat" | cut -d: -f1)
+# a statement in the middle of the body and one in a procedure in the
+# middle of the declarations
+stat=$(((body + lines) / 2))
+proc=$(awk -v from=$((body / 2)) 'NR > from && /^        M := / { print NR; exit }' "$DIR/big.pcat")
+
+{
+    echo "open $DIR/big.pcat"
+    i=0
+    while [ $i -lt "$R" ]; do
+        printf "edit %d 5 %d 5 8\nX := 1; \n" $stat $stat
+        echo "diagnostics"
+        echo "edit $stat 5 $stat 13 0"
+        printf "edit %d 9 %d 9 2\n:=\n" $proc $proc
+        echo "diagnostics"
+        echo "outline"
+        echo "edit $proc 9 $proc 11 0"
+        i=$((i + 1))
+    done
+} > "$DIR/session"
+# the command of every answer, in order; what edits insert is not one
+sed -n 's/^\([a-z]\{1,\}\).*/\1/p' "$DIR/session" > "$DIR/commands"
+
+"$MAIN" --serve < "$DIR/session" > "$DIR/answers" || exit 1
+grep -q "^EEK" "$DIR/answers" || { echo "the broken statement was not found"; exit 1; }
+grep "^ok \|^error " "$DIR/answers" | paste -d' ' "$DIR/commands" - > "$DIR/times"
+if grep -q " error " "$DIR/times"; then
+    grep " error " "$DIR/times" | head -3
+    exit 1
+fi
+
+echo "$lines lines, $(wc -c < "$DIR/big.pcat") bytes, $(sed -n 's/^open ok \([0-9]*\) units.*/\1/p' "$DIR/times") units"
+printf "%-12s %8s %10s\n" command times "median ms"
+status=0
+for command in open edit diagnostics outline; do
+    grep "^$command " "$DIR/times" | awk '{ print $(NF - 1) }' | sort -n > "$DIR/ms"
+    n=$(wc -l < "$DIR/ms")
+    median=$(sed -n "$(((n + 1) / 2))p" "$DIR/ms")
+    printf "%-12s %8d %10.3f" $command $n $median
+    if [ $command = edit ] || [ $command = diagnostics ]; then
+        if awk -v m="$median" -v limit="$LIMIT" 'BEGIN { exit !(m > limit) }'; then
+            printf "  over %s ms" "$LIMIT"
+            status=1
+        fi
+    fi
+    echo
+done
+exit $status
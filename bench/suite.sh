@@ -0,0 +1,108 @@
+#!/bin/sh
+# the parsing benchmark: generates one program of each bench/gen_pcat.sh
+# shape, about 5-10 MB each at SCALE 1, prints each with --stats-json
+# three times and reports the best of the three: tokens/s (over the
+# scanner's time), nodes/s (over scanning and parsing), the wall time of
+# the whole run and peak RSS. With a baseline file, marks every number more than TOLERANCE
+# percent worse than the one stored there and fails; "save" writes the
+# numbers of this run to it instead.
+#
+#   bench/suite.sh build/bin/main_o2 [bench/baseline.txt [save]]
+#   SCALE=0.1 TOLERANCE=20 bench/suite.sh ...
+MAIN=${1:-build/bin/main_o2}
+BASELINE=$2
+SAVE=$3
+SCALE=${SCALE:-1}
+TOLERANCE=${TOLERANCE:-20}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+# a number field of the JSON
+field() {
+    sed -n "s/.*\"$1\": \([0-9.]*\).*/\1/p" "$DIR/stats.json" | head -1
+}
+
+# shape and N at SCALE 1
+WORKLOADS="expr 20000
+block 50000
+procs 20000
+literals 10000
+mixed 20000"
+
+status=0
+printf "%-10s %8s %12s %12s %9s %9s\n" shape MB tokens/s nodes/s wall/s "peak MB"
+echo "$WORKLOADS" | while read shape n; do
+    n=$(awk -v n="$n" -v s="$SCALE" 'BEGIN { n = int(n * s); print n < 1 ? 1 : n }')
+    sh bench/gen_pcat.sh "$shape" "$n" > "$DIR/$shape.pcat"
+    for run in 1 2 3; do
+        start=$(date +%s.%N)
+        if ! "$MAIN" --stats-json "$DIR/stats.json" "$DIR/$shape.pcat" > /dev/null; then
+            echo "$shape: $MAIN failed"
+            exit 1
+        fi
+        end=$(date +%s.%N)
+        awk -v start="$start" -v end="$end" -v bytes="$(field input_bytes)" \
+            -v tokens="$(field tokens)" -v nodes="$(field nodes)" -v lex="$(field lex)" \
+            -v parse="$(field parse)" -v rss="$(field peak_rss)" 'BEGIN {
+            printf "%.0f %.0f %.6f %.1f %.1f\n", (lex > 0 ? tokens / lex : 0),
+                   (lex + parse > 0 ? nodes / (lex + parse) : 0), end - start, rss / 1e6,
+                   bytes / 1e6
+        }'
+    done > "$DIR/runs" || exit 1
+    # the best of the three runs for each number on its own
+    awk -v shape="$shape" '
+        NR == 1 || $1 > tps { tps = $1 }
+        NR == 1 || $2 > nps { nps = $2 }
+        NR == 1 || $3 < wall { wall = $3 }
+        NR == 1 || $4 < peak { peak = $4 }
+        { mb = $5 }
+        END { printf "%s %.0f %.0f %.3f %.1f %.1f\n", shape, tps, nps, wall, peak, mb }
+    ' "$DIR/runs"
+done > "$DIR/results" || { cat "$DIR/results"; exit 1; }
+
+# results lines: shape tokens/s nodes/s wall peak_MB input_MB
+if [ "$SAVE" = save ] && [ -n "$BASELINE" ]; then
+    {
+        echo "# bench/suite.sh $(basename "$MAIN") SCALE $SCALE on $(uname -m), $(date +%Y-%m-%d)"
+        echo "# shape tokens/s nodes/s wall/s peak_MB input_MB"
+        cat "$DIR/results"
+    } > "$BASELINE"
+fi
+
+# numbers for another size are not comparable
+if [ -n "$BASELINE" ] && [ "$SAVE" != save ] && [ -f "$BASELINE" ] &&
+   ! head -1 "$BASELINE" | grep -q " SCALE $SCALE "; then
+    echo "$BASELINE is not for SCALE $SCALE: $(head -1 "$BASELINE")"
+    BASELINE=""
+fi
+
+while read shape tps nps wall peak mb; do
+    printf "%-10s %8s %12s %12s %9s %9s" "$shape" "$mb" "$tps" "$nps" "$wall" "$peak"
+    if [ -n "$BASELINE" ] && [ "$SAVE" != save ] && [ -f "$BASELINE" ]; then
+        # higher is better for the rates, lower for time and memory
+        worse=$(grep "^$shape " "$BASELINE" | awk -v tps="$tps" -v nps="$nps" -v wall="$wall" \
+                -v peak="$peak" -v tol="$TOLERANCE" '{
+            f = tol / 100
+            if (tps < $2 * (1 - f)) printf " tokens/s %.0f%%", 100 * (tps / $2 - 1)
+            if (nps < $3 * (1 - f)) printf " nodes/s %.0f%%", 100 * (nps / $3 - 1)
+            if (wall > $4 * (1 + f)) printf " wall +%.0f%%", 100 * (wall / $4 - 1)
+            if (peak > $5 * (1 + f)) printf " peak +%.0f%%", 100 * (peak / $5 - 1)
+        }')
+        if [ -n "$worse" ]; then
+            printf "  REGRESSION:%s" "$worse"
+            status=1
+        fi
+    fi
+    echo
+done < "$DIR/results"
+
+if [ -n "$BASELINE" ] && [ "$SAVE" != save ]; then
+    if [ ! -f "$BASELINE" ]; then
+        echo "no baseline in $BASELINE"
+    elif [ $status = 0 ]; then
+        echo "within $TOLERANCE% of $BASELINE"
+    else
+        echo "slower or bigger than $BASELINE by more than $TOLERANCE%"
+    fi
+fi
+exit $status
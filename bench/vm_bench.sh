@@ -0,0 +1,45 @@
+#!/bin/sh
+# runs every program on the bytecode VM and by walking the tree: the
+# tests/ programs, the kernels in bench/interp and a generated kernel of
+# long straight-line arithmetic. Checks both print the same and reports
+# the execution time of each (without parsing) and the speedup.
+#
+#   bench/vm_bench.sh build/bin/main [STATEMENTS]
+MAIN=${1:-build/bin/main}
+N=${2:-2000}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+awk -v n="$N" 'BEGIN {
+    print "PROGRAM IS VAR A, B, C, D, I : INTEGER := 1; VAR X, Y : REAL := 0.5;"
+    print "BEGIN FOR I := 1 TO 200 DO"
+    for (i = 0; i < n; i++) {
+        if (i % 4 == 0) print "A := B + C * " i " - D DIV 3;"
+        if (i % 4 == 1) print "B := (A MOD 1000) + I;"
+        if (i % 4 == 2) print "X := X * 0.5 + Y / 4.0 + A;"
+        if (i % 4 == 3) print "IF A > B THEN C := C + 1; ELSE D := D - 1; END;"
+    }
+    print "END; WRITE (A, \" \", B, \" \", C, \" \", D, \" \", X); END;"
+}' > "$DIR/straight.pcat"
+
+seconds() {
+    "$@" 2>&1 >/dev/null </dev/null | awk '/ in .* s \(/ { print $4 }'
+}
+
+status=0
+printf "%-24s %10s %10s %8s\n" program tree vm speedup
+for f in tests/*.pcat bench/interp/*.pcat "$DIR/straight.pcat"; do
+    "$MAIN" --run "$f" > "$DIR/tree.out" 2>&1 </dev/null || continue
+    "$MAIN" --vm "$f" > "$DIR/vm.out" 2>&1 </dev/null
+    if ! cmp -s "$DIR/tree.out" "$DIR/vm.out"; then
+        echo "$f: the VM prints something else"
+        status=1
+        continue
+    fi
+    tree=$(seconds "$MAIN" --run --exec-stats "$f")
+    vm=$(seconds "$MAIN" --vm --exec-stats "$f")
+    awk -v f="$(basename "$f" .pcat)" -v t="$tree" -v v="$vm" 'BEGIN {
+        printf "%-24s %10.6f %10.6f %7.1fx\n", f, t, v, (v > 0 ? t / v : 0)
+    }'
+done
+exit $status
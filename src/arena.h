@@ -0,0 +1,154 @@
+// bump allocator that owns every syntax tree node of one translation unit
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+class Arena {
+    // every object is preceded by a header so that reset() can run the
+    // destructors (nodes own strings and vectors) before reusing the memory
+    struct Header {
+        Header* prev;
+        void (*dtor)(void*);
+    };
+
+    struct Chunk {
+        Chunk* next;
+        size_t size;
+    };
+
+    static const size_t align = 16;
+    static const size_t default_chunk_size = 64 * 1024;
+
+    Chunk* chunks;     // chunk currently bumped from, then older ones
+    Chunk* spare;      // chunks kept by reset() for reuse
+    char* cur;
+    char* end;
+    Header* last;      // most recently allocated object
+    size_t chunk_size;
+    size_t allocated;  // bytes handed out since the last reset
+
+    static size_t round_up(size_t n) {
+        return (n + align - 1) & ~(align - 1);
+    }
+
+    static size_t chunk_header() {
+        return round_up(sizeof(Chunk));
+    }
+
+    void grow(size_t n) {
+        size_t want = n + chunk_header();
+        // the first spare chunk big enough for the request, taken out of
+        // the spare list; a new one if none is
+        Chunk** link = &spare;
+        while (*link && (*link)->size < want)
+            link = &(*link)->next;
+        Chunk* c = *link;
+        if (c) {
+            *link = c->next;
+        } else {
+            size_t size = want > chunk_size ? want : chunk_size;
+            c = (Chunk*)malloc(size);
+            if (!c)
+                throw std::bad_alloc();
+            c->size = size;
+        }
+        c->next = chunks;
+        chunks = c;
+        cur = (char*)c + chunk_header();
+        end = (char*)c + c->size;
+    }
+
+    static void free_list(Chunk* c) {
+        while (c) {
+            Chunk* next = c->next;
+            free(c);
+            c = next;
+        }
+    }
+
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+public:
+    Arena(size_t _chunk_size = default_chunk_size)
+        : chunks(NULL), spare(NULL), cur(NULL), end(NULL), last(NULL),
+          chunk_size(_chunk_size), allocated(0)
+    {}
+
+    ~Arena() {
+        reset();
+        free_list(spare);
+    }
+
+    // raw storage, never destroyed individually
+    void* alloc(size_t n) {
+        n = round_up(n ? n : 1);
+        if ((size_t)(end - cur) < n)
+            grow(n);
+        void* p = cur;
+        cur += n;
+        allocated += n;
+        return p;
+    }
+
+    // storage for an object whose destructor reset() has to run
+    void* alloc_object(size_t n, void (*dtor)(void*)) {
+        Header* h = (Header*)alloc(round_up(sizeof(Header)) + n);
+        h->prev = last;
+        h->dtor = dtor;
+        last = h;
+        return (char*)h + round_up(sizeof(Header));
+    }
+
+    // called when a constructor throws: the object never came to life
+    void abandon(void* p) {
+        Header* h = (Header*)((char*)p - round_up(sizeof(Header)));
+        h->dtor = NULL;
+    }
+
+    // destroys every object and makes all memory available again; chunks
+    // are kept so the next tree does not go back to malloc
+    void reset() {
+        for (Header* h = last; h; h = h->prev)
+            if (h->dtor)
+                h->dtor((char*)h + round_up(sizeof(Header)));
+        last = NULL;
+        while (chunks) {
+            Chunk* next = chunks->next;
+            chunks->next = spare;
+            spare = chunks;
+            chunks = next;
+        }
+        cur = end = NULL;
+        allocated = 0;
+    }
+
+    size_t bytes_allocated() const {
+        return allocated;
+    }
+
+    // the arena new nodes are placed in, per thread so that files can be
+    // parsed in parallel
+    static Arena*& current() {
+        static thread_local Arena fallback;
+        static thread_local Arena* cur = &fallback;
+        return cur;
+    }
+};
+
+// makes an arena current for the lifetime of the scope
+class ArenaScope {
+    Arena* saved;
+public:
+    ArenaScope(Arena& a) : saved(Arena::current()) {
+        Arena::current() = &a;
+    }
+
+    ~ArenaScope() {
+        Arena::current() = saved;
+    }
+};
+
+#endif
@@ -0,0 +1,675 @@
+// register bytecode for PCAT, lowered from the interpreter's resolved code
+// tree. Every procedure gets a window of registers: its variables first,
+// then temporaries. An instruction is a fixed 12 bytes, an opcode and up
+// to three operands; literals come from a constant pool.
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "interp.h"
+
+// the operands each instruction uses are listed after it; R[x] is a
+// register of the running procedure
+#define BYTECODE_OPS(X) \
+    X(LOADK)    /* R[a] = K[b] */ \
+    X(MOVE)     /* R[a] = R[b] */ \
+    X(GETG)     /* R[a] = global b */ \
+    X(SETG)     /* global a = R[b] */ \
+    X(GETO)     /* R[a] = slot b of the frame c levels out */ \
+    X(SETO)     /* slot b of the frame c levels out = R[a] */ \
+    X(REAL)     /* R[a] = R[a] as a real if it is an integer */ \
+    X(ADD) X(SUB) X(MUL) X(RDIV) X(DIV) X(MOD)  /* R[a] = R[b] op R[c] */ \
+    X(LT) X(LE) X(GT) X(GE) X(EQ) X(NE) \
+    X(NEG) X(POS) X(NOT) /* R[a] = op R[b] */ \
+    X(TRUTH)    /* R[a] = R[b], which must be a boolean */ \
+    X(JMP)      /* go to b */ \
+    X(JT)       /* go to b if R[a] */ \
+    X(JF)       /* go to b unless R[a] */ \
+    X(INDEX)    /* R[a] = R[b][R[c]] */ \
+    X(SETINDEX) /* R[a][R[b]] = R[c] */ \
+    X(FIELD)    /* R[a] = R[b].field c */ \
+    X(SETFIELD) /* R[a].field b = R[c] */ \
+    X(RECORD)   /* R[a] = record site b from R[c], R[c+1]... */ \
+    X(ARRAY)    /* R[a] = array site b from R[c], R[c+1]... */ \
+    X(CALL)     /* R[a] = call site b with arguments R[c], R[c+1]... */ \
+    X(RET)      /* return R[a] */ \
+    X(RETNIL)   /* return without a value */ \
+    X(READ)     /* read R[a], declared of kind b */ \
+    X(WRITE)    /* write R[a] */ \
+    X(WRITES)   /* write string b */ \
+    X(WRITELN)  /* end the line */ \
+    X(FORPREP)  /* R[a], R[a+1], R[a+2] are from, to, by: go to b if empty */ \
+    X(FORLOOP)  /* R[a] += R[a+2], go to b unless past R[a+1] */
+
+#define BYTECODE_ENUM(name) OP_##name,
+enum Opcode { BYTECODE_OPS(BYTECODE_ENUM) OP_COUNT };
+#undef BYTECODE_ENUM
+
+struct Insn {
+    unsigned op : 8;
+    unsigned a : 24;
+    unsigned b;
+    unsigned c;
+};
+
+struct FieldSite {
+    Symbol field;
+    FieldCache cache;
+};
+
+struct RecordSite {
+    const RecordInfo* record;
+    std::vector<unsigned> fields;  // field index of each register
+};
+
+struct ArraySite {
+    std::vector<bool> of;  // per item: a count and a value register, or one value
+    unsigned registers;
+    unsigned char slot;    // of the elements, see layout.h
+};
+
+struct CallSite {
+    unsigned proc;
+    unsigned hops;           // static link: levels out from the caller
+};
+
+struct ProcCode {
+    std::string name;
+    unsigned entry;          // first instruction
+    unsigned depth;
+    unsigned params;
+    unsigned slots;          // parameters and local variables
+    unsigned registers;      // slots and temporaries
+    std::vector<unsigned char> kinds;  // per parameter
+    unsigned char result;
+};
+
+// a whole program; procs[0] is the main program. Record sites point at
+// record types owned by the Interpreter that compiled the program
+struct Module {
+    std::vector<Insn> code;
+    std::vector<Value> constants;
+    std::vector<std::string> strings;
+    std::vector<FieldSite> fields;
+    std::vector<RecordSite> records;
+    std::vector<ArraySite> arrays;
+    std::vector<CallSite> calls;
+    std::vector<ProcCode> procs;
+
+    // the bytecode registers an instruction reads and writes
+    void operands(const Insn& in, std::vector<unsigned>& uses, std::vector<unsigned>& defs) const {
+        uses.clear();
+        defs.clear();
+        switch (in.op) {
+        case OP_LOADK: case OP_GETG: case OP_GETO:
+            defs.push_back(in.a);
+            break;
+        case OP_MOVE: case OP_NEG: case OP_POS: case OP_NOT: case OP_TRUTH: case OP_FIELD:
+            uses.push_back(in.b);
+            defs.push_back(in.a);
+            break;
+        case OP_SETG:
+            uses.push_back(in.b);
+            break;
+        case OP_SETO: case OP_JT: case OP_JF: case OP_RET: case OP_WRITE:
+            uses.push_back(in.a);
+            break;
+        case OP_REAL: case OP_READ:
+            uses.push_back(in.a);
+            defs.push_back(in.a);
+            break;
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_RDIV: case OP_DIV: case OP_MOD:
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+        case OP_INDEX:
+            uses.push_back(in.b);
+            uses.push_back(in.c);
+            defs.push_back(in.a);
+            break;
+        case OP_SETINDEX:
+            uses.push_back(in.a);
+            uses.push_back(in.b);
+            uses.push_back(in.c);
+            break;
+        case OP_SETFIELD:
+            uses.push_back(in.a);
+            uses.push_back(in.c);
+            break;
+        case OP_RECORD:
+            for (unsigned i = 0; i < records[in.b].fields.size(); ++i)
+                uses.push_back(in.c + i);
+            defs.push_back(in.a);
+            break;
+        case OP_ARRAY:
+            for (unsigned i = 0; i < arrays[in.b].registers; ++i)
+                uses.push_back(in.c + i);
+            defs.push_back(in.a);
+            break;
+        case OP_CALL:
+            for (unsigned i = 0; i < procs[calls[in.b].proc].params; ++i)
+                uses.push_back(in.c + i);
+            defs.push_back(in.a);
+            break;
+        case OP_FORPREP:
+            uses.push_back(in.a);
+            uses.push_back(in.a + 1);
+            uses.push_back(in.a + 2);
+            break;
+        case OP_FORLOOP:
+            uses.push_back(in.a);
+            uses.push_back(in.a + 1);
+            uses.push_back(in.a + 2);
+            defs.push_back(in.a);
+            break;
+        default:
+            break;
+        }
+    }
+
+    static const char* op_name(unsigned op) {
+#define BYTECODE_NAME(name) #name,
+        static const char* names[] = { BYTECODE_OPS(BYTECODE_NAME) };
+#undef BYTECODE_NAME
+        return op < OP_COUNT ? names[op] : "?";
+    }
+
+    void print(FILE* out) const {
+        for (size_t p = 0; p < procs.size(); ++p) {
+            const ProcCode& proc = procs[p];
+            unsigned end = p + 1 < procs.size() ? procs[p+1].entry : (unsigned)code.size();
+            fprintf(out, "%s: %u params, %u slots, %u registers\n", proc.name.c_str(),
+                    proc.params, proc.slots, proc.registers);
+            for (unsigned i = proc.entry; i < end; ++i) {
+                const Insn& in = code[i];
+                fprintf(out, "%6u  %-9s %u %u %u", i, op_name(in.op), (unsigned)in.a, in.b, in.c);
+                if (in.op == OP_LOADK) {
+                    fputs("    ; ", out);
+                    const Value& k = constants[in.b];
+                    if (k.tag == V_OBJECT)
+                        fputs("?", out);
+                    else
+                        write_value(out, k);
+                } else if (in.op == OP_WRITES) {
+                    fprintf(out, "    ; \"%s\"", strings[in.b].c_str());
+                } else if (in.op == OP_CALL) {
+                    fprintf(out, "    ; %s", procs[calls[in.b].proc].name.c_str());
+                } else if (in.op == OP_FIELD || in.op == OP_SETFIELD) {
+                    Symbol f = fields[in.op == OP_FIELD ? in.c : in.b].field;
+                    fprintf(out, "    ; %s", name_of(f).c_str());
+                }
+                fputc('\n', out);
+            }
+        }
+    }
+};
+
+class BytecodeCompiler {
+    Module* m;
+    std::unordered_map<const Proc*, unsigned> proc_index;
+    std::vector<const Proc*> pending;
+    std::unordered_map<unsigned long long, unsigned> int_constants;
+    std::unordered_map<unsigned long long, unsigned> real_constants;
+
+    // the procedure being lowered
+    const Proc* proc;
+    unsigned top;            // next free temporary
+    unsigned high;           // most registers used
+    std::vector<std::vector<unsigned> > exits;  // jumps to patch, per loop
+
+    BytecodeCompiler(const BytecodeCompiler&);
+    BytecodeCompiler& operator=(const BytecodeCompiler&);
+
+    unsigned emit(Opcode op, unsigned a = 0, unsigned b = 0, unsigned c = 0) {
+        if (a >= (1u << 24))
+            value_error("too many registers");
+        Insn in;
+        in.op = op;
+        in.a = a;
+        in.b = b;
+        in.c = c;
+        m->code.push_back(in);
+        return (unsigned)m->code.size() - 1;
+    }
+
+    unsigned here() const {
+        return (unsigned)m->code.size();
+    }
+
+    void patch(unsigned at, unsigned target) {
+        m->code[at].b = target;
+    }
+
+    unsigned temp() {
+        unsigned r = top++;
+        if (top > high)
+            high = top;
+        return r;
+    }
+
+    unsigned constant(Value k) {
+        unsigned long long bits = 0;
+        std::unordered_map<unsigned long long, unsigned>* pool = &int_constants;
+        if (k.tag == V_REAL) {
+            memcpy(&bits, &k.r, sizeof(k.r));
+            pool = &real_constants;
+        } else if (k.tag != V_NIL) {
+            bits = ((unsigned long long)k.tag << 32) | (unsigned)k.i;
+        } else {
+            bits = (unsigned long long)V_NIL << 32;
+        }
+        std::unordered_map<unsigned long long, unsigned>::iterator it = pool->find(bits);
+        if (it != pool->end())
+            return it->second;
+        m->constants.push_back(k);
+        unsigned i = (unsigned)m->constants.size() - 1;
+        (*pool)[bits] = i;
+        return i;
+    }
+
+    unsigned field_site(Symbol field) {
+        FieldSite f;
+        f.field = field;
+        memset((void*)&f.cache, 0, sizeof(f.cache));
+        m->fields.push_back(f);
+        return (unsigned)m->fields.size() - 1;
+    }
+
+    unsigned proc_of(const Proc* p) {
+        std::unordered_map<const Proc*, unsigned>::iterator it = proc_index.find(p);
+        if (it != proc_index.end())
+            return it->second;
+        unsigned i = (unsigned)m->procs.size();
+        m->procs.push_back(ProcCode());
+        proc_index[p] = i;
+        pending.push_back(p);
+        return i;
+    }
+
+    static bool has_call(const Code* c) {
+        if (!c)
+            return false;
+        if (c->op == C_CALL)
+            return true;
+        if (has_call(c->a) || has_call(c->b) || has_call(c->c) || has_call(c->d))
+            return true;
+        for (unsigned i = 0; i < c->n; ++i)
+            if (has_call(c->list[i]))
+                return true;
+        return false;
+    }
+
+    bool is_variable(unsigned r) const {
+        return r < proc->slots;
+    }
+
+    // a register holding the value of c: a variable's own register when
+    // nothing evaluated after it (later) can call a procedure that changes it
+    unsigned value(Code* c, const Code* later = NULL) {
+        if (c->op == C_LOCAL && !has_call(later))
+            return c->slot;
+        unsigned r = temp();
+        into(c, r);
+        return r;
+    }
+
+    // evaluates c into register dst
+    void into(Code* c, unsigned dst) {
+        switch (c->op) {
+        case C_CONST:
+            emit(OP_LOADK, dst, constant(c->k));
+            break;
+        case C_LOCAL:
+            if (c->slot != dst)
+                emit(OP_MOVE, dst, c->slot);
+            break;
+        case C_GLOBAL:
+            emit(OP_GETG, dst, c->slot);
+            break;
+        case C_OUTER:
+            emit(OP_GETO, dst, c->slot, c->hops);
+            break;
+        case C_INDEX: {
+            unsigned mark = top;
+            unsigned a = value(c->a, c->b);
+            unsigned i = value(c->b);
+            emit(OP_INDEX, dst, a, i);
+            top = mark;
+            break;
+        }
+        case C_FIELD: {
+            unsigned mark = top;
+            unsigned r = value(c->a);
+            emit(OP_FIELD, dst, r, field_site(c->field));
+            top = mark;
+            break;
+        }
+        case C_POS: case C_NEG: case C_NOT: {
+            unsigned mark = top;
+            unsigned r = value(c->a);
+            emit(c->op == C_POS ? OP_POS : c->op == C_NEG ? OP_NEG : OP_NOT, dst, r);
+            top = mark;
+            break;
+        }
+        case C_ADD: case C_SUB: case C_MUL: case C_RDIV: case C_DIV: case C_MOD:
+        case C_LT: case C_LE: case C_GT: case C_GE: case C_EQ: case C_NE: {
+            unsigned mark = top;
+            unsigned a = value(c->a, c->b);
+            unsigned b = value(c->b);
+            emit((Opcode)(c->op < C_AND ? OP_ADD + (c->op - C_ADD) : OP_LT + (c->op - C_LT)),
+                 dst, a, b);
+            top = mark;
+            break;
+        }
+        case C_AND: case C_OR: {
+            // the left value is the result if it decides; a variable being
+            // assigned must not change before the right side is read
+            unsigned mark = top;
+            unsigned r = is_variable(dst) ? temp() : dst;
+            into(c->a, r);
+            unsigned jump = emit(c->op == C_AND ? OP_JF : OP_JT, r);
+            into(c->b, r);
+            emit(OP_TRUTH, r, r);
+            patch(jump, here());
+            if (r != dst)
+                emit(OP_MOVE, dst, r);
+            top = mark;
+            break;
+        }
+        case C_CALL:
+            call(c, dst);
+            break;
+        case C_RECORD: {
+            RecordSite site;
+            site.record = c->record;
+            site.fields.assign(c->fields, c->fields + c->n);
+            m->records.push_back(site);
+            unsigned index = (unsigned)m->records.size() - 1;
+            unsigned mark = top;
+            unsigned base = top;
+            for (unsigned i = 0; i < c->n; ++i)
+                temp();
+            for (unsigned i = 0; i < c->n; ++i)
+                into(c->list[i], base + i);
+            emit(OP_RECORD, dst, index, base);
+            top = mark;
+            break;
+        }
+        case C_ARRAY: {
+            ArraySite site;
+            site.registers = 0;
+            site.slot = c->kind;
+            for (unsigned i = 0; i < c->n; ++i) {
+                site.of.push_back(c->list[i]->op == C_OF);
+                site.registers += site.of.back() ? 2 : 1;
+            }
+            m->arrays.push_back(site);
+            unsigned index = (unsigned)m->arrays.size() - 1;
+            unsigned mark = top;
+            unsigned base = top;
+            for (unsigned i = 0; i < site.registers; ++i)
+                temp();
+            unsigned r = base;
+            for (unsigned i = 0; i < c->n; ++i) {
+                if (c->list[i]->op == C_OF) {
+                    into(c->list[i]->a, r++);
+                    into(c->list[i]->b, r++);
+                } else {
+                    into(c->list[i], r++);
+                }
+            }
+            emit(OP_ARRAY, dst, index, base);
+            top = mark;
+            break;
+        }
+        default:
+            value_error("not an expression");
+        }
+    }
+
+    void call(Code* c, unsigned dst) {
+        CallSite site;
+        site.proc = proc_of(c->proc);
+        site.hops = c->hops;
+        m->calls.push_back(site);
+        unsigned index = (unsigned)m->calls.size() - 1;
+        unsigned mark = top;
+        unsigned base = top;
+        for (unsigned i = 0; i < c->n; ++i)
+            temp();
+        for (unsigned i = 0; i < c->n; ++i)
+            into(c->list[i], base + i);
+        emit(OP_CALL, dst, index, base);
+        top = mark;
+    }
+
+    // stores register r into a plain variable
+    void set_variable(Code* var, unsigned r, unsigned char kind) {
+        if (kind == K_REAL && var->op != C_LOCAL && is_variable(r)) {
+            unsigned t = temp();
+            emit(OP_MOVE, t, r);
+            r = t;
+        }
+        if (kind == K_REAL && var->op != C_LOCAL)
+            emit(OP_REAL, r);
+        switch (var->op) {
+        case C_LOCAL:
+            if (var->slot != r)
+                emit(OP_MOVE, var->slot, r);
+            if (kind == K_REAL)
+                emit(OP_REAL, var->slot);
+            break;
+        case C_GLOBAL:
+            emit(OP_SETG, var->slot, r);
+            break;
+        default:
+            emit(OP_SETO, r, var->slot, var->hops);
+        }
+    }
+
+    void assign(Code* c) {
+        Code* target = c->a;
+        switch (target->op) {
+        case C_LOCAL:
+            into(c->b, target->slot);
+            if (c->kind == K_REAL)
+                emit(OP_REAL, target->slot);
+            break;
+        case C_GLOBAL:
+        case C_OUTER:
+            set_variable(target, value(c->b), c->kind);
+            break;
+        case C_INDEX: {
+            // the value first, then the array and the index
+            unsigned r = value(c->b, target);
+            unsigned a = value(target->a, target->b);
+            unsigned i = value(target->b);
+            emit(OP_SETINDEX, a, i, r);
+            break;
+        }
+        default: {
+            unsigned r = value(c->b, target);
+            unsigned o = value(target->a);
+            emit(OP_SETFIELD, o, field_site(target->field), r);
+        }
+        }
+    }
+
+    void read(Code* lval) {
+        switch (lval->op) {
+        case C_LOCAL:
+            emit(OP_READ, lval->slot, lval->kind);
+            break;
+        case C_GLOBAL:
+        case C_OUTER: {
+            unsigned t = temp();
+            into(lval, t);
+            emit(OP_READ, t, lval->kind);
+            set_variable(lval, t, K_OTHER);
+            break;
+        }
+        case C_INDEX: {
+            unsigned a = value(lval->a, lval->b);
+            unsigned i = value(lval->b);
+            unsigned t = temp();
+            emit(OP_INDEX, t, a, i);
+            emit(OP_READ, t, K_OTHER);
+            emit(OP_SETINDEX, a, i, t);
+            break;
+        }
+        default: {
+            // a REAL field always holds a real, its tag is enough
+            unsigned o = value(lval->a);
+            unsigned t = temp();
+            emit(OP_FIELD, t, o, field_site(lval->field));
+            emit(OP_READ, t, K_OTHER);
+            emit(OP_SETFIELD, o, field_site(lval->field), t);
+        }
+        }
+    }
+
+    void loop_body(Code* body, unsigned top_pc) {
+        stat(body);
+        emit(OP_JMP, 0, top_pc);
+    }
+
+    void end_loop() {
+        for (size_t i = 0; i < exits.back().size(); ++i)
+            patch(exits.back()[i], here());
+        exits.pop_back();
+    }
+
+    void stat(Code* c) {
+        unsigned mark = top;
+        switch (c->op) {
+        case C_BLOCK:
+            for (unsigned i = 0; i < c->n; ++i)
+                stat(c->list[i]);
+            break;
+        case C_ASSIGN:
+            assign(c);
+            break;
+        case C_CALL_STAT:
+            call(c, temp());
+            break;
+        case C_READ:
+            for (unsigned i = 0; i < c->n; ++i) {
+                read(c->list[i]);
+                top = mark;
+            }
+            break;
+        case C_WRITE:
+            for (unsigned i = 0; i < c->n; ++i) {
+                Code* item = c->list[i];
+                if (item->op == C_STRING) {
+                    m->strings.push_back(std::string(item->text.ptr, item->text.len));
+                    emit(OP_WRITES, 0, (unsigned)m->strings.size() - 1);
+                } else {
+                    emit(OP_WRITE, value(item));
+                }
+                top = mark;
+            }
+            emit(OP_WRITELN);
+            break;
+        case C_IF: {
+            unsigned skip = emit(OP_JF, value(c->a));
+            top = mark;
+            stat(c->b);
+            if (c->c) {
+                unsigned end = emit(OP_JMP);
+                patch(skip, here());
+                stat(c->c);
+                patch(end, here());
+            } else {
+                patch(skip, here());
+            }
+            break;
+        }
+        case C_WHILE: {
+            exits.push_back(std::vector<unsigned>());
+            unsigned start = here();
+            exits.back().push_back(emit(OP_JF, value(c->a)));
+            top = mark;
+            loop_body(c->b, start);
+            end_loop();
+            break;
+        }
+        case C_LOOP:
+            exits.push_back(std::vector<unsigned>());
+            loop_body(c->b, here());
+            end_loop();
+            break;
+        case C_FOR: {
+            // R[base] is the counter, R[base+1] the bound, R[base+2] the step
+            unsigned base = temp();
+            temp();
+            temp();
+            into(c->b, base);
+            into(c->c, base + 1);
+            if (c->d)
+                into(c->d, base + 2);
+            else
+                emit(OP_LOADK, base + 2, constant(int_value(1)));
+            exits.push_back(std::vector<unsigned>());
+            exits.back().push_back(emit(OP_FORPREP, base));
+            unsigned start = here();
+            set_variable(c->a, base, K_OTHER);
+            stat(c->list[0]);
+            // the body may have changed the variable
+            into(c->a, base);
+            emit(OP_FORLOOP, base, start);
+            end_loop();
+            break;
+        }
+        case C_EXIT:
+            exits.back().push_back(emit(OP_JMP));
+            break;
+        case C_RETURN:
+            if (c->a)
+                emit(OP_RET, value(c->a));
+            else
+                emit(OP_RETNIL);
+            break;
+        default:
+            value_error("not a statement");
+        }
+        top = mark;
+    }
+
+    void lower(const Proc* p, unsigned index) {
+        proc = p;
+        top = high = p->slots;
+        ProcCode& code = m->procs[index];
+        code.name = name_of(p->name);
+        code.entry = here();
+        code.depth = p->depth;
+        code.params = p->params;
+        code.slots = p->slots;
+        code.kinds.assign(p->kinds.begin(), p->kinds.begin() + p->params);
+        code.result = p->result;
+        stat(p->body);
+        emit(OP_RETNIL);
+        m->procs[index].registers = high;
+    }
+
+public:
+    BytecodeCompiler() : m(NULL), proc(NULL), top(0), high(0) {}
+
+    // lowers program and every procedure it calls into out
+    bool compile(const Proc* program, Module& out, std::string& error) {
+        m = &out;
+        try {
+            proc_of(program);
+            for (size_t i = 0; i < pending.size(); ++i)
+                lower(pending[i], (unsigned)i);
+            return true;
+        } catch (const InterpError& e) {
+            error = e.message;
+            return false;
+        }
+    }
+};
+
+#endif
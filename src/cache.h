@@ -0,0 +1,120 @@
+// on-disk cache of parsed trees: a file whose contents, compiler version
+// and options were seen before is loaded from its saved flat tree instead
+// of being scanned and parsed again
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "flat.h"
+
+// bump whenever a change to the scanner, grammar or tree would make an
+// old entry describe a different tree: 2, operator precedence levels and
+// the ELSE branch of IF; 3, source positions
+const char* const PARSER_VERSION = "pcat-parse-3";
+
+// 128 bits from two independent FNV-1a lanes over the salt and the bytes
+class CacheKey {
+    unsigned long long h1, h2;
+
+    void mix(const char* s, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            h1 = (h1 ^ (unsigned char)s[i]) * 0x100000001b3ull;
+            h2 = (h2 ^ (unsigned char)s[i]) * 0x100000001b3ull;
+            h2 ^= h2 >> 29;
+        }
+    }
+public:
+    // options: everything on the command line that changes the tree
+    explicit CacheKey(const std::string& options)
+        : h1(0xcbf29ce484222325ull), h2(0x84222325cbf29ce4ull)
+    {
+        std::string salt = std::string(PARSER_VERSION) + '\0' + options + '\0';
+        salt += (char)FLAT_VERSION;
+        mix(salt.data(), salt.size());
+    }
+
+    void add(const char* s, size_t n) {
+        mix(s, n);
+    }
+
+    // hashes the file at path; false if it can't be read
+    bool add_file(const char* path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        char buf[1 << 16];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+            mix(buf, (size_t)n);
+        ::close(fd);
+        return n == 0;
+    }
+
+    std::string hex() const {
+        char s[33];
+        snprintf(s, sizeof(s), "%016llx%016llx", h1, h2);
+        return s;
+    }
+};
+
+// entries are written under a private name and renamed into place, so
+// concurrent runs sharing a directory only ever see whole files; the
+// last writer of an entry wins and all writers wrote the same tree
+class ParseCache {
+    std::string dir;
+    std::atomic<unsigned> hits, misses, stores;
+    std::atomic<unsigned> serial;
+
+    std::string entry(const CacheKey& key) const {
+        return dir + "/" + key.hex() + ".ast";
+    }
+public:
+    explicit ParseCache(const std::string& _dir)
+        : dir(_dir), hits(0), misses(0), stores(0), serial(0)
+    {
+        while (dir.size() > 1 && dir[dir.size() - 1] == '/')
+            dir.erase(dir.size() - 1);
+    }
+
+    // creates the directory if needed
+    bool open() {
+        if (mkdir(dir.c_str(), 0777) == 0 || errno == EEXIST) {
+            struct stat st;
+            return stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        return false;
+    }
+
+    // maps the entry for key into out; a missing or damaged entry is a miss
+    bool lookup(const CacheKey& key, FlatFile& out) {
+        if (out.open(entry(key).c_str()) && out.intact()) {
+            ++hits;
+            return true;
+        }
+        ++misses;
+        return false;
+    }
+
+    void store(const CacheKey& key, const FlatView& tree) {
+        std::string path = entry(key);
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), ".%ld.%u.tmp", (long)getpid(), serial++);
+        std::string tmp = path + suffix;
+        if (save_flat(tree, tmp.c_str()) && rename(tmp.c_str(), path.c_str()) == 0)
+            ++stores;
+        else
+            unlink(tmp.c_str());
+    }
+
+    unsigned hit_count() const { return hits; }
+    unsigned miss_count() const { return misses; }
+    unsigned store_count() const { return stores; }
+};
+
+#endif
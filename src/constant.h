@@ -0,0 +1,141 @@
+// constant values in the tree: every number literal is read once, by the
+// scanner, and with --fold the parser replaces arithmetic on numbers by
+// the number it gives. Folding computes what the program would at run time
+// (see value.h), and leaves alone what would fail there or overflow
+#ifndef CONSTANT_H
+#define CONSTANT_H
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// the value of a number; 16 bytes, saved as it is with the flat tree
+struct Literal {
+    unsigned real;  // 1 for a REAL, 0 for an INTEGER
+    int i;          // an INTEGER's value
+    double r;       // a REAL's value
+};
+
+inline Literal int_literal(long long i) {
+    Literal k;
+    k.real = 0;
+    k.i = (int)i;
+    k.r = 0;
+    return k;
+}
+
+inline Literal real_literal(double r) {
+    Literal k;
+    k.real = 1;
+    k.i = 0;
+    k.r = r;
+    return k;
+}
+
+// reads n bytes of digits, with at most one point among them, into k;
+// false if they are out of range: an INTEGER past 2147483647, which k then
+// holds, or a REAL past the largest double
+inline bool read_literal(const char* p, size_t n, Literal& k) {
+    if (!memchr(p, '.', n)) {
+        long long i = 0;
+        for (size_t j = 0; j < n; ++j) {
+            i = i * 10 + (p[j] - '0');
+            if (i > INT_MAX) {
+                k = int_literal(INT_MAX);
+                return false;
+            }
+        }
+        k = int_literal(i);
+        return true;
+    }
+    // the text need not end after the literal
+    char buf[64];
+    std::string big;
+    const char* s = buf;
+    if (n < sizeof(buf)) {
+        memcpy(buf, p, n);
+        buf[n] = '\0';
+    } else {
+        big.assign(p, n);
+        s = big.c_str();
+    }
+    k = real_literal(strtod(s, NULL));
+    return k.r <= DBL_MAX;
+}
+
+enum Folded { FOLDED, NOT_FOLDED, FOLD_OVERFLOW };
+
+inline Folded folded_int(long long i, Literal& out) {
+    if (i < INT_MIN || i > INT_MAX)
+        return FOLD_OVERFLOW;
+    out = int_literal(i);
+    return FOLDED;
+}
+
+inline Folded folded_real(double r, Literal& out) {
+    if (std::isinf(r) || std::isnan(r))
+        return FOLD_OVERFLOW;
+    out = real_literal(r);
+    return FOLDED;
+}
+
+// the unary operator op, "+", "-" or "NOT", on k
+inline Folded fold_unary(const char* op, const Literal& k, Literal& out) {
+    if (op[0] == 'N')
+        return NOT_FOLDED;
+    if (op[0] == '+') {
+        out = k;
+        return FOLDED;
+    }
+    return k.real ? folded_real(-k.r, out) : folded_int(-(long long)k.i, out);
+}
+
+// the binary operator op on a and b; comparisons and the boolean
+// operators make no number, division by zero and DIV or MOD of a REAL
+// are run time errors, none of them is folded
+inline Folded fold_binary(const char* op, const Literal& a, const Literal& b, Literal& out) {
+    bool rdiv = !strcmp(op, "/");
+    bool div = !strcmp(op, "DIV");
+    bool mod = !strcmp(op, "MOD");
+    if (!rdiv && !div && !mod && strcmp(op, "+") && strcmp(op, "-") && strcmp(op, "*"))
+        return NOT_FOLDED;
+    if (!a.real && !b.real) {
+        long long x = a.i, y = b.i;
+        if ((rdiv || div || mod) && y == 0)
+            return NOT_FOLDED;
+        if (rdiv)
+            return folded_real((double)a.i / b.i, out);
+        if (div)
+            return folded_int(x / y, out);
+        if (mod)
+            return folded_int(x % y, out);
+        return folded_int(op[0] == '+' ? x + y : op[0] == '-' ? x - y : x * y, out);
+    }
+    if (div || mod)
+        return NOT_FOLDED;
+    double x = a.real ? a.r : a.i, y = b.real ? b.r : b.i;
+    if (rdiv && y == 0)
+        return NOT_FOLDED;
+    return folded_real(op[0] == '+' ? x + y : op[0] == '-' ? x - y : op[0] == '*' ? x * y
+                                                                               : x / y, out);
+}
+
+// how a folded number is spelled in the tree: an INTEGER in decimal, a
+// REAL with a point or an exponent and the digits to read it back exactly
+inline std::string literal_spelling(const Literal& k) {
+    char s[64];
+    if (!k.real) {
+        snprintf(s, sizeof(s), "%d", k.i);
+        return s;
+    }
+    snprintf(s, sizeof(s), "%.17g", k.r);
+    if (!strpbrk(s, ".e"))
+        strcat(s, ".0");
+    return s;
+}
+
+#endif
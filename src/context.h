@@ -0,0 +1,135 @@
+// the state of one parse: scanner position, the arena owning the tree and
+// the outcome; each file gets its own so files can be parsed in parallel
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "flat.h"
+#include "source.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+class Node;
+class Program;
+struct ParseContext;
+
+// a copy of a spelling in the arena class tree nodes are placed in, so it
+// goes when the nodes that keep it do
+inline Text arena_text(const char* s, size_t n) {
+    char* copy = (char*)Arena::current()->alloc(n);
+    memcpy(copy, s, n);
+    return Text(copy, n);
+}
+
+// the semantic value of every token and grammar symbol
+struct SemValue {
+    Node* node;     // class tree node, NULL unless the context builds that tree
+    unsigned flat;  // node in ParseContext::flat; for a list still being
+                    // reduced, its open_list handle
+    int ln, col;    // where a token starts; not kept for grammar symbols
+};
+
+// defined in the tokenizer
+yyscan_t lexer_create(ParseContext* ctx);
+void lexer_destroy(yyscan_t scanner);
+// scan size bytes at base without copying them; base[size] and
+// base[size+1] must be NUL (see SourceFile). The scanner may change bytes
+// there while it runs and puts them back when destroyed, so they must
+// outlive it
+void scan_in_place(yyscan_t scanner, char* base, size_t size);
+void scan_file(yyscan_t scanner, FILE* in);
+// the next token's code, 0 at the end; its value goes to yylval
+int yylex(SemValue* yylval, yyscan_t scanner);
+ParseContext* yyget_extra(yyscan_t scanner);
+char* yyget_text(yyscan_t scanner);
+
+// what a streaming parse hands over, see ParseContext::stream
+enum StreamItem { STREAM_DECL, STREAM_STAT };
+
+struct ParseContext {
+    yyscan_t scanner;
+    int ln, col;        // just past the last token scanned
+    int tok_ln, tok_col;  // where that token starts
+    bool input_stable;  // literals may point into the input
+    SourceFile source;  // the mapped input, if it could be mapped
+    FlatAst flat;       // the tree, rooted once the whole input is reduced
+    bool build_tree;    // also build the class tree in the arena
+    bool scan_only;     // no parser: tokens carry no value, nothing is built
+    bool fold;          // arithmetic on numbers becomes the number, see constant.h
+    Arena arena;
+    Program* program;   // root of the class tree, if one was built
+    std::string error;  // first problem, empty if none
+    std::vector<std::string> errors;  // every problem, in the order found
+    int error_ln, error_col;  // where the first problem is, 0:0 if it has no place
+
+    // streaming: if set, each declaration and statement of the program's
+    // own body is handed here as soon as it is reduced, in source order,
+    // and then dropped from flat instead of kept in the tree; calls stop
+    // at the first error. The flat tree then only ever holds the largest
+    // of them.
+    std::function<void(StreamItem, const FlatView&, unsigned)> stream;
+    unsigned depth;              // procedure bodies the parser is inside
+    FlatAst::Mark stream_mark;   // where the next streamed item starts
+
+    ParseContext()
+        : ln(1), col(1), tok_ln(1), tok_col(1), input_stable(false), build_tree(false),
+          scan_only(false), fold(false), program(NULL), error_ln(0), error_col(0), depth(0),
+          stream_mark(flat.mark())
+    {
+        scanner = lexer_create(this);
+    }
+
+    void report(const std::string& message) {
+        if (errors.empty())
+            error = message;
+        errors.push_back(message);
+    }
+
+    // a problem with the token at ln:col; parsing goes on to find the next
+    void report(int ln, int col, const std::string& token, const char* message) {
+        if (errors.empty()) {
+            error_ln = ln;
+            error_col = col;
+        }
+        std::ostringstream msg;
+        msg << "EEK, parse error! Position: " << ln << ":" << col
+            << " token: " << token << "  Message: " << message;
+        report(msg.str());
+    }
+
+    // the spelling a class tree literal keeps: the token itself if the
+    // input stays put, else a copy next to the node
+    Text literal_text(const char* s, size_t n) const {
+        return input_stable ? Text(s, n) : arena_text(s, n);
+    }
+
+    // the number expression of a literal at ln:col, its value read into k;
+    // a literal out of range is an error
+    unsigned number(Text spelling, int ln, int col, Literal& k) {
+        if (scan_only)
+            return NO_NODE;
+        if (!read_literal(spelling.ptr, spelling.len, k))
+            report(ln, col, std::string(spelling.ptr, spelling.len),
+                   k.real ? "real out of range" : "integer out of range");
+        return flat.add_number(spelling, k, ln, col);
+    }
+
+    ~ParseContext() {
+        lexer_destroy(scanner);
+    }
+
+private:
+    ParseContext(const ParseContext&);
+    ParseContext& operator=(const ParseContext&);
+};
+
+#endif
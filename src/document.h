@@ -0,0 +1,578 @@
+// a file held open by --serve. Its text is cut into units, one per
+// declaration and one per statement of the program's own body, and each
+// unit is parsed on its own inside an otherwise empty program. An edit is
+// re-scanned from the unit before it up to the first unit boundary past
+// it that was there before, at the same line and column; only the units
+// in between are parsed again, the rest keep their trees and move. A unit
+// cut short by an error takes in the ones after it until the error shows
+// where the whole parse finds it. A text that is not PROGRAM IS ... BEGIN
+// ... END; has no units and is parsed whole.
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "context.h"
+#include "flat_dump.h"
+#include "thread_pool.h"
+#ifndef YYSTYPE
+#define YYSTYPE SemValue
+#endif
+#include "main.tab.h"
+
+class Document {
+public:
+    // a declared name for the outline; level 0 is the program's own, 1 a
+    // procedure's and so on
+    struct Symbol {
+        int ln, col;
+        int kind;       // KW_VAR, KW_TYPE or KW_PROCEDURE
+        unsigned level;
+        std::string name;
+    };
+
+    struct Unit {
+        size_t begin, end;  // its bytes, from the end of the token before it
+        int ln, col;        // where begin is
+        bool statement;     // of the program's body, else a declaration
+        FlatAst tree;       // parsed inside an empty program
+        unsigned items;     // its declarations or statements, NO_NODE if none
+        std::vector<std::string> errors;
+        std::vector<Symbol> symbols;
+    };
+private:
+    enum Section { HEADER, DECLS, BODY, TRAILER };
+
+    std::string text;      // the document, then the two NULs the scanner needs
+    std::vector<Unit> units;
+    bool framed;           // units cover everything between IS and END
+    int program_ln, program_col;  // where PROGRAM is, if framed
+    FlatAst whole;         // the tree of a text without units
+    std::vector<std::string> whole_errors;
+    size_t parsed;         // parses so far, of units or of the whole text
+    size_t grain;          // the least bytes a unit takes before the next starts
+    bool fold;             // see ParseContext::fold
+
+    // turns the ln:col positions the scanner reports into byte offsets,
+    // moving forward only; columns count as the scanner counts them
+    class Cursor {
+        const std::string& text;
+        size_t at;
+        int ln, col;
+    public:
+        Cursor(const std::string& _text, size_t _at, int _ln, int _col)
+            : text(_text), at(_at), ln(_ln), col(_col) {}
+
+        size_t offset(int to_ln, int to_col) {
+            const char* base = text.data();
+            size_t size = text.size() - 2;
+            while (ln < to_ln) {
+                const char* nl = (const char*)memchr(base + at, '\n', size - at);
+                if (!nl)
+                    return size;
+                at = nl - base + 1;
+                ln += 1;
+                col = 1;
+            }
+            while (col < to_col && at < size) {
+                char c = base[at++];
+                if (c == '\t')
+                    col = ((col - 1) / 8 + 1) * 8 + 1;
+                else if (c != '\r')
+                    col += 1;
+            }
+            return at;
+        }
+    };
+
+    size_t size() const {
+        return text.size() - 2;
+    }
+
+    static void start(std::vector<Unit>& out, size_t begin, int ln, int col, bool statement) {
+        out.push_back(Unit());
+        Unit& u = out.back();
+        u.begin = u.end = begin;
+        u.ln = ln;
+        u.col = col;
+        u.statement = statement;
+        u.items = NO_NODE;
+    }
+
+    // the unit of old that starts at begin, ln:col in the same section;
+    // old.size() if there is none
+    static size_t find(const std::vector<Unit>& old, size_t begin, bool statement, int ln,
+                       int col) {
+        size_t lo = 0, hi = old.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (old[mid].begin < begin)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        if (lo < old.size() && old[lo].begin == begin && old[lo].statement == statement
+            && old[lo].ln == ln && old[lo].col == col)
+            return lo;
+        return old.size();
+    }
+
+    // cuts the text from offset from, at ln:col, into units appended to
+    // out; from is 0 for HEADER, otherwise a unit of that section starts
+    // there. Stops at the first unit start at or past until where old has
+    // a unit that started delta bytes and lines lines earlier, and returns
+    // its index; old.size() at the end of the text. Clears framed, and
+    // stops, on anything that does not fit PROGRAM IS ... BEGIN ... END;
+    size_t cut(size_t from, int ln, int col, Section section, std::vector<Unit>& out,
+               const std::vector<Unit>& old, size_t until, long delta, int lines) {
+        ParseContext ctx;
+        ctx.scan_only = true;
+        ctx.ln = ln;
+        ctx.col = col;
+        scan_in_place(ctx.scanner, &text[from], size() - from);
+        Cursor cursor(text, from, ln, col);
+        int depth = section == BODY ? 1 : 0;  // open BEGIN, IF, WHILE, FOR, LOOP, RECORD
+        int nest = 0;                         // open brackets
+        std::vector<int> kinds(1, 0);         // what is declared, per procedure level
+        bool expect_name = false, in_names = false;
+        bool taken = false;                   // out.back() has a token
+        bool boundary = false;                // a statement starts at the next token
+        int seen = 0;                         // tokens of the header or trailer
+        if (section != HEADER)
+            start(out, from, ln, col, section == BODY);
+        SemValue value;
+        for (;;) {
+            int at_ln = ctx.ln, at_col = ctx.col;  // the end of the token before
+            size_t errors = ctx.errors.size();
+            int code = yylex(&value, ctx.scanner);
+            if (section == HEADER || section == TRAILER) {
+                // PROGRAM IS before the units, ; after them, and nothing
+                // the scanner complains about
+                int want = section == HEADER ? (seen == 0 ? KW_PROGRAM : KW_IS)
+                                             : (seen == 0 ? SEMICOLON : 0);
+                if (code != want || ctx.errors.size() != errors) {
+                    framed = false;
+                    return old.size();
+                }
+                if (code == 0)
+                    return old.size();
+                if (code == KW_PROGRAM) {
+                    program_ln = value.ln;
+                    program_col = value.col;
+                }
+                if (section == HEADER && ++seen == 2) {
+                    section = DECLS;
+                    seen = 0;
+                    start(out, cursor.offset(ctx.ln, ctx.col), ctx.ln, ctx.col, false);
+                } else if (section == TRAILER) {
+                    ++seen;
+                }
+                continue;
+            }
+            if (code == 0) {
+                // the body never ended
+                framed = false;
+                return old.size();
+            }
+            bool top = depth == 0 && nest == 0 && kinds.size() == 1;
+            if (section == DECLS && code == KW_BEGIN && top) {
+                // the program's body
+                out.back().end = cursor.offset(ctx.tok_ln, ctx.tok_col);
+                section = BODY;
+                depth = 1;
+                start(out, cursor.offset(ctx.ln, ctx.col), ctx.ln, ctx.col, true);
+                taken = false;
+                continue;
+            }
+            if (section == BODY && code == KW_END && depth == 1 && nest == 0) {
+                out.back().end = cursor.offset(ctx.tok_ln, ctx.tok_col);
+                section = TRAILER;
+                continue;
+            }
+
+            if (taken && ((section == DECLS && top && (code == KW_VAR || code == KW_TYPE
+                                                       || code == KW_PROCEDURE))
+                          || (section == BODY && boundary))) {
+                size_t p = cursor.offset(at_ln, at_col);
+                if (p - out.back().begin >= grain) {
+                    out.back().end = p;
+                    if (p >= until) {
+                        size_t j = find(old, p - delta, section == BODY, at_ln - lines,
+                                        at_col);
+                        if (j < old.size())
+                            return j;
+                    }
+                    start(out, p, at_ln, at_col, section == BODY);
+                }
+            }
+            taken = true;
+            boundary = false;
+            switch (code) {
+            case KW_BEGIN:
+                // a procedure's body: what follows is its enclosing level's
+                if (depth == 0 && kinds.size() > 1)
+                    kinds.pop_back();
+                ++depth;
+                break;
+            case KW_IF: case KW_WHILE: case KW_FOR: case KW_LOOP: case KW_RECORD:
+                ++depth;
+                break;
+            case KW_END:
+                if (depth > 0)
+                    --depth;
+                break;
+            case LPAREN: case LBRACKET: case LBRACE: case LARRAY:
+                ++nest;
+                break;
+            case RPAREN: case RBRACKET: case RBRACE: case RARRAY:
+                if (nest > 0)
+                    --nest;
+                break;
+            case KW_VAR: case KW_TYPE: case KW_PROCEDURE:
+                if (depth == 0 && nest == 0) {
+                    kinds.back() = code;
+                    expect_name = in_names = true;
+                }
+                break;
+            case IDENTIFIER:
+                if (section == DECLS && depth == 0 && nest == 0 && expect_name) {
+                    Symbol s = { ctx.tok_ln, ctx.tok_col, kinds.back(),
+                                 (unsigned)kinds.size() - 1, yyget_text(ctx.scanner) };
+                    out.back().symbols.push_back(s);
+                    if (kinds.back() == KW_PROCEDURE)
+                        kinds.push_back(0);
+                }
+                expect_name = false;
+                break;
+            case COMMA:
+                if (depth == 0 && nest == 0 && in_names && kinds.back() == KW_VAR)
+                    expect_name = true;
+                break;
+            case COLON: case ASSIGN:
+                if (depth == 0 && nest == 0)
+                    in_names = expect_name = false;
+                break;
+            case SEMICOLON:
+                if (depth == 0 && nest == 0)
+                    expect_name = in_names = true;
+                if (section == BODY && depth == 1 && nest == 0)
+                    boundary = true;
+                break;
+            default:
+                expect_name = false;
+                break;
+            }
+        }
+    }
+
+    // parses unit k inside a program that has nothing else, padded so
+    // that the positions in it are those in the document. What closes the
+    // program is made up, except for the last unit of a section where it
+    // stands where the real BEGIN or END does. True if the first error is
+    // in what was made up after the unit: it is missing something the
+    // next unit has
+    bool parse_unit(size_t k) {
+        Unit& u = units[k];
+        bool last = k + 1 == units.size() || units[k + 1].statement != u.statement;
+        std::string src(u.statement ? "PROGRAM IS BEGIN\n" : "PROGRAM IS\n");
+        src.append(u.col - 1, ' ');
+        src.append(text, u.begin, u.end - u.begin);
+        if (!last)
+            src += ' ';
+        src += u.statement ? "END;" : "BEGIN END;";
+        src.append(2, '\0');
+        // after src, the scanner is done with it before it goes
+        ParseContext ctx;
+        ctx.fold = fold;
+        ctx.ln = u.ln - 1;
+        scan_in_place(ctx.scanner, &src[0], src.size() - 2);
+        yyparse(ctx.scanner);
+        u.errors.swap(ctx.errors);
+        std::swap(u.tree, ctx.flat);
+        u.items = NO_NODE;
+        if (u.tree.has_root()) {
+            FlatView v = u.tree.view();
+            u.items = v.child(v.child(v.root, 0), u.statement ? 1 : 0);
+        }
+        if (last || u.errors.empty())
+            return false;
+        const Unit& next = units[k + 1];
+        return ctx.error_ln > next.ln || (ctx.error_ln == next.ln && ctx.error_col >= next.col);
+    }
+
+    // folds unit k + 1 into unit k
+    void join(size_t k) {
+        Unit& u = units[k];
+        const Unit& next = units[k + 1];
+        u.end = next.end;
+        u.symbols.insert(u.symbols.end(), next.symbols.begin(), next.symbols.end());
+        units.erase(units.begin() + k + 1);
+    }
+
+    // parses unit k, taking in the units after it while its error is past
+    // its end; returns how many it took in
+    size_t parse(size_t k) {
+        size_t taken = 0;
+        for (;;) {
+            ++parsed;
+            if (!parse_unit(k))
+                return taken;
+            join(k);
+            ++taken;
+        }
+    }
+
+    // everything from scratch, the units parsed on pool if there is one
+    void load(ThreadPool* pool = NULL) {
+        std::vector<Unit> none;
+        units.clear();
+        whole = FlatAst();
+        whole_errors.clear();
+        framed = true;
+        cut(0, 1, 1, HEADER, units, none, 0, 0, 0);
+        if (framed && pool) {
+            for (size_t k = 0; k < units.size(); ++k)
+                pool->submit([this, k] { parse_unit(k); });
+            pool->wait();
+            parsed += units.size();
+            // those that took too little are parsed again, one at a time
+            for (size_t k = 0; k < units.size(); ++k)
+                if (!units[k].errors.empty())
+                    parse(k);
+            return;
+        }
+        if (framed) {
+            for (size_t k = 0; k < units.size(); ++k)
+                parse(k);
+            return;
+        }
+        units.clear();
+        ParseContext ctx;
+        ctx.fold = fold;
+        scan_in_place(ctx.scanner, &text[0], size());
+        yyparse(ctx.scanner);
+        whole_errors.swap(ctx.errors);
+        std::swap(whole, ctx.flat);
+        ++parsed;
+    }
+
+    static int newlines(const char* p, size_t n) {
+        return (int)std::count(p, p + n, '\n');
+    }
+public:
+    explicit Document(bool _fold = false)
+        : framed(false), program_ln(1), program_col(1), parsed(0), grain(0), fold(_fold) {
+        text.assign(2, '\0');
+    }
+
+    void set(const std::string& s) {
+        text = s;
+        text.append(2, '\0');
+        load();
+    }
+
+    // the same with units of at least _grain bytes where they can be,
+    // several declarations or statements each, parsed on pool
+    void set(const std::string& s, ThreadPool& pool, size_t _grain) {
+        text = s;
+        text.append(2, '\0');
+        grain = _grain;
+        load(&pool);
+        grain = 0;
+    }
+
+    // replaces bytes a..b with s
+    void replace(size_t a, size_t b, const std::string& s) {
+        a = std::min(a, size());
+        b = std::min(std::max(a, b), size());
+        int lines = newlines(s.data(), s.size()) - newlines(text.data() + a, b - a);
+        long delta = (long)s.size() - (long)(b - a);
+        text.replace(a, b - a, s);
+        // touching the header, even its last token, changes the frame
+        if (!framed || units.empty() || a <= units[0].begin) {
+            load();
+            return;
+        }
+        // from the unit before the one the edit is in: an edit at the start
+        // of a unit can change how the one before it ends
+        size_t i = 0;
+        while (i + 1 < units.size() && units[i].end < a)
+            ++i;
+        if (i > 0)
+            --i;
+        std::vector<Unit> fresh;
+        size_t j = cut(units[i].begin, units[i].ln, units[i].col,
+                       units[i].statement ? BODY : DECLS, fresh, units, a + s.size(), delta,
+                       lines);
+        if (!framed) {
+            load();
+            return;
+        }
+        for (size_t k = j; k < units.size(); ++k) {
+            Unit& u = units[k];
+            u.begin += delta;
+            u.end += delta;
+            u.ln += lines;
+            if (lines != 0)
+                for (size_t n = 0; n < u.symbols.size(); ++n)
+                    u.symbols[n].ln += lines;
+        }
+        // units i..j-1 make way for fresh
+        size_t gone = j - i;
+        if (fresh.size() > gone)
+            units.insert(units.begin() + j, fresh.size() - gone, Unit());
+        else
+            units.erase(units.begin() + i + fresh.size(), units.begin() + j);
+        for (size_t k = 0; k < fresh.size(); ++k)
+            std::swap(units[i + k], fresh[k]);
+        size_t k = i, stop = i + fresh.size();
+        for (; k < stop; ++k) {
+            size_t merged = parse(k);
+            stop = stop > k + 1 + merged ? stop - merged : k + 1;
+        }
+        // the positions in the messages of the units after moved
+        if (lines != 0) {
+            for (; k < units.size(); ++k)
+                if (!units[k].errors.empty())
+                    parse(k);
+        }
+    }
+
+    // the byte offset of line ln, byte col, both from 1; past the end of
+    // the line, its end
+    size_t offset(int ln, int col) const {
+        // from the last unit starting on an earlier line
+        size_t lo = 0, hi = units.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (units[mid].ln < ln)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        size_t at = lo > 0 ? units[lo - 1].begin : 0;
+        int line = lo > 0 ? units[lo - 1].ln : 1;
+        const char* base = text.data();
+        for (; line < ln; ++line) {
+            const char* nl = (const char*)memchr(base + at, '\n', size() - at);
+            if (!nl)
+                return size();
+            at = nl - base + 1;
+        }
+        const char* nl = (const char*)memchr(base + at, '\n', size() - at);
+        size_t line_end = nl ? nl - base : size();
+        return std::min(at + (size_t)(col > 1 ? col - 1 : 0), line_end);
+    }
+
+    // replaces the whole text with s, as one edit of the part that differs
+    void update(const std::string& s) {
+        size_t n = size();
+        size_t prefix = 0;
+        while (prefix < n && prefix < s.size() && text[prefix] == s[prefix])
+            ++prefix;
+        size_t suffix = 0;
+        while (suffix < n - prefix && suffix < s.size() - prefix
+               && text[n - 1 - suffix] == s[s.size() - 1 - suffix])
+            ++suffix;
+        replace(prefix, n - suffix, s.substr(prefix, s.size() - prefix - suffix));
+    }
+
+    // the parse errors, in source order
+    std::vector<std::string> diagnostics() const {
+        if (!framed)
+            return whole_errors;
+        std::vector<std::string> out;
+        for (size_t i = 0; i < units.size(); ++i)
+            out.insert(out.end(), units[i].errors.begin(), units[i].errors.end());
+        return out;
+    }
+
+    // every declared name, in source order
+    std::vector<Symbol> outline() const {
+        std::vector<Symbol> out;
+        for (size_t i = 0; i < units.size(); ++i)
+            out.insert(out.end(), units[i].symbols.begin(), units[i].symbols.end());
+        return out;
+    }
+
+    // prints the tree as the program's whole tree would print
+    void dump(Dumper& out) const {
+        if (!framed) {
+            if (whole.has_root())
+                dump_flat(whole.view(), out);
+            return;
+        }
+        out.line(0, "program");
+        out.line(2, "body");
+        out.line(4, "declarations");
+        bool statements = false;
+        for (size_t i = 0; i < units.size(); ++i) {
+            if (units[i].statement && !statements) {
+                out.line(4, "statements");
+                statements = true;
+            }
+            dump_flat(units[i].tree.view(), units[i].items, out, 6);
+        }
+        if (!statements)
+            out.line(4, "statements");
+    }
+
+    // the tree of the whole program into out, as one parse of it would
+    // build it; false if it has errors
+    bool tree(FlatAst& out) const {
+        if (!framed) {
+            if (!whole_errors.empty() || !whole.has_root())
+                return false;
+            FlatView v = whole.view();
+            out.set_root(out.append(v, v.nodes) + v.root);
+            return true;
+        }
+        size_t nodes = 0, children = 0;
+        for (size_t i = 0; i < units.size(); ++i) {
+            const Unit& u = units[i];
+            if (!u.errors.empty() || u.items == NO_NODE)
+                return false;
+            FlatView v = u.tree.view();
+            nodes += v.nodes;
+            children += v.first[v.nodes - 1] + v.count[v.nodes - 1];
+        }
+        out.reserve(nodes, children);
+        std::vector<unsigned> lists[2];
+        for (size_t i = 0; i < units.size(); ++i) {
+            const Unit& u = units[i];
+            // the items come first, then the two lists the body closes,
+            // declarations first, then the body and the program
+            FlatView v = u.tree.view();
+            unsigned at = out.append(v, v.child(v.child(v.root, 0), 0));
+            for (unsigned c = 0; c < v.children(u.items); ++c)
+                lists[u.statement].push_back(at + v.child(u.items, c));
+        }
+        unsigned decls = out.add_array(N_LIST, 0, lists[0].data(), (unsigned)lists[0].size());
+        unsigned stats = out.add_array(N_LIST, 0, lists[1].data(), (unsigned)lists[1].size());
+        // the body starts where its first item does, as in a whole parse;
+        // the program where PROGRAM is, which no unit's tree has
+        unsigned program = out.add(N_PROGRAM, 0, out.add(N_BODY, 0, decls, stats));
+        out.set_root(out.set_pos(program, program_ln, program_col));
+        return true;
+    }
+
+    // marks every name its trees hold as still in use, see Interner::sweep
+    void keep_names(Interner& table) const {
+        for (size_t i = 0; i < units.size(); ++i)
+            units[i].tree.keep_names(table);
+        whole.keep_names(table);
+    }
+
+    size_t unit_count() const {
+        return units.size();
+    }
+
+    size_t parses() const {
+        return parsed;
+    }
+};
+
+#endif
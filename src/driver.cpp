@@ -0,0 +1,778 @@
+// command line driver: a single file has its syntax tree printed, several
+// files (or directories of .pcat files) are syntax checked in parallel.
+// --emit-ast writes the tree of a single file in the binary flat format,
+// --load-ast prints a tree saved that way without parsing anything.
+// With --cache DIR, files whose tree is already in DIR are not parsed.
+// Trees are printed from the flat form the parser builds; --tree builds
+// and prints the class tree instead. --run executes the program instead
+// of printing it, --vm on the bytecode VM rather than by walking the tree;
+// --exec-stats also reports how fast it ran and the memory its records and
+// arrays took. --bytecode lists the bytecode and --emit-asm writes x86-64
+// assembly to link with src/runtime.c; -O1 and -O2 (or -O) optimize the
+// bytecode first, --opt-stats reports on it.
+// --check resolves names and checks types without running anything, also
+// on batches; --check-stats reports how long that took. --tokens lists
+// what the scanner makes of a file, --scan-stats how fast it scans it.
+// --stream prints the tree while parsing and keeps only one declaration or
+// statement of the program's body at a time. --stats reports on stderr how
+// long each phase of compiling one file took and what it made, --stats-json
+// writes the same to a file as JSON. --serve keeps files open for an
+// editor: commands on stdin edit them and ask for their tree, parse errors
+// or outline, each edit reparsing only what it touched. --parallel parses
+// the declarations and statements of one file on -j threads. --fold puts
+// the number in the tree for arithmetic on numbers, see constant.h
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "syntax.h"
+#define YYSTYPE SemValue
+#include "main.tab.h"
+#include "thread_pool.h"
+#include "flat_dump.h"
+#include "cache.h"
+#include "interp.h"
+#include "vm.h"
+#include "x86.h"
+#include "optimize.h"
+#include "semantic.h"
+#include "stats.h"
+#include "document.h"
+
+using namespace std;
+
+// parses path into ctx; on failure ctx.errors says why
+static bool parse_file(ParseContext& ctx, const char* path, bool use_mmap) {
+    ArenaScope scope(ctx.arena);
+    // preferred: scan the mapped file in place, tokens point into it
+    if (use_mmap && (ctx.source.data() || ctx.source.open(path))) {
+        scan_in_place(ctx.scanner, ctx.source.data(), ctx.source.size());
+        yyparse(ctx.scanner);
+        return ctx.error.empty() && ctx.flat.has_root();
+    }
+
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        ctx.report("I can't open file!");
+        return false;
+    }
+    scan_file(ctx.scanner, in);
+    yyparse(ctx.scanner);
+    fclose(in);
+    return ctx.error.empty() && ctx.flat.has_root();
+}
+
+// the tree of path, from the cache if it is there: then saved holds it
+// and ctx is left unused, otherwise the file is parsed into ctx and the
+// new tree is stored
+static bool load_or_parse(ParseContext& ctx, FlatFile& saved, const char* path,
+                          bool use_mmap, ParseCache* cache) {
+    if (!cache)
+        return parse_file(ctx, path, use_mmap);
+    CacheKey key(ctx.fold ? "--fold" : "");
+    if (use_mmap && ctx.source.open(path)) {
+        key.add(ctx.source.data(), ctx.source.size());
+    } else if (!key.add_file(path)) {
+        ctx.report("I can't open file!");
+        return false;
+    }
+    if (cache->lookup(key, saved))
+        return true;
+    if (!parse_file(ctx, path, use_mmap))
+        return false;
+    cache->store(key, ctx.flat.view());
+    return true;
+}
+
+// parses path on jobs threads: the scanner alone cuts its declarations
+// and the statements of its body apart, pieces of them are parsed each by
+// a parser of its own and their trees are copied into ctx.flat in order.
+// A program with errors is parsed again as a whole, for the messages a
+// whole parse gives
+static bool parse_split(ParseContext& ctx, const char* path, bool use_mmap, unsigned jobs) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        ctx.report("I can't open file!");
+        return false;
+    }
+    ostringstream text;
+    text << in.rdbuf();
+    string source = text.str();
+    Document doc(ctx.fold);
+    {
+        ThreadPool pool(jobs);
+        // a few pieces a thread, so one long procedure leaves no thread idle
+        doc.set(source, pool, source.size() / (4 * jobs) + 1);
+    }
+    if (doc.tree(ctx.flat))
+        return true;
+    ctx.flat.clear();
+    return parse_file(ctx, path, use_mmap);
+}
+
+static bool is_directory(const string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static bool has_suffix(const string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// every .pcat file below dir, in a stable order
+static void collect(const string& dir, vector<string>& files) {
+    DIR* d = opendir(dir.c_str());
+    if (!d)
+        return;
+    vector<string> entries;
+    while (struct dirent* e = readdir(d)) {
+        if (strcmp(e->d_name, ".") && strcmp(e->d_name, ".."))
+            entries.push_back(dir + (has_suffix(dir, "/") ? "" : "/") + e->d_name);
+    }
+    closedir(d);
+    sort(entries.begin(), entries.end());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (is_directory(entries[i]))
+            collect(entries[i], files);
+        else if (has_suffix(entries[i], ".pcat"))
+            files.push_back(entries[i]);
+    }
+}
+
+static off_t file_size(const string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+// the first syntax error of a failed parse and how many more there are
+static string parse_problems(const ParseContext& ctx) {
+    if (ctx.errors.empty())
+        return "incomplete program";
+    if (ctx.errors.size() == 1)
+        return ctx.error;
+    return ctx.error + " (and " + to_string(ctx.errors.size() - 1) + " more)";
+}
+
+// the first thing the semantic checks find wrong in tree, empty if nothing
+static string first_problem(const FlatView& tree) {
+    Checker checker;
+    if (checker.check(tree))
+        return "";
+    const vector<string>& d = checker.diagnostics();
+    if (d.size() == 1)
+        return d[0];
+    return d[0] + " (and " + to_string(d.size() - 1) + " more)";
+}
+
+static int check_batch(const vector<string>& files, unsigned jobs, bool use_mmap,
+                       ParseCache* cache, bool check, bool fold) {
+    vector<string> errors(files.size());
+    // hand out the biggest files first so no worker ends on a long tail
+    vector<off_t> sizes(files.size());
+    vector<size_t> order(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        sizes[i] = file_size(files[i]);
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    {
+        ThreadPool pool(jobs);
+        for (size_t k = 0; k < order.size(); ++k) {
+            // no tree outlives its file: once the spellings of the files
+            // done may be most of them, let those under way finish and
+            // free them all
+            if (Interner::global().worth_sweeping()) {
+                pool.wait();
+                Interner::global().sweep();
+            }
+            size_t i = order[k];
+            pool.submit([&files, &errors, i, use_mmap, cache, check, fold] {
+                ParseContext ctx;
+                ctx.fold = fold;
+                FlatFile saved;
+                if (!load_or_parse(ctx, saved, files[i].c_str(), use_mmap, cache))
+                    errors[i] = parse_problems(ctx);
+                else if (check)
+                    errors[i] = first_problem(ctx.flat.has_root() ? ctx.flat.view()
+                                                                  : saved.view());
+            });
+        }
+        pool.wait();
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (errors[i].empty()) {
+            cout << files[i] << ": ok\n";
+        } else {
+            cout << files[i] << ": " << errors[i] << "\n";
+            ++failed;
+        }
+    }
+    cout << files.size() << " files, " << failed << " with errors" << endl;
+    return failed ? 1 : 0;
+}
+
+enum Engine { TREE, VM_ENGINE, LIST_BYTECODE, EMIT_ASM };
+
+// runs the program in tree with READ and WRITE on stdin and stdout, lists
+// its bytecode or compiles it to assembly in asm_out; the bytecode is
+// optimized at opt_level first. Each step is timed into stats, if given
+static int execute(const FlatView& tree, Engine engine, bool exec_stats, const char* asm_out,
+                   int opt_level, bool opt_stats, CompileStats* stats) {
+    Interpreter interp;
+    string error;
+    PhaseTimer lowering_time(stats, "lower");
+    if (!interp.compile(tree, error)) {
+        cerr << error << endl;
+        return -1;
+    }
+    lowering_time.stop();
+    Module module;
+    if (engine != TREE) {
+        PhaseTimer bytecode_time(stats, "bytecode");
+        BytecodeCompiler lowering;
+        if (!lowering.compile(interp.program(), module, error)) {
+            cerr << error << endl;
+            return -1;
+        }
+        bytecode_time.stop();
+        if (opt_level > 0) {
+            PhaseTimer optimize_time(stats, "optimize");
+            Optimizer optimizer;
+            if (!optimizer.optimize(module, opt_level, error)) {
+                cerr << error << endl;
+                return -1;
+            }
+            optimize_time.stop();
+            if (opt_stats)
+                optimizer.print_stats(stderr);
+        }
+        if (engine == LIST_BYTECODE) {
+            PhaseTimer print_time(stats, "print");
+            module.print(stdout);
+            return 0;
+        }
+        if (engine == EMIT_ASM) {
+            PhaseTimer codegen_time(stats, "codegen");
+            X86Backend backend;
+            string text;
+            if (!backend.compile(module, text, error)) {
+                cerr << error << endl;
+                return -1;
+            }
+            FILE* f = fopen(asm_out, "w");
+            if (!f || fwrite(text.data(), 1, text.size(), f) != text.size() || fclose(f)) {
+                cout << asm_out << ": can't write" << endl;
+                return -1;
+            }
+            return 0;
+        }
+    }
+    VM vm;
+    PhaseTimer run_time(stats, "run");
+    bool ok = engine == TREE ? interp.run(error) : vm.run(module, error);
+    double seconds = run_time.elapsed();
+    run_time.stop();
+    if (!ok)
+        cerr << "runtime error: " << error << endl;
+    if (exec_stats) {
+        unsigned long long count = engine == TREE ? interp.statements() : vm.instructions();
+        const char* what = engine == TREE ? "statements" : "instructions";
+        cerr << count << " " << what << " in " << seconds << " s ("
+             << (unsigned long long)(seconds > 0 ? count / seconds : 0)
+             << " " << what << "/sec), "
+             << (engine == TREE ? interp.heap_bytes() : vm.heap_bytes())
+             << " bytes of records and arrays" << endl;
+    }
+    return ok ? 0 : 1;
+}
+
+// prints every problem the semantic checks find in tree; with check_stats,
+// on stderr, how much was resolved and how fast
+static int check_program(const FlatView& tree, bool check_stats, CompileStats* stats) {
+    Checker checker;
+    PhaseTimer check_time(stats, "check");
+    bool ok = checker.check(tree);
+    double seconds = check_time.elapsed();
+    check_time.stop();
+    const vector<string>& d = checker.diagnostics();
+    for (size_t i = 0; i < d.size(); ++i)
+        cout << d[i] << "\n";
+    if (check_stats) {
+        cerr << tree.nodes << " nodes, " << checker.names_resolved() << " names resolved, "
+             << checker.types_declared() << " types in " << seconds << " s ("
+             << (unsigned long long)(seconds > 0 ? tree.nodes / seconds : 0)
+             << " nodes/sec)" << endl;
+    }
+    return ok ? 0 : 1;
+}
+
+// runs only the scanner over path: prints every token as "ln:col code
+// text", where the input ends and then the lexical errors; with stats
+// only, on stderr, how fast it went
+static int scan_tokens(const char* path, bool use_mmap, bool stats) {
+    ParseContext ctx;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    FILE* in = NULL;
+    if (use_mmap && ctx.source.open(path)) {
+        scan_in_place(ctx.scanner, ctx.source.data(), ctx.source.size());
+    } else if ((in = fopen(path, "r")) != NULL) {
+        scan_file(ctx.scanner, in);
+    } else {
+        cout << "I can't open file!" << endl;
+        return -1;
+    }
+    unsigned long long tokens = 0;
+    SemValue value;
+    int code;
+    while ((code = yylex(&value, ctx.scanner)) != 0) {
+        ++tokens;
+        if (!stats) {
+            cout << ctx.tok_ln << ":" << ctx.tok_col << " " << code << " "
+                 << yyget_text(ctx.scanner) << "\n";
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (in)
+        fclose(in);
+    if (stats) {
+        off_t bytes = file_size(path);
+        cerr << bytes << " bytes, " << tokens << " tokens in " << seconds << " s ("
+             << (seconds > 0 ? bytes / seconds / 1e6 : 0) << " MB/s)" << endl;
+    } else {
+        cout << ctx.tok_ln << ":" << ctx.tok_col << " 0\n";
+        for (size_t i = 0; i < ctx.errors.size(); ++i)
+            cout << ctx.errors[i] << "\n";
+        cout << flush;
+    }
+    return ctx.errors.empty() ? 0 : 1;
+}
+
+// how long the scanner takes over path without the parser, which calls
+// it token by token so its share can't be timed from there; counts the
+// tokens. A second pass: the spellings are interned already, the input may
+// be cached
+static double time_scanner(const char* path, bool use_mmap, unsigned long long& tokens) {
+    ParseContext ctx;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    FILE* in = NULL;
+    if (use_mmap && ctx.source.open(path))
+        scan_in_place(ctx.scanner, ctx.source.data(), ctx.source.size());
+    else if ((in = fopen(path, "r")) != NULL)
+        scan_file(ctx.scanner, in);
+    else
+        return 0;
+    SemValue value;
+    while (yylex(&value, ctx.scanner) != 0)
+        ++tokens;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (in)
+        fclose(in);
+    return seconds;
+}
+
+// prints the tree of path as it is parsed, each declaration and statement
+// of the program's body as soon as it is complete; the output is the same
+// as when the whole tree is printed at the end, up to the first error.
+// The input is read through stdio, in blocks, not mapped: mapped pages
+// that have been scanned stay resident until the end of the file
+static int stream_file(const char* path, bool fold) {
+    ParseContext ctx;
+    ctx.fold = fold;
+    Dumper out(stdout);
+    bool decls = false;
+    bool stats = false;
+    ctx.stream = [&](StreamItem what, const FlatView& tree, unsigned n) {
+        if (!decls) {
+            out.line(0, "program");
+            out.line(2, "body");
+            out.line(4, "declarations");
+            decls = true;
+        }
+        if (what == STREAM_STAT && !stats) {
+            out.line(4, "statements");
+            stats = true;
+        }
+        dump_flat(tree, n, out, 6);
+    };
+    if (!parse_file(ctx, path, false)) {
+        out.flush();
+        for (size_t i = 0; i < ctx.errors.size(); ++i)
+            cout << ctx.errors[i] << endl;
+        return -1;
+    }
+    if (!decls) {
+        out.line(0, "program");
+        out.line(2, "body");
+        out.line(4, "declarations");
+    }
+    if (!stats)
+        out.line(4, "statements");
+    return 0;
+}
+
+// --serve: reads commands from stdin, one per line, and answers each on
+// stdout, ending the answer with a line "ok ..." or "error ...":
+//   open PATH          reads PATH, which later commands are about
+//   reload             reads it again
+//   text N             the next N bytes are its whole new text
+//   edit L1 C1 L2 C2 N the next N bytes replace L1:C1 up to L2:C2, lines
+//                      and byte columns from 1
+//   diagnostics        prints its parse errors
+//   outline            prints "ln:col kind name" for every declared name,
+//                      indented by how deep in procedures it is
+//   tree               prints its tree, or its parse errors
+//   quit
+// The "ok" line says how many units the text has, how many were parsed
+// for the command and how long it took
+static int serve() {
+    Document doc;
+    string path;
+    string line;
+    while (getline(cin, line)) {
+        istringstream words(line);
+        string command;
+        words >> command;
+        if (command.empty())
+            continue;
+        if (command == "quit")
+            break;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        size_t parses = doc.parses();
+        string problem;
+        if (command == "open" || command == "reload") {
+            if (command == "open")
+                words >> path;
+            ifstream in(path.c_str(), ios::binary);
+            if (path.empty() || !in) {
+                problem = "can't open " + path;
+            } else {
+                ostringstream text;
+                text << in.rdbuf();
+                doc.set(text.str());
+            }
+        } else if (command == "text" || command == "edit") {
+            int l1 = 0, c1 = 0, l2 = 0, c2 = 0;
+            size_t n = 0;
+            if (command == "edit")
+                words >> l1 >> c1 >> l2 >> c2;
+            words >> n;
+            string text(n, '\0');
+            if (!words || !cin.read(&text[0], n)) {
+                problem = "bad " + command;
+            } else if (command == "text") {
+                doc.update(text);
+            } else {
+                doc.replace(doc.offset(l1, c1), doc.offset(l2, c2), text);
+            }
+        } else if (command == "diagnostics") {
+            vector<string> errors = doc.diagnostics();
+            for (size_t i = 0; i < errors.size(); ++i)
+                cout << errors[i] << "\n";
+        } else if (command == "outline") {
+            vector<Document::Symbol> symbols = doc.outline();
+            for (size_t i = 0; i < symbols.size(); ++i) {
+                const Document::Symbol& s = symbols[i];
+                cout << string(2 * s.level, ' ') << s.ln << ":" << s.col << " "
+                     << (s.kind == KW_VAR ? "var" : s.kind == KW_TYPE ? "type" : "procedure")
+                     << " " << s.name << "\n";
+            }
+        } else if (command == "tree") {
+            vector<string> errors = doc.diagnostics();
+            for (size_t i = 0; i < errors.size(); ++i)
+                cout << errors[i] << "\n";
+            if (errors.empty()) {
+                cout << flush;
+                Dumper out(stdout);
+                doc.dump(out);
+            }
+        } else {
+            problem = "unknown command " + command;
+        }
+        // the spellings of text edited away, once they may be most of them
+        Interner& names = Interner::global();
+        if (names.worth_sweeping()) {
+            doc.keep_names(names);
+            names.sweep();
+        }
+        fflush(stdout);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (!problem.empty())
+            cout << "error " << problem << endl;
+        else
+            cout << "ok " << doc.unit_count() << " units, " << doc.parses() - parses
+                 << " parsed, " << doc.diagnostics().size() << " errors, " << ms << " ms"
+                 << endl;
+    }
+    return 0;
+}
+
+// prints the tree of one file, saves it to emit_ast, checks it or runs it;
+// with stats, times every phase and counts what the parse made
+static int compile(const char* path, bool use_mmap, ParseCache* cache,
+                   const char* emit_ast, bool use_tree, bool run, Engine engine,
+                   bool exec_stats, const char* asm_out, int opt_level, bool opt_stats,
+                   bool check, bool check_stats, unsigned parse_jobs, bool fold,
+                   CompileStats* stats) {
+    ParseContext ctx;
+    ctx.build_tree = use_tree;
+    ctx.fold = fold;
+    FlatFile saved;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool parsed = parse_jobs ? parse_split(ctx, path, use_mmap, parse_jobs)
+                             : load_or_parse(ctx, saved, path, use_mmap, cache);
+    if (stats) {
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        // nothing was scanned if the tree came from the cache
+        bool scanned = ctx.flat.has_root() || !parsed;
+        stats->add_parse(seconds, scanned ? time_scanner(path, use_mmap, stats->tokens) : 0);
+        stats->file = path;
+        stats->input_bytes = file_size(path);
+        stats->count_nodes(scanned ? ctx.flat.view() : saved.view());
+        stats->tree_bytes = ctx.flat.bytes();
+        stats->arena_bytes = ctx.arena.bytes_allocated();
+        stats->symbol_bytes = Interner::global().bytes();
+    }
+    if (!parsed) {
+        for (size_t i = 0; i < ctx.errors.size(); ++i)
+            cout << ctx.errors[i] << endl;
+        return -1;
+    }
+    // a cache hit leaves ctx empty
+    FlatView tree = ctx.flat.has_root() ? ctx.flat.view() : saved.view();
+    if (emit_ast) {
+        PhaseTimer save_time(stats, "save");
+        if (!save_flat(tree, emit_ast)) {
+            cout << emit_ast << ": can't write" << endl;
+            return -1;
+        }
+        return 0;
+    }
+    if (check)
+        return check_program(tree, check_stats, stats);
+    if (run)
+        return execute(tree, engine, exec_stats, asm_out, opt_level, opt_stats, stats);
+    PhaseTimer print_time(stats, "print");
+    if (ctx.program) {
+        ctx.program->print(0);
+    } else {
+        Dumper out(stdout);
+        dump_flat(tree, out);
+    }
+    return 0;
+}
+
+static void usage() {
+    cout << "usage: main [--no-mmap] [--cache dir] [--tree] file\n"
+            "       main [--no-mmap] [--cache dir] [-j N] [--check] file|dir...\n"
+            "       main [--no-mmap] [--cache dir] --check [--check-stats] file\n"
+            "       main [--no-mmap] --emit-ast out.ast file\n"
+            "       main [--no-mmap] [--cache dir] --run [--vm] [--exec-stats] file\n"
+            "       main [--no-mmap] [--cache dir] [-O0|-O1|-O2] [--opt-stats] --vm file\n"
+            "       main [--no-mmap] [--cache dir] [-O0|-O1|-O2] [--opt-stats] --bytecode file\n"
+            "       main [--no-mmap] [--cache dir] [-O0|-O1|-O2] --emit-asm out.s file\n"
+            "       main [--no-mmap] --tokens|--scan-stats file\n"
+            "       main [--no-mmap] --stream file\n"
+            "       main --fold [options of a file] file...\n"
+            "       main [-j N] --parallel [options of a single file] file\n"
+            "       main [--stats] [--stats-json out.json] [options of a single file] file\n"
+            "       main --load-ast file.ast\n"
+            "       main --serve" << endl;
+}
+
+int main(int argc, char** argv) {
+    vector<string> inputs;
+    bool use_mmap = true;
+    bool batch = false;
+    unsigned jobs = thread::hardware_concurrency();
+    const char* emit_ast = NULL;
+    const char* load_ast = NULL;
+    const char* cache_dir = NULL;
+    bool use_tree = false;
+    bool run = false;
+    bool exec_stats = false;
+    Engine engine = TREE;
+    const char* asm_out = NULL;
+    int opt_level = 0;
+    bool opt_stats = false;
+    bool check = false;
+    bool check_stats = false;
+    bool tokens = false;
+    bool scan_stats = false;
+    bool stream = false;
+    bool print_stats = false;
+    const char* stats_json = NULL;
+    bool serving = false;
+    bool parallel = false;
+    bool fold = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--no-mmap")) {
+            use_mmap = false;
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+            batch = true;
+        } else if (!strcmp(argv[i], "--emit-ast") && i + 1 < argc) {
+            emit_ast = argv[++i];
+        } else if (!strcmp(argv[i], "--load-ast") && i + 1 < argc) {
+            load_ast = argv[++i];
+        } else if (!strcmp(argv[i], "--tree")) {
+            use_tree = true;
+        } else if (!strcmp(argv[i], "--run")) {
+            run = true;
+        } else if (!strcmp(argv[i], "--exec-stats")) {
+            run = exec_stats = true;
+        } else if (!strcmp(argv[i], "--vm")) {
+            run = true;
+            engine = VM_ENGINE;
+        } else if (!strcmp(argv[i], "--bytecode")) {
+            run = true;
+            engine = LIST_BYTECODE;
+        } else if (!strcmp(argv[i], "--emit-asm") && i + 1 < argc) {
+            run = true;
+            engine = EMIT_ASM;
+            asm_out = argv[++i];
+        } else if (!strcmp(argv[i], "-O")) {
+            opt_level = 2;
+        } else if (argv[i][0] == '-' && argv[i][1] == 'O' && argv[i][2] >= '0' &&
+                   argv[i][2] <= '2' && !argv[i][3]) {
+            opt_level = argv[i][2] - '0';
+        } else if (!strcmp(argv[i], "--opt-stats")) {
+            opt_stats = true;
+        } else if (!strcmp(argv[i], "--check")) {
+            check = true;
+        } else if (!strcmp(argv[i], "--check-stats")) {
+            check = check_stats = true;
+        } else if (!strcmp(argv[i], "--tokens")) {
+            tokens = true;
+        } else if (!strcmp(argv[i], "--scan-stats")) {
+            tokens = scan_stats = true;
+        } else if (!strcmp(argv[i], "--stream")) {
+            stream = true;
+        } else if (!strcmp(argv[i], "--stats")) {
+            print_stats = true;
+        } else if (!strcmp(argv[i], "--stats-json") && i + 1 < argc) {
+            stats_json = argv[++i];
+        } else if (!strcmp(argv[i], "--parallel")) {
+            parallel = true;
+        } else if (!strcmp(argv[i], "--fold")) {
+            fold = true;
+        } else if (!strcmp(argv[i], "--serve")) {
+            serving = true;
+        } else if (!strcmp(argv[i], "--cache") && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (argv[i][0] == '-' && argv[i][1]) {
+            usage();
+            return -1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+    if (load_ast) {
+        FlatFile saved;
+        if (!saved.open(load_ast)) {
+            cout << load_ast << ": not a saved syntax tree" << endl;
+            return -1;
+        }
+        Dumper out(stdout);
+        dump_flat(saved.view(), out);
+        return 0;
+    }
+    if (serving) {
+        // files come by command
+        if (!inputs.empty()) {
+            usage();
+            return -1;
+        }
+        return serve();
+    }
+    if (inputs.empty()) {
+        cout << "Need a file" << endl;
+        return -1;
+    }
+
+    vector<string> files;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (is_directory(inputs[i])) {
+            collect(inputs[i], files);
+            batch = true;
+        } else {
+            files.push_back(inputs[i]);
+        }
+    }
+    if (files.size() > 1)
+        batch = true;
+    if (parallel) {
+        // one file on -j threads, into the flat tree only
+        if (files.size() > 1 || is_directory(inputs[0]) || use_tree || cache_dir || stream) {
+            usage();
+            return -1;
+        }
+        batch = false;
+    }
+    bool keep_stats = print_stats || stats_json;
+    if (batch && (emit_ast || run || check_stats || tokens || keep_stats)) {
+        usage();
+        return -1;
+    }
+    if (keep_stats && (tokens || stream)) {
+        usage();
+        return -1;
+    }
+    if (tokens)
+        return scan_tokens(files[0].c_str(), use_mmap, scan_stats);
+    if (stream) {
+        // nothing but the printed tree is kept
+        if (batch || emit_ast || run || check || use_tree || cache_dir) {
+            usage();
+            return -1;
+        }
+        return stream_file(files[0].c_str(), fold);
+    }
+    ParseCache* cache = NULL;
+    if (cache_dir) {
+        cache = new ParseCache(cache_dir);
+        if (!cache->open()) {
+            cout << cache_dir << ": can't use as a cache directory" << endl;
+            return -1;
+        }
+    }
+    CompileStats stats;
+    int status = batch ? check_batch(files, jobs, use_mmap, cache, check, fold)
+                       : compile(files[0].c_str(), use_mmap, cache, emit_ast, use_tree,
+                                 run, engine, exec_stats, asm_out, opt_level, opt_stats,
+                                 check, check_stats, parallel ? max(jobs, 1u) : 0, fold,
+                                 keep_stats ? &stats : NULL);
+    if (keep_stats) {
+        fflush(stdout);
+        stats.measure_rss();
+        if (print_stats)
+            stats.print(stderr);
+        FILE* f = stats_json ? fopen(stats_json, "w") : NULL;
+        if (f) {
+            stats.print_json(f);
+            fclose(f);
+        } else if (stats_json) {
+            cout << stats_json << ": can't write" << endl;
+            status = -1;
+        }
+    }
+    if (cache) {
+        // on stderr so the tree printed on stdout stays the same
+        cerr << "cache: " << cache->hit_count() << " hits, "
+             << cache->miss_count() << " misses" << endl;
+        delete cache;
+    }
+    return status;
+}
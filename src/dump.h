@@ -0,0 +1,80 @@
+// buffered writer for the tree dump: lines are assembled in one growable
+// buffer, indentation is copied out of a run of blanks, and the text is
+// handed to the output in large blocks instead of being flushed per line
+#ifndef DUMP_H
+#define DUMP_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "intern.h"
+#include "source.h"
+
+class Dumper {
+    std::string buf;
+    FILE* sink;    // NULL: everything stays in memory, see str()
+
+    static const size_t block = 1 << 16;
+
+    void append(const char* s, size_t n) {
+        buf.append(s, n);
+    }
+public:
+    explicit Dumper(FILE* _sink = NULL) : sink(_sink) {
+        buf.reserve(sink ? 2 * block : block);
+    }
+
+    ~Dumper() {
+        flush();
+    }
+
+    Dumper& indent(int n) {
+        static const char blanks[] =
+            "                                                                ";
+        const int width = sizeof(blanks) - 1;
+        for (; n > width; n -= width)
+            append(blanks, width);
+        append(blanks, n);
+        return *this;
+    }
+
+    // an indented line holding just text
+    Dumper& line(int n, const char* text) {
+        return indent(n) << text << '\n';
+    }
+
+    Dumper& operator<< (const char* s) {
+        append(s, strlen(s));
+        return *this;
+    }
+
+    Dumper& operator<< (Symbol s) {
+        append(s.c_str(), s.size());
+        return *this;
+    }
+
+    Dumper& operator<< (Text t) {
+        append(t.ptr, t.len);
+        return *this;
+    }
+
+    Dumper& operator<< (char c) {
+        buf.push_back(c);
+        if (c == '\n' && sink && buf.size() >= block)
+            flush();
+        return *this;
+    }
+
+    void flush() {
+        if (sink && !buf.empty()) {
+            fwrite(buf.data(), 1, buf.size(), sink);
+            buf.clear();
+        }
+    }
+
+    const std::string& str() const {
+        return buf;
+    }
+};
+
+#endif
@@ -0,0 +1,799 @@
+// flat form of the syntax tree: node kinds, payloads and child ranges in
+// parallel arrays, children referred to by index, every spelling stored
+// once in a string table. The same layout is written to disk, so a saved
+// tree is loaded with one mmap and used in place without any fixups.
+#ifndef FLAT_H
+#define FLAT_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "constant.h"
+#include "intern.h"
+#include "source.h"
+
+// one per concrete syntax tree class; the comment lists the children
+enum NodeKind {
+    N_LIST,             // elements of a Multi<T>, in source order
+    N_ID,               // value: string
+    N_NUMBER,           // value: string (the spelling)
+    N_STRING,           // value: string (with the quotes)
+    N_OP,               // value: string
+    N_PROGRAM,          // body
+    N_BODY,             // decls, stats
+    N_DECL,             // block; value: DECL_VAR, DECL_TYPE or DECL_PROCEDURE
+    N_VAR_DECL,         // ids, type?, expr
+    N_TYPE_DECL,        // id, type
+    N_PROC_DECL,        // id, fpsecs?, type?, body
+    N_FPSEC,            // ids, type
+    N_COMPONENT,        // id, type
+    N_USER_TYPE,        // id
+    N_BUILTIN_TYPE,     // value: string
+    N_ARRAY_TYPE,       // elem_type
+    N_RECORD_TYPE,      // components
+    N_ASSIGN_STAT,      // lvalue, expr
+    N_CALL_STAT,        // id, params?
+    N_READ_STAT,        // lvalues
+    N_WRITE_STAT,       // write_params?
+    N_IF_STAT,          // cond, then, elseifs, else?
+    N_ELSE_IF,          // cond, then
+    N_WHILE_STAT,       // cond, body
+    N_LOOP_STAT,        // body
+    N_FOR_STAT,         // id, from, to, by?, body
+    N_EXIT_STAT,        //
+    N_RETURN_STAT,      // val?
+    N_ID_LVALUE,        // id
+    N_ARRAY_LVALUE,     // lval, index
+    N_RECORD_LVALUE,    // lval, id
+    N_NUMBER_EXPR,      // number; value: its Literal
+    N_LVALUE_EXPR,      // lval
+    N_UNARY_EXPR,       // op, expr
+    N_BINOP_EXPR,       // left, op, right
+    N_CALL_EXPR,        // id, params?
+    N_RECORD_EXPR,      // id, comp_values
+    N_ARRAY_EXPR,       // id, array_values
+    N_COMP_VALUE,       // id, expr
+    N_SIMPLE_ARRAY_VALUE, // expr
+    N_OF_ARRAY_VALUE,   // count, value
+    N_STR_WRITE_EXPR,   // string
+    N_EXPR_WRITE_EXPR,  // expr
+    N_KINDS
+};
+
+enum DeclSort { DECL_VAR, DECL_TYPE, DECL_PROCEDURE };
+
+// kinds whose value is an index into the string table
+inline bool has_text(NodeKind k) {
+    return k == N_ID || k == N_NUMBER || k == N_STRING || k == N_OP
+           || k == N_BUILTIN_TYPE;
+}
+
+// whether its text is a literal's spelling, kept in the tree alone, rather
+// than an interned name
+inline bool is_literal(NodeKind k) {
+    return k == N_NUMBER || k == N_STRING;
+}
+
+// the syntax tree class a kind stands for
+inline const char* kind_name(NodeKind k) {
+    static const char* const names[N_KINDS] = {
+        "Multi", "Id", "Number", "String", "Op", "Program", "Body", "Decl",
+        "VarDecl", "TypeDecl", "ProcDecl", "FPSec", "Component", "UserType",
+        "BuiltinType", "ArrayType", "RecordType", "AssignStat", "CallStat",
+        "ReadStat", "WriteStat", "IfStat", "ElseIf", "WhileStat", "LoopStat",
+        "ForStat", "ExitStat", "ReturnStat", "IdLvalue", "ArrayLvalue",
+        "RecordLvalue", "NumberExpr", "LvalueExpr", "UnaryOpExpr", "BinOpExpr",
+        "CallExpr", "RecordExpr", "ArrayExpr", "CompValue", "SimpleArrayValue",
+        "OfArrayValue", "StrWriteExpr", "ExprWriteExpr"
+    };
+    return names[k];
+}
+
+// what a node stands for where its parent refers to it; a child slot
+// holds a node of that role, or with ROLE_LIST an N_LIST of them, and
+// with ROLE_OPTIONAL it may be absent
+enum Role {
+    ROLE_NONE, ROLE_PROGRAM, ROLE_BODY, ROLE_DECL,
+    ROLE_DECL_ITEM,     // of a DECL: the role its value says, one of the next three
+    ROLE_VAR_DECL, ROLE_TYPE_DECL, ROLE_PROC_DECL,
+    ROLE_FPSEC, ROLE_COMPONENT, ROLE_TYPE, ROLE_STAT, ROLE_ELSE_IF, ROLE_LVALUE,
+    ROLE_EXPR, ROLE_COMP_VALUE, ROLE_ARRAY_VALUE, ROLE_WRITE_EXPR, ROLE_ID,
+    ROLE_NUMBER, ROLE_STRING, ROLE_OP,
+    ROLE_LIST = 0x40,
+    ROLE_OPTIONAL = 0x80
+};
+
+// a kind's role and its children, as the grammar builds them
+struct KindShape {
+    unsigned char role;
+    unsigned char children;
+    unsigned char slot[5];
+};
+
+inline const KindShape& kind_shape(NodeKind k) {
+    enum { L = ROLE_LIST, O = ROLE_OPTIONAL };
+    static const KindShape shapes[N_KINDS] = {
+        { ROLE_NONE, 0, {} },   // N_LIST: its parent's slot says of what
+        { ROLE_ID, 0, {} },
+        { ROLE_NUMBER, 0, {} },
+        { ROLE_STRING, 0, {} },
+        { ROLE_OP, 0, {} },
+        { ROLE_PROGRAM, 1, { ROLE_BODY } },
+        { ROLE_BODY, 2, { L|ROLE_DECL, L|ROLE_STAT } },
+        { ROLE_DECL, 1, { L|ROLE_DECL_ITEM } },
+        { ROLE_VAR_DECL, 3, { L|ROLE_ID, O|ROLE_TYPE, ROLE_EXPR } },
+        { ROLE_TYPE_DECL, 2, { ROLE_ID, ROLE_TYPE } },
+        { ROLE_PROC_DECL, 4, { ROLE_ID, O|L|ROLE_FPSEC, O|ROLE_TYPE, ROLE_BODY } },
+        { ROLE_FPSEC, 2, { L|ROLE_ID, ROLE_TYPE } },
+        { ROLE_COMPONENT, 2, { ROLE_ID, ROLE_TYPE } },
+        { ROLE_TYPE, 1, { ROLE_ID } },
+        { ROLE_TYPE, 0, {} },
+        { ROLE_TYPE, 1, { ROLE_TYPE } },
+        { ROLE_TYPE, 1, { L|ROLE_COMPONENT } },
+        { ROLE_STAT, 2, { ROLE_LVALUE, ROLE_EXPR } },
+        { ROLE_STAT, 2, { ROLE_ID, O|L|ROLE_EXPR } },
+        { ROLE_STAT, 1, { L|ROLE_LVALUE } },
+        { ROLE_STAT, 1, { O|L|ROLE_WRITE_EXPR } },
+        { ROLE_STAT, 4, { ROLE_EXPR, L|ROLE_STAT, L|ROLE_ELSE_IF, O|L|ROLE_STAT } },
+        { ROLE_ELSE_IF, 2, { ROLE_EXPR, L|ROLE_STAT } },
+        { ROLE_STAT, 2, { ROLE_EXPR, L|ROLE_STAT } },
+        { ROLE_STAT, 1, { L|ROLE_STAT } },
+        { ROLE_STAT, 5, { ROLE_ID, ROLE_EXPR, ROLE_EXPR, O|ROLE_EXPR, L|ROLE_STAT } },
+        { ROLE_STAT, 0, {} },
+        { ROLE_STAT, 1, { O|ROLE_EXPR } },
+        { ROLE_LVALUE, 1, { ROLE_ID } },
+        { ROLE_LVALUE, 2, { ROLE_LVALUE, ROLE_EXPR } },
+        { ROLE_LVALUE, 2, { ROLE_LVALUE, ROLE_ID } },
+        { ROLE_EXPR, 1, { ROLE_NUMBER } },
+        { ROLE_EXPR, 1, { ROLE_LVALUE } },
+        { ROLE_EXPR, 2, { ROLE_OP, ROLE_EXPR } },
+        { ROLE_EXPR, 3, { ROLE_EXPR, ROLE_OP, ROLE_EXPR } },
+        { ROLE_EXPR, 2, { ROLE_ID, O|L|ROLE_EXPR } },
+        { ROLE_EXPR, 2, { ROLE_ID, L|ROLE_COMP_VALUE } },
+        { ROLE_EXPR, 2, { ROLE_ID, L|ROLE_ARRAY_VALUE } },
+        { ROLE_COMP_VALUE, 2, { ROLE_ID, ROLE_EXPR } },
+        { ROLE_ARRAY_VALUE, 1, { ROLE_EXPR } },
+        { ROLE_ARRAY_VALUE, 2, { ROLE_EXPR, ROLE_EXPR } },
+        { ROLE_WRITE_EXPR, 1, { ROLE_STRING } },
+        { ROLE_WRITE_EXPR, 1, { ROLE_EXPR } }
+    };
+    return shapes[k];
+}
+
+// marks an absent optional child
+const unsigned NO_NODE = 0xffffffffu;
+
+// where a node's first token starts; ln 0 if it has none, like an empty list
+struct SourcePos {
+    unsigned ln;
+    unsigned col;
+};
+
+// read-only access to a flat tree, whether built in memory or mapped
+struct FlatView {
+    const unsigned char* kind;
+    const unsigned* value;
+    const unsigned* first;   // first child, index into kids
+    const unsigned* count;   // number of children
+    const unsigned* kids;
+    const unsigned* str_offset;  // string i is text[str_offset[i]..str_offset[i+1]-1)
+    const char* text;
+    const Literal* literals;     // the values of the numbers
+    const SourcePos* pos;
+    unsigned nodes;
+    unsigned strings;
+    unsigned literal_count;
+    unsigned root;
+
+    NodeKind kind_of(unsigned n) const {
+        return (NodeKind)kind[n];
+    }
+
+    unsigned children(unsigned n) const {
+        return count[n];
+    }
+
+    unsigned child(unsigned n, unsigned i) const {
+        return kids[first[n] + i];
+    }
+
+    Text str(unsigned s) const {
+        return Text(text + str_offset[s], str_offset[s+1] - str_offset[s] - 1);
+    }
+
+    // the spelling carried by an id, number, string, operator or type name
+    Text text_of(unsigned n) const {
+        return str(value[n]);
+    }
+
+    // the value of a number expression
+    const Literal& number(unsigned n) const {
+        return literals[value[n]];
+    }
+
+    const SourcePos& pos_of(unsigned n) const {
+        return pos[n];
+    }
+};
+
+// a flat tree under construction; nodes are added children first, so a
+// node's index is always greater than its children's
+class FlatAst {
+    std::vector<unsigned char> kind;
+    std::vector<unsigned> value;
+    std::vector<unsigned> first;
+    std::vector<unsigned> count;
+    std::vector<unsigned> kids;
+    std::vector<unsigned> str_offset;
+    std::string text;
+    std::vector<Literal> literals;
+    std::vector<SourcePos> pos;
+    std::unordered_map<Symbol, unsigned> str_index;
+    std::vector<Symbol> names;  // the keys of str_index, in the order added
+    std::vector<std::vector<unsigned> > lists;  // open lists, see open_list
+    std::vector<unsigned> free_lists;
+    unsigned root;
+public:
+    FlatAst() : str_offset(1, 0), root(NO_NODE) {}
+
+    // a node starts where its first child with a position does
+    unsigned add_array(NodeKind k, unsigned val, const unsigned* children, unsigned n) {
+        kind.push_back((unsigned char)k);
+        value.push_back(val);
+        first.push_back((unsigned)kids.size());
+        count.push_back(n);
+        kids.insert(kids.end(), children, children + n);
+        SourcePos where = { 0, 0 };
+        for (unsigned i = 0; i < n && !where.ln; ++i)
+            if (children[i] != NO_NODE)
+                where = pos[children[i]];
+        pos.push_back(where);
+        return (unsigned)kind.size() - 1;
+    }
+
+    unsigned add(NodeKind k, unsigned val = 0) {
+        return add_array(k, val, NULL, 0);
+    }
+
+    // a node's position, for a token's leaf or a node that starts with a
+    // keyword; returns n
+    unsigned set_pos(unsigned n, int ln, int col) {
+        pos[n].ln = (unsigned)ln;
+        pos[n].col = (unsigned)col;
+        return n;
+    }
+
+    unsigned add(NodeKind k, unsigned val, unsigned c0) {
+        return add_array(k, val, &c0, 1);
+    }
+
+    unsigned add(NodeKind k, unsigned val, unsigned c0, unsigned c1) {
+        unsigned c[] = { c0, c1 };
+        return add_array(k, val, c, 2);
+    }
+
+    unsigned add(NodeKind k, unsigned val, unsigned c0, unsigned c1, unsigned c2) {
+        unsigned c[] = { c0, c1, c2 };
+        return add_array(k, val, c, 3);
+    }
+
+    unsigned add(NodeKind k, unsigned val, unsigned c0, unsigned c1, unsigned c2,
+                 unsigned c3) {
+        unsigned c[] = { c0, c1, c2, c3 };
+        return add_array(k, val, c, 4);
+    }
+
+    unsigned add(NodeKind k, unsigned val, unsigned c0, unsigned c1, unsigned c2,
+                 unsigned c3, unsigned c4) {
+        unsigned c[] = { c0, c1, c2, c3, c4 };
+        return add_array(k, val, c, 5);
+    }
+
+    // a list under construction: the parser collects the items of a list
+    // aside, in source order, and makes them one N_LIST node when the
+    // enclosing rule takes the list
+    unsigned open_list() {
+        if (free_lists.empty()) {
+            lists.push_back(std::vector<unsigned>());
+            return (unsigned)lists.size() - 1;
+        }
+        unsigned l = free_lists.back();
+        free_lists.pop_back();
+        return l;
+    }
+
+    void push_list(unsigned l, unsigned item) {
+        lists[l].push_back(item);
+    }
+
+    // the N_LIST node of an open list; NO_NODE stays absent
+    unsigned close_list(unsigned l) {
+        if (l == NO_NODE)
+            return NO_NODE;
+        std::vector<unsigned>& items = lists[l];
+        unsigned n = add_array(N_LIST, 0, items.data(), (unsigned)items.size());
+        items.clear();
+        free_lists.push_back(l);
+        return n;
+    }
+
+    // index of a name in the string table, added on first use
+    unsigned str(Symbol s) {
+        std::unordered_map<Symbol, unsigned>::iterator it = str_index.find(s);
+        if (it != str_index.end())
+            return it->second;
+        unsigned i = str(Text(s.c_str(), s.size()));
+        str_index[s] = i;
+        names.push_back(s);
+        return i;
+    }
+
+    // marks the names in the string table as still in use, see
+    // Interner::sweep
+    void keep_names(Interner& table) const {
+        for (size_t i = 0; i < names.size(); ++i)
+            table.keep(names[i]);
+    }
+
+    // a literal's spelling, copied into the table every time: literals
+    // are not interned, they are rarely spelled twice and never looked up
+    unsigned str(Text t) {
+        unsigned i = (unsigned)str_offset.size() - 1;
+        text.append(t.ptr, t.len);
+        text.push_back('\0');
+        str_offset.push_back((unsigned)text.size());
+        return i;
+    }
+
+    // a number expression spelled spelling at ln:col, of value k, and its
+    // leaf
+    unsigned add_number(Text spelling, const Literal& k, int ln, int col) {
+        unsigned leaf = set_pos(add(N_NUMBER, str(spelling)), ln, col);
+        literals.push_back(k);
+        return add(N_NUMBER_EXPR, (unsigned)literals.size() - 1, leaf);
+    }
+
+    const Literal& number(unsigned n) const {
+        return literals[value[n]];
+    }
+
+    // adds the first n nodes of another tree, with the strings they
+    // carry, and returns where they start here: node i there is node
+    // returned + i here. Nodes only refer to nodes before them, so the
+    // first n hold every subtree rooted among them
+    unsigned append(const FlatView& from, unsigned n) {
+        unsigned at = size();
+        unsigned kids_at = (unsigned)kids.size();
+        unsigned n_kids = n ? from.first[n - 1] + from.count[n - 1] : 0;
+        kind.insert(kind.end(), from.kind, from.kind + n);
+        count.insert(count.end(), from.count, from.count + n);
+        pos.insert(pos.end(), from.pos, from.pos + n);
+        value.resize(at + n);
+        first.resize(at + n);
+        kids.resize(kids_at + n_kids);
+        unsigned literals_at = (unsigned)literals.size();
+        literals.insert(literals.end(), from.literals, from.literals + from.literal_count);
+        std::vector<unsigned> strings(from.strings, NO_NODE);
+        for (unsigned i = 0; i < n; ++i) {
+            unsigned val = from.value[i];
+            if (has_text(from.kind_of(i))) {
+                if (strings[val] == NO_NODE) {
+                    Text t = from.str(val);
+                    strings[val] = is_literal(from.kind_of(i)) ? str(t)
+                                                               : str(intern(t.ptr, t.len));
+                }
+                val = strings[val];
+            } else if (from.kind_of(i) == N_NUMBER_EXPR) {
+                val += literals_at;
+            }
+            value[at + i] = val;
+            first[at + i] = from.first[i] + kids_at;
+        }
+        for (unsigned i = 0; i < n_kids; ++i)
+            kids[kids_at + i] = from.kids[i] == NO_NODE ? NO_NODE : from.kids[i] + at;
+        return at;
+    }
+
+    // room for nodes more nodes with kids children between them
+    void reserve(size_t nodes, size_t children) {
+        kind.reserve(kind.size() + nodes);
+        value.reserve(value.size() + nodes);
+        first.reserve(first.size() + nodes);
+        count.reserve(count.size() + nodes);
+        pos.reserve(pos.size() + nodes);
+        kids.reserve(kids.size() + children);
+    }
+
+    void set_root(unsigned n) {
+        root = n;
+    }
+
+    bool has_root() const {
+        return root != NO_NODE;
+    }
+
+    unsigned size() const {
+        return (unsigned)kind.size();
+    }
+
+    // heap memory held, counting the hash table by its nodes and buckets
+    size_t bytes() const {
+        size_t n = kind.capacity() + 4 * (value.capacity() + first.capacity()
+                   + count.capacity() + kids.capacity() + str_offset.capacity()
+                   + free_lists.capacity()) + sizeof(Symbol) * names.capacity()
+                   + sizeof(SourcePos) * pos.capacity()
+                   + text.capacity() + sizeof(Literal) * literals.capacity()
+                   + str_index.size() * (sizeof(std::pair<Symbol, unsigned>) + 2 * sizeof(void*))
+                   + str_index.bucket_count() * sizeof(void*);
+        for (size_t i = 0; i < lists.size(); ++i)
+            n += sizeof(lists[i]) + 4 * lists[i].capacity();
+        return n;
+    }
+
+    // how far the tree has grown; rewinding to it drops every node added
+    // since, with their numbers' values and the strings first used by them
+    struct Mark {
+        unsigned nodes;
+        unsigned kids;
+        unsigned literals;
+        unsigned strings;
+    };
+
+    Mark mark() const {
+        Mark m;
+        m.nodes = size();
+        m.kids = (unsigned)kids.size();
+        m.literals = (unsigned)literals.size();
+        m.strings = (unsigned)str_offset.size() - 1;
+        return m;
+    }
+
+    // how far it had grown before number expression n and its leaf; the
+    // leaf's spelling was the last string added before them, a literal is
+    // never shared
+    Mark before_number(unsigned n) const {
+        Mark m;
+        m.nodes = n - 1;
+        m.kids = first[n - 1];
+        m.literals = value[n];
+        m.strings = value[n - 1];
+        return m;
+    }
+
+    void rewind(const Mark& m) {
+        kind.resize(m.nodes);
+        value.resize(m.nodes);
+        first.resize(m.nodes);
+        count.resize(m.nodes);
+        pos.resize(m.nodes);
+        kids.resize(m.kids);
+        literals.resize(m.literals);
+        while (!names.empty() && str_index[names.back()] >= m.strings) {
+            str_index.erase(names.back());
+            names.pop_back();
+        }
+        text.resize(str_offset[m.strings]);
+        str_offset.resize(m.strings + 1);
+    }
+
+    void clear() {
+        kind.clear();
+        value.clear();
+        first.clear();
+        count.clear();
+        pos.clear();
+        kids.clear();
+        str_offset.assign(1, 0);
+        text.clear();
+        literals.clear();
+        str_index.clear();
+        names.clear();
+        for (size_t i = 0; i < lists.size(); ++i)
+            lists[i].clear();
+        free_lists.clear();
+        for (size_t i = lists.size(); i > 0; --i)
+            free_lists.push_back((unsigned)i - 1);
+        root = NO_NODE;
+    }
+
+    // valid until the next add
+    FlatView view() const {
+        FlatView v;
+        v.kind = kind.data();
+        v.value = value.data();
+        v.first = first.data();
+        v.count = count.data();
+        v.kids = kids.data();
+        v.str_offset = str_offset.data();
+        v.text = text.data();
+        v.literals = literals.data();
+        v.pos = pos.data();
+        v.nodes = size();
+        v.strings = (unsigned)str_offset.size() - 1;
+        v.literal_count = (unsigned)literals.size();
+        v.root = root;
+        return v;
+    }
+};
+
+// on-disk layout: this header, then the arrays at the given byte offsets,
+// each aligned to 8 bytes
+struct FlatHeader {
+    char magic[4];
+    unsigned version;
+    unsigned nodes;
+    unsigned kid_count;
+    unsigned strings;
+    unsigned text_bytes;
+    unsigned literal_count;
+    unsigned root;
+    unsigned kind_at;
+    unsigned value_at;
+    unsigned first_at;
+    unsigned count_at;
+    unsigned kids_at;
+    unsigned str_offset_at;
+    unsigned text_at;
+    unsigned literals_at;
+    unsigned pos_at;
+    unsigned file_size;
+    unsigned long long checksum;    // flat_checksum of the file with this 0
+};
+
+const unsigned FLAT_VERSION = 4;
+
+inline unsigned flat_align(unsigned n) {
+    return (n + 7) & ~7u;
+}
+
+// FNV-1a over n bytes, 8 at a time, going on from h
+inline unsigned long long flat_checksum(const char* p, size_t n,
+                                        unsigned long long h = 0xcbf29ce484222325ull) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        unsigned long long w;
+        memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0x100000001b3ull;
+        h ^= h >> 32;
+    }
+    for (; i < n; ++i)
+        h = (h ^ (unsigned char)p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+// writes v to path; false on I/O errors
+inline bool save_flat(const FlatView& v, const char* path) {
+    unsigned kid_count = 0;
+    for (unsigned n = 0; n < v.nodes; ++n)
+        if (v.first[n] + v.count[n] > kid_count)
+            kid_count = v.first[n] + v.count[n];
+
+    FlatHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "PCAT", 4);
+    h.version = FLAT_VERSION;
+    h.nodes = v.nodes;
+    h.kid_count = kid_count;
+    h.strings = v.strings;
+    h.text_bytes = v.str_offset[v.strings];
+    h.literal_count = v.literal_count;
+    h.root = v.root;
+    unsigned at = flat_align(sizeof(h));
+    h.kind_at = at;        at = flat_align(at + h.nodes);
+    h.value_at = at;       at = flat_align(at + 4 * h.nodes);
+    h.first_at = at;       at = flat_align(at + 4 * h.nodes);
+    h.count_at = at;       at = flat_align(at + 4 * h.nodes);
+    h.kids_at = at;        at = flat_align(at + 4 * kid_count);
+    h.str_offset_at = at;  at = flat_align(at + 4 * (h.strings + 1));
+    h.text_at = at;        at = flat_align(at + h.text_bytes);
+    h.literals_at = at;    at = flat_align(at + sizeof(Literal) * h.literal_count);
+    h.pos_at = at;         at = flat_align(at + sizeof(SourcePos) * h.nodes);
+    h.file_size = at;
+
+    std::string out(at, '\0');
+    char* p = &out[0];
+    memcpy(p, &h, sizeof(h));
+    memcpy(p + h.kind_at, v.kind, h.nodes);
+    memcpy(p + h.value_at, v.value, 4 * h.nodes);
+    memcpy(p + h.first_at, v.first, 4 * h.nodes);
+    memcpy(p + h.count_at, v.count, 4 * h.nodes);
+    memcpy(p + h.kids_at, v.kids, 4 * kid_count);
+    memcpy(p + h.str_offset_at, v.str_offset, 4 * (h.strings + 1));
+    memcpy(p + h.text_at, v.text, h.text_bytes);
+    memcpy(p + h.literals_at, v.literals, sizeof(Literal) * h.literal_count);
+    memcpy(p + h.pos_at, v.pos, sizeof(SourcePos) * h.nodes);
+    h.checksum = flat_checksum(p, at);
+    memcpy(p, &h, sizeof(h));
+
+    FILE* f = fopen(path, "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    return fclose(f) == 0 && ok;
+}
+
+// a saved flat tree mapped read-only; the view points straight into the
+// mapping
+class FlatFile {
+    void* base;
+    size_t size;
+    FlatView v;
+
+    FlatFile(const FlatFile&);
+    FlatFile& operator=(const FlatFile&);
+
+    // an array of bytes at at, aligned to align, inside the file
+    bool fits(unsigned at, size_t bytes, unsigned align = 4) const {
+        return at % align == 0 && at <= size && bytes <= size - at;
+    }
+
+    // the arrays of h inside the file
+    bool check(const FlatHeader& h) const {
+        if (memcmp(h.magic, "PCAT", 4) || h.version != FLAT_VERSION
+            || h.file_size != size || h.root >= h.nodes)
+            return false;
+        return fits(h.kind_at, h.nodes) && fits(h.value_at, 4ull * h.nodes)
+               && fits(h.first_at, 4ull * h.nodes) && fits(h.count_at, 4ull * h.nodes)
+               && fits(h.kids_at, 4ull * h.kid_count)
+               && fits(h.str_offset_at, 4ull * (h.strings + 1ull))
+               && fits(h.text_at, h.text_bytes)
+               && fits(h.literals_at, sizeof(Literal) * (unsigned long long)h.literal_count,
+                       alignof(Literal))
+               && fits(h.pos_at, sizeof(SourcePos) * (unsigned long long)h.nodes);
+    }
+
+    // every child range, string and number inside its array, children
+    // before their parent, no node the child of two, and below the root a
+    // tree the parser could have built: each node of a kind its parent's
+    // slot takes, with that kind's children and none it needs missing. A
+    // tree that passes is walked from the root like one just parsed
+    bool check_tree(unsigned kid_count, unsigned text_bytes) const {
+        std::vector<bool> taken(v.nodes, false);
+        for (unsigned n = 0; n < v.nodes; ++n) {
+            if (v.kind[n] >= N_KINDS || v.first[n] > kid_count
+                || v.count[n] > kid_count - v.first[n])
+                return false;
+            if (has_text(v.kind_of(n)) && v.value[n] >= v.strings)
+                return false;
+            if (v.kind_of(n) == N_NUMBER_EXPR && v.value[n] >= v.literal_count)
+                return false;
+            for (unsigned i = 0; i < v.count[n]; ++i) {
+                unsigned c = v.child(n, i);
+                if (c == NO_NODE)
+                    continue;
+                if (c >= n || taken[c])
+                    return false;
+                taken[c] = true;
+            }
+        }
+        for (unsigned s = 0; s < v.strings; ++s)
+            if (v.str_offset[s] >= v.str_offset[s+1] || v.str_offset[s+1] > text_bytes)
+                return false;
+        if (v.strings > 0 && v.str_offset[0] != 0)
+            return false;
+
+        // children come first: going down from the root, every node's slot
+        // is known by the time it is reached
+        std::vector<unsigned char> want(v.nodes, (unsigned char)ROLE_NONE);
+        want[v.root] = ROLE_PROGRAM;
+        for (unsigned n = v.root + 1; n-- > 0; ) {
+            unsigned role = want[n];
+            if (role == ROLE_NONE)
+                continue;
+            if (role & ROLE_LIST) {
+                if (v.kind_of(n) != N_LIST)
+                    return false;
+                for (unsigned i = 0; i < v.count[n]; ++i) {
+                    if (v.child(n, i) == NO_NODE)
+                        return false;
+                    want[v.child(n, i)] = (unsigned char)(role & ~ROLE_LIST);
+                }
+                continue;
+            }
+            const KindShape& shape = kind_shape(v.kind_of(n));
+            if (shape.role != role || v.count[n] != shape.children)
+                return false;
+            for (unsigned i = 0; i < shape.children; ++i) {
+                unsigned slot = shape.slot[i];
+                if ((slot & ~(ROLE_LIST | ROLE_OPTIONAL)) == ROLE_DECL_ITEM) {
+                    if (v.value[n] > DECL_PROCEDURE)
+                        return false;
+                    slot = (slot & (ROLE_LIST | ROLE_OPTIONAL)) | (ROLE_VAR_DECL + v.value[n]);
+                }
+                unsigned c = v.child(n, i);
+                if (c == NO_NODE) {
+                    if (!(slot & ROLE_OPTIONAL))
+                        return false;
+                    continue;
+                }
+                want[c] = (unsigned char)(slot & ~ROLE_OPTIONAL);
+            }
+        }
+        return true;
+    }
+
+    void close() {
+        if (base)
+            munmap(base, size);
+        base = NULL;
+        memset(&v, 0, sizeof(v));
+    }
+public:
+    FlatFile() : base(NULL), size(0) {
+        memset(&v, 0, sizeof(v));
+    }
+
+    ~FlatFile() {
+        close();
+    }
+
+    // false if the file is missing, truncated or not a flat tree
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FlatHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size = (size_t)st.st_size;
+        base = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            base = NULL;
+            return false;
+        }
+        const FlatHeader& h = *(const FlatHeader*)base;
+        if (!check(h)) {
+            close();
+            return false;
+        }
+        const char* p = (const char*)base;
+        v.kind = (const unsigned char*)(p + h.kind_at);
+        v.value = (const unsigned*)(p + h.value_at);
+        v.first = (const unsigned*)(p + h.first_at);
+        v.count = (const unsigned*)(p + h.count_at);
+        v.kids = (const unsigned*)(p + h.kids_at);
+        v.str_offset = (const unsigned*)(p + h.str_offset_at);
+        v.text = p + h.text_at;
+        v.literals = (const Literal*)(p + h.literals_at);
+        v.pos = (const SourcePos*)(p + h.pos_at);
+        v.nodes = h.nodes;
+        v.strings = h.strings;
+        v.literal_count = h.literal_count;
+        v.root = h.root;
+        if (!check_tree(h.kid_count, h.text_bytes)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // whether the arrays are the bytes that were saved; open() only checks
+    // that they hold a tree, a damaged file may hold another one
+    bool intact() const {
+        if (!base)
+            return false;
+        FlatHeader h;
+        memcpy(&h, base, sizeof(h));
+        h.checksum = 0;
+        const char* p = (const char*)base;
+        return ((const FlatHeader*)base)->checksum
+               == flat_checksum(p + sizeof(h), size - sizeof(h),
+                                flat_checksum((const char*)&h, sizeof(h)));
+    }
+
+    const FlatView& view() const {
+        return v;
+    }
+};
+
+#endif
@@ -0,0 +1,261 @@
+// prints a flat tree exactly the way the syntax tree classes print
+// themselves, one switch over the node kind instead of a virtual call
+#ifndef FLAT_DUMP_H
+#define FLAT_DUMP_H
+
+#include "dump.h"
+#include "flat.h"
+
+inline void dump_flat(const FlatView& v, unsigned n, Dumper& out, int indent) {
+    if (n == NO_NODE)
+        return;
+    // c(i) is the i-th child
+    #define c(i) v.child(n, i)
+    switch (v.kind_of(n)) {
+    case N_LIST:
+        for (unsigned i = 0; i < v.children(n); ++i)
+            dump_flat(v, c(i), out, indent);
+        break;
+    case N_ID:
+        out.indent(indent) << "identifier:" << v.text_of(n) << '\n';
+        break;
+    case N_NUMBER:
+        out.indent(indent) << "number " << v.text_of(n) << '\n';
+        break;
+    case N_STRING:
+        out.indent(indent) << "string literal " << v.text_of(n) << '\n';
+        break;
+    case N_OP:
+        out.indent(indent) << "operator " << v.text_of(n) << '\n';
+        break;
+    case N_PROGRAM:
+        out.line(indent, "program");
+        dump_flat(v, c(0), out, indent+2);
+        break;
+    case N_BODY:
+        out.line(indent, "body");
+        out.line(indent+2, "declarations");
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "statements");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_DECL:
+        dump_flat(v, c(0), out, indent);
+        break;
+    case N_VAR_DECL:
+        out.line(indent, "variable declaration");
+        out.line(indent+2, "variable names");
+        dump_flat(v, c(0), out, indent+4);
+        if (c(1) != NO_NODE) {
+            out.line(indent+2, "type");
+            dump_flat(v, c(1), out, indent+4);
+        }
+        out.line(indent+2, "initializer");
+        dump_flat(v, c(2), out, indent+4);
+        break;
+    case N_TYPE_DECL:
+        out.line(indent, "type declaration");
+        dump_flat(v, c(0), out, indent+2);
+        dump_flat(v, c(1), out, indent+2);
+        break;
+    case N_PROC_DECL:
+        out.line(indent, "procedure declaration");
+        out.line(indent+2, "id");
+        dump_flat(v, c(0), out, indent+4);
+        if (c(1) != NO_NODE) {
+            out.line(indent+2, "formal parameters");
+            dump_flat(v, c(1), out, indent+4);
+        }
+        if (c(2) != NO_NODE) {
+            out.line(indent+2, "return type");
+            dump_flat(v, c(2), out, indent+4);
+        }
+        dump_flat(v, c(3), out, indent+4);
+        break;
+    case N_FPSEC:
+        out.line(indent, "identifiers");
+        dump_flat(v, c(0), out, indent+2);
+        out.line(indent, "type");
+        dump_flat(v, c(1), out, indent+2);
+        break;
+    case N_COMPONENT:
+        out.line(indent, "component id");
+        dump_flat(v, c(0), out, indent+2);
+        out.line(indent, "component type");
+        dump_flat(v, c(1), out, indent+2);
+        break;
+    case N_USER_TYPE:
+        out.line(indent, "user defined type: ");
+        dump_flat(v, c(0), out, indent+2);
+        break;
+    case N_BUILTIN_TYPE:
+        out.indent(indent) << "type: " << v.text_of(n) << '\n';
+        break;
+    case N_ARRAY_TYPE:
+        out.line(indent, "array type of");
+        dump_flat(v, c(0), out, indent+2);
+        break;
+    case N_RECORD_TYPE:
+        out.line(indent, "record type");
+        dump_flat(v, c(0), out, indent+2);
+        break;
+    case N_ASSIGN_STAT:
+        out.line(indent, "assignment statement");
+        dump_flat(v, c(0), out, indent+2);
+        out.line(indent+2, "value");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_CALL_STAT:
+    case N_CALL_EXPR:
+        if (v.kind_of(n) == N_CALL_STAT) {
+            out.line(indent, "function call statement");
+            out.line(indent+2, "function name");
+        } else {
+            out.line(indent, "function call");
+            out.line(indent+2, "function id");
+        }
+        dump_flat(v, c(0), out, indent+4);
+        if (c(1) != NO_NODE) {
+            out.line(indent+2, "parameters");
+            dump_flat(v, c(1), out, indent+4);
+        } else {
+            out.line(indent+2, "no parameter");
+        }
+        break;
+    case N_READ_STAT:
+        out.line(indent, "read statement");
+        dump_flat(v, c(0), out, indent+2);
+        break;
+    case N_WRITE_STAT:
+        out.line(indent, "write statement");
+        dump_flat(v, c(0), out, indent+2);
+        break;
+    case N_IF_STAT:
+        out.line(indent, "if statement");
+        out.line(indent+2, "condition");
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "then");
+        dump_flat(v, c(1), out, indent+4);
+        if (c(2) != NO_NODE && v.children(c(2)) != 0) {
+            out.line(indent+2, "elseif");
+            dump_flat(v, c(2), out, indent+4);
+        }
+        if (c(3) != NO_NODE) {
+            out.line(indent+2, "else");
+            dump_flat(v, c(3), out, indent+4);
+        }
+        break;
+    case N_ELSE_IF:
+        out.line(indent, "condition");
+        dump_flat(v, c(0), out, indent+2);
+        out.line(indent, "then");
+        dump_flat(v, c(1), out, indent+2);
+        break;
+    case N_WHILE_STAT:
+        out.line(indent, "while loop");
+        out.line(indent+2, "condition expression");
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "body");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_LOOP_STAT:
+        out.line(indent, "loop");
+        dump_flat(v, c(0), out, indent+2);
+        break;
+    case N_FOR_STAT:
+        out.line(indent, "for statement");
+        out.line(indent+2, "for variable");
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "from");
+        dump_flat(v, c(1), out, indent+4);
+        out.line(indent+2, "to");
+        dump_flat(v, c(2), out, indent+4);
+        if (c(3) != NO_NODE) {
+            out.line(indent+2, "by");
+            dump_flat(v, c(3), out, indent+4);
+        }
+        out.line(indent+2, "for body");
+        dump_flat(v, c(4), out, indent+4);
+        break;
+    case N_EXIT_STAT:
+        out.line(indent, "exit statement");
+        break;
+    case N_RETURN_STAT:
+        if (c(0) != NO_NODE) {
+            out.line(indent, "return value");
+            dump_flat(v, c(0), out, indent+4);
+        } else {
+            out.line(indent, "return statement");
+        }
+        break;
+    case N_ID_LVALUE:
+        out.line(indent, "id lvalue");
+        dump_flat(v, c(0), out, indent+4);
+        break;
+    case N_ARRAY_LVALUE:
+        out.line(indent, "array lvalue");
+        out.line(indent+2, "array");
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "index");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_RECORD_LVALUE:
+        out.line(indent, "record lvalue");
+        out.line(indent+2, "record");
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "member");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_NUMBER_EXPR:
+    case N_LVALUE_EXPR:
+    case N_SIMPLE_ARRAY_VALUE:
+    case N_STR_WRITE_EXPR:
+    case N_EXPR_WRITE_EXPR:
+        dump_flat(v, c(0), out, indent);
+        break;
+    case N_UNARY_EXPR:
+        out.line(indent, "unary operator expression");
+        dump_flat(v, c(0), out, indent+2);
+        dump_flat(v, c(1), out, indent+2);
+        break;
+    case N_BINOP_EXPR:
+        out.line(indent, "binary operator expression");
+        dump_flat(v, c(0), out, indent+4);
+        dump_flat(v, c(1), out, indent+2);
+        dump_flat(v, c(2), out, indent+4);
+        break;
+    case N_RECORD_EXPR:
+    case N_ARRAY_EXPR:
+        if (v.kind_of(n) == N_RECORD_EXPR) {
+            out.line(indent, "record expression");
+            out.line(indent+2, "record id");
+        } else {
+            out.line(indent, "array expression");
+            out.line(indent+2, "array id");
+        }
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "values");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_COMP_VALUE:
+        out.line(indent, "member");
+        dump_flat(v, c(0), out, indent+2);
+        out.line(indent, "value");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_OF_ARRAY_VALUE:
+        dump_flat(v, c(0), out, indent+4);
+        out.line(indent+2, "of");
+        dump_flat(v, c(1), out, indent+4);
+        break;
+    case N_KINDS:
+        break;
+    }
+    #undef c
+}
+
+inline void dump_flat(const FlatView& v, Dumper& out) {
+    dump_flat(v, v.root, out, 0);
+}
+
+#endif
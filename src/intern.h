@@ -0,0 +1,232 @@
+// interned names, identifiers, operators and type names: every distinct
+// spelling is stored once and referred to by a stable handle, so comparing
+// two of them is a pointer compare and hashing them is free. Spellings
+// stay until a sweep finds them no longer kept, see Interner::sweep
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Symbol {
+public:
+    struct Entry {
+        unsigned hash;
+        unsigned id;   // in order of first appearance, never reused
+        unsigned len;
+        unsigned kept; // the generation that last kept it
+        char text[1];
+    };
+private:
+    friend class Interner;
+    const Entry* e;
+public:
+    Symbol() : e(NULL) {}
+    explicit Symbol(const Entry* _e) : e(_e) {}
+
+    const char* c_str() const { return e->text; }
+    size_t size() const { return e->len; }
+    unsigned hash() const { return e->hash; }
+    unsigned id() const { return e->id; }
+    std::string str() const { return std::string(e->text, e->len); }
+
+    bool null() const { return e == NULL; }
+    bool operator== (const Symbol& o) const { return e == o.e; }
+    bool operator!= (const Symbol& o) const { return e != o.e; }
+};
+
+inline std::ostream& operator<< (std::ostream& out, const Symbol& s) {
+    return out.write(s.c_str(), s.size());
+}
+
+namespace std {
+template <> struct hash<Symbol> {
+    size_t operator() (const Symbol& s) const { return s.hash(); }
+};
+}
+
+class Interner {
+    // open addressing, linear probing, power of two capacity; split into
+    // shards with their own lock so parallel lexers rarely contend
+    struct Shard {
+        std::mutex lock;
+        std::vector<Symbol::Entry*> slots;
+        size_t count;
+        size_t bytes;  // of its entries
+
+        Shard() : slots(256, (Symbol::Entry*)NULL), count(0), bytes(0) {}
+    };
+
+    static const unsigned shard_bits = 6;
+    Shard shards[1 << shard_bits];
+    std::atomic<unsigned> next_id;
+    std::atomic<size_t> live;   // entries in all shards
+    unsigned generation;        // what keep() marks entries with, from 1
+    size_t swept;               // entries the last sweep left
+
+    static size_t entry_size(size_t n) {
+        return offsetof(Symbol::Entry, text) + n + 1;
+    }
+
+    Shard& shard_of(unsigned h) {
+        return shards[h & ((1 << shard_bits) - 1)];
+    }
+
+    static unsigned hash_bytes(const char* s, size_t n) {
+        // FNV-1a
+        unsigned h = 2166136261u;
+        for (size_t i = 0; i < n; ++i) {
+            h ^= (unsigned char)s[i];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // the low bits pick the shard, the rest index its table
+    static void rehash(Shard& sh, size_t capacity) {
+        std::vector<Symbol::Entry*> old(capacity, (Symbol::Entry*)NULL);
+        old.swap(sh.slots);
+        size_t mask = sh.slots.size() - 1;
+        for (size_t i = 0; i < old.size(); ++i) {
+            if (!old[i])
+                continue;
+            size_t j = (old[i]->hash >> shard_bits) & mask;
+            while (sh.slots[j])
+                j = (j + 1) & mask;
+            sh.slots[j] = old[i];
+        }
+    }
+
+    Interner(const Interner&);
+    Interner& operator=(const Interner&);
+public:
+    Interner() : next_id(0), live(0), generation(1), swept(0) {}
+
+    ~Interner() {
+        for (unsigned i = 0; i < (1u << shard_bits); ++i)
+            for (size_t j = 0; j < shards[i].slots.size(); ++j)
+                free(shards[i].slots[j]);
+    }
+
+    Symbol intern(const char* s, size_t n) {
+        unsigned h = hash_bytes(s, n);
+        Shard& sh = shard_of(h);
+        std::lock_guard<std::mutex> guard(sh.lock);
+        size_t mask = sh.slots.size() - 1;
+        size_t i = (h >> shard_bits) & mask;
+        for (; sh.slots[i]; i = (i + 1) & mask) {
+            Symbol::Entry* e = sh.slots[i];
+            if (e->hash == h && e->len == n && memcmp(e->text, s, n) == 0)
+                return Symbol(e);
+        }
+        Symbol::Entry* e = (Symbol::Entry*)malloc(entry_size(n));
+        if (!e)
+            throw std::bad_alloc();
+        e->hash = h;
+        e->id = next_id++;
+        e->len = (unsigned)n;
+        e->kept = 0;
+        memcpy(e->text, s, n);
+        e->text[n] = 0;
+        sh.slots[i] = e;
+        sh.bytes += entry_size(n);
+        ++live;
+        // keep the load factor under one half
+        if (++sh.count * 2 > sh.slots.size())
+            rehash(sh, sh.slots.size() * 2);
+        return Symbol(e);
+    }
+
+    Symbol intern(const char* s) {
+        return intern(s, strlen(s));
+    }
+
+    Symbol intern(const std::string& s) {
+        return intern(s.data(), s.size());
+    }
+
+    // spellings held now
+    size_t size() const {
+        return live;
+    }
+
+    // spellings and hash tables together
+    size_t bytes() {
+        size_t n = 0;
+        for (unsigned i = 0; i < (1u << shard_bits); ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            n += shards[i].bytes + shards[i].slots.capacity() * sizeof(Symbol::Entry*);
+        }
+        return n;
+    }
+
+    // marks s as still in use for the next sweep
+    void keep(Symbol s) {
+        Shard& sh = shard_of(s.hash());
+        std::lock_guard<std::mutex> guard(sh.lock);
+        const_cast<Symbol::Entry*>(s.e)->kept = generation;
+    }
+
+    // frees every spelling not kept since the last sweep, and returns how
+    // many. A Symbol not kept must not be used after it, so nothing else
+    // may intern meanwhile: a batch sweeps between files, a long-lived
+    // program after keeping what its trees still name
+    size_t sweep() {
+        size_t freed = 0;
+        for (unsigned i = 0; i < (1u << shard_bits); ++i) {
+            Shard& sh = shards[i];
+            std::lock_guard<std::mutex> guard(sh.lock);
+            size_t count = 0;
+            for (size_t j = 0; j < sh.slots.size(); ++j) {
+                Symbol::Entry* e = sh.slots[j];
+                if (!e || e->kept == generation) {
+                    count += e != NULL;
+                    continue;
+                }
+                sh.bytes -= entry_size(e->len);
+                free(e);
+                sh.slots[j] = NULL;
+                ++freed;
+            }
+            // the survivors, in a table no more than a quarter full
+            size_t capacity = 256;
+            while (capacity < count * 4)
+                capacity *= 2;
+            rehash(sh, capacity);
+            sh.count = count;
+        }
+        live -= freed;
+        swept = live;
+        ++generation;
+        return freed;
+    }
+
+    // whether the spellings since the last sweep are enough that most of
+    // them may be dead: sweeping then costs little per spelling interned
+    bool worth_sweeping() const {
+        return live > 2 * swept + 4096;
+    }
+
+    static Interner& global() {
+        static Interner table;
+        return table;
+    }
+};
+
+inline Symbol intern(const char* s, size_t n) {
+    return Interner::global().intern(s, n);
+}
+
+inline Symbol intern(const char* s) {
+    return Interner::global().intern(s);
+}
+
+#endif
@@ -0,0 +1,963 @@
+// runs a program straight from its flat tree. A compile step resolves every
+// name once: variables become frame slots, calls point at their procedure,
+// record constructors at field indices. What it produces is a tree of small
+// code nodes that the evaluator walks with one switch per node.
+#ifndef INTERP_H
+#define INTERP_H
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "flat.h"
+#include "intern.h"
+#include "scope.h"
+#include "value.h"
+
+enum CodeOp {
+    // expressions
+    C_CONST, C_LOCAL, C_GLOBAL, C_OUTER, C_INDEX, C_FIELD,
+    C_POS, C_NEG, C_NOT,
+    C_ADD, C_SUB, C_MUL, C_RDIV, C_DIV, C_MOD, C_AND, C_OR,
+    C_LT, C_LE, C_GT, C_GE, C_EQ, C_NE,
+    C_CALL, C_RECORD, C_ARRAY, C_OF, C_STRING,
+    // statements
+    C_BLOCK, C_ASSIGN, C_CALL_STAT, C_READ, C_WRITE, C_IF, C_WHILE, C_LOOP,
+    C_FOR, C_EXIT, C_RETURN
+};
+
+struct Proc;
+
+struct Code {
+    unsigned char op;
+    unsigned char kind;      // of the target of C_ASSIGN, C_FOR and C_RETURN;
+                             // C_ARRAY: the slot of its elements
+    unsigned hops;           // C_OUTER: frames up; C_CALL: static link hops
+    unsigned slot;
+    Value k;                 // C_CONST
+    Code* a;
+    Code* b;
+    Code* c;
+    Code* d;
+    Code** list;             // arguments, statements, WRITE items...
+    unsigned n;
+    unsigned* fields;        // C_RECORD: field index of each list entry
+    Proc* proc;              // C_CALL
+    Symbol field;            // C_FIELD
+    FieldCache cache;        // C_FIELD: where the field was last time
+    const RecordInfo* record;  // C_RECORD
+    Text text;               // C_STRING, without the quotes
+};
+
+struct Proc {
+    Symbol name;
+    unsigned depth;          // nesting depth of the body, the program is 0
+    unsigned params;
+    unsigned slots;          // parameters, then local variables
+    std::vector<unsigned char> kinds;  // per slot
+    unsigned char result;
+    bool has_result;
+    unsigned node;           // N_PROC_DECL
+    Code* body;              // variable initializers, then statements
+
+    Proc() : depth(0), params(0), slots(0), result(K_OTHER), has_result(false),
+             node(NO_NODE), body(NULL) {}
+};
+
+class Interpreter {
+    struct Frame {
+        Value* slots;
+        Frame* up;           // frame of the enclosing procedure
+    };
+
+    enum Flow { F_NEXT, F_EXIT, F_RETURN };
+
+    enum What { E_VAR, E_PROC, E_TYPE, E_CONST };
+
+    struct Entity {
+        unsigned char what;
+        unsigned char kind;
+        unsigned depth, slot;
+        Proc* proc;
+        const RecordInfo* record;
+        unsigned elem;       // an array type's element type node
+        Value k;
+    };
+
+    static const unsigned stack_slots = 1 << 20;
+    static const size_t max_native_stack = 4 << 20;  // bytes, for deep recursion
+
+    Arena code;              // code nodes and their arrays
+    Arena heap;              // records and arrays made by the program
+    std::deque<Proc> procs;
+    std::deque<RecordInfo> records;
+    Proc* main;
+
+    // compile state
+    FlatView v;
+    ScopedTable<Entity> scopes;
+    std::vector<Proc*> nest;
+
+    // run state
+    Value* stack;
+    Value* sp;
+    Frame* globals;
+    Value result;
+    const char* native_base;  // a local of run(), recursion is measured from it
+    unsigned long long steps;
+    FILE* in;
+    FILE* out;
+
+    Interpreter(const Interpreter&);
+    Interpreter& operator=(const Interpreter&);
+
+    static void fail(const std::string& message) {
+        value_error(message);
+    }
+
+    Code* new_code(CodeOp op) {
+        Code* c = (Code*)code.alloc(sizeof(Code));
+        memset((void*)c, 0, sizeof(Code));
+        c->op = op;
+        return c;
+    }
+
+    template <class T>
+    T* code_array(unsigned n) {
+        return (T*)code.alloc(sizeof(T) * (n ? n : 1));
+    }
+
+    Symbol sym(unsigned n) const {
+        Text t = v.text_of(n);
+        return intern(t.ptr, t.len);
+    }
+
+    void declare(Symbol name, const Entity& e) {
+        scopes.declare(name, e);
+    }
+
+    const Entity* lookup(Symbol name) const {
+        return scopes.lookup(name);
+    }
+
+    Entity entity(What what) const {
+        Entity e;
+        memset((void*)&e, 0, sizeof(e));
+        e.what = (unsigned char)what;
+        e.elem = NO_NODE;
+        return e;
+    }
+
+    // ---- compile ----
+
+    // the kind a type node stands for, and its record if it is one
+    unsigned char kind_of_type(unsigned t, const RecordInfo** record) {
+        if (record)
+            *record = NULL;
+        if (t == NO_NODE)
+            return K_OTHER;
+        switch (v.kind_of(t)) {
+        case N_BUILTIN_TYPE: {
+            Symbol s = sym(t);
+            if (s == intern("INTEGER"))
+                return K_INT;
+            if (s == intern("REAL"))
+                return K_REAL;
+            return K_STRING;
+        }
+        case N_USER_TYPE: {
+            const Entity* e = lookup(sym(v.child(t, 0)));
+            if (!e || e->what != E_TYPE)
+                return K_OTHER;
+            if (record)
+                *record = e->record;
+            return e->kind;
+        }
+        default:
+            return K_OTHER;
+        }
+    }
+
+    // the slot a field or element of type t is stored in
+    unsigned char slot_of_type(unsigned t) {
+        const RecordInfo* record;
+        switch (kind_of_type(t, &record)) {
+        case K_INT:  return S_INT;
+        case K_REAL: return S_REAL;
+        case K_BOOL: return S_BOOL;
+        default:
+            break;
+        }
+        if (record || (t != NO_NODE && v.kind_of(t) == N_ARRAY_TYPE))
+            return S_REF;
+        if (t != NO_NODE && v.kind_of(t) == N_USER_TYPE) {
+            const Entity* e = lookup(sym(v.child(t, 0)));
+            if (e && e->what == E_TYPE && e->elem != NO_NODE)
+                return S_REF;
+        }
+        return S_VALUE;
+    }
+
+    void declare_type(unsigned decl) {
+        Symbol name = sym(v.child(decl, 0));
+        unsigned t = v.child(decl, 1);
+        Entity e = entity(E_TYPE);
+        if (v.kind_of(t) == N_RECORD_TYPE) {
+            records.push_back(RecordInfo());
+            RecordInfo& r = records.back();
+            r.name = name;
+            unsigned comps = v.child(t, 0);
+            for (unsigned i = 0; i < v.children(comps); ++i) {
+                unsigned comp = v.child(comps, i);
+                r.fields.push_back(sym(v.child(comp, 0)));
+                r.type_nodes.push_back(v.child(comp, 1));
+            }
+            e.record = &r;
+        } else if (v.kind_of(t) == N_ARRAY_TYPE) {
+            e.elem = v.child(t, 0);
+        } else {
+            e.kind = kind_of_type(t, &e.record);
+        }
+        declare(name, e);
+    }
+
+    void declare_proc(unsigned decl) {
+        procs.push_back(Proc());
+        Proc* p = &procs.back();
+        p->name = sym(v.child(decl, 0));
+        p->node = decl;
+        p->depth = nest.back()->depth + 1;
+        Entity e = entity(E_PROC);
+        e.proc = p;
+        declare(p->name, e);
+    }
+
+    unsigned new_slot(Symbol name, unsigned char kind) {
+        Proc* p = nest.back();
+        Entity e = entity(E_VAR);
+        e.kind = kind;
+        e.depth = p->depth;
+        e.slot = p->slots++;
+        p->kinds.push_back(kind);
+        declare(name, e);
+        return e.slot;
+    }
+
+    Code* variable(const Entity& e) {
+        unsigned depth = nest.back()->depth;
+        Code* c;
+        if (e.depth == depth) {
+            c = new_code(C_LOCAL);
+        } else if (e.depth == 0) {
+            c = new_code(C_GLOBAL);
+        } else {
+            c = new_code(C_OUTER);
+            c->hops = depth - e.depth;
+        }
+        c->slot = e.slot;
+        c->kind = e.kind;
+        return c;
+    }
+
+    Code* compile_lvalue(unsigned n) {
+        switch (v.kind_of(n)) {
+        case N_ID_LVALUE: {
+            Symbol name = sym(v.child(n, 0));
+            const Entity* e = lookup(name);
+            if (!e)
+                fail("undeclared identifier " + name_of(name));
+            if (e->what != E_VAR)
+                fail(name_of(name) + " is not a variable");
+            return variable(*e);
+        }
+        case N_ARRAY_LVALUE: {
+            Code* c = new_code(C_INDEX);
+            c->a = compile_lvalue(v.child(n, 0));
+            c->b = compile_expr(v.child(n, 1));
+            return c;
+        }
+        default: {
+            Code* c = new_code(C_FIELD);
+            c->a = compile_lvalue(v.child(n, 0));
+            c->field = sym(v.child(n, 1));
+            return c;
+        }
+        }
+    }
+
+    Code* constant(Value k) {
+        Code* c = new_code(C_CONST);
+        c->k = k;
+        return c;
+    }
+
+    // the scanner has read its value, and checked it
+    Code* compile_number(unsigned n) {
+        const Literal& k = v.number(n);
+        return constant(k.real ? real_value(k.r) : int_value(k.i));
+    }
+
+    Code* compile_call(unsigned id, unsigned params, CodeOp op) {
+        Symbol name = sym(id);
+        const Entity* e = lookup(name);
+        if (!e || e->what != E_PROC)
+            fail(name_of(name) + " is not a procedure");
+        Proc* p = e->proc;
+        unsigned count = params == NO_NODE ? 0 : v.children(params);
+        unsigned formals = 0;
+        unsigned fpsecs = v.child(p->node, 1);
+        if (fpsecs != NO_NODE)
+            for (unsigned i = 0; i < v.children(fpsecs); ++i)
+                formals += v.children(v.child(v.child(fpsecs, i), 0));
+        if (count != formals)
+            fail(name_of(name) + " called with the wrong number of arguments");
+        Code* c = new_code(op);
+        c->proc = p;
+        c->hops = nest.back()->depth - (p->depth - 1);
+        c->n = count;
+        c->list = code_array<Code*>(count);
+        for (unsigned i = 0; i < count; ++i)
+            c->list[i] = compile_expr(v.child(params, i));
+        return c;
+    }
+
+    static CodeOp binary_op(Symbol op) {
+        static const struct { const char* s; CodeOp op; } ops[] = {
+            { "+", C_ADD }, { "-", C_SUB }, { "*", C_MUL }, { "/", C_RDIV },
+            { "DIV", C_DIV }, { "MOD", C_MOD }, { "AND", C_AND }, { "OR", C_OR },
+            { "<", C_LT }, { "<=", C_LE }, { ">", C_GT }, { ">=", C_GE },
+            { "=", C_EQ }, { "<>", C_NE }
+        };
+        for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i)
+            if (!strcmp(op.c_str(), ops[i].s))
+                return ops[i].op;
+        fail("unknown operator " + name_of(op));
+        return C_ADD;
+    }
+
+    Code* compile_expr(unsigned n) {
+        switch (v.kind_of(n)) {
+        case N_NUMBER_EXPR:
+            return compile_number(n);
+        case N_LVALUE_EXPR: {
+            unsigned lval = v.child(n, 0);
+            // TRUE, FALSE and NIL are predeclared constants
+            if (v.kind_of(lval) == N_ID_LVALUE) {
+                const Entity* e = lookup(sym(v.child(lval, 0)));
+                if (e && e->what == E_CONST)
+                    return constant(e->k);
+            }
+            return compile_lvalue(lval);
+        }
+        case N_UNARY_EXPR: {
+            Symbol op = sym(v.child(n, 0));
+            Code* c = new_code(op == intern("-") ? C_NEG : op == intern("+") ? C_POS : C_NOT);
+            c->a = compile_expr(v.child(n, 1));
+            return c;
+        }
+        case N_BINOP_EXPR: {
+            Code* c = new_code(binary_op(sym(v.child(n, 1))));
+            c->a = compile_expr(v.child(n, 0));
+            c->b = compile_expr(v.child(n, 2));
+            return c;
+        }
+        case N_CALL_EXPR:
+            return compile_call(v.child(n, 0), v.child(n, 1), C_CALL);
+        case N_RECORD_EXPR: {
+            Symbol name = sym(v.child(n, 0));
+            const Entity* e = lookup(name);
+            if (!e || e->what != E_TYPE || !e->record)
+                fail(name_of(name) + " is not a record type");
+            unsigned vals = v.child(n, 1);
+            Code* c = new_code(C_RECORD);
+            c->record = e->record;
+            c->n = v.children(vals);
+            c->list = code_array<Code*>(c->n);
+            c->fields = code_array<unsigned>(c->n);
+            for (unsigned i = 0; i < c->n; ++i) {
+                unsigned cv = v.child(vals, i);
+                Symbol field = sym(v.child(cv, 0));
+                int at = e->record->find(field);
+                if (at < 0)
+                    fail(name_of(name) + " has no field " + name_of(field));
+                c->fields[i] = (unsigned)at;
+                c->list[i] = compile_expr(v.child(cv, 1));
+            }
+            return c;
+        }
+        case N_ARRAY_EXPR: {
+            Symbol name = sym(v.child(n, 0));
+            const Entity* e = lookup(name);
+            if (!e || e->what != E_TYPE)
+                fail(name_of(name) + " is not an array type");
+            unsigned vals = v.child(n, 1);
+            Code* c = new_code(C_ARRAY);
+            c->kind = e->elem == NO_NODE ? (unsigned char)S_VALUE : slot_of_type(e->elem);
+            c->n = v.children(vals);
+            c->list = code_array<Code*>(c->n);
+            for (unsigned i = 0; i < c->n; ++i) {
+                unsigned av = v.child(vals, i);
+                if (v.kind_of(av) == N_OF_ARRAY_VALUE) {
+                    Code* of = new_code(C_OF);
+                    of->a = compile_expr(v.child(av, 0));
+                    of->b = compile_expr(v.child(av, 1));
+                    c->list[i] = of;
+                } else {
+                    c->list[i] = compile_expr(v.child(av, 0));
+                }
+            }
+            return c;
+        }
+        default:
+            fail("not an expression");
+            return NULL;
+        }
+    }
+
+    Code* block(const std::vector<Code*>& stats) {
+        Code* c = new_code(C_BLOCK);
+        c->n = (unsigned)stats.size();
+        c->list = code_array<Code*>(c->n);
+        for (unsigned i = 0; i < c->n; ++i)
+            c->list[i] = stats[i];
+        return c;
+    }
+
+    Code* compile_stats(unsigned list) {
+        std::vector<Code*> stats;
+        for (unsigned i = 0; i < v.children(list); ++i)
+            stats.push_back(compile_stat(v.child(list, i)));
+        return block(stats);
+    }
+
+    Code* compile_stat(unsigned n) {
+        switch (v.kind_of(n)) {
+        case N_ASSIGN_STAT: {
+            Code* c = new_code(C_ASSIGN);
+            c->a = compile_lvalue(v.child(n, 0));
+            c->kind = c->a->kind;
+            c->b = compile_expr(v.child(n, 1));
+            return c;
+        }
+        case N_CALL_STAT:
+            return compile_call(v.child(n, 0), v.child(n, 1), C_CALL_STAT);
+        case N_READ_STAT: {
+            unsigned lvals = v.child(n, 0);
+            Code* c = new_code(C_READ);
+            c->n = v.children(lvals);
+            c->list = code_array<Code*>(c->n);
+            for (unsigned i = 0; i < c->n; ++i)
+                c->list[i] = compile_lvalue(v.child(lvals, i));
+            return c;
+        }
+        case N_WRITE_STAT: {
+            unsigned items = v.child(n, 0);
+            Code* c = new_code(C_WRITE);
+            c->n = items == NO_NODE ? 0 : v.children(items);
+            c->list = code_array<Code*>(c->n);
+            for (unsigned i = 0; i < c->n; ++i) {
+                unsigned item = v.child(items, i);
+                if (v.kind_of(item) == N_STR_WRITE_EXPR) {
+                    Text t = v.text_of(v.child(item, 0));
+                    Code* s = new_code(C_STRING);
+                    s->text = Text(t.ptr + 1, t.len - 2);
+                    c->list[i] = s;
+                } else {
+                    c->list[i] = compile_expr(v.child(item, 0));
+                }
+            }
+            return c;
+        }
+        case N_IF_STAT: {
+            // ELSIF arms become nested IFs in the ELSE branch
+            Code* c = new_code(C_IF);
+            c->a = compile_expr(v.child(n, 0));
+            c->b = compile_stats(v.child(n, 1));
+            Code* last = c;
+            unsigned elseifs = v.child(n, 2);
+            for (unsigned i = 0; i < v.children(elseifs); ++i) {
+                unsigned arm = v.child(elseifs, i);
+                Code* e = new_code(C_IF);
+                e->a = compile_expr(v.child(arm, 0));
+                e->b = compile_stats(v.child(arm, 1));
+                last->c = e;
+                last = e;
+            }
+            if (v.child(n, 3) != NO_NODE)
+                last->c = compile_stats(v.child(n, 3));
+            return c;
+        }
+        case N_WHILE_STAT: {
+            Code* c = new_code(C_WHILE);
+            c->a = compile_expr(v.child(n, 0));
+            c->b = compile_stats(v.child(n, 1));
+            return c;
+        }
+        case N_LOOP_STAT: {
+            Code* c = new_code(C_LOOP);
+            c->b = compile_stats(v.child(n, 0));
+            return c;
+        }
+        case N_FOR_STAT: {
+            Symbol name = sym(v.child(n, 0));
+            const Entity* e = lookup(name);
+            if (!e || e->what != E_VAR)
+                fail("FOR variable " + name_of(name) + " is not a variable");
+            Code* c = new_code(C_FOR);
+            c->a = variable(*e);
+            c->b = compile_expr(v.child(n, 1));
+            c->c = compile_expr(v.child(n, 2));
+            c->d = v.child(n, 3) == NO_NODE ? NULL : compile_expr(v.child(n, 3));
+            c->list = code_array<Code*>(1);
+            c->list[0] = compile_stats(v.child(n, 4));
+            return c;
+        }
+        case N_EXIT_STAT:
+            return new_code(C_EXIT);
+        case N_RETURN_STAT: {
+            Code* c = new_code(C_RETURN);
+            if (v.child(n, 0) != NO_NODE)
+                c->a = compile_expr(v.child(n, 0));
+            c->kind = nest.back()->result;
+            return c;
+        }
+        default:
+            fail("not a statement");
+            return NULL;
+        }
+    }
+
+    // declarations of a body in three passes: types and procedure names
+    // first so they can be used before their declaration, then variables
+    // in order, then the procedure bodies
+    Code* compile_body(unsigned body) {
+        scopes.open();
+        unsigned decls = v.child(body, 0);
+        std::vector<Code*> stats;
+
+        for (unsigned i = 0; i < v.children(decls); ++i) {
+            unsigned decl = v.child(decls, i);
+            unsigned block = v.child(decl, 0);
+            for (unsigned j = 0; j < v.children(block); ++j) {
+                if (v.value[decl] == DECL_TYPE)
+                    declare_type(v.child(block, j));
+                else if (v.value[decl] == DECL_PROCEDURE)
+                    declare_proc(v.child(block, j));
+            }
+        }
+        for (unsigned i = scopes.local_begin(); i < scopes.size(); ++i) {
+            const Entity& e = scopes.value_at(i);
+            RecordInfo* r = (RecordInfo*)e.record;
+            if (e.what == E_TYPE && r && r->name == scopes.name_at(i)) {
+                for (size_t f = 0; f < r->type_nodes.size(); ++f) {
+                    r->kinds.push_back(kind_of_type(r->type_nodes[f], NULL));
+                    r->slots.push_back(slot_of_type(r->type_nodes[f]));
+                }
+                r->layout = lay_out(r->slots);
+            }
+        }
+
+        for (unsigned i = 0; i < v.children(decls); ++i) {
+            unsigned decl = v.child(decls, i);
+            if (v.value[decl] != DECL_VAR)
+                continue;
+            unsigned block = v.child(decl, 0);
+            for (unsigned j = 0; j < v.children(block); ++j) {
+                unsigned var = v.child(block, j);
+                unsigned ids = v.child(var, 0);
+                unsigned char kind = kind_of_type(v.child(var, 1), NULL);
+                // the initializer sees the names declared before this one
+                Code* init = compile_expr(v.child(var, 2));
+                for (unsigned k = 0; k < v.children(ids); ++k) {
+                    Code* c = new_code(C_ASSIGN);
+                    c->kind = kind;
+                    c->a = new_code(C_LOCAL);
+                    c->a->slot = new_slot(sym(v.child(ids, k)), kind);
+                    c->b = init;
+                    stats.push_back(c);
+                }
+            }
+        }
+
+        for (unsigned i = 0; i < v.children(decls); ++i) {
+            unsigned decl = v.child(decls, i);
+            if (v.value[decl] != DECL_PROCEDURE)
+                continue;
+            unsigned block = v.child(decl, 0);
+            for (unsigned j = 0; j < v.children(block); ++j)
+                compile_proc(lookup(sym(v.child(v.child(block, j), 0)))->proc);
+        }
+
+        Code* body_stats = compile_stats(v.child(body, 1));
+        for (unsigned i = 0; i < body_stats->n; ++i)
+            stats.push_back(body_stats->list[i]);
+        scopes.close();
+        return block(stats);
+    }
+
+    void compile_proc(Proc* p) {
+        nest.push_back(p);
+        scopes.open();
+        unsigned fpsecs = v.child(p->node, 1);
+        if (fpsecs != NO_NODE) {
+            for (unsigned i = 0; i < v.children(fpsecs); ++i) {
+                unsigned sec = v.child(fpsecs, i);
+                unsigned char kind = kind_of_type(v.child(sec, 1), NULL);
+                unsigned ids = v.child(sec, 0);
+                for (unsigned k = 0; k < v.children(ids); ++k)
+                    new_slot(sym(v.child(ids, k)), kind);
+            }
+        }
+        p->params = p->slots;
+        p->has_result = v.child(p->node, 2) != NO_NODE;
+        p->result = kind_of_type(v.child(p->node, 2), NULL);
+        p->body = compile_body(v.child(p->node, 3));
+        scopes.close();
+        nest.pop_back();
+    }
+
+    void predeclare() {
+        scopes.open();
+        Entity t = entity(E_CONST);
+        t.k = bool_value(true);
+        declare(intern("TRUE"), t);
+        t.k = bool_value(false);
+        declare(intern("FALSE"), t);
+        t.k = nil_value();
+        declare(intern("NIL"), t);
+        Entity b = entity(E_TYPE);
+        b.kind = K_BOOL;
+        declare(intern("BOOLEAN"), b);
+    }
+
+    // ---- run ----
+
+    Value* frame_slot(Code* c, Frame* f) {
+        switch (c->op) {
+        case C_LOCAL:
+            return &f->slots[c->slot];
+        case C_GLOBAL:
+            return &globals->slots[c->slot];
+        default:
+            for (unsigned h = c->hops; h; --h)
+                f = f->up;
+            return &f->slots[c->slot];
+        }
+    }
+
+    // the object and item an element or field names; kind is set for
+    // record fields
+    Object* locate(Code* c, Frame* f, unsigned& at, unsigned char& kind) {
+        if (c->op == C_INDEX) {
+            Value a = eval(c->a, f);
+            at = element_index(a, eval(c->b, f));
+            kind = K_OTHER;
+            return a.obj;
+        }
+        Value r = eval(c->a, f);
+        const FieldCache& field = find_field(r, c->field, c->cache);
+        at = field.index;
+        kind = field.kind;
+        return r.obj;
+    }
+
+    Value call(Code* c, Frame* f) {
+        Proc* p = c->proc;
+        char here;
+        if ((size_t)(native_base - &here) > max_native_stack)
+            fail("procedure calls nested too deeply");
+        Value* slots = sp;
+        if (p->slots > (unsigned)(stack + stack_slots - sp))
+            fail("out of stack");
+        // claim the frame first, calls in the arguments go above it
+        sp += p->slots;
+        for (unsigned i = 0; i < c->n; ++i)
+            store(&slots[i], eval(c->list[i], f), p->kinds[i]);
+        for (unsigned i = c->n; i < p->slots; ++i)
+            slots[i] = nil_value();
+        Frame frame;
+        frame.slots = slots;
+        frame.up = f;
+        for (unsigned h = c->hops; h; --h)
+            frame.up = frame.up->up;
+        result = nil_value();
+        exec(p->body, &frame);
+        sp = slots;
+        return result;
+    }
+
+    Value eval(Code* c, Frame* f) {
+        switch (c->op) {
+        case C_CONST:
+            return c->k;
+        case C_LOCAL:
+            return f->slots[c->slot];
+        case C_GLOBAL:
+            return globals->slots[c->slot];
+        case C_OUTER:
+            return *frame_slot(c, f);
+        case C_INDEX: {
+            Value a = eval(c->a, f);
+            return load_item(a.obj, element_index(a, eval(c->b, f)));
+        }
+        case C_FIELD: {
+            Value r = eval(c->a, f);
+            return load_field(r.obj, find_field(r, c->field, c->cache));
+        }
+        case C_POS: {
+            Value x = eval(c->a, f);
+            if (!is_number(x))
+                fail("unary + of a non-number");
+            return x;
+        }
+        case C_NEG:
+            return negative(eval(c->a, f));
+        case C_NOT:
+            return bool_value(!truth(eval(c->a, f)));
+        case C_ADD: case C_SUB: case C_MUL: case C_RDIV: case C_DIV: case C_MOD: {
+            Value x = eval(c->a, f);
+            return arith(ArithOp(c->op - C_ADD), x, eval(c->b, f));
+        }
+        case C_AND:
+            return bool_value(truth(eval(c->a, f)) && truth(eval(c->b, f)));
+        case C_OR:
+            return bool_value(truth(eval(c->a, f)) || truth(eval(c->b, f)));
+        case C_LT: case C_LE: case C_GT: case C_GE: case C_EQ: case C_NE: {
+            Value x = eval(c->a, f);
+            return compare(CompareOp(c->op - C_LT), x, eval(c->b, f));
+        }
+        case C_CALL:
+            return call(c, f);
+        case C_RECORD: {
+            const RecordInfo* r = c->record;
+            Object* o = new_record(heap, r);
+            for (unsigned i = 0; i < c->n; ++i) {
+                unsigned at = c->fields[i];
+                store_item(heap, o, at, as_kind(eval(c->list[i], f), r->kinds[at]));
+            }
+            return object_value(o);
+        }
+        case C_ARRAY:
+            return make_array(c, f);
+        default:
+            fail("not an expression");
+            return nil_value();
+        }
+    }
+
+    Value make_array(Code* c, Frame* f) {
+        // counts first, so the array is allocated once
+        std::vector<Value> vals(c->n);
+        std::vector<unsigned> counts(c->n, 1);
+        for (unsigned i = 0; i < c->n; ++i) {
+            Code* item = c->list[i];
+            if (item->op == C_OF) {
+                counts[i] = array_count(eval(item->a, f));
+                vals[i] = eval(item->b, f);
+            } else {
+                vals[i] = eval(item, f);
+            }
+        }
+        return object_value(new_array(heap, vals.data(), counts.data(), c->n, c->kind));
+    }
+
+    void read_into(Code* lval, Frame* f) {
+        if (lval->op != C_INDEX && lval->op != C_FIELD) {
+            read_value(in, frame_slot(lval, f), lval->kind);
+            return;
+        }
+        unsigned at;
+        unsigned char kind;
+        Object* o = locate(lval, f, at, kind);
+        Value x = load_item(o, at);
+        read_value(in, &x, kind);
+        store_item(heap, o, at, x);
+    }
+
+    Flow exec(Code* c, Frame* f) {
+        switch (c->op) {
+        case C_BLOCK:
+            for (unsigned i = 0; i < c->n; ++i) {
+                ++steps;
+                Flow flow = exec(c->list[i], f);
+                if (flow != F_NEXT)
+                    return flow;
+            }
+            return F_NEXT;
+        case C_ASSIGN: {
+            Value x = eval(c->b, f);
+            if (c->a->op == C_LOCAL) {
+                store(&f->slots[c->a->slot], x, c->kind);
+            } else if (c->a->op == C_INDEX) {
+                Value a = eval(c->a->a, f);
+                store_item(heap, a.obj, element_index(a, eval(c->a->b, f)), x);
+            } else if (c->a->op == C_FIELD) {
+                Value r = eval(c->a->a, f);
+                store_field(heap, r.obj, find_field(r, c->a->field, c->a->cache), x);
+            } else {
+                store(frame_slot(c->a, f), x, c->kind);
+            }
+            return F_NEXT;
+        }
+        case C_CALL_STAT:
+            call(c, f);
+            return F_NEXT;
+        case C_READ:
+            fflush(out);
+            for (unsigned i = 0; i < c->n; ++i)
+                read_into(c->list[i], f);
+            return F_NEXT;
+        case C_WRITE:
+            for (unsigned i = 0; i < c->n; ++i) {
+                Code* item = c->list[i];
+                if (item->op == C_STRING)
+                    fwrite(item->text.ptr, 1, item->text.len, out);
+                else
+                    write_value(out, eval(item, f));
+            }
+            fputc('\n', out);
+            return F_NEXT;
+        case C_IF:
+            if (truth(eval(c->a, f)))
+                return exec(c->b, f);
+            return c->c ? exec(c->c, f) : F_NEXT;
+        case C_WHILE:
+            while (truth(eval(c->a, f))) {
+                Flow flow = exec(c->b, f);
+                if (flow == F_EXIT)
+                    break;
+                if (flow == F_RETURN)
+                    return flow;
+            }
+            return F_NEXT;
+        case C_LOOP:
+            for (;;) {
+                Flow flow = exec(c->b, f);
+                if (flow == F_EXIT)
+                    break;
+                if (flow == F_RETURN)
+                    return flow;
+            }
+            return F_NEXT;
+        case C_FOR: {
+            Value* var = frame_slot(c->a, f);
+            Value from = eval(c->b, f);
+            Value to = eval(c->c, f);
+            Value by = c->d ? eval(c->d, f) : int_value(1);
+            if (from.tag != V_INT || to.tag != V_INT || by.tag != V_INT)
+                fail("FOR bounds and step must be integers");
+            if (by.i == 0)
+                fail("FOR step is zero");
+            // the bounds are fixed on entry; the body may change the variable
+            long long i = from.i;
+            while (by.i > 0 ? i <= to.i : i >= to.i) {
+                *var = int_value((int)i);
+                Flow flow = exec(c->list[0], f);
+                if (flow == F_EXIT)
+                    break;
+                if (flow == F_RETURN)
+                    return flow;
+                if (var->tag != V_INT)
+                    fail("FOR variable assigned a non-integer");
+                i = (long long)var->i + by.i;
+            }
+            return F_NEXT;
+        }
+        case C_EXIT:
+            return F_EXIT;
+        case C_RETURN:
+            if (c->a)
+                store(&result, eval(c->a, f), c->kind);
+            return F_RETURN;
+        default:
+            fail("not a statement");
+            return F_NEXT;
+        }
+    }
+
+public:
+    Interpreter()
+        : main(NULL), stack(NULL), sp(NULL), globals(NULL), native_base(NULL), steps(0),
+          in(stdin), out(stdout)
+    {
+        memset((void*)&v, 0, sizeof(v));
+    }
+
+    ~Interpreter() {
+        delete[] stack;
+    }
+
+    // resolves the program in tree; false with error set if it refers to
+    // something undeclared or calls something wrongly
+    bool compile(const FlatView& tree, std::string& error) {
+        v = tree;
+        try {
+            if (v.root == NO_NODE || v.kind_of(v.root) != N_PROGRAM)
+                fail("no program");
+            predeclare();
+            procs.push_back(Proc());
+            main = &procs.back();
+            main->name = intern("PROGRAM");
+            nest.push_back(main);
+            main->body = compile_body(v.child(v.root, 0));
+            nest.pop_back();
+            scopes.close();
+            return true;
+        } catch (const InterpError& e) {
+            error = e.message;
+            return false;
+        }
+    }
+
+    // the compiled main program, for the bytecode compiler; the procedures
+    // and record types it refers to live as long as the interpreter
+    const Proc* program() const {
+        return main;
+    }
+
+    // runs the compiled program; READ and WRITE use the given streams
+    bool run(std::string& error, FILE* input = stdin, FILE* output = stdout) {
+        in = input;
+        out = output;
+        if (!stack)
+            stack = new Value[stack_slots];
+        sp = stack;
+        steps = 0;
+        char base;
+        native_base = &base;
+        try {
+            if (main->slots > stack_slots)
+                fail("out of stack");
+            Frame frame;
+            frame.slots = sp;
+            frame.up = NULL;
+            globals = &frame;
+            sp += main->slots;
+            for (unsigned i = 0; i < main->slots; ++i)
+                frame.slots[i] = nil_value();
+            exec(main->body, &frame);
+            fflush(out);
+            return true;
+        } catch (const InterpError& e) {
+            fflush(out);
+            error = e.message;
+            return false;
+        }
+    }
+
+    // statements executed by the last run
+    unsigned long long statements() const {
+        return steps;
+    }
+
+    // bytes of the records and arrays the last run made
+    size_t heap_bytes() const {
+        return heap.bytes_allocated();
+    }
+};
+
+#endif
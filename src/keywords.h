@@ -0,0 +1,102 @@
+// keyword recognition for the lexer: a perfect hash over the reserved
+// words, so an identifier-shaped token costs one table probe and one
+// memcmp instead of a scan over every terminal of the grammar
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <cstddef>
+#include <cstring>
+#include "main.tab.h"
+
+struct Keyword {
+    const char* word;
+    size_t len;
+    int code;
+};
+
+// the hash below is collision free for exactly these words; regenerate the
+// table if a keyword is added
+inline const Keyword& keyword_slot(const char* s, size_t n) {
+    static const Keyword table[64] = {
+        { "READ", 4, KW_READ },
+        { "DIV", 3, KW_DIV },
+        { "RECORD", 6, KW_RECORD },
+        { "VAR", 3, KW_VAR },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { "TO", 2, KW_TO },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { "END", 3, KW_END },
+        { "OF", 2, KW_OF },
+        { "LOOP", 4, KW_LOOP },
+        { "FOR", 3, KW_FOR },
+        { "WHILE", 5, KW_WHILE },
+        { NULL, 0, 0 },
+        { "BY", 2, KW_BY },
+        { NULL, 0, 0 },
+        { "OUT", 3, KW_OUT },
+        { "ELSE", 4, KW_ELSE },
+        { "MOD", 3, KW_MOD },
+        { "PROGRAM", 7, KW_PROGRAM },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { "INTEGER", 7, TYPES },
+        { "STRING", 6, TYPES },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { "REAL", 4, TYPES },
+        { "EXIT", 4, KW_EXIT },
+        { "ELSIF", 5, KW_ELSIF },
+        { NULL, 0, 0 },
+        { "WRITE", 5, KW_WRITE },
+        { NULL, 0, 0 },
+        { "TYPE", 4, KW_TYPE },
+        { "IN", 2, KW_IN },
+        { "AND", 3, KW_AND },
+        { "BEGIN", 5, KW_BEGIN },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { "IS", 2, KW_IS },
+        { "ARRAY", 5, KW_ARRAY },
+        { "NOT", 3, KW_NOT },
+        { "THEN", 4, KW_THEN },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { "OR", 2, KW_OR },
+        { NULL, 0, 0 },
+        { "IF", 2, KW_IF },
+        { "DO", 2, KW_DO },
+        { "PROCEDURE", 9, KW_PROCEDURE },
+        { "RETURN", 6, KW_RETURN },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+        { NULL, 0, 0 },
+    };
+    unsigned h = 25 * (unsigned char)s[0] + 2 * (unsigned char)s[1]
+                 + 12 * (unsigned char)s[n-1] + (unsigned)n;
+    return table[h & 63];
+}
+
+// token code of a reserved word (TYPES for the builtin type names),
+// 0 if the text is an ordinary identifier
+inline int keyword_code(const char* s, size_t n) {
+    if (n < 2 || n > 9)
+        return 0;
+    const Keyword& k = keyword_slot(s, n);
+    if (k.len == n && memcmp(k.word, s, n) == 0)
+        return k.code;
+    return 0;
+}
+
+#endif
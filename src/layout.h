@@ -0,0 +1,60 @@
+// how records and arrays are laid out in memory. Every field and element
+// is stored as a slot chosen from its declared type: an INTEGER in 4
+// bytes, a REAL in 8, a BOOLEAN in 1, a record or array as a pointer.
+// Each record type gets fixed field offsets once its field types are
+// known; an array's elements follow each other at the size of its slot.
+// A slot only holds values of its own tag, value.h moves an object given
+// anything else to plain Values, so the layout never changes a result
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <vector>
+
+// what a field or element is stored as
+enum Slot {
+    S_VALUE,  // a tagged Value, whatever it holds
+    S_INT,    // an int
+    S_REAL,   // a double
+    S_BOOL,   // a byte, 0 or 1
+    S_REF     // an Object*, NIL is a null pointer
+};
+
+inline unsigned slot_size(unsigned char s) {
+    static const unsigned char sizes[] = { 16, 4, 8, 1, 8 };
+    return sizes[s];
+}
+
+inline unsigned slot_align(unsigned char s) {
+    return s == S_VALUE ? 8 : slot_size(s);
+}
+
+// where the fields of a record type are; the size is a multiple of the
+// alignment so records can be allocated back to back
+struct Layout {
+    std::vector<unsigned> offsets;  // per field, in declaration order
+    unsigned size;
+    unsigned align;
+
+    Layout() : size(0), align(1) {}
+};
+
+// fixed offsets for fields stored as slots: the most aligned fields go
+// first, so the only padding is at the end
+inline Layout lay_out(const std::vector<unsigned char>& slots) {
+    Layout l;
+    l.offsets.resize(slots.size());
+    for (unsigned a = 8; a; a /= 2) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slot_align(slots[i]) != a)
+                continue;
+            l.offsets[i] = l.size;
+            l.size += slot_size(slots[i]);
+            if (a > l.align)
+                l.align = a;
+        }
+    }
+    l.size = (l.size + l.align - 1) / l.align * l.align;
+    return l;
+}
+
+#endif
@@ -0,0 +1,381 @@
+// a hand-written scanner for the language of tokenizer.l, linked in place
+// of the flex one with make LEXER=simd. Runs of blanks, identifier and
+// digit characters and the insides of comments and strings are skipped
+// 16 bytes at a time with SSE2, or 32 with AVX2 when built for it (add
+// -mavx2 to SIMD); everything else is one switch on the first byte.
+// Token codes, positions, tree leaves and diagnostics are the flex
+// scanner's, tests/lexer_fuzz.sh compares the two.
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "syntax.h"
+#include "context.h"
+#define YYSTYPE SemValue
+
+#include "main.tab.h"
+#include "keywords.h"
+
+namespace {
+
+const int tab_width = 8;
+
+#if defined(__AVX2__)
+typedef __m256i Vec;
+const int vec_width = 32;
+const unsigned all_lanes = ~0u;
+inline Vec load(const char* p) { return _mm256_loadu_si256((const __m256i*)p); }
+inline Vec splat(char c) { return _mm256_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+inline Vec gt(Vec a, Vec b) { return _mm256_cmpgt_epi8(a, b); }
+inline Vec both(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+inline Vec either(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+inline unsigned bits(Vec v) { return (unsigned)_mm256_movemask_epi8(v); }
+#elif defined(__SSE2__)
+typedef __m128i Vec;
+const int vec_width = 16;
+const unsigned all_lanes = 0xffff;
+inline Vec load(const char* p) { return _mm_loadu_si128((const __m128i*)p); }
+inline Vec splat(char c) { return _mm_set1_epi8(c); }
+inline Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+inline Vec gt(Vec a, Vec b) { return _mm_cmpgt_epi8(a, b); }
+inline Vec both(Vec a, Vec b) { return _mm_and_si128(a, b); }
+inline Vec either(Vec a, Vec b) { return _mm_or_si128(a, b); }
+inline unsigned bits(Vec v) { return (unsigned)_mm_movemask_epi8(v); }
+#endif
+
+#ifdef __SSE2__
+// lanes holding lo..hi; the compare is signed, so bytes from 0x80 up are
+// negative and fall outside every ASCII range
+inline Vec in_range(Vec v, char lo, char hi) {
+    return both(gt(v, splat(lo - 1)), gt(splat(hi + 1), v));
+}
+#endif
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+inline bool is_letter(char c) { return (c | 0x20) >= 'a' && (c | 0x20) <= 'z'; }
+
+// the classes of bytes a run is skipped up to: stops(v) has a bit set for
+// each lane that ends the run
+
+struct Blanks {
+    static bool stops(char c) { return c != ' '; }
+#ifdef __SSE2__
+    static unsigned stops(Vec v) { return ~bits(eq(v, splat(' '))); }
+#endif
+};
+
+struct Digits {
+    static bool stops(char c) { return !is_digit(c); }
+#ifdef __SSE2__
+    static unsigned stops(Vec v) { return ~bits(in_range(v, '0', '9')); }
+#endif
+};
+
+struct WordChars {
+    static bool stops(char c) { return !is_letter(c) && !is_digit(c); }
+#ifdef __SSE2__
+    static unsigned stops(Vec v) {
+        Vec lower = either(v, splat(0x20));
+        return ~bits(either(in_range(lower, 'a', 'z'), in_range(v, '0', '9')));
+    }
+#endif
+};
+
+// inside a comment: the stars that may close it
+struct Stars {
+    static bool stops(char c) { return c == '*'; }
+#ifdef __SSE2__
+    static unsigned stops(Vec v) { return bits(eq(v, splat('*'))); }
+#endif
+};
+
+// the bytes that move the position other than one column on
+struct LineBreaks {
+    static bool stops(char c) { return c == '\n' || c == '\t'; }
+#ifdef __SSE2__
+    static unsigned stops(Vec v) { return bits(either(eq(v, splat('\n')), eq(v, splat('\t')))); }
+#endif
+};
+
+// the first byte of p..end that class C stops at, or end
+template <class C>
+inline const char* skip(const char* p, const char* end) {
+#ifdef __SSE2__
+    while (end - p >= vec_width) {
+        unsigned stop = C::stops(load(p)) & all_lanes;
+        if (stop)
+            return p + __builtin_ctz(stop);
+        p += vec_width;
+    }
+#endif
+    while (p < end && !C::stops(*p))
+        ++p;
+    return p;
+}
+
+struct Scanner {
+    ParseContext* ctx;
+    const char* p;      // the next byte
+    const char* end;
+    FILE* in;           // read in blocks into file, NULL once all of it is
+    std::vector<char> file;
+    const char* token;  // the last token, for yyget_text
+    size_t token_len;
+    std::string text;   // its NUL terminated copy
+};
+
+const size_t block = 1 << 16;
+
+// the buffer ends at end but the input may not: keeps p..end, reads on
+// after it and moves p and end to the same bytes in the new buffer. The
+// token at p is then scanned again, so the buffer holds at least the
+// longest token or comment, never the whole input.
+inline bool more(Scanner* s, const char*& p, const char*& end) {
+    if (!s->in)
+        return false;
+    std::vector<char>& buf = s->file;
+    size_t kept = end - p;
+    memmove(&buf[0], p, kept);
+    if (buf.size() < kept + block)
+        buf.resize(std::max(2 * buf.size(), kept + block));
+    size_t n = fread(&buf[kept], 1, buf.size() - kept, s->in);
+    if (n == 0)
+        s->in = NULL;
+    p = &buf[0];
+    end = p + kept + n;
+    return true;
+}
+
+// moves ln:col past a..b, which may hold tabs and newlines
+inline void advance(const char* a, const char* b, int& ln, int& col) {
+    for (;;) {
+        const char* s = skip<LineBreaks>(a, b);
+        col += (int)(s - a);
+        if (s == b)
+            return;
+        if (*s == '\n') {
+            col = 1;
+            ln += 1;
+        } else {
+            col = ((col - 1) / tab_width + 1) * tab_width + 1;
+        }
+        a = s + 1;
+    }
+}
+
+}
+
+yyscan_t lexer_create(ParseContext* ctx) {
+    Scanner* s = new Scanner;
+    s->ctx = ctx;
+    s->p = s->end = s->token = "";
+    s->in = NULL;
+    s->token_len = 0;
+    return s;
+}
+
+void lexer_destroy(yyscan_t scanner) {
+    delete (Scanner*)scanner;
+}
+
+void scan_in_place(yyscan_t scanner, char* base, size_t size) {
+    Scanner* s = (Scanner*)scanner;
+    s->ctx->input_stable = true;
+    s->in = NULL;
+    s->p = base;
+    s->end = base + size;
+}
+
+void scan_file(yyscan_t scanner, FILE* in) {
+    Scanner* s = (Scanner*)scanner;
+    s->ctx->input_stable = false;
+    s->in = in;
+    s->file.assign(block, '\0');
+    s->p = s->end = &s->file[0];
+}
+
+ParseContext* yyget_extra(yyscan_t scanner) {
+    return ((Scanner*)scanner)->ctx;
+}
+
+char* yyget_text(yyscan_t scanner) {
+    Scanner* s = (Scanner*)scanner;
+    s->text.assign(s->token, s->token_len);
+    return &s->text[0];
+}
+
+int yylex(SemValue* yylval, yyscan_t scanner) {
+    Scanner* s = (Scanner*)scanner;
+    ParseContext* ctx = s->ctx;
+    const char* p = s->p;
+    const char* end = s->end;
+    int ln = ctx->ln;
+    int col = ctx->col;
+    int code;
+    const char* q;
+
+// every token ends here: q is past it
+#define RETURN(c) \
+    do { code = (c); goto done; } while (0)
+#define LEAF(kind, text, make) \
+    yylval->flat = ctx->scan_only ? NO_NODE \
+                   : ctx->flat.set_pos(ctx->flat.add(kind, ctx->flat.str(text)), ln, col); \
+    yylval->node = ctx->build_tree && !ctx->scan_only ? (Node*)(make) : NULL
+
+    for (;;) {
+        // two bytes tell every operator apart
+        if (end - p < 2 && more(s, p, end))
+            continue;
+        if (p == end) {
+            // syntax errors at the end point past the last character
+            q = p;
+            RETURN(0);
+        }
+        switch (*p) {
+        case ' ':
+            q = skip<Blanks>(p + 1, end);
+            col += (int)(q - p);
+            p = q;
+            continue;
+        case '\t':
+            col = ((col - 1) / tab_width + 1) * tab_width + 1;
+            ++p;
+            continue;
+        case '\n':
+            col = 1;
+            ln += 1;
+            ++p;
+            continue;
+        case '\r':
+            ++p;
+            continue;
+        case '(':
+            if (p + 1 < end && p[1] == '*') {
+                // comments end at the first *) and may span lines
+                q = p + 2;
+                for (;;) {
+                    q = skip<Stars>(q, end);
+                    if (q == end || (q + 1 < end && q[1] == ')'))
+                        break;
+                    ++q;
+                }
+                if (q == end && more(s, p, end))
+                    continue;
+                if (q == end) {
+                    ctx->report(ln, col, "(*", "unterminated comment");
+                } else {
+                    q += 2;
+                }
+                advance(p, q, ln, col);
+                p = q;
+                continue;
+            }
+            q = p + 1;
+            RETURN(LPAREN);
+        case '"': {
+            const char* close = (const char*)memchr(p + 1, '"', end - p - 1);
+            if (!close && more(s, p, end))
+                continue;
+            if (!close)
+                break;
+            q = close + 1;
+            LEAF(N_STRING, Text(p, q - p), new String(ctx->literal_text(p, q - p)));
+            // the one token that may span lines
+            ctx->tok_ln = ln;
+            ctx->tok_col = col;
+            advance(p, q, ln, col);
+            s->token = p;
+            s->token_len = q - p;
+            s->p = q;
+            s->end = end;
+            ctx->ln = ln;
+            ctx->col = col;
+            return STRING;
+        }
+        case ':':
+            q = p + 1 + (p + 1 < end && p[1] == '=');
+            RETURN(q - p == 2 ? ASSIGN : COLON);
+        case ';': q = p + 1; RETURN(SEMICOLON);
+        case ',': q = p + 1; RETURN(COMMA);
+        case '.': q = p + 1; RETURN(DOT);
+        case ')': q = p + 1; RETURN(RPAREN);
+        case '[':
+            q = p + 1 + (p + 1 < end && p[1] == '<');
+            RETURN(q - p == 2 ? LARRAY : LBRACKET);
+        case ']': q = p + 1; RETURN(RBRACKET);
+        case '{': q = p + 1; RETURN(LBRACE);
+        case '}': q = p + 1; RETURN(RBRACE);
+        case '\\': q = p + 1; RETURN(BACKSLASH);
+        case '+': q = p + 1; RETURN(PLUS);
+        case '-': q = p + 1; RETURN(MINUS);
+        case '*': q = p + 1; RETURN(STAR);
+        case '/': q = p + 1; RETURN(SLASH);
+        case '=': q = p + 1; RETURN(EQ);
+        case '<':
+            q = p + 1;
+            if (q == end || (*q != '=' && *q != '>'))
+                RETURN(LT);
+            RETURN(*q++ == '=' ? LE : NE);
+        case '>':
+            q = p + 1;
+            if (q == end || (*q != '=' && *q != ']'))
+                RETURN(GT);
+            RETURN(*q++ == '=' ? GE : RARRAY);
+        default:
+            if (is_letter(*p)) {
+                q = skip<WordChars>(p + 1, end);
+                if (q == end && more(s, p, end))
+                    continue;
+                // reserved words are identifier shaped, tell them apart with one probe
+                code = keyword_code(p, q - p);
+                if (code == TYPES) {
+                    LEAF(N_BUILTIN_TYPE, intern(p, q - p), new BuiltinType(p, q - p));
+                } else if (code == 0) {
+                    LEAF(N_ID, intern(p, q - p), new Id(p, q - p));
+                    code = IDENTIFIER;
+                }
+                goto done;
+            }
+            if (is_digit(*p)) {
+                q = skip<Digits>(p + 1, end);
+                code = INTEGER;
+                if (q < end && *q == '.') {
+                    q = skip<Digits>(q + 1, end);
+                    code = REAL;
+                }
+                if (q == end && more(s, p, end))
+                    continue;
+                // the value is read here, once; the token is its number expression
+                Literal k;
+                yylval->flat = ctx->number(Text(p, q - p), ln, col, k);
+                yylval->node = ctx->build_tree && !ctx->scan_only
+                               ? new Number(ctx->literal_text(p, q - p), k) : NULL;
+                goto done;
+            }
+            break;
+        }
+        // no token starts with this byte
+        ctx->report(ln, col, std::string(p, 1), "unexpected character");
+        col += 1;
+        ++p;
+    }
+
+done:
+    // q is past a token on one line that started at p
+    ctx->tok_ln = yylval->ln = ln;
+    ctx->tok_col = yylval->col = col;
+    s->token = p;
+    s->token_len = q - p;
+    s->p = q;
+    s->end = end;
+    ctx->ln = ln;
+    ctx->col = col + (int)(q - p);
+    return code;
+#undef RETURN
+#undef LEAF
+}
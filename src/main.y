@@ -2,124 +2,344 @@
 #include <cstring>
 #include <cstdio>
 #include <iostream>
+#include <sstream>
 using namespace std;
 
 #include "syntax.h"
+#include "tokenizer.h"
+#include "context.h"
+
+#define YYSTYPE SemValue
+// plain data: lets the parser grow its stacks with memcpy instead of
+// failing at YYINITDEPTH, which C++ otherwise forces
+#define YYSTYPE_IS_TRIVIAL 1
+
+void yyerror(yyscan_t scanner, const char *s);
+
+// every action adds its node to the flat tree; the class tree is only
+// built when the parse context asks for it
+#define CTX yyget_extra(scanner)
+#define FLAT (yyget_extra(scanner)->flat)
+#define TREE(e) (yyget_extra(scanner)->build_tree ? (Node*)(e) : NULL)
+#define LIST(v) FLAT.close_list((v).flat)
+// node n, which starts with keyword token tok
+#define AT(tok, n) FLAT.set_pos(n, (tok).ln, (tok).col)
+
+static SemValue sem(unsigned flat, Node* node) {
+    SemValue v;
+    v.node = node;
+    v.flat = flat;
+    return v;
+}
+
+static SemValue none() {
+    return sem(NO_NODE, NULL);
+}
+
+template <class T>
+static SemValue new_list(ParseContext* ctx) {
+    return sem(ctx->flat.open_list(), ctx->build_tree ? new Multi<T>() : NULL);
+}
+
+template <class T>
+static void append(ParseContext* ctx, SemValue& list, const SemValue& item) {
+    if (list.node)
+        ((Multi<T>*)list.node)->add((T*)item.node);
+    ctx->flat.push_list(list.flat, item.flat);
+}
+
+template <class T>
+static SemValue single(ParseContext* ctx, const SemValue& item) {
+    SemValue v = new_list<T>(ctx);
+    append<T>(ctx, v, item);
+    return v;
+}
+
+// an item of the program's own body in a streaming parse: handed over,
+// then its nodes are dropped; false if it goes into the tree as usual.
+// lookahead is the leaf of the token the parser has already scanned, if
+// it has one
+static bool streamed(ParseContext* ctx, StreamItem what, const SemValue& item,
+                     unsigned lookahead) {
+    if (!ctx->stream || ctx->depth != 0)
+        return false;
+    if (ctx->errors.empty())
+        ctx->stream(what, ctx->flat.view(), item.flat);
+    // every node since the last item is this one's, except a lookahead
+    // leaf scanned before the reduction: that one has to stay
+    if ((lookahead == NO_NODE || lookahead < ctx->stream_mark.nodes)
+        && item.flat == ctx->flat.size() - 1)
+        ctx->flat.rewind(ctx->stream_mark);
+    ctx->stream_mark = ctx->flat.mark();
+    return true;
+}
+
+#define STREAMED(what, item) \
+    streamed(CTX, what, item, yychar == IDENTIFIER || yychar == INTEGER || yychar == REAL \
+                              || yychar == STRING || yychar == TYPES ? yylval.flat : NO_NODE)
+
+// the leaf of operator token tok
+static SemValue op_leaf(ParseContext* ctx, const SemValue& tok, const char* op) {
+    unsigned leaf = ctx->flat.add(N_OP, ctx->flat.str(intern(op)));
+    return sem(ctx->flat.set_pos(leaf, tok.ln, tok.col), ctx->build_tree ? new Op(op) : NULL);
+}
+
+// with --fold, op on numbers (e and, for a binary op, l) is replaced by
+// the number it gives; the operands go from the tree unless something came
+// after them. An overflow is reported at the operator, tok, and the
+// expression is built as it is
+static bool fold(ParseContext* ctx, const SemValue& tok, const char* op, const SemValue* l,
+                 const SemValue& e, SemValue& out) {
+    FlatAst& flat = ctx->flat;
+    if (!ctx->fold || e.flat == NO_NODE || (l && l->flat == NO_NODE))
+        return false;
+    FlatView v = flat.view();
+    if (v.kind_of(e.flat) != N_NUMBER_EXPR || (l && v.kind_of(l->flat) != N_NUMBER_EXPR))
+        return false;
+    Literal k;
+    Folded how = l ? fold_binary(op, v.number(l->flat), v.number(e.flat), k)
+                   : fold_unary(op, v.number(e.flat), k);
+    if (how == FOLD_OVERFLOW)
+        ctx->report(tok.ln, tok.col, op, "constant out of range");
+    if (how != FOLDED)
+        return false;
+    // the number stands where the expression starts
+    int ln = l ? (int)v.pos_of(l->flat).ln : tok.ln;
+    int col = l ? (int)v.pos_of(l->flat).col : tok.col;
+    // each number is its leaf and its expression, the two last nodes added
+    if (e.flat == flat.size() - 1 && (!l || l->flat + 2 == e.flat))
+        flat.rewind(flat.before_number(l ? l->flat : e.flat));
+    std::string s = literal_spelling(k);
+    Node* node = NULL;
+    if (ctx->build_tree)
+        node = new NumberExpr(new Number(arena_text(s.data(), s.size()), k));
+    out = sem(flat.add_number(Text(s.data(), s.size()), k, ln, col), node);
+    return true;
+}
+
+static SemValue unary(ParseContext* ctx, const SemValue& tok, const char* op,
+                      const SemValue& e) {
+    SemValue folded;
+    if (fold(ctx, tok, op, NULL, e, folded))
+        return folded;
+    SemValue o = op_leaf(ctx, tok, op);
+    return sem(ctx->flat.add(N_UNARY_EXPR, 0, o.flat, e.flat),
+               ctx->build_tree ? new UnaryOpExpr((Op*)o.node, (Expr*)e.node) : NULL);
+}
+
+static SemValue binary(ParseContext* ctx, const SemValue& l, const SemValue& tok,
+                       const char* op, const SemValue& r) {
+    SemValue folded;
+    if (fold(ctx, tok, op, &l, r, folded))
+        return folded;
+    SemValue o = op_leaf(ctx, tok, op);
+    return sem(ctx->flat.add(N_BINOP_EXPR, 0, l.flat, o.flat, r.flat),
+               ctx->build_tree ? new BinOpExpr((Op*)o.node, (Expr*)l.node, (Expr*)r.node)
+                               : NULL);
+}
+%}
 
-extern "C" int yylex();
-extern "C" FILE *yyin;
-// defined in the tokenizer
-extern "C" int ln, col;
-extern "C" char* yytext;
-
-void yyerror(const char *s);
+%code requires {
+#include "context.h"
+}
 
-#define YYSTYPE Node*
-%}
+// reentrant: all state is reached through the scanner, see ParseContext
+%define api.pure full
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner}
 
 %token TYPES
 %token INTEGER
 %token REAL
-%token OPERATOR
 %token STRING
 %token IDENTIFIER
-%token-table // keywords and delimiters are literal strings
+
+// keywords and delimiters; the lexer returns these codes directly and the
+// grammar refers to them by their quoted spelling
+%token KW_AND "AND"
+%token KW_ELSIF "ELSIF"
+%token KW_LOOP "LOOP"
+%token KW_PROGRAM "PROGRAM"
+%token KW_VAR "VAR"
+%token KW_ARRAY "ARRAY"
+%token KW_END "END"
+%token KW_MOD "MOD"
+%token KW_READ "READ"
+%token KW_WHILE "WHILE"
+%token KW_BEGIN "BEGIN"
+%token KW_EXIT "EXIT"
+%token KW_NOT "NOT"
+%token KW_RECORD "RECORD"
+%token KW_WRITE "WRITE"
+%token KW_BY "BY"
+%token KW_FOR "FOR"
+%token KW_OF "OF"
+%token KW_RETURN "RETURN"
+%token KW_DIV "DIV"
+%token KW_IF "IF"
+%token KW_OR "OR"
+%token KW_THEN "THEN"
+%token KW_DO "DO"
+%token KW_IN "IN"
+%token KW_OUT "OUT"
+%token KW_TO "TO"
+%token KW_ELSE "ELSE"
+%token KW_IS "IS"
+%token KW_PROCEDURE "PROCEDURE"
+%token KW_TYPE "TYPE"
+%token ASSIGN ":="
+%token COLON ":"
+%token SEMICOLON ";"
+%token COMMA ","
+%token DOT "."
+%token LPAREN "("
+%token RPAREN ")"
+%token LBRACKET "["
+%token RBRACKET "]"
+%token LBRACE "{"
+%token RBRACE "}"
+%token LARRAY "[<"
+%token RARRAY ">]"
+%token BACKSLASH "\\"
+%token PLUS "+"
+%token MINUS "-"
+%token STAR "*"
+%token SLASH "/"
+%token LT "<"
+%token LE "<="
+%token GT ">"
+%token GE ">="
+%token EQ "="
+%token NE "<>"
+
+// PCAT operator precedence, loosest first; all binary operators are left
+// associative and comparisons do not chain
+%nonassoc "<" "<=" ">" ">=" "=" "<>"
+%left "+" "-" "OR"
+%left "*" "/" "DIV" "MOD" "AND"
+%precedence UNARY
 
 %define parse.error verbose 
+
+// error recovery: a syntax error is reported, then the parser skips to the
+// end of the statement, declaration or bracketed expression it is in and
+// goes on, so one run finds every error. Bison keeps quiet until three
+// tokens past each recovery, which hides the errors the skipping causes.
+// The tree of an input with errors is never used; the parts that had them
+// are left out or NO_NODE.
+
+// a procedure whose body recovery skips out of is left all the same
+%destructor { CTX->depth--; } proc_enter
 %%
 
 program: "PROGRAM" "IS" body ";" 
- { Program* prog = new Program((Body*)$3);
-   prog->print(0);
-   $$ = prog;
+ { $$ = sem(AT($1, FLAT.add(N_PROGRAM, 0, $3.flat)), TREE(new Program((Body*)$3.node)));
+   FLAT.set_root($$.flat);
+   CTX->program = (Program*)$$.node;
  };
 
-body: declaration_block "BEGIN" statement_block "END" 
+body: declaration_block "BEGIN" body_statements "END" 
 { 
-  $$ = new Body((Multi<Decl>*)$1, (Multi<Stat>*)$3); 
+  unsigned decls = LIST($1);
+  $$ = sem(FLAT.add(N_BODY, 0, decls, LIST($3)),
+           TREE(new Body((Multi<Decl>*)$1.node, (Multi<Stat>*)$3.node)));
 };
 
-declaration_block: declaration declaration_block 
+declaration_block: declaration_block declaration 
 { 
-  ((Multi<Decl>*)$2)->add((Decl*)$1); 
- $$=$2; 
+  $$ = $1;
+  if (!STREAMED(STREAM_DECL, $2))
+    append<Decl>(CTX, $$, $2);
 }
-| { $$ = new Multi<Decl>(); }  ;
+| { $$ = new_list<Decl>(CTX); }  ;
 
-statement_block: statement statement_block 
+// the statements of a body; those of the program's own body may be streamed
+body_statements: body_statements statement 
 {
-  ((Multi<Stat>*)$2)->add((Stat*)$1);
-  $$ = $2;
+  $$ = $1;
+  if (!STREAMED(STREAM_STAT, $2))
+    append<Stat>(CTX, $$, $2);
+}
+| body_statements error ";" { $$ = $1; }
+| { $$ = new_list<Stat>(CTX); } ;
+
+statement_block: statement_block statement 
+{
+  $$ = $1;
+  append<Stat>(CTX, $$, $2);
 }
-| { $$ = new Multi<Stat>(); } ;
+| statement_block error ";" { $$ = $1; }
+| { $$ = new_list<Stat>(CTX); } ;
 
 declaration: "VAR" var_decl_block 
 {
-  $$ = new Decl("var", (Multi<Node>*)$2);
+  $$ = sem(AT($1, FLAT.add(N_DECL, DECL_VAR, LIST($2))),
+           TREE(new Decl("var", (Multi<Node>*)$2.node)));
 }
 | "TYPE" type_decl_block
 {
-  $$ = new Decl("type", (Multi<Node>*)$2);
+  $$ = sem(AT($1, FLAT.add(N_DECL, DECL_TYPE, LIST($2))),
+           TREE(new Decl("type", (Multi<Node>*)$2.node)));
 }
 | "PROCEDURE" proc_decl_block 
 {
-  $$ = new Decl("procedure", (Multi<Node>*)$2);
+  $$ = sem(AT($1, FLAT.add(N_DECL, DECL_PROCEDURE, LIST($2))),
+           TREE(new Decl("procedure", (Multi<Node>*)$2.node)));
 };
 
-var_decl_block: var_decl var_decl_block 
+var_decl_block: var_decl_block var_decl 
 {
-  ((Multi<VarDecl>*)$2)->add((VarDecl*)$1);
-  $$ = $2;
+  $$ = $1;
+  append<VarDecl>(CTX, $$, $2);
 }
 | var_decl 
 {
-  Multi<VarDecl>* v = new Multi<VarDecl>();
-  v->add((VarDecl*)$1);
-  $$ = v;
+  $$ = single<VarDecl>(CTX, $1);
 }
+| var_decl_block error ";" { $$ = $1; }
+| error ";" { $$ = new_list<VarDecl>(CTX); }
 ;
 
-type_decl_block: type_decl type_decl_block 
+type_decl_block: type_decl_block type_decl 
 {
-  ((Multi<TypeDecl>*)$2)->add((TypeDecl*)$1);
-  $$ = $2;
+  $$ = $1;
+  append<TypeDecl>(CTX, $$, $2);
 }
 | type_decl
 {
-  Multi<TypeDecl>* v = new Multi<TypeDecl>();
-  v->add((TypeDecl*)$1);
-  $$ = v;
+  $$ = single<TypeDecl>(CTX, $1);
 }
+| type_decl_block error ";" { $$ = $1; }
+| error ";" { $$ = new_list<TypeDecl>(CTX); }
 ;
 
-proc_decl_block: proc_decl proc_decl_block 
+proc_decl_block: proc_decl_block proc_decl 
 {
-  ((Multi<ProcDecl>*)$2)->add((ProcDecl*)$1);
-  $$ = $2;
+  $$ = $1;
+  append<ProcDecl>(CTX, $$, $2);
 }
 | proc_decl
 {
-  Multi<ProcDecl>* v = new Multi<ProcDecl>();
-  v->add((ProcDecl*)$1);
-  $$ = v;
+  $$ = single<ProcDecl>(CTX, $1);
 }
+| proc_decl_block error ";" { $$ = $1; }
+| error ";" { $$ = new_list<ProcDecl>(CTX); }
 ;
 
 var_decl: id_block type_opt ":=" expr ";" 
 {
-  $$ = new VarDecl((Multi<Id>*)$1, (Type*)$2, (Expr*)$4);
+  $$ = sem(FLAT.add(N_VAR_DECL, 0, LIST($1), $2.flat, $4.flat),
+           TREE(new VarDecl((Multi<Id>*)$1.node, (Type*)$2.node, (Expr*)$4.node)));
 };
 
-id_block: IDENTIFIER "," id_block 
+id_block: id_block "," IDENTIFIER 
 {
-  ((Multi<Id>*)$3)->add((Id*)$1);
-  $$ = $3;
+  $$ = $1;
+  append<Id>(CTX, $$, $3);
 }
 | IDENTIFIER
 {
-  Multi<Id>* v = new Multi<Id>();
-  v->add((Id*)$1);
-  $$ = v;
+  $$ = single<Id>(CTX, $1);
 }
 ;
 
@@ -127,22 +347,31 @@ type_opt: ":" type
 {
   $$ = $2;
 }
-| { $$ = NULL; };
+| { $$ = none(); };
 
 type_decl: IDENTIFIER "IS" type ";" 
 {
-  $$ = new TypeDecl((Id*)$1, (Type*)$3);
+  $$ = sem(FLAT.add(N_TYPE_DECL, 0, $1.flat, $3.flat),
+           TREE(new TypeDecl((Id*)$1.node, (Type*)$3.node)));
 }
 ;
 
-proc_decl: IDENTIFIER formal_params type_opt "IS" body ";" 
+proc_decl: IDENTIFIER formal_params type_opt "IS" proc_enter body terminator
 {
-  $$ = new ProcDecl((Id*)$1, (Multi<FPSec>*)$2, (Type*)$3, (Body*)$5);
+  (void)$5;
+  CTX->depth--;
+  $$ = sem(FLAT.add(N_PROC_DECL, 0, $1.flat, LIST($2), $3.flat, $6.flat),
+           TREE(new ProcDecl((Id*)$1.node, (Multi<FPSec>*)$2.node, (Type*)$3.node,
+                             (Body*)$6.node)));
 };
 
+// the parser is inside one more procedure body until proc_decl is reduced
+// or proc_enter is dropped
+proc_enter: { CTX->depth++; $$ = none(); } ;
+
 type: IDENTIFIER 
 {
-  $$ = new UserType((Id*)$1);
+  $$ = sem(FLAT.add(N_USER_TYPE, 0, $1.flat), TREE(new UserType((Id*)$1.node)));
 }
 | TYPES 
 {
@@ -150,145 +379,162 @@ type: IDENTIFIER
 }
 | "ARRAY" "OF" type 
 {
-  $$ = new ArrayType((Type *)$3);
+  $$ = sem(FLAT.add(N_ARRAY_TYPE, 0, $3.flat), TREE(new ArrayType((Type *)$3.node)));
 }
 | "RECORD" component_block "END"
 {
-  $$ = new RecordType((Multi<Component>*)$2);
+  $$ = sem(FLAT.add(N_RECORD_TYPE, 0, LIST($2)),
+           TREE(new RecordType((Multi<Component>*)$2.node)));
 }
 ;
 
-component_block: component component_block 
+component_block: component_block component 
 {
-  ((Multi<Component>*)$2)->add((Component*)$1);
-  $$ = $2;
+  $$ = $1;
+  append<Component>(CTX, $$, $2);
 }
 | component 
 {
-  Multi<Component>* v = new Multi<Component>();
-  v->add((Component*)$1);
-  $$ = v;
+  $$ = single<Component>(CTX, $1);
 }
 ;
 
 component: IDENTIFIER ":" type ";"
 {
-  $$ = new Component((Id*)$1, (Type*)$3);
+  $$ = sem(FLAT.add(N_COMPONENT, 0, $1.flat, $3.flat),
+           TREE(new Component((Id*)$1.node, (Type*)$3.node)));
 }
 ;
 
 formal_params: "(" fp_section_block ")"  { $$ = $2; } 
 | "(" ")"
 {
-  $$ = NULL;
+  $$ = none();
 }
+| "(" error ")" { $$ = none(); }
 ;
 
-fp_section_block: fp_section ";" fp_section_block 
+fp_section_block: fp_section_block ";" fp_section 
 {
-  ((Multi<FPSec>*)$3)->add((FPSec*)$1);
-  $$ = $3;
+  $$ = $1;
+  append<FPSec>(CTX, $$, $3);
 }
 | fp_section
 {
-  Multi<FPSec>* v = new Multi<FPSec>;
-  v->add((FPSec*)$1);
-  $$ = v;
+  $$ = single<FPSec>(CTX, $1);
 }
 ;
 
 fp_section: id_block ":" type
 {
-  $$ = new FPSec((Multi<Id>*)$1, (Type*)$3);
+  $$ = sem(FLAT.add(N_FPSEC, 0, LIST($1), $3.flat),
+           TREE(new FPSec((Multi<Id>*)$1.node, (Type*)$3.node)));
 };
 
 statement: 
  lvalue ":=" expr ";" 
  {
-   $$ = new AssignStat((Lvalue*)$1, (Expr*)$3);
+   $$ = sem(FLAT.add(N_ASSIGN_STAT, 0, $1.flat, $3.flat),
+            TREE(new AssignStat((Lvalue*)$1.node, (Expr*)$3.node)));
  } 
 |
  IDENTIFIER actual_params ";" 
 {
-  $$ = new CallStat((Id*)$1, (Multi<Expr>*)$2);
+  $$ = sem(FLAT.add(N_CALL_STAT, 0, $1.flat, LIST($2)),
+           TREE(new CallStat((Id*)$1.node, (Multi<Expr>*)$2.node)));
 }
 |
  "READ" "(" lvalue_block ")" ";" 
 { 
-  $$ = new ReadStat((Multi<Lvalue>*)$3);
+  $$ = sem(AT($1, FLAT.add(N_READ_STAT, 0, LIST($3))),
+           TREE(new ReadStat((Multi<Lvalue>*)$3.node)));
 }
 |
  "WRITE" write_params ";" 
 {
-  $$ = new WriteStat((Multi<WriteExpr>*)$2);
+  $$ = sem(AT($1, FLAT.add(N_WRITE_STAT, 0, LIST($2))),
+           TREE(new WriteStat((Multi<WriteExpr>*)$2.node)));
 }
 |
- "IF" expr "THEN" statement_block elseif_block else_opt "END" ";" 
+ "IF" cond "THEN" statement_block elseif_block else_opt "END" terminator
 {
-  $$ = new IfStat((Expr*)$2, (Multi<Stat>*)$4, (Multi<ElseIf>*)$5, 
-                  (Multi<Stat>*)$5);
+  unsigned then = LIST($4);
+  unsigned elseifs = LIST($5);
+  $$ = sem(AT($1, FLAT.add(N_IF_STAT, 0, $2.flat, then, elseifs, LIST($6))),
+           TREE(new IfStat((Expr*)$2.node, (Multi<Stat>*)$4.node,
+                           (Multi<ElseIf>*)$5.node, (Multi<Stat>*)$6.node)));
 }
 |
- "WHILE" expr "DO" statement_block "END" ";"
+ "WHILE" cond "DO" statement_block "END" terminator
 {
-  $$ = new WhileStat((Expr*)$2, (Multi<Stat>*)$4);
+  $$ = sem(AT($1, FLAT.add(N_WHILE_STAT, 0, $2.flat, LIST($4))),
+           TREE(new WhileStat((Expr*)$2.node, (Multi<Stat>*)$4.node)));
 }
 |
- "LOOP" statement_block "END" ";" 
+ "LOOP" statement_block "END" terminator
 {
-  $$ = new LoopStat((Multi<Stat>*)$2);
+  $$ = sem(AT($1, FLAT.add(N_LOOP_STAT, 0, LIST($2))),
+           TREE(new LoopStat((Multi<Stat>*)$2.node)));
 }
 |
- "FOR" IDENTIFIER ":=" expr "TO" expr by_opt "DO" statement_block "END" ";" 
+ "FOR" IDENTIFIER ":=" expr "TO" expr by_opt "DO" statement_block "END" terminator
 {
-  $$ = new ForStat((Id*)$2, (Expr*)$4, (Expr*)$6, (Expr*)$7, (Multi<Stat>*)$9);
+  $$ = sem(AT($1, FLAT.add(N_FOR_STAT, 0, $2.flat, $4.flat, $6.flat, $7.flat, LIST($9))),
+           TREE(new ForStat((Id*)$2.node, (Expr*)$4.node, (Expr*)$6.node,
+                            (Expr*)$7.node, (Multi<Stat>*)$9.node)));
 }
 |
  "EXIT" ";" 
 {
-  $$ = new ExitStat();
+  $$ = sem(AT($1, FLAT.add(N_EXIT_STAT)), TREE(new ExitStat()));
 }
 |
  "RETURN" expr_opt ";"
 {
-  $$ = new ReturnStat((Expr*)$2);
+  $$ = sem(AT($1, FLAT.add(N_RETURN_STAT, 0, $2.flat)),
+           TREE(new ReturnStat((Expr*)$2.node)));
 }
  ;
 
+cond: expr { $$ = $1; }
+| error { $$ = none(); } ;
+
+// the ';' after an END; a missing one is reported where it should be and
+// taken as read, rather than looked for further on
+terminator: ";" { $$ = none(); }
+| error { $$ = none(); } ;
+
 by_opt: "BY" expr
 { $$ = $2; }  
-| { $$ = NULL; };
+| { $$ = none(); };
 
-elseif_block: "ELSIF" expr "THEN" statement_block elseif_block 
+elseif_block: elseif_block "ELSIF" cond "THEN" statement_block 
 {
-  Multi<ElseIf>* v = (Multi<ElseIf>*)$5;
-  ElseIf* s = new ElseIf((Expr*)$2, (Multi<Stat>*)$4);
-  v->add(s);
-  $$ = v;
+  SemValue s = sem(FLAT.add(N_ELSE_IF, 0, $3.flat, LIST($5)),
+                   TREE(new ElseIf((Expr*)$3.node, (Multi<Stat>*)$5.node)));
+  $$ = $1;
+  append<ElseIf>(CTX, $$, s);
 }
 |
 {
-  $$ = new Multi<ElseIf>();
+  $$ = new_list<ElseIf>(CTX);
 }
 ;
 else_opt: "ELSE" statement_block 
 {
   { $$ = $2; }
 }
-| { $$ = NULL;  } 
+| { $$ = none();  } 
 ;
 
-lvalue_block: lvalue "," lvalue_block 
+lvalue_block: lvalue_block "," lvalue 
 {
-  Multi<Lvalue>* v = (Multi<Lvalue>*)$3;
-  v->add((Lvalue*)$1);
-  $$ = v;
+  $$ = $1;
+  append<Lvalue>(CTX, $$, $3);
 }
 | lvalue
 {
-  Multi<Lvalue>* v = new Multi<Lvalue>();
-  v->add((Lvalue*)$1);
-  $$ = $1;
+  $$ = single<Lvalue>(CTX, $1);
 }
 ;
 
@@ -298,156 +544,128 @@ write_params:  "(" write_expr_block ")"
 }
 | "(" ")"
 {
-  $$ = NULL;
+  $$ = none();
 }
+| "(" error ")" { $$ = none(); }
 ;
-write_expr_block: write_expr "," write_expr_block 
+write_expr_block: write_expr_block "," write_expr 
 {
-  Multi<WriteExpr>* v = (Multi<WriteExpr>*)$3;
-  v->add((WriteExpr*)$1);
-  $$ = v;
+  $$ = $1;
+  append<WriteExpr>(CTX, $$, $3);
 }
 | write_expr
 {
-  Multi<WriteExpr>* v = new Multi<WriteExpr>();
-  v->add((WriteExpr*)$1);
-  $$ = v;
+  $$ = single<WriteExpr>(CTX, $1);
 }
 ;
 
 write_expr: STRING 
 {
-  $$ = new StrWriteExpr((String*)$1);
+  $$ = sem(FLAT.add(N_STR_WRITE_EXPR, 0, $1.flat), TREE(new StrWriteExpr((String*)$1.node)));
 }                        
 | expr 
 {
-  $$ = new ExprWriteExpr((Expr*)$1);
+  $$ = sem(FLAT.add(N_EXPR_WRITE_EXPR, 0, $1.flat), TREE(new ExprWriteExpr((Expr*)$1.node)));
 }
 ;
 
 expr: number { $$ = $1; }| 
-lvalue { $$ = new LvalueExpr((Lvalue*)$1); }| 
+lvalue { $$ = sem(FLAT.add(N_LVALUE_EXPR, 0, $1.flat), TREE(new LvalueExpr((Lvalue*)$1.node))); }| 
 "(" expr ")" { $$ = $2; }| 
-unary_op expr { $$ = new UnaryOpExpr((Op*)$1, (Expr*)$2); } |
-expr binary_op expr { $$ = new BinOpExpr((Op*)$2, (Expr*)$1, (Expr*)$3); } |
-IDENTIFIER actual_params { $$ = new CallExpr((Id*)$1, (Multi<Expr>*)$2); }|
-IDENTIFIER comp_values { $$ = new RecordExpr((Id*)$1, (Multi<CompValue>*)$2); } |
-IDENTIFIER array_values { $$ = new ArrayExpr((Id*)$1, (Multi<ArrayValue>*)$2); };
-
-expr_block: expr "," expr_block 
+"(" error ")" { $$ = none(); }| 
+"+" expr %prec UNARY { $$ = unary(CTX, $1, "+", $2); } |
+"-" expr %prec UNARY { $$ = unary(CTX, $1, "-", $2); } |
+"NOT" expr %prec UNARY { $$ = unary(CTX, $1, "NOT", $2); } |
+expr "*" expr { $$ = binary(CTX, $1, $2, "*", $3); } |
+expr "/" expr { $$ = binary(CTX, $1, $2, "/", $3); } |
+expr "DIV" expr { $$ = binary(CTX, $1, $2, "DIV", $3); } |
+expr "MOD" expr { $$ = binary(CTX, $1, $2, "MOD", $3); } |
+expr "AND" expr { $$ = binary(CTX, $1, $2, "AND", $3); } |
+expr "+" expr { $$ = binary(CTX, $1, $2, "+", $3); } |
+expr "-" expr { $$ = binary(CTX, $1, $2, "-", $3); } |
+expr "OR" expr { $$ = binary(CTX, $1, $2, "OR", $3); } |
+expr "<" expr { $$ = binary(CTX, $1, $2, "<", $3); } |
+expr "<=" expr { $$ = binary(CTX, $1, $2, "<=", $3); } |
+expr ">" expr { $$ = binary(CTX, $1, $2, ">", $3); } |
+expr ">=" expr { $$ = binary(CTX, $1, $2, ">=", $3); } |
+expr "=" expr { $$ = binary(CTX, $1, $2, "=", $3); } |
+expr "<>" expr { $$ = binary(CTX, $1, $2, "<>", $3); } |
+IDENTIFIER actual_params { $$ = sem(FLAT.add(N_CALL_EXPR, 0, $1.flat, LIST($2)),
+                                    TREE(new CallExpr((Id*)$1.node, (Multi<Expr>*)$2.node))); }|
+IDENTIFIER comp_values { $$ = sem(FLAT.add(N_RECORD_EXPR, 0, $1.flat, LIST($2)),
+                                  TREE(new RecordExpr((Id*)$1.node, (Multi<CompValue>*)$2.node))); } |
+IDENTIFIER array_values { $$ = sem(FLAT.add(N_ARRAY_EXPR, 0, $1.flat, LIST($2)),
+                                   TREE(new ArrayExpr((Id*)$1.node, (Multi<ArrayValue>*)$2.node))); };
+
+expr_block: expr_block "," expr 
 {
-  Multi<Expr>* v = (Multi<Expr>*)$3;
-  v->add((Expr*)$1);
-  $$ = v;
+  $$ = $1;
+  append<Expr>(CTX, $$, $3);
 }
 | expr 
 {
-  Multi<Expr>* v = new Multi<Expr>();
-  v->add((Expr*)$1);
-  $$ = v;
+  $$ = single<Expr>(CTX, $1);
 }
 ;
-expr_opt: expr { $$=$1; }| {$$=NULL;};
+expr_opt: expr { $$=$1; }| {$$=none();};
 
-lvalue: IDENTIFIER { $$ = new IdLvalue((Id*)$1); } |
-lvalue "[" expr "]" { $$ = new ArrayLvalue((Lvalue*)$1, (Expr*)$3); } |
-lvalue "." IDENTIFIER { $$ = new RecordLvalue((Lvalue*)$1, (Id*)$3); } ;
+lvalue: IDENTIFIER { $$ = sem(FLAT.add(N_ID_LVALUE, 0, $1.flat), TREE(new IdLvalue((Id*)$1.node))); } |
+lvalue "[" expr "]" { $$ = sem(FLAT.add(N_ARRAY_LVALUE, 0, $1.flat, $3.flat),
+                               TREE(new ArrayLvalue((Lvalue*)$1.node, (Expr*)$3.node))); } |
+lvalue "[" error "]" { $$ = $1; } |
+lvalue "." IDENTIFIER { $$ = sem(FLAT.add(N_RECORD_LVALUE, 0, $1.flat, $3.flat),
+                                 TREE(new RecordLvalue((Lvalue*)$1.node, (Id*)$3.node))); } ;
 
 actual_params: "(" expr_block ")" { $$ = $2; } 
-| "(" ")" { $$ = NULL; } ;
+| "(" ")" { $$ = none(); }
+| "(" error ")" { $$ = none(); } ;
 
-comp_values: "{" comp_value_block "}" { $$ = $2; };
-comp_value_block: IDENTIFIER ":=" expr ";" comp_value_block 
+comp_values: "{" comp_value_block "}" { $$ = $2; }
+| "{" error "}" { $$ = none(); } ;
+comp_value_block: comp_value_block ";" IDENTIFIER ":=" expr 
 {
-  Multi<CompValue>* v = (Multi<CompValue>*)$5;
-  v->add(new CompValue((Id*)$1, (Expr*)$3));
-  $$ = v;
+  SemValue v = sem(FLAT.add(N_COMP_VALUE, 0, $3.flat, $5.flat),
+                   TREE(new CompValue((Id*)$3.node, (Expr*)$5.node)));
+  $$ = $1;
+  append<CompValue>(CTX, $$, v);
 }
 | IDENTIFIER ":=" expr
 {
-   Multi<CompValue>* v = new Multi<CompValue>();
-   v->add(new CompValue((Id*)$1, (Expr*)$3));
-   $$ = v;
+  $$ = single<CompValue>(CTX, sem(FLAT.add(N_COMP_VALUE, 0, $1.flat, $3.flat),
+                                  TREE(new CompValue((Id*)$1.node, (Expr*)$3.node))));
 }
 ;
 
-array_values: "[<" array_value_block ">]" { $$ = $2; };
+array_values: "[<" array_value_block ">]" { $$ = $2; }
+| "[<" error ">]" { $$ = none(); } ;
 
-array_value_block: array_value "," array_value_block 
+array_value_block: array_value_block "," array_value 
 {
-  Multi<ArrayValue>* v = (Multi<ArrayValue>*)$3;
-  v->add((ArrayValue*)$1);
-  $$ = v;
+  $$ = $1;
+  append<ArrayValue>(CTX, $$, $3);
 }
 | array_value
 {
-  Multi<ArrayValue>* v = new Multi<ArrayValue>();
-  v->add((ArrayValue*)$1);
-  $$ = v;
+  $$ = single<ArrayValue>(CTX, $1);
 }
 ;
 
 array_value: expr "OF" expr 
-{ $$ = new OfArrayValue((Expr*)$1, (Expr*)$3); }
-| expr { $$ = new SimpleArrayValue((Expr*)$1); };
+{ $$ = sem(FLAT.add(N_OF_ARRAY_VALUE, 0, $1.flat, $3.flat),
+           TREE(new OfArrayValue((Expr*)$1.node, (Expr*)$3.node))); }
+| expr { $$ = sem(FLAT.add(N_SIMPLE_ARRAY_VALUE, 0, $1.flat),
+                  TREE(new SimpleArrayValue((Expr*)$1.node))); };
 
-number: REAL { $$ = new NumberExpr((Number*)$1); } 
-| INTEGER { $$ = new NumberExpr((Number*)$1); } ;
+// the scanner makes a number's expression, it has read the value
+number: REAL { $$ = sem($1.flat, TREE(new NumberExpr((Number*)$1.node))); } 
+| INTEGER { $$ = sem($1.flat, TREE(new NumberExpr((Number*)$1.node))); } ;
 
-unary_op:  OPERATOR { $$ = $1; } | "NOT" { $$ = new Op("NOT"); };
-
-binary_op: OPERATOR { $$ = $1; } 
-| "DIV" { $$ = new Op("DIV"); }
-| "MOD" { $$ = new Op("MOD"); } 
-| "OR"  { $$ = new Op("OR"); }
-| "AND" { $$ = new Op("AND"); }
-;
 
 
 %%
 
-int main(int argc, char** argv) {
-  if (argc != 2) {
-    cout << "Need a file" << endl;
-    return -1;
-  }
-
-	FILE *myfile = fopen(argv[1], "r");
-	// make sure it is valid:
-	if (!myfile) {
-		cout << "I can't open file!" << endl;
-		return -1;
-	}
-	// set flex to read from it instead of defaulting to STDIN:
-	yyin = myfile;
-	
-	// parse through the input until there is no more:
-	do {
-		yyparse();
-	} while (!feof(yyin));
-	
-}
-
-void yyerror(const char *s) {
-	cout << "EEK, parse error! Position: " << ln << ":" << col 
-         << " token: " << yytext 
-         << "  Message: " << s << endl;
-	// might as well halt now:
-	exit(-1);
-}
-
-// http://www.gnu.org/software/bison/manual/html_node/Calling-Convention.html#Calling-Convention
-int find_token_code (char* token_buffer) {
-    int i;
-    for (i = 0; i < YYNTOKENS; i++) {
-        if (yytname[i] != 0
-            && yytname[i][0] == '"'
-            && ! strncmp (yytname[i] + 1, token_buffer,
-                          strlen (token_buffer))
-            && yytname[i][strlen (token_buffer) + 1] == '"'
-            && yytname[i][strlen (token_buffer) + 2] == 0)
-          break;
-    }
-
-    return  255+i;
+// the error is at the lookahead, the last token scanned
+void yyerror(yyscan_t scanner, const char *s) {
+	ParseContext* ctx = yyget_extra(scanner);
+	ctx->report(ctx->tok_ln, ctx->tok_col, yyget_text(scanner), s);
 }
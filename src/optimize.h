@@ -0,0 +1,915 @@
+// the optimizer: each procedure's bytecode goes to SSA form (ssa.h), through
+// the passes its level asks for and back. Level 1 folds constants and
+// removes dead code; level 2 also eliminates common subexpressions and
+// moves loop-invariant code out of loops. Nothing changes what a program
+// prints or the runtime error it stops with: an instruction that can fail
+// is neither removed nor moved.
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ssa.h"
+
+// what a value may be, a set of these; none yet while types are solved
+enum TypeBits {
+    T_INT = 1, T_REAL = 2, T_BOOL = 4, T_NIL = 8, T_OBJECT = 16,
+    T_NUMBER = T_INT | T_REAL, T_REF = T_NIL | T_OBJECT, T_ANY = 31
+};
+
+struct PassStats {
+    const char* name;
+    unsigned removed;        // SSA instructions
+    unsigned changed;        // folded, replaced or hoisted
+};
+
+class Optimizer {
+    Module* m;
+    SsaProc* s;
+    std::vector<unsigned char> types;
+    std::unordered_map<unsigned long long, unsigned> int_constants;
+    std::unordered_map<unsigned long long, unsigned> real_constants;
+    std::vector<PassStats> passes;
+    unsigned before_count, after_count;
+
+    Optimizer(const Optimizer&);
+    Optimizer& operator=(const Optimizer&);
+
+    static unsigned long long bits_of(const Value& k) {
+        unsigned long long bits = 0;
+        if (k.tag == V_REAL)
+            memcpy(&bits, &k.r, sizeof(k.r));
+        else if (k.tag != V_NIL)
+            bits = ((unsigned long long)k.tag << 32) | (unsigned)k.i;
+        else
+            bits = (unsigned long long)V_NIL << 32;
+        return bits;
+    }
+
+    unsigned constant(Value k) {
+        std::unordered_map<unsigned long long, unsigned>& pool =
+            k.tag == V_REAL ? real_constants : int_constants;
+        unsigned long long bits = bits_of(k);
+        std::unordered_map<unsigned long long, unsigned>::iterator it = pool.find(bits);
+        if (it != pool.end())
+            return it->second;
+        m->constants.push_back(k);
+        return pool[bits] = (unsigned)m->constants.size() - 1;
+    }
+
+    PassStats& stats(const char* name) {
+        for (size_t i = 0; i < passes.size(); ++i)
+            if (!strcmp(passes[i].name, name))
+                return passes[i];
+        PassStats p = { name, 0, 0 };
+        passes.push_back(p);
+        return passes.back();
+    }
+
+    const Value* constant_of(unsigned v) const {
+        const SsaInsn& in = s->insns[v];
+        return in.op == OP_LOADK ? &m->constants[in.b] : NULL;
+    }
+
+    static bool is_arith(unsigned op) {
+        return op >= OP_ADD && op <= OP_MOD;
+    }
+
+    static bool is_compare(unsigned op) {
+        return op >= OP_LT && op <= OP_NE;
+    }
+
+    static bool commutes(unsigned op) {
+        return op == OP_ADD || op == OP_MUL || op == OP_EQ || op == OP_NE;
+    }
+
+    static bool has_effect(unsigned op) {
+        switch (op) {
+        case OP_SETG: case OP_SETO: case OP_SETINDEX: case OP_SETFIELD: case S_SET:
+        case OP_CALL: case OP_READ: case OP_WRITE: case OP_WRITES: case OP_WRITELN:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    unsigned removed(unsigned before) const {
+        unsigned after = s->count();
+        return before > after ? before - after : 0;
+    }
+
+    // ---- types ----
+
+    unsigned char type_of(unsigned v) const {
+        // made after the types were
+        if (v >= types.size() || !types[v])
+            return T_ANY;
+        return types[v];
+    }
+
+    bool only(unsigned v, unsigned char set) const {
+        return (type_of(s->value(v)) & ~set) == 0;
+    }
+
+    unsigned char transfer(const SsaInsn& in) const {
+        unsigned char x = in.args.size() > 0 ? types[in.args[0]] : 0;
+        unsigned char y = in.args.size() > 1 ? types[in.args[1]] : 0;
+        switch (in.op) {
+        case OP_LOADK: {
+            static const unsigned char of_tag[] = { T_INT, T_REAL, T_BOOL, T_NIL, T_OBJECT };
+            return of_tag[m->constants[in.b].tag];
+        }
+        case OP_REAL:
+            return x & T_INT ? (unsigned char)((x & ~T_INT) | T_REAL) : x;
+        case OP_ADD: case OP_SUB: case OP_MUL: {
+            unsigned char t = 0;
+            if ((x & T_INT) && (y & T_INT))
+                t |= T_INT;
+            if ((x & T_NUMBER) && (y & T_NUMBER) && ((x | y) & T_REAL))
+                t |= T_REAL;
+            return t ? t : (unsigned char)(x && y ? T_NUMBER : 0);
+        }
+        case OP_RDIV:
+            return T_REAL;
+        case OP_DIV: case OP_MOD:
+            return T_INT;
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+        case OP_NOT: case OP_TRUTH:
+            return T_BOOL;
+        case OP_NEG: case OP_POS:
+            return x & T_NUMBER ? (unsigned char)(x & T_NUMBER) : (unsigned char)(x ? T_NUMBER : 0);
+        case OP_READ:
+            return T_NUMBER;
+        case OP_RECORD: case OP_ARRAY:
+            return T_OBJECT;
+        case S_PHI: {
+            unsigned char t = 0;
+            for (size_t i = 0; i < in.args.size(); ++i)
+                t |= types[in.args[i]];
+            return t;
+        }
+        default:
+            return T_ANY;
+        }
+    }
+
+    // optimistically, from nothing up, so loops settle on what they start with
+    void infer_types() {
+        s->compact();
+        types.assign(s->insns.size(), 0);
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t l = 0; l < s->layout.size(); ++l) {
+                const SsaBlock& b = s->blocks[s->layout[l]];
+                const std::vector<unsigned>* lists[2] = { &b.phis, &b.insns };
+                for (int k = 0; k < 2; ++k) {
+                    for (size_t i = 0; i < lists[k]->size(); ++i) {
+                        unsigned v = (*lists[k])[i];
+                        unsigned char t = types[v] | transfer(s->insns[v]);
+                        if (t != types[v]) {
+                            types[v] = t;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    bool nonzero(unsigned v) const {
+        const Value* k = constant_of(s->value(v));
+        return k && is_number(*k) && as_real(*k) != 0;
+    }
+
+    // whether the instruction can stop the program with an error
+    bool can_fail(const SsaInsn& in) const {
+        unsigned x = in.args.size() > 0 ? in.args[0] : 0;
+        unsigned y = in.args.size() > 1 ? in.args[1] : 0;
+        switch (in.op) {
+        case OP_LOADK: case OP_GETG: case OP_GETO: case S_GET: case S_ENTRY: case S_PHI:
+        case OP_REAL: case OP_RECORD:
+            return false;
+        case OP_ADD: case OP_SUB: case OP_MUL:
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+            return !only(x, T_NUMBER) || !only(y, T_NUMBER);
+        case OP_RDIV:
+            return !only(x, T_NUMBER) || !only(y, T_NUMBER) || !nonzero(y);
+        case OP_DIV: case OP_MOD:
+            return !only(x, T_INT) || !only(y, T_INT) || !nonzero(y);
+        case OP_EQ: case OP_NE:
+            return !(only(x, T_NUMBER) && only(y, T_NUMBER)) &&
+                   !(only(x, T_BOOL) && only(y, T_BOOL)) &&
+                   !(only(x, T_REF) && only(y, T_REF));
+        case OP_NEG: case OP_POS:
+            return !only(x, T_NUMBER);
+        case OP_NOT: case OP_TRUTH:
+            return !only(x, T_BOOL);
+        default:
+            return true;
+        }
+    }
+
+    // ---- constant folding ----
+
+    // the value the instruction computes from constant operands, if it can
+    // be computed without an error
+    bool evaluate(const SsaInsn& in, Value& out) const {
+        Value k[2];
+        if (in.args.empty() || in.args.size() > 2)
+            return false;
+        for (size_t i = 0; i < in.args.size(); ++i) {
+            const Value* c = constant_of(s->value(in.args[i]));
+            if (!c)
+                return false;
+            k[i] = *c;
+        }
+        try {
+            if (is_arith(in.op)) {
+                out = arith((ArithOp)(in.op - OP_ADD), k[0], k[1]);
+            } else if (is_compare(in.op)) {
+                out = compare((CompareOp)(in.op - OP_LT), k[0], k[1]);
+            } else {
+                switch (in.op) {
+                case OP_NEG:
+                    out = negative(k[0]);
+                    break;
+                case OP_POS:
+                    if (!is_number(k[0]))
+                        return false;
+                    out = k[0];
+                    break;
+                case OP_NOT:
+                    out = bool_value(!truth(k[0]));
+                    break;
+                case OP_TRUTH:
+                    out = bool_value(truth(k[0]));
+                    break;
+                case OP_REAL:
+                    out = k[0].tag == V_INT ? real_value(k[0].i) : k[0];
+                    break;
+                default:
+                    return false;
+                }
+            }
+        } catch (const InterpError&) {
+            // left to fail when it runs
+            return false;
+        }
+        return true;
+    }
+
+    // a value the instruction always equals, or none
+    unsigned identity(const SsaInsn& in) const {
+        if (in.op == S_PHI) {
+            unsigned same = SsaProc::none;
+            for (size_t i = 0; i < in.args.size(); ++i) {
+                unsigned a = s->value(in.args[i]);
+                if (a == same || &s->insns[a] == &in)
+                    continue;
+                if (same != SsaProc::none)
+                    return SsaProc::none;
+                same = a;
+            }
+            return same;
+        }
+        if (in.args.empty())
+            return SsaProc::none;
+        unsigned x = s->value(in.args[0]);
+        switch (in.op) {
+        case OP_REAL:
+            return only(x, T_REAL | T_BOOL | T_REF) ? x : SsaProc::none;
+        case OP_POS:
+            return only(x, T_NUMBER) ? x : SsaProc::none;
+        case OP_TRUTH:
+            return only(x, T_BOOL) ? x : SsaProc::none;
+        case OP_ADD: case OP_SUB: case OP_MUL: {
+            // integer x + 0, x - 0, x * 1 and the same the other way round
+            unsigned y = s->value(in.args[1]);
+            const Value* kx = constant_of(x);
+            const Value* ky = constant_of(y);
+            int unit = in.op == OP_MUL ? 1 : 0;
+            if (ky && ky->tag == V_INT && ky->i == unit && only(x, T_INT))
+                return x;
+            if (kx && kx->tag == V_INT && kx->i == unit && only(y, T_INT) && in.op != OP_SUB)
+                return y;
+            return SsaProc::none;
+        }
+        default:
+            return SsaProc::none;
+        }
+    }
+
+    void fold() {
+        PassStats& st = stats("fold");
+        unsigned before = s->count();
+        infer_types();
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t l = 0; l < s->layout.size(); ++l) {
+                unsigned b = s->layout[l];
+                SsaBlock& blk = s->blocks[b];
+                if (blk.removed)
+                    continue;
+                const std::vector<unsigned>* lists[2] = { &blk.phis, &blk.insns };
+                for (int k = 0; k < 2; ++k) {
+                    for (size_t i = 0; i < lists[k]->size(); ++i) {
+                        unsigned v = (*lists[k])[i];
+                        SsaInsn& in = s->insns[v];
+                        if (in.removed)
+                            continue;
+                        for (size_t a = 0; a < in.args.size(); ++a)
+                            in.args[a] = s->value(in.args[a]);
+                        unsigned same = identity(in);
+                        if (same != SsaProc::none) {
+                            s->replace(v, same);
+                            ++st.changed;
+                            changed = true;
+                            continue;
+                        }
+                        Value out;
+                        if (in.op != OP_LOADK && evaluate(in, out)) {
+                            in.op = OP_LOADK;
+                            in.b = constant(out);
+                            in.args.clear();
+                            ++st.changed;
+                            changed = true;
+                        }
+                    }
+                }
+                // a branch on a constant goes one way; one on a
+                // non-boolean is left to fail
+                if (blk.term == OP_JT || blk.term == OP_JF) {
+                    blk.cond = s->value(blk.cond);
+                    const Value* k = constant_of(blk.cond);
+                    if (k && k->tag == V_BOOL) {
+                        bool taken = (k->i != 0) == (blk.term == OP_JT);
+                        unsigned go = blk.succs[taken], gone = blk.succs[!taken];
+                        blk.term = OP_JMP;
+                        blk.cond = SsaProc::none;
+                        blk.succs.assign(1, go);
+                        if (gone != go)
+                            s->drop_pred(gone, b);
+                        else
+                            s->drop_pred(go, b);
+                        ++st.changed;
+                        changed = true;
+                    }
+                }
+            }
+            if (changed)
+                s->remove_unreachable();
+        }
+        s->compact();
+        st.removed += removed(before);
+    }
+
+    // ---- common subexpressions ----
+
+    struct KeyHash {
+        size_t operator()(const std::vector<unsigned>& k) const {
+            size_t h = 0;
+            for (size_t i = 0; i < k.size(); ++i)
+                h = h * 1000003u ^ k[i];
+            return h;
+        }
+    };
+    typedef std::unordered_map<std::vector<unsigned>, unsigned, KeyHash> Table;
+
+    // memory is named by epochs: stores start a new one, loads are only
+    // the same in the same one. Pins have their own, changed by S_SET
+    struct Epochs {
+        unsigned memory, pins;
+    };
+
+    // an operand in a key: constants by value, each is loaded where it is used
+    unsigned operand(unsigned v) const {
+        const SsaInsn& in = s->insns[v];
+        return in.op == OP_LOADK ? in.b | 0x80000000u : v;
+    }
+
+    // a key for the instruction's value, empty if it has none worth sharing
+    bool key(const SsaInsn& in, const Epochs& e, std::vector<unsigned>& k) const {
+        k.clear();
+        k.push_back(in.op);
+        switch (in.op) {
+        case S_ENTRY:
+            k.push_back(in.b);
+            k.push_back(in.c);
+            return true;
+        case OP_GETG: case OP_GETO:
+            k.push_back(in.b);
+            k.push_back(in.c);
+            k.push_back(e.memory);
+            return true;
+        case S_GET:
+            k.push_back(in.c);
+            k.push_back(e.pins);
+            k.push_back(s->pins[in.c].reg != SsaProc::none ? e.memory : 0);
+            return true;
+        case OP_FIELD:
+            // by the field's name: every site of the same field finds it
+            // in the same place
+            k.push_back(m->fields[in.c].field.id());
+            k.push_back(e.memory);
+            k.push_back(operand(in.args[0]));
+            return true;
+        case OP_INDEX:
+            k.push_back(e.memory);
+            k.push_back(operand(in.args[0]));
+            k.push_back(operand(in.args[1]));
+            return true;
+        case OP_REAL: case OP_NEG: case OP_POS: case OP_NOT: case OP_TRUTH:
+            k.push_back(operand(in.args[0]));
+            return true;
+        default:
+            if (!is_arith(in.op) && !is_compare(in.op))
+                return false;
+            if (commutes(in.op) && operand(in.args[1]) < operand(in.args[0])) {
+                k.push_back(operand(in.args[1]));
+                k.push_back(operand(in.args[0]));
+            } else {
+                k.push_back(operand(in.args[0]));
+                k.push_back(operand(in.args[1]));
+            }
+            return true;
+        }
+    }
+
+    // the key of the load a store's value can be read back by
+    bool stored(const SsaInsn& in, const Epochs& e, std::vector<unsigned>& k, unsigned& v) const {
+        SsaInsn load;
+        load.removed = false;
+        load.b = in.b;
+        load.c = in.c;
+        switch (in.op) {
+        case OP_SETG:
+            load.op = OP_GETG;
+            load.c = 0;
+            v = in.args[0];
+            break;
+        case OP_SETO:
+            load.op = OP_GETO;
+            v = in.args[0];
+            break;
+        case S_SET:
+            load.op = S_GET;
+            v = in.args[0];
+            break;
+        case OP_SETINDEX:
+            load.op = OP_INDEX;
+            load.args.push_back(in.args[0]);
+            load.args.push_back(in.args[1]);
+            v = in.args[2];
+            break;
+        default:
+            return false;
+        }
+        return key(load, e, k);
+    }
+
+    void cse() {
+        PassStats& st = stats("cse");
+        unsigned before = s->count();
+        s->compact();
+        s->dominators();
+        std::vector<std::vector<unsigned> > kids = s->dominator_tree();
+        Table table;
+        std::vector<std::vector<unsigned> > undo_keys;
+        std::vector<size_t> marks;
+        std::vector<Epochs> end(s->blocks.size());
+        unsigned next_epoch = 1;
+        std::vector<unsigned> k;
+        std::vector<std::pair<unsigned, size_t> > stack;
+        stack.push_back(std::make_pair(0u, (size_t)0));
+        marks.push_back(0);
+        while (!stack.empty()) {
+            unsigned b = stack.back().first;
+            if (stack.back().second == 0) {
+                SsaBlock& blk = s->blocks[b];
+                // memory is as the dominator left it only when that is
+                // the one way in
+                Epochs e;
+                unsigned d = s->idom[b];
+                if (b && blk.preds.size() == 1 && blk.preds[0] == d &&
+                    s->blocks[d].term != OP_FORLOOP && s->blocks[d].term != OP_FORPREP) {
+                    e = end[d];
+                } else {
+                    e.memory = next_epoch++;
+                    e.pins = next_epoch++;
+                }
+                for (size_t i = 0; i < blk.phis.size(); ++i) {
+                    SsaInsn& in = s->insns[blk.phis[i]];
+                    for (size_t a = 0; a < in.args.size(); ++a)
+                        in.args[a] = s->value(in.args[a]);
+                }
+                for (size_t i = 0; i < blk.insns.size(); ++i) {
+                    unsigned v = blk.insns[i];
+                    SsaInsn& in = s->insns[v];
+                    for (size_t a = 0; a < in.args.size(); ++a)
+                        in.args[a] = s->value(in.args[a]);
+                    unsigned w;
+                    if (in.op == S_SET && stored(in, e, k, w)) {
+                        // storing what the pin already holds
+                        Table::iterator it = table.find(k);
+                        if (it != table.end() && it->second == w) {
+                            in.removed = true;
+                            ++st.changed;
+                            continue;
+                        }
+                    }
+                    if (key(in, e, k)) {
+                        Table::iterator it = table.find(k);
+                        if (it != table.end()) {
+                            s->replace(v, it->second);
+                            ++st.changed;
+                            continue;
+                        }
+                        table[k] = v;
+                        undo_keys.push_back(k);
+                    }
+                    if (in.op == S_SET)
+                        e.pins = next_epoch++;
+                    else if (in.op == OP_CALL) {
+                        e.memory = next_epoch++;
+                        e.pins = next_epoch++;
+                    } else if (has_effect(in.op) && in.op != OP_WRITE && in.op != OP_WRITES &&
+                               in.op != OP_WRITELN && in.op != OP_READ) {
+                        e.memory = next_epoch++;
+                    }
+                    if (stored(in, e, k, w)) {
+                        table[k] = w;
+                        undo_keys.push_back(k);
+                    }
+                }
+                if (blk.cond != SsaProc::none)
+                    blk.cond = s->value(blk.cond);
+                end[b] = e;
+            }
+            size_t& next = stack.back().second;
+            if (next < kids[b].size()) {
+                unsigned c = kids[b][next++];
+                marks.push_back(undo_keys.size());
+                stack.push_back(std::make_pair(c, (size_t)0));
+            } else {
+                while (undo_keys.size() > marks.back()) {
+                    table.erase(undo_keys.back());
+                    undo_keys.pop_back();
+                }
+                marks.pop_back();
+                stack.pop_back();
+            }
+        }
+        s->compact();
+        st.removed += removed(before);
+    }
+
+    // ---- loop-invariant code ----
+
+    struct Loop {
+        unsigned header;
+        std::vector<unsigned> body;
+        unsigned parent;
+    };
+
+    // natural loops, a header's back edges together, smallest first
+    std::vector<Loop> find_loops() {
+        std::vector<Loop> loops;
+        std::vector<unsigned> loop_of(s->blocks.size(), SsaProc::none);
+        std::vector<unsigned> mark(s->blocks.size(), SsaProc::none);
+        for (size_t i = 0; i < s->rpo.size(); ++i) {
+            unsigned h = s->rpo[i];
+            Loop loop;
+            loop.header = h;
+            loop.parent = SsaProc::none;
+            std::vector<unsigned> work;
+            for (size_t k = 0; k < s->blocks[h].preds.size(); ++k) {
+                unsigned p = s->blocks[h].preds[k];
+                if (s->idom[p] != SsaProc::none && s->dominates(h, p))
+                    work.push_back(p);
+            }
+            if (work.empty())
+                continue;
+            unsigned id = (unsigned)loops.size();
+            mark[h] = id;
+            loop.body.push_back(h);
+            while (!work.empty()) {
+                unsigned b = work.back();
+                work.pop_back();
+                if (mark[b] == id)
+                    continue;
+                mark[b] = id;
+                loop.body.push_back(b);
+                for (size_t k = 0; k < s->blocks[b].preds.size(); ++k)
+                    work.push_back(s->blocks[b].preds[k]);
+            }
+            loops.push_back(loop);
+        }
+        std::stable_sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+            return a.body.size() < b.body.size();
+        });
+        for (unsigned l = 0; l < loops.size(); ++l)
+            loop_of[loops[l].header] = l;
+        for (unsigned l = 0; l < loops.size(); ++l)
+            for (size_t i = 0; i < loops[l].body.size(); ++i) {
+                unsigned inner = loop_of[loops[l].body[i]];
+                if (inner != SsaProc::none && inner != l && loops[inner].parent == SsaProc::none)
+                    loops[inner].parent = l;
+            }
+        return loops;
+    }
+
+    // the block before the loop's header that every way in passes; made
+    // if there is none, with the phis of the ways in split off
+    unsigned preheader(std::vector<Loop>& loops, unsigned l, const std::vector<unsigned>& in_loop,
+                       unsigned stamp) {
+        unsigned h = loops[l].header;
+        SsaBlock& header = s->blocks[h];
+        std::vector<size_t> outside;
+        for (size_t k = 0; k < header.preds.size(); ++k)
+            if (in_loop[header.preds[k]] != stamp)
+                outside.push_back(k);
+        if (outside.size() == 1) {
+            unsigned p = header.preds[outside[0]];
+            if (s->blocks[p].succs.size() == 1)
+                return p;
+        }
+        unsigned pre = s->add_block();
+        SsaBlock& hb = s->blocks[h];
+        SsaBlock& pb = s->blocks[pre];
+        pb.succs.push_back(h);
+        std::vector<unsigned> preds;
+        for (size_t i = 0; i < outside.size(); ++i) {
+            unsigned p = hb.preds[outside[i]];
+            pb.preds.push_back(p);
+            std::vector<unsigned>& succs = s->blocks[p].succs;
+            *std::find(succs.begin(), succs.end(), h) = pre;
+        }
+        for (size_t i = 0; i < hb.phis.size(); ++i) {
+            unsigned phi = hb.phis[i];
+            std::vector<unsigned> in_args, out_args;
+            size_t o = 0;
+            for (size_t k = 0; k < hb.preds.size(); ++k) {
+                if (o < outside.size() && outside[o] == k) {
+                    out_args.push_back(s->insns[phi].args[k]);
+                    ++o;
+                } else {
+                    in_args.push_back(s->insns[phi].args[k]);
+                }
+            }
+            unsigned from = out_args[0];
+            if (out_args.size() > 1) {
+                from = s->add(S_PHI, pre);
+                s->insns[from].args = out_args;
+                s->blocks[pre].phis.push_back(from);
+            }
+            in_args.insert(in_args.begin(), from);
+            s->insns[phi].args = in_args;
+        }
+        SsaBlock& hb2 = s->blocks[h];
+        for (size_t k = 0; k < hb2.preds.size(); ++k)
+            if (std::find(outside.begin(), outside.end(), k) == outside.end())
+                preds.push_back(hb2.preds[k]);
+        preds.insert(preds.begin(), pre);
+        hb2.preds = preds;
+        s->layout.insert(std::find(s->layout.begin(), s->layout.end(), h), pre);
+        for (unsigned p = loops[l].parent; p != SsaProc::none; p = loops[p].parent)
+            loops[p].body.push_back(pre);
+        return pre;
+    }
+
+    void licm() {
+        PassStats& st = stats("licm");
+        unsigned before = s->count();
+        infer_types();
+        s->dominators();
+        std::vector<Loop> loops = find_loops();
+        std::vector<unsigned> in_loop(s->blocks.size(), 0);
+        std::set<std::pair<unsigned, unsigned> > stored_outer;
+        std::set<unsigned> stored_globals, stored_pins;
+        for (unsigned l = 0; l < loops.size(); ++l) {
+            unsigned stamp = l + 1;
+            in_loop.resize(s->blocks.size(), 0);
+            for (size_t i = 0; i < loops[l].body.size(); ++i)
+                in_loop[loops[l].body[i]] = stamp;
+            // what the loop writes
+            bool calls = false;
+            stored_outer.clear();
+            stored_globals.clear();
+            stored_pins.clear();
+            for (size_t i = 0; i < loops[l].body.size(); ++i) {
+                const SsaBlock& blk = s->blocks[loops[l].body[i]];
+                if (blk.term == OP_FORLOOP)
+                    stored_pins.insert(blk.pin);
+                for (size_t k = 0; k < blk.insns.size(); ++k) {
+                    const SsaInsn& in = s->insns[blk.insns[k]];
+                    if (in.removed)
+                        continue;
+                    if (in.op == OP_CALL)
+                        calls = true;
+                    else if (in.op == OP_SETG)
+                        stored_globals.insert(in.b);
+                    else if (in.op == OP_SETO)
+                        stored_outer.insert(std::make_pair(in.b, in.c));
+                    else if (in.op == S_SET)
+                        stored_pins.insert(in.c);
+                }
+            }
+            // hoistable instructions, in an order that has operands first
+            std::vector<unsigned> hoist;
+            std::vector<bool> moved(s->insns.size(), false);
+            std::vector<unsigned> order;
+            for (size_t i = 0; i < s->layout.size(); ++i)
+                if (s->layout[i] < in_loop.size() && in_loop[s->layout[i]] == stamp)
+                    order.push_back(s->layout[i]);
+            for (size_t i = 0; i < order.size(); ++i) {
+                const SsaBlock& blk = s->blocks[order[i]];
+                for (size_t k = 0; k < blk.insns.size(); ++k) {
+                    unsigned v = blk.insns[k];
+                    const SsaInsn& in = s->insns[v];
+                    if (in.removed || has_effect(in.op) || can_fail(in))
+                        continue;
+                    if (in.op == OP_GETG && (calls || stored_globals.count(in.b)))
+                        continue;
+                    if (in.op == OP_GETO && (calls || stored_outer.count(std::make_pair(in.b, in.c))))
+                        continue;
+                    if (in.op == S_GET) {
+                        unsigned pin = in.c;
+                        if (stored_pins.count(pin) || (s->pins[pin].reg != SsaProc::none && calls))
+                            continue;
+                    }
+                    if (in.op == OP_RECORD || in.op == OP_ARRAY || in.op == S_ENTRY)
+                        continue;
+                    bool invariant = true;
+                    for (size_t a = 0; a < in.args.size() && invariant; ++a) {
+                        unsigned arg = s->value(in.args[a]);
+                        unsigned def = s->insns[arg].block;
+                        invariant = moved[arg] || def >= in_loop.size() || in_loop[def] != stamp;
+                    }
+                    if (!invariant)
+                        continue;
+                    moved[v] = true;
+                    hoist.push_back(v);
+                }
+            }
+            if (hoist.empty())
+                continue;
+            unsigned pre = preheader(loops, l, in_loop, stamp);
+            for (size_t i = 0; i < hoist.size(); ++i) {
+                SsaInsn& in = s->insns[hoist[i]];
+                std::vector<unsigned>& from = s->blocks[in.block].insns;
+                from.erase(std::find(from.begin(), from.end(), hoist[i]));
+                in.block = pre;
+                for (size_t a = 0; a < in.args.size(); ++a)
+                    in.args[a] = s->value(in.args[a]);
+                s->blocks[pre].insns.push_back(hoist[i]);
+            }
+            st.changed += (unsigned)hoist.size();
+        }
+        s->compact();
+        st.removed += removed(before);
+    }
+
+    // ---- dead code ----
+
+    void dce() {
+        PassStats& st = stats("dce");
+        unsigned before = s->count();
+        infer_types();
+        std::vector<bool> live(s->insns.size(), false);
+        std::vector<unsigned> work;
+        for (size_t l = 0; l < s->layout.size(); ++l) {
+            const SsaBlock& blk = s->blocks[s->layout[l]];
+            for (size_t i = 0; i < blk.insns.size(); ++i) {
+                const SsaInsn& in = s->insns[blk.insns[i]];
+                if (has_effect(in.op) || can_fail(in)) {
+                    live[blk.insns[i]] = true;
+                    work.push_back(blk.insns[i]);
+                }
+            }
+            if (blk.cond != SsaProc::none && !live[blk.cond]) {
+                live[blk.cond] = true;
+                work.push_back(blk.cond);
+            }
+        }
+        while (!work.empty()) {
+            unsigned v = work.back();
+            work.pop_back();
+            const SsaInsn& in = s->insns[v];
+            for (size_t a = 0; a < in.args.size(); ++a) {
+                if (!live[in.args[a]]) {
+                    live[in.args[a]] = true;
+                    work.push_back(in.args[a]);
+                }
+            }
+        }
+        for (size_t l = 0; l < s->layout.size(); ++l) {
+            const SsaBlock& blk = s->blocks[s->layout[l]];
+            for (size_t i = 0; i < blk.phis.size(); ++i)
+                if (!live[blk.phis[i]])
+                    s->insns[blk.phis[i]].removed = true;
+            for (size_t i = 0; i < blk.insns.size(); ++i)
+                if (!live[blk.insns[i]])
+                    s->insns[blk.insns[i]].removed = true;
+        }
+        s->compact();
+        st.removed += removed(before);
+    }
+
+    // per procedure, the variables procedures nested in it reach, or for
+    // the main program the ones any procedure does
+    std::vector<std::vector<bool> > reached() const {
+        std::vector<std::set<unsigned> > escaping(1);
+        for (size_t p = 0; p < m->procs.size(); ++p) {
+            const ProcCode& pc = m->procs[p];
+            unsigned end = p + 1 < m->procs.size() ? m->procs[p+1].entry : (unsigned)m->code.size();
+            for (unsigned i = pc.entry; i < end; ++i) {
+                const Insn& in = m->code[i];
+                if (in.op == OP_GETG)
+                    escaping[0].insert(in.b);
+                else if (in.op == OP_SETG)
+                    escaping[0].insert(in.a);
+                else if (in.op == OP_GETO || in.op == OP_SETO) {
+                    // every procedure at that depth, to be safe
+                    unsigned depth = pc.depth - in.c;
+                    if (escaping.size() <= depth)
+                        escaping.resize(depth + 1);
+                    escaping[depth].insert(in.b);
+                }
+            }
+        }
+        std::vector<std::vector<bool> > fixed(m->procs.size());
+        for (size_t p = 0; p < m->procs.size(); ++p) {
+            unsigned depth = p ? m->procs[p].depth : 0;
+            fixed[p].assign(m->procs[p].registers, false);
+            if (depth < escaping.size())
+                for (std::set<unsigned>::const_iterator it = escaping[depth].begin();
+                     it != escaping[depth].end(); ++it)
+                    if (*it < m->procs[p].slots)
+                        fixed[p][*it] = true;
+        }
+        return fixed;
+    }
+
+public:
+    Optimizer() : m(NULL), s(NULL), before_count(0), after_count(0) {}
+
+    // rewrites the bytecode of every procedure in module at level 1 or 2
+    bool optimize(Module& module, int level, std::string& error) {
+        m = &module;
+        for (size_t i = 0; i < m->constants.size(); ++i) {
+            const Value& k = m->constants[i];
+            if (k.tag == V_OBJECT)
+                continue;
+            std::unordered_map<unsigned long long, unsigned>& pool =
+                k.tag == V_REAL ? real_constants : int_constants;
+            if (!pool.count(bits_of(k)))
+                pool[bits_of(k)] = (unsigned)i;
+        }
+        stats("fold");
+        if (level >= 2) {
+            stats("cse");
+            stats("licm");
+        }
+        stats("dce");
+        before_count = (unsigned)m->code.size();
+        std::vector<std::vector<bool> > fixed = reached();
+        std::vector<Insn> code;
+        try {
+            for (unsigned p = 0; p < m->procs.size(); ++p) {
+                SsaProc proc;
+                s = &proc;
+                proc.build(*m, p, fixed[p]);
+                fold();
+                if (level >= 2) {
+                    cse();
+                    licm();
+                    fold();
+                }
+                dce();
+                proc.lower(code, m->procs[p]);
+                s = NULL;
+            }
+        } catch (const InterpError& e) {
+            error = e.message;
+            return false;
+        }
+        m->code.swap(code);
+        after_count = (unsigned)m->code.size();
+        return true;
+    }
+
+    // SSA instructions each pass removed and the bytecode before and after
+    void print_stats(FILE* out) const {
+        fprintf(out, "%-6s %9s %9s\n", "pass", "removed", "changed");
+        for (size_t i = 0; i < passes.size(); ++i)
+            fprintf(out, "%-6s %9u %9u\n", passes[i].name, passes[i].removed, passes[i].changed);
+        fprintf(out, "bytecode: %u -> %u instructions\n", before_count, after_count);
+    }
+};
+
+#endif
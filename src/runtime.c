@@ -0,0 +1,413 @@
+/* run-time support for programs compiled to x86-64 by the native backend
+ * (src/x86.h). Link it with the generated assembly:
+ *
+ *   main --emit-asm prog.s prog.pcat && cc prog.s src/runtime.c -o prog
+ *
+ * Values are NaN-boxed in 64 bits: a real is its IEEE double, everything
+ * else sits in the negative NaN space with a tag in the top 16 bits. The
+ * generated code handles the common cases inline and calls in here for
+ * the rest; results and error messages are the same as the interpreter's. */
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+typedef uint64_t value;
+
+#define TAG_INT  0xFFF9u
+#define TAG_BOOL 0xFFFAu
+#define TAG_NIL  0xFFFBu
+#define TAG_OBJ  0xFFFCu
+
+#define NIL      ((value)TAG_NIL << 48)
+#define PAYLOAD  0x0000FFFFFFFFFFFFull
+
+/* kinds, as in src/value.h */
+enum { K_OTHER, K_INT, K_REAL, K_BOOL, K_STRING };
+
+/* operators, in the order of the bytecode's */
+enum { A_ADD, A_SUB, A_MUL, A_RDIV, A_DIV, A_MOD };
+enum { R_LT, R_LE, R_GT, R_GE, R_EQ, R_NE };
+
+struct record_info {
+    const char* name;
+    uint64_t fields;
+    const uint8_t* kinds;
+    const uint64_t* ids;      /* field ids, for lookups by field site */
+};
+
+/* a record or an array; record is NULL for an array */
+struct object {
+    const struct record_info* record;
+    uint32_t size;
+    uint32_t pad;
+    value items[];
+};
+
+/* one per field access in the program; the generated code checks the
+ * cached record type inline */
+struct field_site {
+    const struct record_info* seen;
+    uint64_t offset;          /* of the item in the object */
+    uint64_t id;
+    const char* name;
+};
+
+struct record_site {
+    const struct record_info* record;
+    uint64_t n;
+    const uint64_t* fields;   /* field index of each value */
+};
+
+struct array_site {
+    uint64_t n;
+    const uint8_t* of;        /* per item: a count and a value, or one value */
+};
+
+char* pcat_stack_limit;
+void pcat_main(void);
+
+static unsigned tag(value v) {
+    return (unsigned)(v >> 48);
+}
+
+static int is_int(value v) {
+    return tag(v) == TAG_INT;
+}
+
+static int is_real(value v) {
+    return tag(v) < TAG_INT;
+}
+
+static int is_number(value v) {
+    return tag(v) <= TAG_INT;
+}
+
+static int32_t int_of(value v) {
+    return (int32_t)(uint32_t)v;
+}
+
+static double real_of(value v) {
+    double d;
+    memcpy(&d, &v, sizeof(d));
+    return d;
+}
+
+static double as_real(value v) {
+    return is_int(v) ? (double)int_of(v) : real_of(v);
+}
+
+static value box_int(int32_t i) {
+    return ((value)TAG_INT << 48) | (uint32_t)i;
+}
+
+static value box_real(double d) {
+    value v;
+    memcpy(&v, &d, sizeof(v));
+    return v;
+}
+
+static value box_bool(int b) {
+    return ((value)TAG_BOOL << 48) | (b != 0);
+}
+
+static struct object* object_of(value v) {
+    return (struct object*)(uintptr_t)(v & PAYLOAD);
+}
+
+static value box_object(struct object* o) {
+    return ((value)TAG_OBJ << 48) | (uint64_t)(uintptr_t)o;
+}
+
+void pcat_fail(const char* message) {
+    fflush(stdout);
+    fprintf(stderr, "runtime error: %s\n", message);
+    exit(1);
+}
+
+value pcat_arith(int op, value x, value y) {
+    if (!is_number(x) || !is_number(y))
+        pcat_fail("arithmetic on a non-number");
+    if (is_int(x) && is_int(y)) {
+        /* wraps around like the 32-bit machine integers PCAT assumes */
+        int32_t a = int_of(x), b = int_of(y);
+        switch (op) {
+        case A_ADD: return box_int((int32_t)((uint32_t)a + (uint32_t)b));
+        case A_SUB: return box_int((int32_t)((uint32_t)a - (uint32_t)b));
+        case A_MUL: return box_int((int32_t)((uint32_t)a * (uint32_t)b));
+        case A_RDIV:
+            if (!b)
+                pcat_fail("division by zero");
+            return box_real((double)a / b);
+        case A_DIV:
+            if (!b)
+                pcat_fail("division by zero");
+            return box_int(b == -1 ? (int32_t)(0u - (uint32_t)a) : a / b);
+        default:
+            if (!b)
+                pcat_fail("division by zero");
+            return box_int(b == -1 ? 0 : a % b);
+        }
+    }
+    double a = as_real(x), b = as_real(y);
+    switch (op) {
+    case A_ADD: return box_real(a + b);
+    case A_SUB: return box_real(a - b);
+    case A_MUL: return box_real(a * b);
+    case A_RDIV:
+        if (b == 0)
+            pcat_fail("division by zero");
+        return box_real(a / b);
+    default:
+        pcat_fail("DIV and MOD need integers");
+        return x;
+    }
+}
+
+static int same(value x, value y) {
+    if (is_number(x) && is_number(y))
+        return as_real(x) == as_real(y);
+    if (tag(x) == TAG_BOOL && tag(y) == TAG_BOOL)
+        return x == y;
+    if (tag(x) < TAG_NIL || tag(y) < TAG_NIL)
+        pcat_fail("comparing values of different types");
+    return x == y;
+}
+
+value pcat_compare(int op, value x, value y) {
+    if (op == R_EQ)
+        return box_bool(same(x, y));
+    if (op == R_NE)
+        return box_bool(!same(x, y));
+    if (!is_number(x) || !is_number(y))
+        pcat_fail("ordering non-numbers");
+    double a = as_real(x), b = as_real(y);
+    if (is_int(x) && is_int(y)) {
+        a = int_of(x);
+        b = int_of(y);
+    }
+    switch (op) {
+    case R_LT: return box_bool(a < b);
+    case R_LE: return box_bool(a <= b);
+    case R_GT: return box_bool(a > b);
+    default:   return box_bool(a >= b);
+    }
+}
+
+value pcat_negative(value x) {
+    if (is_int(x))
+        return box_int((int32_t)(0u - (uint32_t)int_of(x)));
+    if (is_real(x))
+        return box_real(-real_of(x));
+    pcat_fail("unary - of a non-number");
+    return x;
+}
+
+void pcat_not_number(void) {
+    pcat_fail("unary + of a non-number");
+}
+
+void pcat_not_boolean(void) {
+    pcat_fail("condition is not a boolean");
+}
+
+void pcat_for_fail(value from, value to, value by) {
+    if (!is_int(from) || !is_int(to) || !is_int(by))
+        pcat_fail("FOR bounds and step must be integers");
+    pcat_fail("FOR step is zero");
+}
+
+void pcat_for_variable(void) {
+    pcat_fail("FOR variable assigned a non-integer");
+}
+
+void pcat_too_deep(void) {
+    pcat_fail("procedure calls nested too deeply");
+}
+
+void pcat_index_fail(value a, value i) {
+    if (tag(a) != TAG_OBJ || object_of(a)->record)
+        pcat_fail(tag(a) == TAG_NIL ? "indexing NIL" : "indexing a non-array");
+    if (!is_int(i))
+        pcat_fail("array index is not an integer");
+    pcat_fail("array index out of bounds");
+}
+
+/* the item a field access refers to, filling in its cache */
+value* pcat_field(struct field_site* site, value r) {
+    if (tag(r) != TAG_OBJ || !object_of(r)->record)
+        pcat_fail(tag(r) == TAG_NIL ? "field of NIL" : "field of a non-record");
+    struct object* o = object_of(r);
+    const struct record_info* info = o->record;
+    if (site->seen != info) {
+        uint64_t i;
+        for (i = 0; i < info->fields; ++i)
+            if (info->ids[i] == site->id)
+                break;
+        if (i == info->fields) {
+            char message[256];
+            snprintf(message, sizeof(message), "%s has no field %s", info->name, site->name);
+            pcat_fail(message);
+        }
+        site->seen = info;
+        site->offset = (uint64_t)((char*)&o->items[i] - (char*)o);
+    }
+    return (value*)((char*)o + site->offset);
+}
+
+static value to_kind(value v, unsigned kind) {
+    return kind == K_REAL && is_int(v) ? box_real(int_of(v)) : v;
+}
+
+void pcat_set_field(struct field_site* site, value r, value v) {
+    value* at = pcat_field(site, r);
+    const struct record_info* info = object_of(r)->record;
+    *at = to_kind(v, info->kinds[at - object_of(r)->items]);
+}
+
+/* bump allocation, nothing is ever freed */
+static struct object* new_object(const struct record_info* record, uint64_t size) {
+    static char* next;
+    static char* end;
+    size_t bytes = (sizeof(struct object) + size * sizeof(value) + 15) & ~(size_t)15;
+    if (size > UINT32_MAX / sizeof(value))
+        pcat_fail("array too large");
+    if ((size_t)(end - next) < bytes) {
+        size_t chunk = bytes > (1u << 20) ? bytes : (1u << 20);
+        next = malloc(chunk);
+        if (!next)
+            pcat_fail("out of memory");
+        end = next + chunk;
+    }
+    struct object* o = (struct object*)next;
+    next += bytes;
+    o->record = record;
+    o->size = (uint32_t)size;
+    o->pad = 0;
+    return o;
+}
+
+value pcat_new_record(const struct record_site* site, const value* vals) {
+    const struct record_info* r = site->record;
+    struct object* o = new_object(r, r->fields);
+    for (uint64_t i = 0; i < r->fields; ++i)
+        o->items[i] = r->kinds[i] == K_REAL ? box_real(0)
+                    : r->kinds[i] == K_INT ? box_int(0)
+                    : r->kinds[i] == K_BOOL ? box_bool(0) : NIL;
+    for (uint64_t i = 0; i < site->n; ++i)
+        o->items[site->fields[i]] = to_kind(vals[i], r->kinds[site->fields[i]]);
+    return box_object(o);
+}
+
+/* count copies of v from at: one, then copies of what is there already,
+ * doubling, which memcpy does a block at a time */
+static void fill(value* at, value v, uint64_t count) {
+    uint64_t done = 1;
+    if (!count)
+        return;
+    at[0] = v;
+    while (done < count) {
+        uint64_t n = done < count - done ? done : count - done;
+        memcpy(at + done, at, n * sizeof(value));
+        done += n;
+    }
+}
+
+value pcat_new_array(const struct array_site* site, const value* vals) {
+    uint64_t size = 0;
+    const value* v = vals;
+    for (uint64_t i = 0; i < site->n; ++i) {
+        if (site->of[i]) {
+            if (!is_int(*v) || int_of(*v) < 0)
+                pcat_fail("array count is not a non-negative integer");
+            size += (uint64_t)int_of(*v);
+            v += 2;
+        } else {
+            size += 1;
+            v += 1;
+        }
+    }
+    struct object* o = new_object(NULL, size);
+    value* at = o->items;
+    v = vals;
+    for (uint64_t i = 0; i < site->n; ++i) {
+        uint64_t count = 1;
+        if (site->of[i])
+            count = (uint64_t)int_of(*v++);
+        fill(at, *v++, count);
+        at += count;
+    }
+    return box_object(o);
+}
+
+void pcat_write(value x) {
+    switch (tag(x)) {
+    case TAG_INT:
+        printf("%d", int_of(x));
+        break;
+    case TAG_BOOL:
+        fputs(x & 1 ? "TRUE" : "FALSE", stdout);
+        break;
+    case TAG_NIL:
+        fputs("NIL", stdout);
+        break;
+    case TAG_OBJ:
+        pcat_fail("WRITE of a record or array");
+        break;
+    default: {
+        /* always with a point or exponent so reals read as reals */
+        char s[64];
+        snprintf(s, sizeof(s), "%g", real_of(x));
+        if (!strpbrk(s, ".eni"))
+            strcat(s, ".0");
+        fputs(s, stdout);
+    }
+    }
+}
+
+void pcat_write_string(const char* s, uint64_t n) {
+    fwrite(s, 1, n, stdout);
+}
+
+void pcat_writeln(void) {
+    putchar('\n');
+}
+
+/* reads a number: a real if it is declared or the target holds one */
+value pcat_read(uint64_t kind, value current) {
+    fflush(stdout);
+    if (kind == K_REAL || is_real(current)) {
+        double r;
+        if (scanf("%lf", &r) != 1)
+            pcat_fail("READ: expected a real number");
+        return box_real(r);
+    }
+    int i;
+    if (scanf("%d", &i) != 1)
+        pcat_fail("READ: expected an integer");
+    return box_int(i);
+}
+
+/* below the deepest PCAT frame: the runtime's own calls, and above main
+ * the environment, both counted against the stack limit */
+#define STACK_RESERVE ((uintptr_t)512 << 10)
+
+/* how far below top the deepest PCAT frame may go: the stack limit, or
+ * the usual 8 MB when there is none, less the reserve */
+static uintptr_t stack_room(uintptr_t top) {
+    struct rlimit rl;
+    uintptr_t size = (uintptr_t)8 << 20;
+    if (getrlimit(RLIMIT_STACK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+        size = rl.rlim_cur < top ? (uintptr_t)rl.rlim_cur : top;
+    return size > 2 * STACK_RESERVE ? size - STACK_RESERVE : size / 2;
+}
+
+int main(void) {
+    char here;
+    uintptr_t top = (uintptr_t)&here;
+    pcat_stack_limit = (char*)(top - stack_room(top));
+    pcat_main();
+    fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,167 @@
+// symbol tables for nested scopes. Every name maps, through one open
+// addressing table, to its innermost binding; the bindings it hides are
+// chained behind it and come back when the scope hiding them closes. So a
+// lookup costs one probe sequence however deeply scopes nest, and closing
+// a scope costs the number of names declared in it.
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <vector>
+#include "intern.h"
+
+// open addressing, linear probing, power of two capacity: 64-bit keys to
+// unsigned values. Nothing is ever removed.
+class IndexTable {
+    struct Slot {
+        unsigned long long key;
+        unsigned value;
+        bool used;
+    };
+    std::vector<Slot> slots;
+    size_t count;
+
+    static size_t hash(unsigned long long key) {
+        // Fibonacci hashing: the high bits of the product are well mixed
+        return (size_t)((key * 0x9e3779b97f4a7c15ull) >> 32);
+    }
+
+    size_t probe(unsigned long long key) const {
+        size_t mask = slots.size() - 1;
+        size_t i = hash(key) & mask;
+        while (slots[i].used && slots[i].key != key)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow() {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        for (size_t i = 0; i < old.size(); ++i)
+            if (old[i].used)
+                slots[probe(old[i].key)] = old[i];
+    }
+public:
+    IndexTable() : slots(16), count(0) {}
+
+    unsigned* find(unsigned long long key) {
+        Slot& s = slots[probe(key)];
+        return s.used ? &s.value : NULL;
+    }
+
+    const unsigned* find(unsigned long long key) const {
+        const Slot& s = slots[probe(key)];
+        return s.used ? &s.value : NULL;
+    }
+
+    // the value of key, added as value if it is not there yet; valid
+    // until the next insert
+    unsigned& insert(unsigned long long key, unsigned value) {
+        // keep the load factor under one half
+        if ((count + 1) * 2 > slots.size())
+            grow();
+        Slot& s = slots[probe(key)];
+        if (!s.used) {
+            s.used = true;
+            s.key = key;
+            s.value = value;
+            ++count;
+        }
+        return s.value;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    void clear() {
+        slots.assign(16, Slot());
+        count = 0;
+    }
+};
+
+template <class T>
+class ScopedTable {
+    enum { none = ~0u };
+
+    struct Binding {
+        Symbol name;
+        unsigned shadowed;   // the binding of name this one hides
+        T value;
+    };
+
+    IndexTable innermost;    // symbol id to its innermost binding, or none
+    std::vector<Binding> bindings;  // in order of declaration
+    std::vector<unsigned> marks;    // bindings.size() as each scope opened
+public:
+    void open() {
+        marks.push_back((unsigned)bindings.size());
+    }
+
+    void close() {
+        unsigned mark = marks.back();
+        marks.pop_back();
+        while (bindings.size() > mark) {
+            Binding& b = bindings.back();
+            *innermost.find(b.name.id()) = b.shadowed;
+            bindings.pop_back();
+        }
+    }
+
+    unsigned depth() const {
+        return (unsigned)marks.size();
+    }
+
+    // binds name in the innermost scope; a name declared twice in one
+    // scope means the later declaration until the scope closes
+    T& declare(Symbol name, const T& value) {
+        unsigned& top = innermost.insert(name.id(), none);
+        Binding b;
+        b.name = name;
+        b.shadowed = top;
+        b.value = value;
+        top = (unsigned)bindings.size();
+        bindings.push_back(b);
+        return bindings.back().value;
+    }
+
+    // the innermost binding of name, NULL if there is none; pointers stay
+    // valid until the next declare
+    T* lookup(Symbol name) {
+        const unsigned* top = innermost.find(name.id());
+        return top && *top != none ? &bindings[*top].value : NULL;
+    }
+
+    const T* lookup(Symbol name) const {
+        const unsigned* top = innermost.find(name.id());
+        return top && *top != none ? &bindings[*top].value : NULL;
+    }
+
+    // the binding of name in the innermost scope only
+    T* lookup_local(Symbol name) {
+        const unsigned* top = innermost.find(name.id());
+        return top && *top != none && *top >= marks.back() ? &bindings[*top].value : NULL;
+    }
+
+    // the bindings of the innermost scope are local_begin()..size()-1
+    unsigned local_begin() const {
+        return marks.back();
+    }
+
+    unsigned size() const {
+        return (unsigned)bindings.size();
+    }
+
+    Symbol name_at(unsigned i) const {
+        return bindings[i].name;
+    }
+
+    T& value_at(unsigned i) {
+        return bindings[i].value;
+    }
+
+    const T& value_at(unsigned i) const {
+        return bindings[i].value;
+    }
+};
+
+#endif
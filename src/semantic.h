@@ -0,0 +1,842 @@
+// static checks on a flat tree: every name is resolved to its declaration
+// and every expression gets a type, INTEGER operands meeting REAL ones are
+// marked as promoted. Scopes are ScopedTables, so resolving a name costs
+// one expected O(1) lookup however far out it is declared and the pass is
+// linear in the size of the program. Problems are collected rather than
+// thrown; an expression already found wrong has the error type, which
+// fits anywhere, so one mistake is reported once.
+#ifndef SEMANTIC_H
+#define SEMANTIC_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "flat.h"
+#include "intern.h"
+#include "scope.h"
+
+class Checker {
+public:
+    // ids of the predeclared types, the declared ones follow
+    enum { T_ERROR, T_INT, T_REAL, T_BOOL, T_NIL, T_STRING, T_BUILTINS };
+private:
+    enum TypeClass { TY_ERROR, TY_INT, TY_REAL, TY_BOOL, TY_NIL, TY_STRING,
+                     TY_RECORD, TY_ARRAY, TY_ALIAS };
+
+    enum What { D_VAR, D_CONST, D_TYPE, D_PROC };
+
+    struct Decl {
+        unsigned char what;
+        unsigned type;       // D_VAR, D_CONST: its type; D_TYPE: the type;
+                             // D_PROC: index in sigs
+        unsigned id;         // the declaring N_ID, NO_NODE if predeclared
+    };
+
+    struct TypeInfo {
+        unsigned char cls;
+        bool busy, done;     // TY_ALIAS: being resolved, resolved
+        Symbol name;
+        unsigned node;       // the type node it was made from
+        unsigned of;         // TY_ARRAY: element type; TY_ALIAS: what it names
+        unsigned first;      // TY_RECORD: its fields are field_types[first..]
+        unsigned fields;
+    };
+
+    struct Signature {
+        Symbol name;
+        unsigned node;       // N_PROC_DECL
+        std::vector<unsigned> params;
+        unsigned result;
+        bool has_result;
+    };
+
+    FlatView v;
+    std::vector<Symbol> symbols;  // of each name in the tree's table
+    ScopedTable<Decl> scopes;
+    std::vector<TypeInfo> types;
+    std::vector<Signature> sigs;
+    IndexTable field_index;  // record type << 32 | field symbol to a field
+    std::vector<unsigned> field_types;
+    std::vector<unsigned> type_of_node;
+    std::vector<unsigned> decl_of_node;
+    std::vector<bool> promoted_node;
+    std::vector<std::string> diags;
+    std::vector<unsigned> nest;  // the procedures being checked, as sigs
+    unsigned loops;              // around the current statement
+    unsigned long long resolved;
+
+    Checker(const Checker&);
+    Checker& operator=(const Checker&);
+
+    Symbol sym(unsigned n) const {
+        return symbols[v.value[n]];
+    }
+
+    static std::string str(Symbol s) {
+        return std::string(s.c_str(), s.size());
+    }
+
+    // a problem at node at, given as ln:col where it starts, the way the
+    // parser gives its errors
+    void error(unsigned at, const std::string& message) {
+        std::string where = nest.empty() ? "program"
+                          : "procedure " + str(sigs[nest.back()].name);
+        if (at != NO_NODE && v.pos_of(at).ln)
+            where = number(v.pos_of(at).ln) + ":" + number(v.pos_of(at).col) + " " + where;
+        diags.push_back(where + ": " + message);
+    }
+
+    std::string type_name(unsigned t) const {
+        static const char* const builtin[] = {
+            "no type", "INTEGER", "REAL", "BOOLEAN", "NIL", "STRING"
+        };
+        if (t < T_BUILTINS)
+            return builtin[t];
+        const TypeInfo& ti = types[t];
+        if (!ti.name.null())
+            return str(ti.name);
+        return ti.cls == TY_ARRAY ? "ARRAY OF " + type_name(ti.of) : "RECORD";
+    }
+
+    unsigned new_type(unsigned char cls, Symbol name, unsigned node) {
+        TypeInfo ti;
+        ti.cls = cls;
+        ti.busy = ti.done = false;
+        ti.name = name;
+        ti.node = node;
+        ti.of = T_ERROR;
+        ti.first = ti.fields = 0;
+        types.push_back(ti);
+        return (unsigned)types.size() - 1;
+    }
+
+    // the innermost declaration of the identifier in id, recorded for node
+    const Decl* resolve(unsigned node, unsigned id) {
+        ++resolved;
+        const Decl* d = scopes.lookup(sym(id));
+        if (d)
+            decl_of_node[node] = d->id;
+        return d;
+    }
+
+    bool declare(unsigned id, const Decl& d) {
+        Symbol name = sym(id);
+        if (scopes.lookup_local(name)) {
+            error(id, str(name) + " is declared twice in the same scope");
+            return false;
+        }
+        scopes.declare(name, d);
+        return true;
+    }
+
+    static Decl entry(What what, unsigned type, unsigned id) {
+        Decl d;
+        d.what = (unsigned char)what;
+        d.type = type;
+        d.id = id;
+        return d;
+    }
+
+    // ---- types ----
+
+    // the type a type node denotes; ARRAY OF and RECORD written out in
+    // place are new types of their own
+    unsigned type_from(unsigned n) {
+        if (n == NO_NODE)
+            return T_ERROR;
+        switch (v.kind_of(n)) {
+        case N_BUILTIN_TYPE: {
+            Text t = v.text_of(n);
+            if (t.len == 7 && !memcmp(t.ptr, "INTEGER", 7))
+                return T_INT;
+            if (t.len == 4 && !memcmp(t.ptr, "REAL", 4))
+                return T_REAL;
+            return T_STRING;
+        }
+        case N_USER_TYPE: {
+            unsigned id = v.child(n, 0);
+            const Decl* d = resolve(n, id);
+            if (!d) {
+                error(id, "type " + str(sym(id)) + " is not declared");
+                return T_ERROR;
+            }
+            if (d->what != D_TYPE) {
+                error(id, str(sym(id)) + " is not a type");
+                return T_ERROR;
+            }
+            return target(d->type);
+        }
+        case N_ARRAY_TYPE: {
+            unsigned t = new_type(TY_ARRAY, Symbol(), n);
+            complete(t);
+            return t;
+        }
+        case N_RECORD_TYPE: {
+            unsigned t = new_type(TY_RECORD, Symbol(), n);
+            complete(t);
+            return t;
+        }
+        default:
+            return T_ERROR;
+        }
+    }
+
+    // a declared type as used: an alias is replaced by what it names,
+    // following chains of aliases
+    unsigned target(unsigned t) {
+        if (types[t].cls != TY_ALIAS || types[t].done)
+            return types[t].cls == TY_ALIAS ? types[t].of : t;
+        if (types[t].busy) {
+            error(types[t].node, "type " + str(types[t].name) + " is defined in terms of itself");
+            types[t].done = true;
+            return T_ERROR;
+        }
+        types[t].busy = true;
+        unsigned of = type_from(types[t].node);
+        types[t].busy = false;
+        types[t].done = true;
+        types[t].of = of;
+        return of;
+    }
+
+    // fills in the element type of an array or the fields of a record
+    void complete(unsigned t) {
+        unsigned n = types[t].node;
+        if (types[t].cls == TY_ARRAY) {
+            unsigned elem = type_from(v.child(n, 0));
+            types[t].of = elem;
+            return;
+        }
+        unsigned comps = v.child(n, 0);
+        unsigned first = (unsigned)field_types.size();
+        types[t].first = first;
+        types[t].fields = v.children(comps);
+        field_types.resize(first + v.children(comps), T_ERROR);
+        for (unsigned i = 0; i < v.children(comps); ++i) {
+            unsigned comp = v.child(comps, i);
+            Symbol name = sym(v.child(comp, 0));
+            unsigned key = first + i;
+            if (field_index.insert(field_key(t, name), key) != key)
+                error(v.child(comp, 0), type_name(t) + " has two fields named " + str(name));
+            field_types[key] = type_from(v.child(comp, 1));
+        }
+    }
+
+    static unsigned long long field_key(unsigned t, Symbol name) {
+        return (unsigned long long)t << 32 | name.id();
+    }
+
+    unsigned cls(unsigned t) const {
+        return types[t].cls;
+    }
+
+    bool is_number(unsigned t) const {
+        return t == T_INT || t == T_REAL;
+    }
+
+    bool is_reference(unsigned t) const {
+        return cls(t) == TY_RECORD || cls(t) == TY_ARRAY;
+    }
+
+    // whether a value of type from can be stored where to is expected;
+    // an INTEGER going into a REAL is promoted
+    bool fits(unsigned from, unsigned to, unsigned expr) {
+        if (from == to || from == T_ERROR || to == T_ERROR)
+            return true;
+        if (from == T_INT && to == T_REAL) {
+            promoted_node[expr] = true;
+            return true;
+        }
+        return from == T_NIL && is_reference(to);
+    }
+
+    void mismatch(unsigned expr, const std::string& what, unsigned type, unsigned want) {
+        error(expr, what + " is " + type_name(type) + ", not " + type_name(want));
+    }
+
+    void expect(unsigned expr, unsigned type, unsigned want, const char* what) {
+        if (!fits(type, want, expr))
+            mismatch(expr, what, type, want);
+    }
+
+    // ---- expressions ----
+
+    unsigned typed(unsigned n, unsigned t) {
+        type_of_node[n] = t;
+        return t;
+    }
+
+    // the type of an lvalue; read says whether it is only read, then it
+    // may also name a constant
+    unsigned lvalue(unsigned n, bool read = false) {
+        switch (v.kind_of(n)) {
+        case N_ID_LVALUE: {
+            unsigned id = v.child(n, 0);
+            const Decl* d = resolve(n, id);
+            if (!d) {
+                error(id, str(sym(id)) + " is not declared");
+                return typed(n, T_ERROR);
+            }
+            if (d->what == D_CONST && read)
+                return typed(n, d->type);
+            if (d->what != D_VAR) {
+                error(id, str(sym(id)) + " is not a variable");
+                return typed(n, T_ERROR);
+            }
+            return typed(n, d->type);
+        }
+        case N_ARRAY_LVALUE: {
+            unsigned a = lvalue(v.child(n, 0));
+            unsigned i = expr(v.child(n, 1));
+            if (i != T_INT && i != T_ERROR)
+                error(v.child(n, 1), "array index is " + type_name(i) + ", not INTEGER");
+            if (a == T_ERROR)
+                return typed(n, T_ERROR);
+            if (cls(a) != TY_ARRAY) {
+                error(n, "indexing " + type_name(a) + ", not an array");
+                return typed(n, T_ERROR);
+            }
+            return typed(n, types[a].of);
+        }
+        default: {
+            unsigned r = lvalue(v.child(n, 0));
+            Symbol field = sym(v.child(n, 1));
+            if (r == T_ERROR)
+                return typed(n, T_ERROR);
+            if (cls(r) != TY_RECORD) {
+                error(v.child(n, 1),
+                      "field " + str(field) + " of " + type_name(r) + ", not a record");
+                return typed(n, T_ERROR);
+            }
+            const unsigned* at = field_index.find(field_key(r, field));
+            if (!at) {
+                error(v.child(n, 1), type_name(r) + " has no field " + str(field));
+                return typed(n, T_ERROR);
+            }
+            return typed(n, field_types[*at]);
+        }
+        }
+    }
+
+    // the result of a call; checks the arguments against the parameters
+    unsigned call(unsigned n, bool value) {
+        unsigned id = v.child(n, 0);
+        unsigned params = v.child(n, 1);
+        unsigned count = params == NO_NODE ? 0 : v.children(params);
+        std::vector<unsigned> args(count);
+        for (unsigned i = 0; i < count; ++i)
+            args[i] = expr(v.child(params, i));
+        const Decl* d = resolve(n, id);
+        if (!d) {
+            error(id, "procedure " + str(sym(id)) + " is not declared");
+            return T_ERROR;
+        }
+        if (d->what != D_PROC) {
+            error(id, str(sym(id)) + " is not a procedure");
+            return T_ERROR;
+        }
+        const Signature& s = sigs[d->type];
+        if (count != s.params.size()) {
+            error(id, str(sym(id)) + " takes " + number(s.params.size()) + " arguments, not "
+                      + number(count));
+        } else {
+            for (unsigned i = 0; i < count; ++i)
+                if (!fits(args[i], s.params[i], v.child(params, i)))
+                    mismatch(v.child(params, i), "argument " + number(i + 1) + " of "
+                             + str(sym(id)), args[i], s.params[i]);
+        }
+        if (s.has_result)
+            return s.result;
+        if (value)
+            error(id, str(sym(id)) + " does not return a value");
+        return T_ERROR;
+    }
+
+    static std::string number(size_t i) {
+        char s[24];
+        snprintf(s, sizeof(s), "%zu", i);
+        return s;
+    }
+
+    enum OpClass { O_LOGIC, O_EQUALITY, O_ORDER, O_INTEGER, O_DIVIDE, O_ARITH };
+
+    // from the first characters of the operators the grammar allows
+    static OpClass op_class(Text t) {
+        switch (t.ptr[0]) {
+        case 'A': case 'O': return O_LOGIC;
+        case '=': return O_EQUALITY;
+        case '<': return t.len == 2 && t.ptr[1] == '>' ? O_EQUALITY : O_ORDER;
+        case '>': return O_ORDER;
+        case 'D': case 'M': return O_INTEGER;
+        case '/': return O_DIVIDE;
+        default: return O_ARITH;
+        }
+    }
+
+    void operand_error(unsigned n, unsigned a, unsigned b, const char* want) {
+        Text t = v.text_of(v.child(n, 1));
+        error(v.child(n, 1), std::string(t.ptr, t.len) + " of " + type_name(a) + " and "
+                             + type_name(b) + ", not " + want);
+    }
+
+    unsigned binary(unsigned n) {
+        unsigned left = v.child(n, 0), right = v.child(n, 2);
+        unsigned a = expr(left), b = expr(right);
+        OpClass op = op_class(v.text_of(v.child(n, 1)));
+        if (a == T_ERROR || b == T_ERROR)
+            return T_ERROR;
+        if (op == O_LOGIC) {
+            if (a == T_BOOL && b == T_BOOL)
+                return T_BOOL;
+            operand_error(n, a, b, "BOOLEAN");
+            return T_ERROR;
+        }
+        if (op == O_EQUALITY) {
+            if (is_number(a) && is_number(b)) {
+                promote(left, a, b);
+                promote(right, b, a);
+                return T_BOOL;
+            }
+            if (a == b && (a == T_BOOL || is_reference(a) || a == T_NIL))
+                return T_BOOL;
+            if ((a == T_NIL && is_reference(b)) || (b == T_NIL && is_reference(a)))
+                return T_BOOL;
+            error(v.child(n, 1), "comparing " + type_name(a) + " and " + type_name(b));
+            return T_ERROR;
+        }
+        if (op == O_INTEGER) {
+            if (a == T_INT && b == T_INT)
+                return T_INT;
+            operand_error(n, a, b, "INTEGER");
+            return T_ERROR;
+        }
+        if (!is_number(a) || !is_number(b)) {
+            operand_error(n, a, b, "numbers");
+            return T_ERROR;
+        }
+        promote(left, a, b);
+        promote(right, b, a);
+        if (op == O_ORDER)
+            return T_BOOL;
+        if (op == O_DIVIDE) {
+            // always a REAL division
+            promote(left, a, T_REAL);
+            promote(right, b, T_REAL);
+            return T_REAL;
+        }
+        return a == T_INT && b == T_INT ? T_INT : T_REAL;
+    }
+
+    // an INTEGER operand next to a REAL one
+    void promote(unsigned operand, unsigned type, unsigned other) {
+        if (type == T_INT && other == T_REAL)
+            promoted_node[operand] = true;
+    }
+
+    unsigned expr(unsigned n) {
+        return typed(n, expr_type(n));
+    }
+
+    unsigned expr_type(unsigned n) {
+        switch (v.kind_of(n)) {
+        case N_NUMBER_EXPR:
+            return v.number(n).real ? T_REAL : T_INT;
+        case N_LVALUE_EXPR:
+            // TRUE, FALSE and NIL are predeclared constants
+            return lvalue(v.child(n, 0), true);
+        case N_UNARY_EXPR: {
+            unsigned t = expr(v.child(n, 1));
+            Text op = v.text_of(v.child(n, 0));
+            if (t == T_ERROR)
+                return T_ERROR;
+            if (op.ptr[0] == 'N' ? t == T_BOOL : is_number(t))
+                return t;
+            error(v.child(n, 0), std::string(op.ptr, op.len) + " of " + type_name(t));
+            return T_ERROR;
+        }
+        case N_BINOP_EXPR:
+            return binary(n);
+        case N_CALL_EXPR:
+            return call(n, true);
+        case N_RECORD_EXPR: {
+            unsigned t = named_type(n, TY_RECORD, "record");
+            unsigned vals = v.child(n, 1);
+            for (unsigned i = 0; i < v.children(vals); ++i) {
+                unsigned cv = v.child(vals, i);
+                unsigned e = expr(v.child(cv, 1));
+                if (t == T_ERROR)
+                    continue;
+                Symbol field = sym(v.child(cv, 0));
+                const unsigned* at = field_index.find(field_key(t, field));
+                if (!at)
+                    error(v.child(cv, 0), type_name(t) + " has no field " + str(field));
+                else if (!fits(e, field_types[*at], v.child(cv, 1)))
+                    mismatch(v.child(cv, 1), "field " + str(field), e, field_types[*at]);
+            }
+            return t;
+        }
+        case N_ARRAY_EXPR: {
+            unsigned t = named_type(n, TY_ARRAY, "array");
+            unsigned elem = types[t].of;
+            unsigned vals = v.child(n, 1);
+            for (unsigned i = 0; i < v.children(vals); ++i) {
+                unsigned av = v.child(vals, i);
+                unsigned value = v.child(av, v.kind_of(av) == N_OF_ARRAY_VALUE ? 1 : 0);
+                if (v.kind_of(av) == N_OF_ARRAY_VALUE) {
+                    unsigned count = expr(v.child(av, 0));
+                    expect(v.child(av, 0), count, T_INT, "array count");
+                }
+                expect(value, expr(value), elem, "array element");
+            }
+            return t;
+        }
+        default:
+            return T_ERROR;
+        }
+    }
+
+    // the record or array type named by a constructor
+    unsigned named_type(unsigned n, unsigned char want, const char* what) {
+        unsigned id = v.child(n, 0);
+        const Decl* d = resolve(n, id);
+        if (!d) {
+            error(id, "type " + str(sym(id)) + " is not declared");
+            return T_ERROR;
+        }
+        if (d->what != D_TYPE) {
+            error(id, str(sym(id)) + " is not a type");
+            return T_ERROR;
+        }
+        unsigned t = target(d->type);
+        if (t != T_ERROR && cls(t) != want) {
+            error(id, str(sym(id)) + " is not " + (want == TY_ARRAY ? "an " : "a ") + what
+                      + " type");
+            return T_ERROR;
+        }
+        return t;
+    }
+
+    // ---- statements ----
+
+    void condition(unsigned n) {
+        expect(n, expr(n), T_BOOL, "condition");
+    }
+
+    void stats(unsigned list) {
+        for (unsigned i = 0; i < v.children(list); ++i)
+            stat(v.child(list, i));
+    }
+
+    void stat(unsigned n) {
+        switch (v.kind_of(n)) {
+        case N_ASSIGN_STAT: {
+            unsigned target = lvalue(v.child(n, 0));
+            unsigned value = v.child(n, 1);
+            expect(value, expr(value), target, "assigned value");
+            break;
+        }
+        case N_CALL_STAT:
+            call(n, false);
+            break;
+        case N_READ_STAT: {
+            unsigned lvals = v.child(n, 0);
+            for (unsigned i = 0; i < v.children(lvals); ++i) {
+                unsigned t = lvalue(v.child(lvals, i));
+                if (t != T_ERROR && !is_number(t))
+                    error(v.child(lvals, i), "READ into " + type_name(t) + ", not a number");
+            }
+            break;
+        }
+        case N_WRITE_STAT: {
+            unsigned items = v.child(n, 0);
+            unsigned count = items == NO_NODE ? 0 : v.children(items);
+            for (unsigned i = 0; i < count; ++i) {
+                unsigned item = v.child(items, i);
+                if (v.kind_of(item) == N_STR_WRITE_EXPR)
+                    continue;
+                unsigned t = expr(v.child(item, 0));
+                if (is_reference(t) || t == T_STRING)
+                    error(item, "WRITE of " + type_name(t));
+            }
+            break;
+        }
+        case N_IF_STAT: {
+            condition(v.child(n, 0));
+            stats(v.child(n, 1));
+            unsigned elseifs = v.child(n, 2);
+            for (unsigned i = 0; i < v.children(elseifs); ++i) {
+                condition(v.child(v.child(elseifs, i), 0));
+                stats(v.child(v.child(elseifs, i), 1));
+            }
+            if (v.child(n, 3) != NO_NODE)
+                stats(v.child(n, 3));
+            break;
+        }
+        case N_WHILE_STAT:
+            condition(v.child(n, 0));
+            ++loops;
+            stats(v.child(n, 1));
+            --loops;
+            break;
+        case N_LOOP_STAT:
+            ++loops;
+            stats(v.child(n, 0));
+            --loops;
+            break;
+        case N_FOR_STAT: {
+            unsigned id = v.child(n, 0);
+            const Decl* d = resolve(n, id);
+            if (!d)
+                error(id, "FOR variable " + str(sym(id)) + " is not declared");
+            else if (d->what != D_VAR || (d->type != T_INT && d->type != T_ERROR))
+                error(id, "FOR variable " + str(sym(id)) + " is not an INTEGER variable");
+            for (unsigned i = 1; i <= 3; ++i)
+                if (v.child(n, i) != NO_NODE)
+                    expect(v.child(n, i), expr(v.child(n, i)), T_INT,
+                           i == 3 ? "FOR step" : "FOR bound");
+            ++loops;
+            stats(v.child(n, 4));
+            --loops;
+            break;
+        }
+        case N_EXIT_STAT:
+            if (!loops)
+                error(n, "EXIT outside a loop");
+            break;
+        case N_RETURN_STAT: {
+            unsigned value = v.child(n, 0);
+            const Signature* s = nest.empty() ? NULL : &sigs[nest.back()];
+            if (value == NO_NODE) {
+                if (s && s->has_result)
+                    error(n, "RETURN without a value");
+            } else if (!s || !s->has_result) {
+                expr(value);
+                error(n, "RETURN with a value from "
+                         + std::string(s ? "a procedure without a result" : "the program"));
+            } else {
+                expect(value, expr(value), s->result, "returned value");
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // ---- declarations ----
+
+    void for_decls(unsigned decls, DeclSort sort, void (Checker::*each)(unsigned)) {
+        for (unsigned i = 0; i < v.children(decls); ++i) {
+            unsigned decl = v.child(decls, i);
+            if (v.value[decl] != (unsigned)sort)
+                continue;
+            unsigned block = v.child(decl, 0);
+            for (unsigned j = 0; j < v.children(block); ++j)
+                (this->*each)(v.child(block, j));
+        }
+    }
+
+    void declare_type(unsigned n) {
+        unsigned id = v.child(n, 0);
+        unsigned t = v.child(n, 1);
+        unsigned char c = v.kind_of(t) == N_RECORD_TYPE ? TY_RECORD
+                        : v.kind_of(t) == N_ARRAY_TYPE ? TY_ARRAY : TY_ALIAS;
+        declare(id, entry(D_TYPE, new_type(c, sym(id), t), id));
+    }
+
+    void complete_type(unsigned n) {
+        unsigned id = v.child(n, 0);
+        const Decl* d = scopes.lookup_local(sym(id));
+        // a duplicate declaration was not entered
+        if (!d || d->id != id)
+            return;
+        if (types[d->type].cls == TY_ALIAS)
+            target(d->type);
+        else
+            complete(d->type);
+    }
+
+    void declare_proc(unsigned n) {
+        unsigned id = v.child(n, 0);
+        Signature s;
+        s.name = sym(id);
+        s.node = n;
+        s.result = T_ERROR;
+        s.has_result = false;
+        sigs.push_back(s);
+        declare(id, entry(D_PROC, (unsigned)sigs.size() - 1, id));
+    }
+
+    // the entry of a declared procedure, NULL for a duplicate
+    const Decl* proc_entry(unsigned n) {
+        const Decl* d = scopes.lookup_local(sym(v.child(n, 0)));
+        return d && d->what == D_PROC && sigs[d->type].node == n ? d : NULL;
+    }
+
+    void sign_proc(unsigned n) {
+        const Decl* d = proc_entry(n);
+        if (!d)
+            return;
+        unsigned index = d->type;
+        unsigned fpsecs = v.child(n, 1);
+        std::vector<unsigned> params;
+        if (fpsecs != NO_NODE) {
+            for (unsigned i = 0; i < v.children(fpsecs); ++i) {
+                unsigned sec = v.child(fpsecs, i);
+                unsigned t = type_from(v.child(sec, 1));
+                params.insert(params.end(), v.children(v.child(sec, 0)), t);
+            }
+        }
+        bool has_result = v.child(n, 2) != NO_NODE;
+        unsigned result = type_from(v.child(n, 2));
+        Signature& s = sigs[index];
+        s.params.swap(params);
+        s.has_result = has_result;
+        s.result = result;
+    }
+
+    void declare_var(unsigned var) {
+        unsigned ids = v.child(var, 0);
+        unsigned init = v.child(var, 2);
+        bool typed_decl = v.child(var, 1) != NO_NODE;
+        unsigned t = type_from(v.child(var, 1));
+        // the initializer sees the names declared before this one
+        unsigned value = expr(init);
+        if (typed_decl) {
+            expect(init, value, t, "initial value");
+        } else if (value == T_NIL) {
+            error(var, "a variable initialized to NIL needs a declared type");
+        } else {
+            t = value;
+        }
+        for (unsigned k = 0; k < v.children(ids); ++k) {
+            unsigned id = v.child(ids, k);
+            declare(id, entry(D_VAR, t, id));
+            type_of_node[id] = t;
+        }
+    }
+
+    void check_proc(unsigned n) {
+        const Decl* d = proc_entry(n);
+        if (!d)
+            return;
+        unsigned index = d->type;
+        nest.push_back(index);
+        scopes.open();
+        unsigned fpsecs = v.child(n, 1);
+        unsigned k = 0;
+        if (fpsecs != NO_NODE) {
+            for (unsigned i = 0; i < v.children(fpsecs); ++i) {
+                unsigned ids = v.child(v.child(fpsecs, i), 0);
+                for (unsigned j = 0; j < v.children(ids); ++j, ++k) {
+                    unsigned id = v.child(ids, j);
+                    declare(id, entry(D_VAR, sigs[index].params[k], id));
+                    type_of_node[id] = sigs[index].params[k];
+                }
+            }
+        }
+        body(v.child(n, 3));
+        scopes.close();
+        nest.pop_back();
+    }
+
+    // types and procedure names first so they can be used before their
+    // declaration, then variables in order, then the procedure bodies and
+    // the statements
+    void body(unsigned n) {
+        scopes.open();
+        unsigned decls = v.child(n, 0);
+        for_decls(decls, DECL_TYPE, &Checker::declare_type);
+        for_decls(decls, DECL_PROCEDURE, &Checker::declare_proc);
+        for_decls(decls, DECL_TYPE, &Checker::complete_type);
+        for_decls(decls, DECL_PROCEDURE, &Checker::sign_proc);
+        for_decls(decls, DECL_VAR, &Checker::declare_var);
+        for_decls(decls, DECL_PROCEDURE, &Checker::check_proc);
+        stats(v.child(n, 1));
+        scopes.close();
+    }
+
+    void predeclare() {
+        scopes.open();
+        scopes.declare(intern("TRUE"), entry(D_CONST, T_BOOL, NO_NODE));
+        scopes.declare(intern("FALSE"), entry(D_CONST, T_BOOL, NO_NODE));
+        scopes.declare(intern("NIL"), entry(D_CONST, T_NIL, NO_NODE));
+        scopes.declare(intern("BOOLEAN"), entry(D_TYPE, T_BOOL, NO_NODE));
+    }
+public:
+    Checker() : loops(0), resolved(0) {}
+
+    // checks the program in tree; false if anything was wrong, then
+    // diagnostics() says what
+    bool check(const FlatView& tree) {
+        v = tree;
+        // names are interned once here rather than at every use; literals
+        // are never looked up
+        symbols.assign(v.strings, Symbol());
+        for (unsigned n = 0; n < v.nodes; ++n) {
+            if (!has_text(v.kind_of(n)) || is_literal(v.kind_of(n))
+                || !symbols[v.value[n]].null())
+                continue;
+            Text t = v.text_of(n);
+            symbols[v.value[n]] = intern(t.ptr, t.len);
+        }
+        types.clear();
+        static const unsigned char builtin[] = {
+            TY_ERROR, TY_INT, TY_REAL, TY_BOOL, TY_NIL, TY_STRING
+        };
+        for (unsigned t = 0; t < T_BUILTINS; ++t)
+            new_type(builtin[t], Symbol(), NO_NODE);
+        sigs.clear();
+        field_index.clear();
+        field_types.clear();
+        type_of_node.assign(v.nodes, T_ERROR);
+        decl_of_node.assign(v.nodes, NO_NODE);
+        promoted_node.assign(v.nodes, false);
+        diags.clear();
+        resolved = 0;
+        if (v.root == NO_NODE || v.kind_of(v.root) != N_PROGRAM) {
+            diags.push_back("no program");
+            return false;
+        }
+        predeclare();
+        body(v.child(v.root, 0));
+        scopes.close();
+        return diags.empty();
+    }
+
+    const std::vector<std::string>& diagnostics() const {
+        return diags;
+    }
+
+    // the type of an expression or lvalue node, or of a declared N_ID
+    unsigned type_of(unsigned n) const {
+        return type_of_node[n];
+    }
+
+    std::string type_name_of(unsigned n) const {
+        return type_name(type_of_node[n]);
+    }
+
+    // the N_ID declaring what an N_ID_LVALUE, call, N_USER_TYPE,
+    // constructor or FOR statement refers to; NO_NODE if it is predeclared
+    // or undeclared
+    unsigned declaration(unsigned n) const {
+        return decl_of_node[n];
+    }
+
+    // whether an INTEGER expression is converted to REAL where it is used
+    bool promoted(unsigned n) const {
+        return promoted_node[n];
+    }
+
+    unsigned long long names_resolved() const {
+        return resolved;
+    }
+
+    size_t types_declared() const {
+        return types.size() - T_BUILTINS;
+    }
+};
+
+#endif
@@ -0,0 +1,98 @@
+// source files mapped into memory, and views of text inside them
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <cstddef>
+#include <ostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// a piece of text that outlives the token it came from: either a slice of
+// a mapped source file or a copy in the arena of the nodes that keep it;
+// not NUL terminated
+struct Text {
+    const char* ptr;
+    unsigned len;
+
+    Text() : ptr(""), len(0) {}
+    Text(const char* _ptr, size_t _len) : ptr(_ptr), len((unsigned)_len) {}
+};
+
+inline std::ostream& operator<< (std::ostream& out, const Text& t) {
+    return out.write(t.ptr, t.len);
+}
+
+// the whole file mapped copy-on-write, followed by the two NUL bytes flex
+// expects at the end of a buffer it scans in place
+class SourceFile {
+    char* base;
+    size_t size_;
+    size_t mapped;
+
+    SourceFile(const SourceFile&);
+    SourceFile& operator=(const SourceFile&);
+public:
+    SourceFile() : base(NULL), size_(0), mapped(0) {}
+
+    ~SourceFile() {
+        close();
+    }
+
+    // false if the path is not a regular file that can be mapped, the
+    // caller then falls back to stdio
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return false;
+        }
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        size_t len = ((size_t)st.st_size + 2 + page - 1) / page * page;
+        // reserve zeroed memory for the file plus terminator, then put the
+        // file over its start; the tail of the last page reads as zero
+        void* p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        if (st.st_size > 0
+            && mmap(p, (size_t)st.st_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(p, len);
+            ::close(fd);
+            return false;
+        }
+        ::close(fd);
+        madvise(p, len, MADV_SEQUENTIAL);
+        base = (char*)p;
+        size_ = (size_t)st.st_size;
+        mapped = len;
+        return true;
+    }
+
+    void close() {
+        if (base)
+            munmap(base, mapped);
+        base = NULL;
+        size_ = mapped = 0;
+    }
+
+    // writable: flex NUL-terminates the current token in place while its
+    // action runs and restores the byte afterwards
+    char* data() const {
+        return base;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+};
+
+#endif
@@ -0,0 +1,1468 @@
+// SSA form of a procedure's bytecode, for the optimizer in optimize.h, and
+// the way back to bytecode. The form is built from the bytecode rather
+// than the tree: it already has slots resolved, REAL conversions explicit
+// and every expression in three-address form.
+//
+// Registers become values, except those that must stay where they are:
+// variables nested procedures reach through the static link (and the
+// main program's, which procedures read as globals) and a FOR loop's
+// counter, bound and step. Those are pins, read and written by S_GET and
+// S_SET. Going back, values get registers again by linear scan, with the
+// arguments of calls, records and arrays in consecutive registers.
+#ifndef SSA_H
+#define SSA_H
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bytecode.h"
+
+// opcodes past the bytecode's; OP_REAL and OP_READ are not in place here,
+// they take a value and make a new one
+enum SsaOp {
+    S_PHI = OP_COUNT,   // one argument per predecessor, in their order
+    S_ENTRY,            // parameter c as passed in
+    S_GET,              // pin c
+    S_SET               // pin c = the argument
+};
+
+struct SsaInsn {
+    unsigned op;
+    unsigned block;
+    unsigned b, c;                 // operands that are not values
+    std::vector<unsigned> args;    // values used
+    bool removed;
+};
+
+struct SsaBlock {
+    std::vector<unsigned> phis;
+    std::vector<unsigned> insns;
+    std::vector<unsigned> preds;   // phi arguments are in this order
+    std::vector<unsigned> succs;   // JMP: the target; branches: fall through, taken
+    unsigned term;                 // JMP, JT, JF, FORPREP, FORLOOP, RET or RETNIL
+    unsigned cond;                 // tested by JT and JF, returned by RET
+    unsigned pin;                  // FORPREP, FORLOOP: the first of the loop's pins
+    bool removed;
+};
+
+// a register kept in SSA form: a variable reached from elsewhere, or one
+// of a FOR's three
+struct Pin {
+    unsigned reg;                  // ~0u for a FOR's, it gets one when lowered
+    unsigned first;                // the first of a FOR's three
+};
+
+class SsaProc {
+public:
+    enum { none = ~0u };
+
+    Module* m;
+    unsigned index;
+    std::vector<SsaInsn> insns;    // a value is the index of its instruction
+    std::vector<SsaBlock> blocks;  // block 0 is the entry
+    std::vector<Pin> pins;
+    std::vector<unsigned> layout;  // block order in the bytecode
+    std::vector<unsigned> idom;    // after dominators()
+    std::vector<unsigned> rpo;
+
+private:
+    std::vector<unsigned> alias;   // replaced values
+    std::vector<unsigned> pre, post;  // dominator tree numbering
+
+    // construction
+    struct ForLoop {
+        unsigned prep, loop, base, pin, parent;
+    };
+    unsigned entry, length;
+    std::vector<unsigned> fixed_pin;   // per register
+    std::vector<ForLoop> fors;
+    std::vector<unsigned> for_of;      // per position, the innermost FOR around it
+    std::vector<unsigned> cur;         // per register, its value while renaming
+    std::vector<unsigned> initial_of;  // per register, its value on entry
+    std::vector<std::pair<unsigned, unsigned> > undo;
+    unsigned nil;
+
+    // lowering
+    struct LInsn {
+        unsigned op;
+        unsigned dst;
+        std::vector<unsigned> src;
+        unsigned b, c;
+        unsigned target;               // block, for branches
+    };
+    struct VReg {
+        unsigned reg;
+        unsigned group;
+        unsigned hint;
+        unsigned precolor;
+        unsigned fixed;
+        unsigned start, end;
+    };
+    std::vector<VReg> vregs;
+    std::vector<std::vector<unsigned> > groups;
+    std::vector<unsigned> value_vreg, pin_vreg;
+    std::vector<LInsn> lcode;
+    std::vector<unsigned> lstart;      // per block, its first lowered instruction
+    std::vector<unsigned> position;    // of an instruction in its block
+    std::vector<unsigned> touched, touch_at;  // per pin, by the block being coalesced
+    std::vector<unsigned> last_use, block_uses, use_stamp;  // per value, in it
+    unsigned stamp;
+    unsigned first_split;              // blocks from here hold an edge's copies
+
+    SsaProc(const SsaProc&);
+    SsaProc& operator=(const SsaProc&);
+
+public:
+    SsaProc() : m(NULL), index(0), entry(0), length(0), nil(none), stamp(0), first_split(0) {}
+
+    unsigned value(unsigned v) {
+        while (alias[v] != v) {
+            alias[v] = alias[alias[v]];
+            v = alias[v];
+        }
+        return v;
+    }
+
+    // uses of v now see with; v's instruction goes
+    void replace(unsigned v, unsigned with) {
+        alias[v] = with;
+        insns[v].removed = true;
+    }
+
+    unsigned add(unsigned op, unsigned block, unsigned b = 0, unsigned c = 0) {
+        SsaInsn in;
+        in.op = op;
+        in.block = block;
+        in.b = b;
+        in.c = c;
+        in.removed = false;
+        insns.push_back(in);
+        alias.push_back((unsigned)alias.size());
+        return (unsigned)insns.size() - 1;
+    }
+
+    unsigned add_block() {
+        SsaBlock b;
+        b.term = OP_JMP;
+        b.cond = none;
+        b.pin = none;
+        b.removed = false;
+        blocks.push_back(b);
+        return (unsigned)blocks.size() - 1;
+    }
+
+    static bool defines(unsigned op) {
+        switch (op) {
+        case OP_SETG: case OP_SETO: case OP_SETINDEX: case OP_SETFIELD:
+        case OP_WRITE: case OP_WRITES: case OP_WRITELN: case S_SET:
+            return false;
+        default:
+            return true;
+        }
+    }
+
+    // drops the edge from block from to s: its predecessor entry and the
+    // phi arguments for it
+    void drop_pred(unsigned s, unsigned from) {
+        SsaBlock& b = blocks[s];
+        for (size_t k = b.preds.size(); k > 0; --k) {
+            if (b.preds[k-1] == from) {
+                b.preds.erase(b.preds.begin() + (k - 1));
+                for (size_t i = 0; i < b.phis.size(); ++i)
+                    insns[b.phis[i]].args.erase(insns[b.phis[i]].args.begin() + (k - 1));
+                return;
+            }
+        }
+    }
+
+    // blocks not reachable from the entry go, with their instructions;
+    // returns how many instructions that was
+    unsigned remove_unreachable() {
+        std::vector<bool> seen(blocks.size(), false);
+        std::vector<unsigned> stack(1, 0);
+        seen[0] = true;
+        while (!stack.empty()) {
+            unsigned b = stack.back();
+            stack.pop_back();
+            for (size_t i = 0; i < blocks[b].succs.size(); ++i) {
+                unsigned s = blocks[b].succs[i];
+                if (!seen[s]) {
+                    seen[s] = true;
+                    stack.push_back(s);
+                }
+            }
+        }
+        unsigned removed = 0;
+        for (unsigned b = 0; b < blocks.size(); ++b) {
+            if (seen[b] || blocks[b].removed)
+                continue;
+            for (size_t i = 0; i < blocks[b].succs.size(); ++i)
+                if (seen[blocks[b].succs[i]])
+                    drop_pred(blocks[b].succs[i], b);
+            removed += count(b) + 1;
+            blocks[b].removed = true;
+            for (size_t i = 0; i < blocks[b].phis.size(); ++i)
+                insns[blocks[b].phis[i]].removed = true;
+            for (size_t i = 0; i < blocks[b].insns.size(); ++i)
+                insns[blocks[b].insns[i]].removed = true;
+        }
+        return removed;
+    }
+
+    // live instructions of block b, its terminator not counted
+    unsigned count(unsigned b) const {
+        unsigned n = 0;
+        for (size_t i = 0; i < blocks[b].phis.size(); ++i)
+            n += !insns[blocks[b].phis[i]].removed;
+        for (size_t i = 0; i < blocks[b].insns.size(); ++i)
+            n += !insns[blocks[b].insns[i]].removed;
+        return n;
+    }
+
+    // live instructions and terminators
+    unsigned count() const {
+        unsigned n = 0;
+        for (unsigned b = 0; b < blocks.size(); ++b)
+            if (!blocks[b].removed)
+                n += count(b) + 1;
+        return n;
+    }
+
+    // drops removed instructions and blocks from the lists and sends
+    // arguments to the values that replaced them
+    void compact() {
+        std::vector<unsigned> keep;
+        for (unsigned b = 0; b < blocks.size(); ++b) {
+            SsaBlock& blk = blocks[b];
+            if (blk.removed)
+                continue;
+            std::vector<unsigned>* lists[2] = { &blk.phis, &blk.insns };
+            for (int l = 0; l < 2; ++l) {
+                keep.clear();
+                for (size_t i = 0; i < lists[l]->size(); ++i) {
+                    unsigned v = (*lists[l])[i];
+                    if (insns[v].removed)
+                        continue;
+                    for (size_t k = 0; k < insns[v].args.size(); ++k)
+                        insns[v].args[k] = value(insns[v].args[k]);
+                    keep.push_back(v);
+                }
+                lists[l]->swap(keep);
+            }
+            if (blk.cond != none)
+                blk.cond = value(blk.cond);
+        }
+        keep.clear();
+        for (size_t i = 0; i < layout.size(); ++i)
+            if (!blocks[layout[i]].removed)
+                keep.push_back(layout[i]);
+        layout.swap(keep);
+    }
+
+    // ---- dominators ----
+
+    // immediate dominators by Cooper, Harvey and Kennedy's iteration over
+    // reverse postorder, then a numbering of the tree for dominates()
+    void dominators() {
+        unsigned n = (unsigned)blocks.size();
+        rpo.clear();
+        std::vector<unsigned> order(n, none);
+        std::vector<char> state(n, 0);
+        std::vector<std::pair<unsigned, unsigned> > stack;
+        stack.push_back(std::make_pair(0u, 0u));
+        state[0] = 1;
+        while (!stack.empty()) {
+            unsigned b = stack.back().first;
+            unsigned& i = stack.back().second;
+            if (i < blocks[b].succs.size()) {
+                unsigned s = blocks[b].succs[i++];
+                if (!state[s]) {
+                    state[s] = 1;
+                    stack.push_back(std::make_pair(s, 0u));
+                }
+            } else {
+                rpo.push_back(b);
+                stack.pop_back();
+            }
+        }
+        std::reverse(rpo.begin(), rpo.end());
+        for (unsigned i = 0; i < rpo.size(); ++i)
+            order[rpo[i]] = i;
+        idom.assign(n, none);
+        idom[0] = 0;
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t i = 1; i < rpo.size(); ++i) {
+                unsigned b = rpo[i];
+                unsigned d = none;
+                for (size_t k = 0; k < blocks[b].preds.size(); ++k) {
+                    unsigned p = blocks[b].preds[k];
+                    if (idom[p] == none)
+                        continue;
+                    if (d == none) {
+                        d = p;
+                        continue;
+                    }
+                    unsigned x = p, y = d;
+                    while (x != y) {
+                        while (order[x] > order[y])
+                            x = idom[x];
+                        while (order[y] > order[x])
+                            y = idom[y];
+                    }
+                    d = x;
+                }
+                if (d != idom[b]) {
+                    idom[b] = d;
+                    changed = true;
+                }
+            }
+        }
+        // preorder and postorder numbers of the dominator tree
+        std::vector<std::vector<unsigned> > kids(n);
+        for (size_t i = 1; i < rpo.size(); ++i)
+            kids[idom[rpo[i]]].push_back(rpo[i]);
+        pre.assign(n, 0);
+        post.assign(n, 0);
+        unsigned clock = 0;
+        stack.clear();
+        stack.push_back(std::make_pair(0u, 0u));
+        pre[0] = clock++;
+        while (!stack.empty()) {
+            unsigned b = stack.back().first;
+            unsigned& i = stack.back().second;
+            if (i < kids[b].size()) {
+                unsigned k = kids[b][i++];
+                pre[k] = clock++;
+                stack.push_back(std::make_pair(k, 0u));
+            } else {
+                post[b] = clock++;
+                stack.pop_back();
+            }
+        }
+    }
+
+    bool dominates(unsigned a, unsigned b) const {
+        return pre[a] <= pre[b] && post[b] <= post[a];
+    }
+
+    // children in the dominator tree, per block
+    std::vector<std::vector<unsigned> > dominator_tree() const {
+        std::vector<std::vector<unsigned> > kids(blocks.size());
+        for (size_t i = 1; i < rpo.size(); ++i)
+            kids[idom[rpo[i]]].push_back(rpo[i]);
+        return kids;
+    }
+
+    // ---- construction ----
+
+private:
+    unsigned pin_at(unsigned q, unsigned r) const {
+        if (fixed_pin[r] != none)
+            return fixed_pin[r];
+        for (unsigned f = for_of[q]; f != none; f = fors[f].parent)
+            if (r >= fors[f].base && r < fors[f].base + 3)
+                return fors[f].pin + (r - fors[f].base);
+        return none;
+    }
+
+    unsigned initial(unsigned r) {
+        if (initial_of[r] != none)
+            return initial_of[r];
+        if (r < m->procs[index].params) {
+            unsigned v = add(S_ENTRY, 0, 0, r);
+            blocks[0].insns.push_back(v);
+            return initial_of[r] = v;
+        }
+        // locals start as NIL; temporaries are written before they are read
+        if (nil == none) {
+            unsigned k = 0;
+            while (k < m->constants.size() && m->constants[k].tag != V_NIL)
+                ++k;
+            if (k == m->constants.size())
+                m->constants.push_back(nil_value());
+            nil = add(OP_LOADK, 0, k);
+            blocks[0].insns.push_back(nil);
+        }
+        return initial_of[r] = nil;
+    }
+
+    unsigned read(unsigned q, unsigned block, unsigned r) {
+        unsigned pin = pin_at(q, r);
+        if (pin != none) {
+            unsigned v = add(S_GET, block, 0, pin);
+            blocks[block].insns.push_back(v);
+            return v;
+        }
+        if (cur[r] == none)
+            cur[r] = initial(r);
+        return cur[r];
+    }
+
+    void write(unsigned q, unsigned block, unsigned r, unsigned v) {
+        unsigned pin = pin_at(q, r);
+        if (pin != none) {
+            unsigned s = add(S_SET, block, 0, pin);
+            insns[s].args.push_back(v);
+            blocks[block].insns.push_back(s);
+            return;
+        }
+        undo.push_back(std::make_pair(r, cur[r]));
+        cur[r] = v;
+    }
+
+    unsigned emit(unsigned op, unsigned block, unsigned b = 0, unsigned c = 0) {
+        unsigned v = add(op, block, b, c);
+        blocks[block].insns.push_back(v);
+        return v;
+    }
+
+    void translate(unsigned q, unsigned block) {
+        const Insn& in = m->code[entry + q];
+        unsigned v;
+        switch (in.op) {
+        case OP_LOADK:
+            write(q, block, in.a, emit(OP_LOADK, block, in.b));
+            break;
+        case OP_MOVE:
+            write(q, block, in.a, read(q, block, in.b));
+            break;
+        case OP_GETG:
+            write(q, block, in.a, emit(OP_GETG, block, in.b));
+            break;
+        case OP_GETO:
+            write(q, block, in.a, emit(OP_GETO, block, in.b, in.c));
+            break;
+        case OP_SETG:
+            v = read(q, block, in.b);
+            insns[emit(OP_SETG, block, in.a)].args.push_back(v);
+            break;
+        case OP_SETO:
+            v = read(q, block, in.a);
+            insns[emit(OP_SETO, block, in.b, in.c)].args.push_back(v);
+            break;
+        case OP_REAL: case OP_NEG: case OP_POS: case OP_NOT: case OP_TRUTH: case OP_FIELD:
+        case OP_READ: {
+            unsigned from = in.op == OP_REAL || in.op == OP_READ ? in.a : in.b;
+            v = read(q, block, from);
+            unsigned r = emit(in.op, block, in.op == OP_READ ? in.b : 0, in.op == OP_FIELD ? in.c : 0);
+            insns[r].args.push_back(v);
+            write(q, block, in.a, r);
+            break;
+        }
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_RDIV: case OP_DIV: case OP_MOD:
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+        case OP_INDEX: {
+            unsigned x = read(q, block, in.b);
+            unsigned y = read(q, block, in.c);
+            unsigned r = emit(in.op, block);
+            insns[r].args.push_back(x);
+            insns[r].args.push_back(y);
+            write(q, block, in.a, r);
+            break;
+        }
+        case OP_SETINDEX: {
+            unsigned x = read(q, block, in.a);
+            unsigned y = read(q, block, in.b);
+            unsigned z = read(q, block, in.c);
+            unsigned r = emit(OP_SETINDEX, block);
+            insns[r].args.push_back(x);
+            insns[r].args.push_back(y);
+            insns[r].args.push_back(z);
+            break;
+        }
+        case OP_SETFIELD: {
+            unsigned x = read(q, block, in.a);
+            unsigned y = read(q, block, in.c);
+            unsigned r = emit(OP_SETFIELD, block, in.b);
+            insns[r].args.push_back(x);
+            insns[r].args.push_back(y);
+            break;
+        }
+        case OP_RECORD: case OP_ARRAY: case OP_CALL: {
+            unsigned n = in.op == OP_RECORD ? (unsigned)m->records[in.b].fields.size()
+                       : in.op == OP_ARRAY ? m->arrays[in.b].registers
+                       : m->procs[m->calls[in.b].proc].params;
+            std::vector<unsigned> args;
+            for (unsigned i = 0; i < n; ++i)
+                args.push_back(read(q, block, in.c + i));
+            unsigned r = emit(in.op, block, in.b);
+            insns[r].args = args;
+            write(q, block, in.a, r);
+            break;
+        }
+        case OP_WRITE:
+            v = read(q, block, in.a);
+            insns[emit(OP_WRITE, block)].args.push_back(v);
+            break;
+        case OP_WRITES:
+            emit(OP_WRITES, block, in.b);
+            break;
+        case OP_WRITELN:
+            emit(OP_WRITELN, block);
+            break;
+        case OP_JMP: case OP_RETNIL: case OP_FORLOOP:
+            break;
+        case OP_JT: case OP_JF: case OP_RET:
+            blocks[block].cond = read(q, block, in.a);
+            break;
+        case OP_FORPREP: {
+            unsigned f = 0;
+            while (fors[f].prep != q)
+                ++f;
+            for (unsigned i = 0; i < 3; ++i) {
+                v = read(q, block, in.a + i);
+                unsigned s = emit(S_SET, block, 0, fors[f].pin + i);
+                insns[s].args.push_back(v);
+            }
+            blocks[block].pin = fors[f].pin;
+            break;
+        }
+        default:
+            value_error("bad instruction");
+        }
+    }
+
+public:
+    // the SSA form of procedure p of module; fixed marks the registers that
+    // other procedures reach
+    void build(Module& module, unsigned p, const std::vector<bool>& fixed) {
+        m = &module;
+        index = p;
+        const ProcCode& pc = m->procs[p];
+        entry = pc.entry;
+        unsigned end = p + 1 < m->procs.size() ? m->procs[p+1].entry : (unsigned)m->code.size();
+        length = end - entry;
+        unsigned nregs = pc.registers;
+
+        fixed_pin.assign(nregs, none);
+        for (unsigned r = 0; r < nregs && r < fixed.size(); ++r) {
+            if (fixed[r]) {
+                Pin pin = { r, none };
+                fixed_pin[r] = (unsigned)pins.size();
+                pins.push_back(pin);
+            }
+        }
+        // FOR loops, from FORPREP to FORLOOP; inner ones start later
+        for_of.assign(length + 1, none);
+        for (unsigned q = 0; q < length; ++q) {
+            const Insn& in = m->code[entry + q];
+            if (in.op != OP_FORPREP)
+                continue;
+            ForLoop f = { q, in.b - 1 - entry, in.a, (unsigned)pins.size(), for_of[q] };
+            for (unsigned i = 0; i < 3; ++i) {
+                Pin pin = { none, f.pin };
+                pins.push_back(pin);
+            }
+            for (unsigned k = q + 1; k <= f.loop; ++k)
+                for_of[k] = (unsigned)fors.size();
+            fors.push_back(f);
+        }
+
+        // blocks: an empty entry, then one per leader
+        std::vector<unsigned> block_at(length + 1, none);
+        std::vector<bool> leader(length + 1, false);
+        leader[0] = true;
+        for (unsigned q = 0; q < length; ++q) {
+            const Insn& in = m->code[entry + q];
+            bool branch = in.op == OP_JMP || in.op == OP_JT || in.op == OP_JF ||
+                          in.op == OP_FORPREP || in.op == OP_FORLOOP;
+            if (branch)
+                leader[in.b - entry] = true;
+            if (branch || in.op == OP_RET || in.op == OP_RETNIL)
+                leader[q + 1] = true;
+        }
+        add_block();
+        std::vector<unsigned> first, last;
+        for (unsigned q = 0; q < length; ++q) {
+            if (leader[q]) {
+                block_at[q] = add_block();
+                first.push_back(q);
+                if (q)
+                    last.push_back(q);
+            }
+        }
+        last.push_back(length);
+        blocks[0].succs.push_back(1);
+        for (unsigned b = 1; b < blocks.size(); ++b) {
+            const Insn& in = m->code[entry + last[b-1] - 1];
+            SsaBlock& blk = blocks[b];
+            unsigned next = last[b-1] < length ? block_at[last[b-1]] : none;
+            switch (in.op) {
+            case OP_JMP:
+                blk.succs.push_back(block_at[in.b - entry]);
+                break;
+            case OP_JT: case OP_JF: case OP_FORPREP: case OP_FORLOOP:
+                blk.term = in.op;
+                blk.succs.push_back(next);
+                blk.succs.push_back(block_at[in.b - entry]);
+                break;
+            case OP_RET: case OP_RETNIL:
+                blk.term = in.op;
+                break;
+            default:
+                blk.succs.push_back(next);
+            }
+            if (in.op == OP_FORLOOP) {
+                unsigned f = 0;
+                while (fors[f].loop != last[b-1] - 1)
+                    ++f;
+                blk.pin = fors[f].pin;
+            }
+        }
+        for (unsigned b = 0; b < blocks.size(); ++b)
+            for (size_t i = 0; i < blocks[b].succs.size(); ++i)
+                blocks[blocks[b].succs[i]].preds.push_back(b);
+        for (unsigned b = 0; b < blocks.size(); ++b)
+            layout.push_back(b);
+        remove_unreachable();
+        dominators();
+
+        // registers read before written and written, per block
+        size_t words = (nregs + 63) / 64;
+        std::vector<std::vector<unsigned long long> > use(blocks.size()), def(blocks.size()),
+            in(blocks.size());
+        std::vector<std::vector<unsigned> > def_blocks(nregs);
+        std::vector<unsigned> uses, defs;
+        for (unsigned b = 1; b < blocks.size(); ++b) {
+            use[b].assign(words, 0);
+            def[b].assign(words, 0);
+            in[b].assign(words, 0);
+            if (blocks[b].removed)
+                continue;
+            for (unsigned q = first[b-1]; q < last[b-1]; ++q) {
+                m->operands(m->code[entry + q], uses, defs);
+                for (size_t i = 0; i < uses.size(); ++i) {
+                    unsigned r = uses[i];
+                    if (pin_at(q, r) == none && !(def[b][r / 64] >> (r % 64) & 1))
+                        use[b][r / 64] |= 1ull << (r % 64);
+                }
+                for (size_t i = 0; i < defs.size(); ++i) {
+                    unsigned r = defs[i];
+                    if (pin_at(q, r) != none || (def[b][r / 64] >> (r % 64) & 1))
+                        continue;
+                    def[b][r / 64] |= 1ull << (r % 64);
+                    def_blocks[r].push_back(b);
+                }
+            }
+        }
+        use[0].assign(words, 0);
+        def[0].assign(words, 0);
+        in[0].assign(words, 0);
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t i = rpo.size(); i > 0; --i) {
+                unsigned b = rpo[i-1];
+                for (size_t w = 0; w < words; ++w) {
+                    unsigned long long out = 0;
+                    for (size_t s = 0; s < blocks[b].succs.size(); ++s)
+                        out |= in[blocks[b].succs[s]][w];
+                    unsigned long long x = use[b][w] | (out & ~def[b][w]);
+                    if (x != in[b][w]) {
+                        in[b][w] = x;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // phis at the iterated dominance frontier of each register's
+        // definitions, where it is live
+        std::vector<std::vector<unsigned> > frontier(blocks.size());
+        for (size_t i = 0; i < rpo.size(); ++i) {
+            unsigned b = rpo[i];
+            if (blocks[b].preds.size() < 2)
+                continue;
+            for (size_t k = 0; k < blocks[b].preds.size(); ++k) {
+                unsigned runner = blocks[b].preds[k];
+                while (runner != idom[b]) {
+                    if (frontier[runner].empty() || frontier[runner].back() != b)
+                        frontier[runner].push_back(b);
+                    runner = idom[runner];
+                }
+            }
+        }
+        std::vector<unsigned> placed(blocks.size(), none), queued(blocks.size(), none);
+        std::vector<unsigned> work;
+        for (unsigned r = 0; r < nregs; ++r) {
+            if (def_blocks[r].empty())
+                continue;
+            work = def_blocks[r];
+            work.push_back(0);
+            for (size_t i = 0; i < work.size(); ++i)
+                queued[work[i]] = r;
+            while (!work.empty()) {
+                unsigned b = work.back();
+                work.pop_back();
+                for (size_t i = 0; i < frontier[b].size(); ++i) {
+                    unsigned f = frontier[b][i];
+                    if (placed[f] == r || !(in[f][r / 64] >> (r % 64) & 1))
+                        continue;
+                    placed[f] = r;
+                    unsigned phi = add(S_PHI, f, r);
+                    insns[phi].args.assign(blocks[f].preds.size(), none);
+                    blocks[f].phis.push_back(phi);
+                    if (queued[f] != r) {
+                        queued[f] = r;
+                        work.push_back(f);
+                    }
+                }
+            }
+        }
+
+        // renaming, down the dominator tree
+        std::vector<std::vector<unsigned> > kids = dominator_tree();
+        cur.assign(nregs, none);
+        initial_of.assign(nregs, none);
+        std::vector<std::pair<unsigned, size_t> > stack;
+        stack.push_back(std::make_pair(0u, (size_t)0));
+        std::vector<size_t> marks;
+        marks.push_back(undo.size());
+        std::vector<bool> done_block(blocks.size(), false);
+        while (!stack.empty()) {
+            unsigned b = stack.back().first;
+            if (!done_block[b]) {
+                done_block[b] = true;
+                for (size_t i = 0; i < blocks[b].phis.size(); ++i) {
+                    unsigned phi = blocks[b].phis[i];
+                    undo.push_back(std::make_pair(insns[phi].b, cur[insns[phi].b]));
+                    cur[insns[phi].b] = phi;
+                }
+                if (b)
+                    for (unsigned q = first[b-1]; q < last[b-1]; ++q)
+                        translate(q, b);
+                for (size_t s = 0; s < blocks[b].succs.size(); ++s) {
+                    unsigned succ = blocks[b].succs[s];
+                    if (s && succ == blocks[b].succs[0])
+                        continue;
+                    const SsaBlock& sb = blocks[succ];
+                    for (size_t k = 0; k < sb.preds.size(); ++k) {
+                        if (sb.preds[k] != b)
+                            continue;
+                        for (size_t i = 0; i < sb.phis.size(); ++i) {
+                            unsigned r = insns[sb.phis[i]].b;
+                            if (cur[r] == none)
+                                cur[r] = initial(r);
+                            insns[sb.phis[i]].args[k] = cur[r];
+                        }
+                    }
+                }
+            }
+            size_t& next = stack.back().second;
+            if (next < kids[b].size()) {
+                unsigned k = kids[b][next++];
+                marks.push_back(undo.size());
+                stack.push_back(std::make_pair(k, (size_t)0));
+            } else {
+                while (undo.size() > marks.back()) {
+                    cur[undo.back().first] = undo.back().second;
+                    undo.pop_back();
+                }
+                marks.pop_back();
+                stack.pop_back();
+            }
+        }
+        for (size_t i = 0; i < blocks.size(); ++i)
+            for (size_t k = 0; k < blocks[i].phis.size(); ++k)
+                insns[blocks[i].phis[k]].b = 0;
+    }
+
+    // ---- back to bytecode ----
+
+private:
+    unsigned new_vreg() {
+        VReg v = { none, none, none, none, none, none, 0 };
+        vregs.push_back(v);
+        return (unsigned)vregs.size() - 1;
+    }
+
+    unsigned vreg_of(unsigned v) {
+        if (value_vreg[v] == none)
+            value_vreg[v] = new_vreg();
+        return value_vreg[v];
+    }
+
+    void put(unsigned op, unsigned dst, unsigned b = 0, unsigned c = 0) {
+        LInsn l;
+        l.op = op;
+        l.dst = dst;
+        l.b = b;
+        l.c = c;
+        l.target = none;
+        lcode.push_back(l);
+    }
+
+    void move(unsigned dst, unsigned src) {
+        if (dst == src)
+            return;
+        put(OP_MOVE, dst);
+        lcode.back().src.push_back(src);
+        if (vregs[dst].hint == none)
+            vregs[dst].hint = src;
+        if (vregs[src].hint == none)
+            vregs[src].hint = dst;
+    }
+
+    void jump(unsigned op, unsigned target, unsigned src = none) {
+        put(op, none);
+        lcode.back().target = target;
+        if (src != none)
+            lcode.back().src.push_back(src);
+    }
+
+    // whether the phi copies for the edge from p to s can go before p's
+    // branch, on the way to its other successor o too: nothing there may
+    // read what they overwrite
+    bool copies_early(unsigned p, unsigned s, unsigned o) const {
+        if (dominates(s, o))
+            return false;
+        unsigned cond = blocks[p].cond;
+        if (cond != none && insns[cond].op == S_PHI && insns[cond].block == s)
+            return false;
+        const SsaBlock& other = blocks[o];
+        size_t k = std::find(other.preds.begin(), other.preds.end(), p) - other.preds.begin();
+        for (size_t i = 0; i < other.phis.size(); ++i) {
+            unsigned a = insns[other.phis[i]].args[k];
+            if (insns[a].op == S_PHI && insns[a].block == s)
+                return false;
+        }
+        return true;
+    }
+
+    // a block of its own for the copies on an edge from a branch into a
+    // block with phis, unless they can go before the branch; one on the
+    // fall-through edge goes straight after the branch
+    void split_critical_edges(std::vector<unsigned>& early) {
+        unsigned n = (unsigned)blocks.size();
+        first_split = n;
+        std::vector<std::vector<unsigned> > after(n);
+        std::vector<unsigned> at_end;
+        for (unsigned p = 0; p < n; ++p) {
+            if (blocks[p].removed || blocks[p].succs.size() < 2)
+                continue;
+            for (unsigned i = 2; i > 0; --i) {
+                unsigned s = blocks[p].succs[i-1];
+                unsigned o = blocks[p].succs[2-i];
+                if (blocks[s].phis.empty())
+                    continue;
+                if (early[p] == none && s != o && copies_early(p, s, o)) {
+                    early[p] = s;
+                    continue;
+                }
+                unsigned e = add_block();
+                blocks[e].succs.push_back(s);
+                blocks[e].preds.push_back(p);
+                blocks[p].succs[i-1] = e;
+                *std::find(blocks[s].preds.begin(), blocks[s].preds.end(), p) = e;
+                if (i == 1)
+                    after[p].push_back(e);
+                else
+                    at_end.push_back(e);
+            }
+        }
+        std::vector<unsigned> order;
+        for (size_t l = 0; l < layout.size(); ++l) {
+            order.push_back(layout[l]);
+            order.insert(order.end(), after[layout[l]].begin(), after[layout[l]].end());
+        }
+        order.insert(order.end(), at_end.begin(), at_end.end());
+        layout.swap(order);
+        early.resize(blocks.size(), none);
+    }
+
+    // copies that happen at once, in an order that reads each source
+    // before it is overwritten
+    void parallel_copy(std::vector<std::pair<unsigned, unsigned> >& copies) {
+        for (size_t i = 0; i < copies.size(); ) {
+            if (copies[i].first == copies[i].second)
+                copies.erase(copies.begin() + i);
+            else
+                ++i;
+        }
+        while (!copies.empty()) {
+            bool progress = false;
+            for (size_t i = 0; i < copies.size(); ++i) {
+                bool read_later = false;
+                for (size_t j = 0; j < copies.size() && !read_later; ++j)
+                    read_later = j != i && copies[j].second == copies[i].first;
+                if (!read_later) {
+                    move(copies[i].first, copies[i].second);
+                    copies.erase(copies.begin() + i);
+                    progress = true;
+                    break;
+                }
+            }
+            if (!progress) {
+                // a cycle: save one destination first
+                unsigned t = new_vreg();
+                unsigned d = copies[0].first;
+                move(t, d);
+                for (size_t j = 0; j < copies.size(); ++j)
+                    if (copies[j].second == d)
+                        copies[j].second = t;
+            }
+        }
+    }
+
+    // nothing touched the pin after position since in the block being
+    // coalesced; a call may change a variable nested procedures reach
+    bool quiet(unsigned pin, unsigned since, unsigned last_call) const {
+        if (touched[pin] == stamp && touch_at[pin] > since)
+            return false;
+        return pins[pin].reg == none || last_call == none || last_call < since;
+    }
+
+    void read_pin(unsigned a, unsigned b, const std::vector<unsigned>& uses, unsigned last_call) {
+        const SsaInsn& def = insns[a];
+        if (def.op == S_GET && def.block == b && uses[a] == 1 && value_vreg[a] == none &&
+            quiet(def.c, position[a], last_call))
+            value_vreg[a] = pin_vreg[def.c];
+    }
+
+    // values that can be computed straight into the register they end up
+    // in: a pin they are stored to, an argument's place; and pins read
+    // once before they change, which need no copy
+    void coalesce(unsigned b, const std::vector<unsigned>& uses, std::vector<unsigned>& arg_group) {
+        const SsaBlock& blk = blocks[b];
+        ++stamp;
+        unsigned last_call = none;
+        for (size_t i = 0; i < blk.insns.size(); ++i) {
+            unsigned v = blk.insns[i];
+            const SsaInsn& in = insns[v];
+            position[v] = (unsigned)i;
+            for (size_t k = 0; k < in.args.size(); ++k)
+                read_pin(in.args[k], b, uses, last_call);
+            if (in.op == OP_CALL || in.op == OP_RECORD || in.op == OP_ARRAY) {
+                std::vector<unsigned> members;
+                for (size_t k = 0; k < in.args.size(); ++k) {
+                    members.push_back(new_vreg());
+                    vregs[members.back()].group = (unsigned)groups.size();
+                }
+                arg_group[v] = (unsigned)groups.size();
+                groups.push_back(members);
+            }
+            if (in.op == S_SET || arg_group[v] != none) {
+                for (size_t k = 0; k < in.args.size(); ++k) {
+                    unsigned a = in.args[k];
+                    const SsaInsn& def = insns[a];
+                    if (def.block != b || uses[a] != 1 || value_vreg[a] != none ||
+                        def.op == S_PHI || def.op == S_ENTRY || def.op == S_GET)
+                        continue;
+                    if (in.op == S_SET && !quiet(in.c, position[a], last_call))
+                        continue;
+                    value_vreg[a] = in.op == S_SET ? pin_vreg[in.c] : groups[arg_group[v]][k];
+                }
+            }
+            if (in.op == S_GET || in.op == S_SET) {
+                touched[in.c] = stamp;
+                touch_at[in.c] = (unsigned)i;
+            }
+            if (in.op == OP_CALL)
+                last_call = (unsigned)i;
+        }
+        if (blk.cond != none)
+            read_pin(blk.cond, b, uses, last_call);
+    }
+
+    void count_use(unsigned v, unsigned at) {
+        if (use_stamp[v] != stamp) {
+            use_stamp[v] = stamp;
+            block_uses[v] = 0;
+        }
+        last_use[v] = at;
+        ++block_uses[v];
+    }
+
+    unsigned uses_here(unsigned v) const {
+        return use_stamp[v] == stamp ? block_uses[v] : 0;
+    }
+
+    // a phi and the value that reaches it from b share a register when the
+    // phi is dead by the time the value is made and the value is not used
+    // past b but by the copies: then there is nothing to copy
+    void coalesce_phis(unsigned b, const std::vector<unsigned>& uses, const std::vector<unsigned>& early) {
+        const SsaBlock& blk = blocks[b];
+        unsigned h = blk.succs.size() == 1 ? blk.succs[0] : early[b];
+        if (h == none || blocks[h].phis.empty() || blk.insns.empty())
+            return;
+        ++stamp;
+        for (size_t i = 0; i < blk.insns.size(); ++i) {
+            const SsaInsn& in = insns[blk.insns[i]];
+            for (size_t k = 0; k < in.args.size(); ++k)
+                count_use(in.args[k], (unsigned)i);
+        }
+        if (blk.cond != none)
+            count_use(blk.cond, (unsigned)blk.insns.size());
+        // what the copies on the edges out of b read, and whether a
+        // successor past an edge's own block could still see a phi of h
+        std::vector<unsigned> edge_args;
+        bool others_clear = true;
+        for (size_t i = 0; i < blk.succs.size(); ++i) {
+            unsigned target = blk.succs[i], from = b;
+            if (target >= first_split) {
+                from = target;
+                target = blocks[target].succs[0];
+            }
+            if (target != h && dominates(h, target))
+                others_clear = false;
+            if (i && blk.succs[i] == blk.succs[0])
+                continue;
+            const SsaBlock& t = blocks[target];
+            size_t j = std::find(t.preds.begin(), t.preds.end(), from) - t.preds.begin();
+            for (size_t q = 0; q < t.phis.size(); ++q)
+                edge_args.push_back(insns[t.phis[q]].args[j]);
+        }
+        if (!others_clear)
+            return;
+        const SsaBlock& hb = blocks[h];
+        size_t k = std::find(hb.preds.begin(), hb.preds.end(), b) - hb.preds.begin();
+        for (size_t i = 0; i < hb.phis.size(); ++i) {
+            unsigned p = hb.phis[i];
+            unsigned a = insns[p].args[k];
+            const SsaInsn& def = insns[a];
+            if (def.block != b || value_vreg[a] != none ||
+                def.op == S_PHI || def.op == S_GET || def.op == S_ENTRY)
+                continue;
+            if (uses_here(p) && last_use[p] > position[a])
+                continue;
+            unsigned copies = 0;
+            bool reads_p = false;
+            for (size_t e = 0; e < edge_args.size(); ++e) {
+                copies += edge_args[e] == a;
+                reads_p = reads_p || edge_args[e] == p;
+            }
+            if (reads_p || uses_here(a) + copies != uses[a])
+                continue;
+            value_vreg[a] = vreg_of(p);
+        }
+    }
+
+public:
+    // the bytecode for this procedure, appended to code; sets pc's entry
+    // and register count
+    void lower(std::vector<Insn>& code, ProcCode& pc) {
+        compact();
+        dominators();
+        std::vector<unsigned> early(blocks.size(), none);
+        split_critical_edges(early);
+
+        vregs.clear();
+        groups.clear();
+        lcode.clear();
+        value_vreg.assign(insns.size(), none);
+        pin_vreg.assign(pins.size(), none);
+        for (unsigned p = 0; p < pins.size(); ++p) {
+            if (pins[p].reg != none) {
+                pin_vreg[p] = new_vreg();
+                vregs[pin_vreg[p]].fixed = pins[p].reg;
+            } else if (pins[p].first == p) {
+                std::vector<unsigned> members;
+                for (unsigned i = 0; i < 3; ++i) {
+                    pin_vreg[p + i] = new_vreg();
+                    vregs[pin_vreg[p + i]].group = (unsigned)groups.size();
+                    members.push_back(pin_vreg[p + i]);
+                }
+                groups.push_back(members);
+            }
+        }
+        std::vector<unsigned> uses(insns.size(), 0);
+        for (size_t l = 0; l < layout.size(); ++l) {
+            const SsaBlock& blk = blocks[layout[l]];
+            for (size_t i = 0; i < blk.phis.size(); ++i)
+                for (size_t k = 0; k < insns[blk.phis[i]].args.size(); ++k)
+                    ++uses[insns[blk.phis[i]].args[k]];
+            for (size_t i = 0; i < blk.insns.size(); ++i)
+                for (size_t k = 0; k < insns[blk.insns[i]].args.size(); ++k)
+                    ++uses[insns[blk.insns[i]].args[k]];
+            if (blk.cond != none)
+                ++uses[blk.cond];
+        }
+        std::vector<unsigned> arg_group(insns.size(), none);
+        position.assign(insns.size(), 0);
+        touched.assign(pins.size(), 0);
+        touch_at.assign(pins.size(), 0);
+        stamp = 0;
+        for (size_t l = 0; l < layout.size(); ++l)
+            coalesce(layout[l], uses, arg_group);
+        last_use.assign(insns.size(), 0);
+        block_uses.assign(insns.size(), 0);
+        use_stamp.assign(insns.size(), 0);
+        for (size_t l = 0; l < layout.size(); ++l)
+            coalesce_phis(layout[l], uses, early);
+
+        // lowered instructions, block by block
+        lstart.assign(blocks.size(), none);
+        std::vector<unsigned> lend(blocks.size(), none);
+        for (size_t l = 0; l < layout.size(); ++l) {
+            unsigned b = layout[l];
+            const SsaBlock& blk = blocks[b];
+            lstart[b] = (unsigned)lcode.size();
+            for (size_t i = 0; i < blk.insns.size(); ++i) {
+                unsigned v = blk.insns[i];
+                const SsaInsn& in = insns[v];
+                std::vector<unsigned> src;
+                for (size_t k = 0; k < in.args.size(); ++k)
+                    src.push_back(vreg_of(in.args[k]));
+                switch (in.op) {
+                case S_ENTRY:
+                    vregs[vreg_of(v)].precolor = in.c;
+                    break;
+                case S_GET:
+                    move(vreg_of(v), pin_vreg[in.c]);
+                    break;
+                case S_SET:
+                    move(pin_vreg[in.c], src[0]);
+                    break;
+                case OP_REAL: case OP_READ:
+                    // in place in the bytecode
+                    move(vreg_of(v), src[0]);
+                    put(in.op, vreg_of(v), in.b);
+                    lcode.back().src.push_back(vreg_of(v));
+                    break;
+                case OP_CALL: case OP_RECORD: case OP_ARRAY: {
+                    const std::vector<unsigned>& members = groups[arg_group[v]];
+                    for (size_t k = 0; k < src.size(); ++k)
+                        move(members[k], src[k]);
+                    put(in.op, vreg_of(v), in.b);
+                    lcode.back().src = members;
+                    lcode.back().c = arg_group[v];
+                    break;
+                }
+                default:
+                    put(in.op, defines(in.op) ? vreg_of(v) : none, in.b, in.c);
+                    lcode.back().src = src;
+                }
+            }
+            // phi copies go at the end of the one predecessor
+            unsigned to = blk.succs.size() == 1 ? blk.succs[0] : early[b];
+            if (to != none && !blocks[to].phis.empty()) {
+                const SsaBlock& s = blocks[to];
+                size_t k = std::find(s.preds.begin(), s.preds.end(), b) - s.preds.begin();
+                std::vector<std::pair<unsigned, unsigned> > copies;
+                for (size_t i = 0; i < s.phis.size(); ++i)
+                    copies.push_back(std::make_pair(vreg_of(s.phis[i]),
+                                                    vreg_of(insns[s.phis[i]].args[k])));
+                parallel_copy(copies);
+            }
+            switch (blk.term) {
+            case OP_JMP:
+                jump(OP_JMP, blk.succs[0]);
+                break;
+            case OP_JT: case OP_JF:
+                jump(blk.term, blk.succs[1], vreg_of(blk.cond));
+                jump(OP_JMP, blk.succs[0]);
+                break;
+            case OP_FORPREP: case OP_FORLOOP: {
+                const std::vector<unsigned>& g = groups[vregs[pin_vreg[blk.pin]].group];
+                jump(blk.term, blk.succs[1]);
+                lcode.back().src = g;
+                if (blk.term == OP_FORLOOP)
+                    lcode.back().dst = g[0];
+                jump(OP_JMP, blk.succs[0]);
+                break;
+            }
+            case OP_RET:
+                put(OP_RET, none);
+                lcode.back().src.push_back(vreg_of(blk.cond));
+                break;
+            default:
+                put(OP_RETNIL, none);
+            }
+            lend[b] = (unsigned)lcode.size();
+        }
+
+        allocate(lend, pc);
+
+        // the bytecode
+        pc.entry = (unsigned)code.size();
+        std::vector<unsigned> start(blocks.size(), none);
+        std::vector<std::pair<unsigned, unsigned> > fixups;
+        for (size_t l = 0; l < layout.size(); ++l) {
+            unsigned b = layout[l];
+            unsigned next = l + 1 < layout.size() ? layout[l + 1] : none;
+            start[b] = (unsigned)code.size();
+            for (unsigned i = lstart[b]; i < lend[b]; ++i) {
+                const LInsn& li = lcode[i];
+                Insn out;
+                out.op = li.op;
+                out.a = 0;
+                out.b = li.b;
+                out.c = li.c;
+                unsigned d = li.dst != none ? vregs[li.dst].reg : 0;
+                unsigned s0 = li.src.size() > 0 ? vregs[li.src[0]].reg : 0;
+                unsigned s1 = li.src.size() > 1 ? vregs[li.src[1]].reg : 0;
+                switch (li.op) {
+                case OP_MOVE:
+                    if (d == s0)
+                        continue;
+                    out.a = d;
+                    out.b = s0;
+                    break;
+                case OP_JMP:
+                    if (li.target == next)
+                        continue;
+                    break;
+                case OP_JT: case OP_JF:
+                    // branch on the opposite when the target is next
+                    if (li.target == next && i + 1 < lend[b] && lcode[i + 1].target != next) {
+                        out.op = li.op == OP_JT ? OP_JF : OP_JT;
+                        out.a = s0;
+                        fixups.push_back(std::make_pair((unsigned)code.size(), lcode[i + 1].target));
+                        code.push_back(out);
+                        ++i;
+                        continue;
+                    }
+                    out.a = s0;
+                    break;
+                case OP_LOADK: case OP_GETG: case OP_GETO:
+                    out.a = d;
+                    break;
+                case OP_SETG:
+                    out.a = li.b;
+                    out.b = s0;
+                    break;
+                case OP_SETO: case OP_WRITE: case OP_RET: case OP_FORPREP: case OP_FORLOOP:
+                    out.a = s0;
+                    break;
+                case OP_REAL: case OP_READ:
+                    out.a = d;
+                    break;
+                case OP_NEG: case OP_POS: case OP_NOT: case OP_TRUTH:
+                    out.a = d;
+                    out.b = s0;
+                    break;
+                case OP_FIELD:
+                    out.a = d;
+                    out.b = s0;
+                    out.c = li.c;
+                    break;
+                case OP_SETFIELD:
+                    out.a = s0;
+                    out.c = s1;
+                    break;
+                case OP_SETINDEX:
+                    out.a = s0;
+                    out.b = s1;
+                    out.c = vregs[li.src[2]].reg;
+                    break;
+                case OP_RECORD: case OP_ARRAY: case OP_CALL:
+                    out.a = d;
+                    out.c = li.src.empty() ? 0 : s0;
+                    break;
+                case OP_WRITES: case OP_WRITELN: case OP_RETNIL:
+                    break;
+                default:
+                    out.a = d;
+                    out.b = s0;
+                    out.c = s1;
+                }
+                if (li.target != none)
+                    fixups.push_back(std::make_pair((unsigned)code.size(), li.target));
+                code.push_back(out);
+            }
+        }
+        for (size_t i = 0; i < fixups.size(); ++i)
+            code[fixups[i].first].b = start[fixups[i].second];
+    }
+
+private:
+    // live ranges over the lowered instructions, then linear scan onto as
+    // many registers as it takes
+    void allocate(const std::vector<unsigned>& lend, ProcCode& pc) {
+        unsigned n = (unsigned)vregs.size();
+        unsigned positions = (unsigned)lcode.size();
+        size_t words = (n + 63) / 64;
+        std::vector<std::vector<unsigned long long> > use(blocks.size()), def(blocks.size()),
+            in(blocks.size()), out(blocks.size());
+        for (size_t l = 0; l < layout.size(); ++l) {
+            unsigned b = layout[l];
+            use[b].assign(words, 0);
+            def[b].assign(words, 0);
+            in[b].assign(words, 0);
+            out[b].assign(words, 0);
+            for (unsigned i = lstart[b]; i < lend[b]; ++i) {
+                const LInsn& li = lcode[i];
+                for (size_t k = 0; k < li.src.size(); ++k) {
+                    unsigned v = li.src[k];
+                    if (!(def[b][v / 64] >> (v % 64) & 1))
+                        use[b][v / 64] |= 1ull << (v % 64);
+                }
+                if (li.dst != none)
+                    def[b][li.dst / 64] |= 1ull << (li.dst % 64);
+            }
+        }
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t l = layout.size(); l > 0; --l) {
+                unsigned b = layout[l-1];
+                for (size_t w = 0; w < words; ++w) {
+                    unsigned long long o = 0;
+                    for (size_t s = 0; s < blocks[b].succs.size(); ++s)
+                        o |= in[blocks[b].succs[s]][w];
+                    unsigned long long x = use[b][w] | (o & ~def[b][w]);
+                    if (o != out[b][w] || x != in[b][w]) {
+                        out[b][w] = o;
+                        in[b][w] = x;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        for (unsigned v = 0; v < n; ++v) {
+            vregs[v].start = none;
+            vregs[v].end = 0;
+        }
+        for (size_t l = 0; l < layout.size(); ++l) {
+            unsigned b = layout[l];
+            if (lstart[b] == lend[b])
+                continue;
+            for (size_t w = 0; w < words; ++w) {
+                for (unsigned long long x = in[b][w] | out[b][w]; x; x &= x - 1) {
+                    unsigned v = (unsigned)(w * 64 + __builtin_ctzll(x));
+                    if (in[b][w] >> (v % 64) & 1) {
+                        vregs[v].start = std::min(vregs[v].start, lstart[b]);
+                        vregs[v].end = std::max(vregs[v].end, lstart[b]);
+                    }
+                    if (out[b][w] >> (v % 64) & 1) {
+                        vregs[v].start = std::min(vregs[v].start, lend[b] - 1);
+                        vregs[v].end = std::max(vregs[v].end, lend[b] - 1);
+                    }
+                }
+            }
+            for (unsigned i = lstart[b]; i < lend[b]; ++i) {
+                const LInsn& li = lcode[i];
+                for (size_t k = 0; k < li.src.size(); ++k) {
+                    VReg& r = vregs[li.src[k]];
+                    r.start = std::min(r.start, i);
+                    r.end = std::max(r.end, i);
+                }
+                if (li.dst != none) {
+                    VReg& r = vregs[li.dst];
+                    r.start = std::min(r.start, i);
+                    r.end = std::max(r.end, i);
+                }
+            }
+        }
+        (void)positions;
+
+        // units: a register, or a group of consecutive ones
+        struct Unit {
+            unsigned start, end, width, first;
+            bool precolored;
+        };
+        std::vector<Unit> units;
+        std::vector<unsigned> group_unit(groups.size(), none);
+        for (unsigned v = 0; v < n; ++v) {
+            VReg& r = vregs[v];
+            if (r.fixed != none) {
+                r.reg = r.fixed;
+                continue;
+            }
+            if (r.precolor != none)
+                r.start = 0;
+            if (r.start == none)
+                continue;
+            if (r.group != none) {
+                unsigned& u = group_unit[r.group];
+                if (u == none) {
+                    Unit unit = { r.start, r.end, (unsigned)groups[r.group].size(), v, false };
+                    u = (unsigned)units.size();
+                    units.push_back(unit);
+                } else {
+                    units[u].start = std::min(units[u].start, r.start);
+                    units[u].end = std::max(units[u].end, r.end);
+                }
+                continue;
+            }
+            Unit unit = { r.start, r.end, 1, v, r.precolor != none };
+            units.push_back(unit);
+        }
+        std::vector<unsigned> order(units.size());
+        for (unsigned i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&units](unsigned a, unsigned b) {
+            if (units[a].start != units[b].start)
+                return units[a].start < units[b].start;
+            return units[a].precolored && !units[b].precolored;
+        });
+
+        std::set<unsigned> free_regs;
+        std::vector<bool> is_fixed(pc.slots, false);
+        for (unsigned p = 0; p < pins.size(); ++p)
+            if (pins[p].reg != none)
+                is_fixed[pins[p].reg] = true;
+        for (unsigned r = 0; r < pc.slots; ++r)
+            if (!is_fixed[r])
+                free_regs.insert(r);
+        unsigned top = pc.slots;
+        std::vector<std::pair<unsigned, unsigned> > active;  // end, unit; a heap
+        std::vector<unsigned> base(units.size(), none);
+        for (size_t k = 0; k < order.size(); ++k) {
+            const Unit& u = units[order[k]];
+            // a register read by the instruction that writes another can be
+            // that register: operands are read first
+            while (!active.empty() && active.front().first <= u.start) {
+                unsigned done = active.front().second;
+                std::pop_heap(active.begin(), active.end(), std::greater<std::pair<unsigned, unsigned> >());
+                active.pop_back();
+                for (unsigned i = 0; i < units[done].width; ++i)
+                    free_regs.insert(base[done] + i);
+            }
+            unsigned r = none;
+            if (u.width == 1) {
+                unsigned want = u.precolored ? vregs[u.first].precolor : none;
+                unsigned hint = vregs[u.first].hint;
+                if (want == none && hint != none && vregs[hint].reg != none)
+                    want = vregs[hint].reg;
+                if (want != none && free_regs.count(want))
+                    r = want;
+                else if (!free_regs.empty())
+                    r = *free_regs.begin();
+                else
+                    r = top++;
+                free_regs.erase(r);
+            } else {
+                // the first run of free registers long enough, among the
+                // first few; past the top otherwise
+                unsigned tried = 0;
+                for (std::set<unsigned>::iterator it = free_regs.begin();
+                     it != free_regs.end() && tried < 64 && r == none; ++it, ++tried) {
+                    unsigned i = 1;
+                    while (i < u.width && (free_regs.count(*it + i) || *it + i >= top))
+                        ++i;
+                    if (i == u.width)
+                        r = *it;
+                }
+                if (r == none)
+                    r = top;
+                for (unsigned i = 0; i < u.width; ++i) {
+                    if (r + i >= top)
+                        top = r + i + 1;
+                    free_regs.erase(r + i);
+                }
+            }
+            base[order[k]] = r;
+            if (u.width == 1) {
+                vregs[u.first].reg = r;
+            } else {
+                const std::vector<unsigned>& g = groups[vregs[u.first].group];
+                for (unsigned i = 0; i < g.size(); ++i)
+                    vregs[g[i]].reg = r + i;
+            }
+            active.push_back(std::make_pair(u.end, order[k]));
+            std::push_heap(active.begin(), active.end(), std::greater<std::pair<unsigned, unsigned> >());
+        }
+        if (top >= (1u << 24))
+            value_error("too many registers");
+        pc.registers = top;
+        // vregs that are never live still need a register to name
+        for (unsigned v = 0; v < n; ++v)
+            if (vregs[v].reg == none)
+                vregs[v].reg = 0;
+    }
+};
+
+#endif
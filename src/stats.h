@@ -0,0 +1,189 @@
+// --stats: where the time of one compile goes, phase by phase, and how much
+// it makes: tokens, nodes of each syntax tree class, bytes held and peak
+// RSS. Printed as a table for people, or as JSON for tools that track the
+// numbers from one version of the compiler to the next.
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include "flat.h"
+
+struct CompileStats {
+    struct Phase {
+        const char* name;
+        double seconds;
+    };
+
+    std::string file;
+    size_t input_bytes;
+    std::vector<Phase> phases;      // in the order they first ran
+    unsigned long long tokens;
+    unsigned nodes[N_KINDS];
+    size_t tree_bytes;              // the flat tree
+    size_t arena_bytes;             // the class tree, if one was built
+    size_t symbol_bytes;            // every distinct spelling
+    size_t peak_rss;
+
+    CompileStats()
+        : input_bytes(0), tokens(0), tree_bytes(0), arena_bytes(0), symbol_bytes(0),
+          peak_rss(0)
+    {
+        std::fill(nodes, nodes + N_KINDS, 0u);
+    }
+
+    // adds to the phase called name, or starts it
+    void add(const char* name, double seconds) {
+        for (size_t i = 0; i < phases.size(); ++i) {
+            if (phases[i].name == std::string(name)) {
+                phases[i].seconds += seconds;
+                return;
+            }
+        }
+        Phase p = { name, seconds };
+        phases.push_back(p);
+    }
+
+    // the parser pulls tokens as it goes: parsing is timed as a whole and
+    // the time the scanner takes on its own is taken off into "lex"
+    void add_parse(double seconds, double lex) {
+        add("lex", lex);
+        add("parse", std::max(0.0, seconds - lex));
+    }
+
+    void count_nodes(const FlatView& tree) {
+        for (unsigned n = 0; n < tree.nodes; ++n)
+            ++nodes[tree.kind[n]];
+    }
+
+    // how much the process ever held resident
+    void measure_rss() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            peak_rss = (size_t)usage.ru_maxrss * 1024;
+    }
+
+    double seconds(const char* name) const {
+        for (size_t i = 0; i < phases.size(); ++i)
+            if (phases[i].name == std::string(name))
+                return phases[i].seconds;
+        return 0;
+    }
+
+    double total_seconds() const {
+        double t = 0;
+        for (size_t i = 0; i < phases.size(); ++i)
+            t += phases[i].seconds;
+        return t;
+    }
+
+    unsigned long long total_nodes() const {
+        unsigned long long t = 0;
+        for (unsigned k = 0; k < N_KINDS; ++k)
+            t += nodes[k];
+        return t;
+    }
+
+    // node classes that occur, most frequent first
+    std::vector<std::pair<unsigned, NodeKind> > node_classes() const {
+        std::vector<std::pair<unsigned, NodeKind> > v;
+        for (unsigned k = 0; k < N_KINDS; ++k)
+            if (nodes[k])
+                v.push_back(std::make_pair(nodes[k], (NodeKind)k));
+        std::stable_sort(v.begin(), v.end(),
+                         [](const std::pair<unsigned, NodeKind>& a,
+                            const std::pair<unsigned, NodeKind>& b) {
+                             return a.first > b.first;
+                         });
+        return v;
+    }
+
+    static double rate(double amount, double seconds) {
+        return seconds > 0 ? amount / seconds : 0;
+    }
+
+    void print(FILE* out) const {
+        double total = total_seconds();
+        fprintf(out, "%s: %zu bytes, %llu tokens, %llu nodes\n", file.c_str(), input_bytes,
+                tokens, total_nodes());
+        for (size_t i = 0; i < phases.size(); ++i)
+            fprintf(out, "  %-10s %10.6f s %6.1f%%\n", phases[i].name, phases[i].seconds,
+                    total > 0 ? 100 * phases[i].seconds / total : 0.0);
+        fprintf(out, "  %-10s %10.6f s\n", "total", total);
+        double lex = seconds("lex");
+        double parse = lex + seconds("parse");
+        fprintf(out, "  lexing %.1f MB/s, %.0f tokens/s; parsing %.1f MB/s, %.0f nodes/s\n",
+                rate(input_bytes, lex) / 1e6, rate(tokens, lex),
+                rate(input_bytes, parse) / 1e6, rate(total_nodes(), parse));
+        std::vector<std::pair<unsigned, NodeKind> > classes = node_classes();
+        for (size_t i = 0; i < classes.size(); ++i)
+            fprintf(out, "  %-18s %10u\n", kind_name(classes[i].second), classes[i].first);
+        fprintf(out, "  bytes: flat tree %zu, class tree %zu, symbols %zu; peak RSS %zu\n",
+                tree_bytes, arena_bytes, symbol_bytes, peak_rss);
+    }
+
+    static void print_string(FILE* out, const std::string& s) {
+        fputc('"', out);
+        for (size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = s[i];
+            if (c == '"' || c == '\\')
+                fprintf(out, "\\%c", c);
+            else if (c < 0x20)
+                fprintf(out, "\\u%04x", c);
+            else
+                fputc(c, out);
+        }
+        fputc('"', out);
+    }
+
+    // one object; times in seconds, sizes in bytes
+    void print_json(FILE* out) const {
+        fprintf(out, "{\"file\": ");
+        print_string(out, file);
+        fprintf(out, ", \"input_bytes\": %zu, \"tokens\": %llu,\n \"phases\": {", input_bytes,
+                tokens);
+        for (size_t i = 0; i < phases.size(); ++i)
+            fprintf(out, "%s\"%s\": %.9f", i ? ", " : "", phases[i].name, phases[i].seconds);
+        fprintf(out, "},\n \"total_seconds\": %.9f, \"nodes\": %llu,\n \"node_classes\": {",
+                total_seconds(), total_nodes());
+        std::vector<std::pair<unsigned, NodeKind> > classes = node_classes();
+        for (size_t i = 0; i < classes.size(); ++i)
+            fprintf(out, "%s\"%s\": %u", i ? ", " : "", kind_name(classes[i].second),
+                    classes[i].first);
+        fprintf(out, "},\n \"bytes\": {\"flat_tree\": %zu, \"class_tree\": %zu, "
+                "\"symbols\": %zu, \"peak_rss\": %zu}}\n",
+                tree_bytes, arena_bytes, symbol_bytes, peak_rss);
+    }
+};
+
+// adds the time from here to the end of the scope, or to stop(), to a
+// phase; does nothing without stats
+class PhaseTimer {
+    CompileStats* stats;
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+public:
+    PhaseTimer(CompileStats* _stats, const char* _name)
+        : stats(_stats), name(_name), start(std::chrono::steady_clock::now()) {}
+
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void stop() {
+        if (stats)
+            stats->add(name, elapsed());
+        stats = NULL;
+    }
+
+    ~PhaseTimer() {
+        stop();
+    }
+};
+
+#endif
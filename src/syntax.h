@@ -2,59 +2,94 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include "arena.h"
+#include "constant.h"
+#include "intern.h"
+#include "source.h"
+#include "dump.h"
 
 using namespace std;
 
 class Node {
+    static void destroy(void* p) {
+        ((Node*)p)->~Node();
+    }
 public:
-    virtual void print(int indent) = 0;
+    virtual ~Node() {}
+    virtual void dump(Dumper& out, int indent) = 0;
+
+    // writes the subtree to stdout
+    void print(int indent) {
+        Dumper out(stdout);
+        dump(out, indent);
+    }
+
+    // nodes live in the current arena and are released all at once
+    static void* operator new(size_t size) {
+        return Arena::current()->alloc_object(size, destroy);
+    }
+
+    static void operator delete(void* p) {
+        Arena::current()->abandon(p);
+    }
 };
 
 class Op : public Node {
-    string op;
+    Symbol op;
 public:
-    Op(const char* _op) : op(_op) {}
+    Op(const char* _op) : op(intern(_op)) {}
+    Op(const char* _op, size_t len) : op(intern(_op, len)) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "operator " << op << endl;
+    void dump (Dumper& out, int indent) {
+        out.indent(indent) << "operator " << op << '\n';
     }
 };
 
 class Id : public Node {
-    string id;
+    Symbol id;
 public:
-    Id(const char* _id) : id(_id) {}
+    Id(const char* _id) : id(intern(_id)) {}
+    Id(const char* _id, size_t len) : id(intern(_id, len)) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "identifier:"<<id<<endl;
+    Symbol symbol() const {
+        return id;
+    }
+
+    void dump (Dumper& out, int indent) {
+        out.indent(indent) << "identifier:" << id << '\n';
     }
 };
 
+// literal spellings are mostly unique, so they are kept as views of the
+// source instead of being interned; the value is read once, by the scanner
 class Number : public Node {
-    string repr;
+    Text repr;
+    Literal k;
 public:
-    Number(const char* _repr) : repr(_repr) {}
+    Number(Text _repr, const Literal& _k) : repr(_repr), k(_k) {}
+
+    const Literal& value() const {
+        return k;
+    }
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "number " << repr << endl;
+    void dump (Dumper& out, int indent) {
+        out.indent(indent) << "number " << repr << '\n';
     }
 };
 
 class String : public Node {
-    string str;
+    Text str;
 public:
-    String(const char* _str) : str(_str) {}
+    String(Text _str) : str(_str) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "string literal " << str << endl;
+    void dump (Dumper& out, int indent) {
+        out.indent(indent) << "string literal " << str << '\n';
     }
 };
 
 template <class T> 
 class Multi: public Node { 
-    // note because of the way the parse works, the order of nodes is backward
-    // of its syntactic order
-    vector<T*> nodes;
+    vector<T*> nodes; // in source order
 public:
     void add (T* n) {
         nodes.push_back(n);
@@ -64,9 +99,9 @@ public:
         return nodes.empty();
     }
 
-    void print(int indent) {
-        for (typename vector<T*>::reverse_iterator it=nodes.rbegin(); it!=nodes.rend(); it++) {
-            (*it)->print(indent);
+    void dump (Dumper& out, int indent) {
+        for (typename vector<T*>::iterator it=nodes.begin(); it!=nodes.end(); it++) {
+            (*it)->dump(out, indent);
         }
     }
 };
@@ -80,9 +115,9 @@ class IdLvalue: public Lvalue {
 public:
     IdLvalue(Id* _id) : id(_id) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "id lvalue" << endl;
-        id->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "id lvalue");
+        id->dump(out, indent+4);
     }
 };
 
@@ -94,12 +129,12 @@ class ArrayLvalue : public Lvalue {
 public:
     ArrayLvalue(Lvalue* _lval, Expr* _expr) : lval(_lval), expr(_expr) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "array lvalue" << endl;
-        cout << string(indent+2, ' ') << "array" << endl;
-        lval->print(indent+4);
-        cout << string(indent+2, ' ') << "index" << endl;
-        ((Node*)expr)->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "array lvalue");
+        out.line(indent+2, "array");
+        lval->dump(out, indent+4);
+        out.line(indent+2, "index");
+        ((Node*)expr)->dump(out, indent+4);
     }
 };
 
@@ -109,12 +144,12 @@ class RecordLvalue: public Lvalue {
 public:
     RecordLvalue(Lvalue* _lval, Id* _id) : lval(_lval), id(_id) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "record lvalue" << endl;
-        cout << string(indent+2, ' ') << "record" << endl;
-        lval->print(indent+4);
-        cout << string(indent+2, ' ') << "member" << endl;
-        id->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "record lvalue");
+        out.line(indent+2, "record");
+        lval->dump(out, indent+4);
+        out.line(indent+2, "member");
+        id->dump(out, indent+4);
     }
 };
 
@@ -124,11 +159,11 @@ class CompValue: public Node {
 public:
     CompValue(Id* _id, Expr* _expr) : id(_id), expr(_expr) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "member" << endl;
-        id->print(indent+2);
-        cout << string(indent, ' ') << "value" << endl;
-        ((Node*)expr)->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "member");
+        id->dump(out, indent+2);
+        out.line(indent, "value");
+        ((Node*)expr)->dump(out, indent+4);
     }
 };
 
@@ -140,8 +175,8 @@ class SimpleArrayValue : public ArrayValue {
 public:
     SimpleArrayValue(Expr* _expr) : expr(_expr) {}
    
-    void print (int indent) {
-        ((Node*)expr)->print(indent);
+    void dump (Dumper& out, int indent) {
+        ((Node*)expr)->dump(out, indent);
     }
 };
 
@@ -151,10 +186,10 @@ class OfArrayValue : public ArrayValue {
 public:
     OfArrayValue(Expr* _left, Expr* _right): left(_left), right(_right) {}
 
-    void print (int indent) {
-        ((Node*)left)->print(indent+4);
-        cout << string(indent+2, ' ') << "of" << endl;
-        ((Node*)right)->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        ((Node*)left)->dump(out, indent+4);
+        out.line(indent+2, "of");
+        ((Node*)right)->dump(out, indent+4);
     }
 }; 
 
@@ -166,8 +201,8 @@ class NumberExpr: public Expr {
 public:
     NumberExpr(Number* _n) : n(_n) {}
 
-    void print (int indent) {
-        n->print(indent);
+    void dump (Dumper& out, int indent) {
+        n->dump(out, indent);
     }
 };
 
@@ -176,8 +211,8 @@ class LvalueExpr : public Expr {
 public:
     LvalueExpr(Lvalue* _lval) : lval(_lval) {}
 
-    void print (int indent) {
-        lval->print(indent);
+    void dump (Dumper& out, int indent) {
+        lval->dump(out, indent);
     }
 };
 
@@ -187,10 +222,10 @@ class UnaryOpExpr : public Expr {
 public:
     UnaryOpExpr(Op* _op, Expr* _expr) : op(_op), expr(_expr) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "unary operator expression" << endl;
-        op->print(indent+2);
-        expr->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "unary operator expression");
+        op->dump(out, indent+2);
+        expr->dump(out, indent+2);
     }
 };
 
@@ -202,11 +237,11 @@ public:
     BinOpExpr(Op* _op, Expr* _left, Expr* _right) 
         :op(_op), left(_left), right(_right) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "binary operator expression" << endl;
-        left->print(indent+4);
-        op->print(indent+2);
-        right->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "binary operator expression");
+        left->dump(out, indent+4);
+        op->dump(out, indent+2);
+        right->dump(out, indent+4);
     }
 
 };
@@ -217,15 +252,15 @@ class CallExpr : public Expr {
 public:
     CallExpr(Id* _id, Multi<Expr>* _params) : id(_id), params(_params) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "function call" << endl;
-        cout << string(indent+2, ' ') << "function id" << endl;
-        id->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "function call");
+        out.line(indent+2, "function id");
+        id->dump(out, indent+4);
         if  (params) {
-            cout << string(indent+2, ' ') << "parameters" << endl;
-            params->print(indent+4);
+            out.line(indent+2, "parameters");
+            params->dump(out, indent+4);
         } else {
-            cout << string(indent+2, ' ') << "no parameter" << endl;
+            out.line(indent+2, "no parameter");
         }
     }
 };
@@ -236,12 +271,12 @@ class RecordExpr : public Expr {
 public:
     RecordExpr(Id* _id, Multi<CompValue>* _vals) : id(_id), vals(_vals) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "record expression" << endl;
-        cout << string(indent+2, ' ') << "record id" << endl;
-        id->print(indent+4);
-        cout << string(indent+2, ' ') << "values" << endl;
-        vals->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "record expression");
+        out.line(indent+2, "record id");
+        id->dump(out, indent+4);
+        out.line(indent+2, "values");
+        vals->dump(out, indent+4);
     }
 };
 
@@ -251,12 +286,12 @@ class ArrayExpr : public Expr {
 public:
     ArrayExpr(Id* _id, Multi<ArrayValue>* _vals) : id(_id), vals(_vals) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "array expression" << endl;
-        cout << string(indent+2, ' ') << "array id" << endl;
-        id->print(indent+4);
-        cout << string(indent+2, ' ') << "values" << endl;
-        vals->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "array expression");
+        out.line(indent+2, "array id");
+        id->dump(out, indent+4);
+        out.line(indent+2, "values");
+        vals->dump(out, indent+4);
     }
 };
 
@@ -268,8 +303,8 @@ class StrWriteExpr : public WriteExpr {
 public:
     StrWriteExpr(String* _str) : str(_str) {}
 
-    void print (int indent) {
-        str->print(indent);
+    void dump (Dumper& out, int indent) {
+        str->dump(out, indent);
     }
 };
 
@@ -278,8 +313,8 @@ class ExprWriteExpr : public WriteExpr {
 public:
     ExprWriteExpr(Expr* _expr) : expr(_expr) {}
 
-    void print (int indent) {
-        expr->print(indent);
+    void dump (Dumper& out, int indent) {
+        expr->dump(out, indent);
     }
 };
 
@@ -294,11 +329,11 @@ public:
         : lvalue(_lvalue), expr(_expr) 
     {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "assignment statement" << endl;
-        lvalue->print(indent+2);
-        cout << string(indent+2, ' ') << "value" << endl;
-        expr->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "assignment statement");
+        lvalue->dump(out, indent+2);
+        out.line(indent+2, "value");
+        expr->dump(out, indent+4);
     }
 };
 
@@ -308,15 +343,15 @@ class CallStat: public Stat {
 public:
     CallStat(Id* _id, Multi<Expr>* _params) : id(_id), params(_params) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "function call statement" << endl;
-        cout << string(indent+2, ' ') << "function name" << endl;
-        id->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "function call statement");
+        out.line(indent+2, "function name");
+        id->dump(out, indent+4);
         if (params) {
-            cout << string(indent+2, ' ') << "parameters" << endl;
-            params->print(indent+4);
+            out.line(indent+2, "parameters");
+            params->dump(out, indent+4);
         } else {
-            cout << string(indent+2, ' ') << "no parameter" << endl;
+            out.line(indent+2, "no parameter");
         }
     }
 };
@@ -326,9 +361,9 @@ class ReadStat: public Stat {
 public:
     ReadStat(Multi<Lvalue>* _lvalues) : lvalues(_lvalues) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "read statement" << endl;
-        lvalues->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "read statement");
+        lvalues->dump(out, indent+2);
     }
 };
 
@@ -337,9 +372,10 @@ class WriteStat: public Stat {
 public:
     WriteStat(Multi<WriteExpr>* _write_params) : write_params(_write_params) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "write statement" << endl;
-        write_params->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "write statement");
+        if (write_params)
+            write_params->dump(out, indent+2);
     }
 };
 
@@ -349,11 +385,11 @@ class ElseIf : public Node {
 public:
     ElseIf(Expr* _cond, Multi<Stat>* _then) : cond(_cond), then(_then) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "condition" << endl;
-        cond->print(indent+2);
-        cout << string(indent, ' ') << "then" << endl;
-        then->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "condition");
+        cond->dump(out, indent+2);
+        out.line(indent, "then");
+        then->dump(out, indent+2);
     }
 };
 
@@ -367,19 +403,19 @@ public:
         : cond(_cond), then(_then), elseif(_elseif), else_(_else) 
     {}
 
-    void print (int indent) {
-        cout << string(indent, ' ')<< "if statement" << endl;
-        cout << string(indent+2, ' ') <<"condition" << endl;
-        cond->print(indent+4);
-        cout << string(indent+2, ' ') <<"then" << endl;
-        then->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "if statement");
+        out.line(indent+2, "condition");
+        cond->dump(out, indent+4);
+        out.line(indent+2, "then");
+        then->dump(out, indent+4);
         if (elseif && !elseif->empty()) {
-            cout << string(indent+2, ' ') <<"elseif" << endl;
-            elseif->print(indent+4);
+            out.line(indent+2, "elseif");
+            elseif->dump(out, indent+4);
         }
         if (else_) {
-            cout << string(indent+2, ' ') <<"else" << endl;
-            else_->print(indent+4);
+            out.line(indent+2, "else");
+            else_->dump(out, indent+4);
         }
     }
 };
@@ -390,12 +426,12 @@ class WhileStat: public Stat {
 public:
     WhileStat(Expr* _cond, Multi<Stat>* _body) : cond(_cond), body(_body) {};
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "while loop" << endl;
-        cout << string(indent+2, ' ') << "condition expression" << endl;
-        cond->print(indent+4);
-        cout << string(indent+2, ' ')  << "body" << endl;
-        body->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "while loop");
+        out.line(indent+2, "condition expression");
+        cond->dump(out, indent+4);
+        out.line(indent+2, "body");
+        body->dump(out, indent+4);
     }
 };
 
@@ -404,9 +440,9 @@ class LoopStat: public Stat {
 public:
     LoopStat(Multi<Stat>* _body) : body(_body) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "loop" << endl;
-        body->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "loop");
+        body->dump(out, indent+2);
     }
 };
 
@@ -421,32 +457,32 @@ public:
         : id(_id), from(_from), to(_to), by(_by), body(_body)
     {}
     
-    void print (int indent) {
-        cout << string(indent, ' ') << "for statement" << endl;
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "for statement");
 
-        cout << string(indent+2, ' ') << "for variable" << endl;
-        id->print(indent+4);
+        out.line(indent+2, "for variable");
+        id->dump(out, indent+4);
 
-        cout << string(indent+2, ' ') << "from" << endl;
-        from->print(indent+4);
+        out.line(indent+2, "from");
+        from->dump(out, indent+4);
 
-        cout << string(indent+2, ' ') << "to" << endl;
-        to->print(indent+4);
+        out.line(indent+2, "to");
+        to->dump(out, indent+4);
         
         if (by) {
-            cout << string(indent+2, ' ') << "by" << endl;
-            by->print(indent+4);
+            out.line(indent+2, "by");
+            by->dump(out, indent+4);
         }
 
-        cout << string(indent+2, ' ') << "for body" << endl;
-        body->print(indent+4);
+        out.line(indent+2, "for body");
+        body->dump(out, indent+4);
     }
 };
 
 class ExitStat: public Stat {
 public:
-    void print (int indent) {
-        cout << string(indent, ' ') << "exit statement" << endl;
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "exit statement");
     }
 };
 
@@ -454,12 +490,12 @@ class ReturnStat: public Stat {
     Expr* val; //nullable
 public:
     ReturnStat(Expr* _val) : val(_val) {}
-    void print (int indent) {
+    void dump (Dumper& out, int indent) {
         if (val) {
-            cout << string(indent, ' ') << "return value" << endl;
-            val->print(indent+4);
+            out.line(indent, "return value");
+            val->dump(out, indent+4);
         } else {
-            cout << string(indent, ' ') << "return statement" << endl;
+            out.line(indent, "return statement");
         }
     }
 };
@@ -476,16 +512,16 @@ public:
     {
     }
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "variable declaration" << endl;
-        cout << string(indent+2, ' ') << "variable names" << endl;
-        ids->print(indent+4);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "variable declaration");
+        out.line(indent+2, "variable names");
+        ids->dump(out, indent+4);
         if (type) {
-            cout << string(indent+2, ' ') << "type" << endl;
-            ((Node*)type)->print(indent+4);
+            out.line(indent+2, "type");
+            ((Node*)type)->dump(out, indent+4);
         }
-        cout << string(indent+2, ' ') << "initializer" << endl;
-        expr->print(indent+4);
+        out.line(indent+2, "initializer");
+        expr->dump(out, indent+4);
     }
 };
 
@@ -497,19 +533,22 @@ class UserType : public Type {
 public:
     UserType(Id* _id)  : id(_id) {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "user defined type: " << endl;
-        id->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "user defined type: ");
+        id->dump(out, indent+2);
     }
 };
 
 class BuiltinType : public Type {
-    string typename_;
+    Symbol typename_;
 public:
-    BuiltinType(string _typename) : typename_(_typename) {}
+    BuiltinType(const char* _typename) : typename_(intern(_typename)) {}
+    BuiltinType(const char* _typename, size_t len)
+        : typename_(intern(_typename, len))
+    {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "type: " << typename_ << endl;
+    void dump (Dumper& out, int indent) {
+        out.indent(indent) << "type: " << typename_ << '\n';
     }
 };
 
@@ -518,9 +557,9 @@ class ArrayType : public Type {
 public:
     ArrayType(Type* _elem_type) : elem_type(_elem_type) {}
 
-    void print(int indent) {
-        cout << string(indent, ' ') << "array type of" << endl;
-        elem_type->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "array type of");
+        elem_type->dump(out, indent+2);
     }
 };
 
@@ -530,11 +569,11 @@ class Component : public Node {
 public:
     Component(Id* _id, Type* _type) : id(_id), type(_type) {}
 
-    void print(int indent) {
-        cout << string(indent, ' ') << "component id" <<endl;
-        id->print(indent+2);
-        cout << string(indent, ' ') << "component type" << endl;
-        type->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "component id");
+        id->dump(out, indent+2);
+        out.line(indent, "component type");
+        type->dump(out, indent+2);
     }
 };
 
@@ -543,9 +582,9 @@ class RecordType: public Type {
 public:
     RecordType(Multi<Component>* _components) : components(_components) {}
 
-    void print(int indent) {
-        cout << string(indent, ' ') << "record type" << endl;
-        components->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "record type");
+        components->dump(out, indent+2);
     }
 };
 
@@ -554,10 +593,10 @@ class TypeDecl: public Node {
     Type* type;
 public:
     TypeDecl(Id* _id, Type* _type) : id(_id), type(_type) {}
-    void print (int indent) {
-        cout << string(indent, ' ') << "type declaration" << endl;
-        id->print(indent+2);
-        type->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "type declaration");
+        id->dump(out, indent+2);
+        type->dump(out, indent+2);
     }
 };
 
@@ -569,11 +608,11 @@ public:
         : ids(_ids), type_(_type) 
     {}
 
-    void print (int indent) {
-        cout << string(indent, ' ') << "identifiers" << endl;
-        ids->print(indent+2);
-        cout << string(indent, ' ') << "type" << endl;
-        type_->print(indent+2);
+    void dump (Dumper& out, int indent) {
+        out.line(indent, "identifiers");
+        ids->dump(out, indent+2);
+        out.line(indent, "type");
+        type_->dump(out, indent+2);
     }
 };
 
@@ -589,19 +628,19 @@ public:
         : id(_id), fpsecs(_fpsecs), type(_type), body(_body) 
     {}
 
-    void print (int ident) {
-        cout << string(ident, ' ') << "procedure declaration" << endl;
-        cout << string(ident+2, ' ') << "id" << endl;
-        id->print(ident+4);
+    void dump (Dumper& out, int ident) {
+        out.line(ident, "procedure declaration");
+        out.line(ident+2, "id");
+        id->dump(out, ident+4);
         if (fpsecs) {
-            cout << string(ident+2, ' ') << "formal parameters" << endl;
-            fpsecs->print(ident+4);
+            out.line(ident+2, "formal parameters");
+            fpsecs->dump(out, ident+4);
         }
         if (type) {
-            cout << string(ident+2, ' ') << "return type" << endl;
-            type->print(ident+4);
+            out.line(ident+2, "return type");
+            type->dump(out, ident+4);
         }
-        ((Node*)body)->print(ident+4);
+        ((Node*)body)->dump(out, ident+4);
     }
 };
 
@@ -611,8 +650,8 @@ class Decl: public Node {
 public:
     Decl(const char* _type, Multi<Node>* _block) : type(_type), block(_block) {}
 
-    void print (int ident) {
-        block->print(ident);
+    void dump (Dumper& out, int ident) {
+        block->dump(out, ident);
     }
 };
 
@@ -621,12 +660,12 @@ class Body: public Node {
     Multi<Stat>* stats;
 public:
     Body(Multi<Decl>* _decls, Multi<Stat>* _stats): decls(_decls), stats(_stats) {}
-    void print (int ident) {
-        cout << string(ident, ' ') << "body" << endl;
-        cout << string(ident+2, ' ')<< "declarations" << endl;
-        decls->print(ident+4);
-        cout << string(ident+2, ' ') << "statements" << endl;
-        stats->print(ident+4);
+    void dump (Dumper& out, int ident) {
+        out.line(ident, "body");
+        out.line(ident+2, "declarations");
+        decls->dump(out, ident+4);
+        out.line(ident+2, "statements");
+        stats->dump(out, ident+4);
     }
 };
 
@@ -634,9 +673,9 @@ class Program: public Node {
     Body* body;
 public:
     Program(Body* _body) : body(_body) {}
-    void print (int ident) {
-        cout << string(ident, ' ') << "program" << endl;;
-        body->print(ident+2);
+    void dump (Dumper& out, int ident) {
+        out.line(ident, "program");
+        body->dump(out, ident+2);
     }
 };
 
@@ -0,0 +1,126 @@
+// a fixed set of workers with a task deque each: a worker runs tasks from
+// the back of its own deque and, once that is empty, steals from the front
+// of the others, which keeps every core busy on batches of uneven tasks
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+    struct Queue {
+        std::mutex lock;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue> > queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> next;     // round robin target of submit()
+    std::atomic<size_t> queued;     // tasks sitting in some deque
+    std::atomic<size_t> pending;    // tasks submitted but not finished
+    std::mutex state;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    bool stopping;
+
+    bool pop(unsigned self, std::function<void()>& task) {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> guard(q.lock);
+        if (q.tasks.empty())
+            return false;
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(unsigned self, std::function<void()>& task) {
+        for (size_t i = 1; i < queues.size(); ++i) {
+            Queue& q = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> guard(q.lock);
+            if (q.tasks.empty())
+                continue;
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void run(unsigned self) {
+        for (;;) {
+            std::function<void()> task;
+            if (pop(self, task) || steal(self, task)) {
+                --queued;
+                task();
+                if (--pending == 0) {
+                    std::lock_guard<std::mutex> guard(state);
+                    finished.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(state);
+            while (!stopping && queued == 0)
+                wake.wait(guard);
+            if (stopping && queued == 0)
+                return;
+        }
+    }
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+public:
+    explicit ThreadPool(unsigned threads)
+        : next(0), queued(0), pending(0), stopping(false)
+    {
+        if (threads == 0)
+            threads = 1;
+        for (unsigned i = 0; i < threads; ++i)
+            queues.push_back(std::unique_ptr<Queue>(new Queue));
+        for (unsigned i = 0; i < threads; ++i)
+            workers.push_back(std::thread(&ThreadPool::run, this, i));
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(state);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+
+    void submit(std::function<void()> task) {
+        ++pending;
+        {
+            // under the lock so a worker about to sleep cannot miss it
+            std::lock_guard<std::mutex> guard(state);
+            ++queued;
+        }
+        Queue& q = *queues[next++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> guard(q.lock);
+            q.tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // blocks until every submitted task has run
+    void wait() {
+        std::unique_lock<std::mutex> guard(state);
+        while (pending != 0)
+            finished.wait(guard);
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+};
+
+#endif
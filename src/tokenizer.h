@@ -1,11 +1,6 @@
-#define MAX_INT "2147483647"
-#define INT_OVERFLOW 1
-
 #define STR_OVER_LONG 1
 #define UNEXPECTED_WORD 2
 
 
-int check_integer(char *int_str);
-
 int check_string(char *str);
 
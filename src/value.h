@@ -0,0 +1,458 @@
+// run-time values of PCAT programs and the operations on them, shared by
+// the tree-walking interpreter and the bytecode VM so both agree on every
+// result and error
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "intern.h"
+#include "layout.h"
+
+enum ValueTag { V_INT, V_REAL, V_BOOL, V_NIL, V_OBJECT };
+
+struct Object;
+
+struct Value {
+    unsigned char tag;
+    union {
+        int i;
+        double r;
+        Object* obj;
+    };
+};
+
+inline Value int_value(int i) {
+    Value v;
+    v.tag = V_INT;
+    v.i = i;
+    return v;
+}
+
+inline Value real_value(double r) {
+    Value v;
+    v.tag = V_REAL;
+    v.r = r;
+    return v;
+}
+
+inline Value bool_value(bool b) {
+    Value v;
+    v.tag = V_BOOL;
+    v.i = b;
+    return v;
+}
+
+inline Value nil_value() {
+    Value v;
+    v.tag = V_NIL;
+    v.obj = NULL;
+    return v;
+}
+
+inline Value object_value(Object* o) {
+    Value v;
+    v.tag = V_OBJECT;
+    v.obj = o;
+    return v;
+}
+
+// what the declarations say about a variable, field or result; only REAL
+// matters at run time, integers stored there are converted
+enum Kind { K_OTHER, K_INT, K_REAL, K_BOOL, K_STRING };
+
+struct RecordInfo {
+    Symbol name;
+    std::vector<Symbol> fields;
+    std::vector<unsigned char> kinds;
+    std::vector<unsigned char> slots;  // how each field is stored
+    Layout layout;                     // where, once the kinds are known
+    std::vector<unsigned> type_nodes;  // field types, resolved once all are declared
+
+    int find(Symbol f) const {
+        for (size_t i = 0; i < fields.size(); ++i)
+            if (fields[i] == f)
+                return (int)i;
+        return -1;
+    }
+};
+
+// a record or an array; records and arrays are references. The items
+// follow the header in slots (see layout.h), a record's where its layout
+// puts them, an array's one after the other. Once moved, they are Values
+// elsewhere and the first bytes of the items point to them
+struct Object {
+    const RecordInfo* record;  // NULL for an array
+    unsigned size;             // fields or elements
+    unsigned char slot;        // how an array's elements are stored
+    bool moved;
+};
+
+// thrown by compile and run, caught at the interface
+struct InterpError {
+    std::string message;
+    explicit InterpError(const std::string& m) : message(m) {}
+};
+
+inline void value_error(const std::string& message) {
+    throw InterpError(message);
+}
+
+inline std::string name_of(Symbol s) {
+    return std::string(s.c_str(), s.size());
+}
+
+// in the order of the operators in CodeOp and the VM's opcodes
+enum ArithOp { A_ADD, A_SUB, A_MUL, A_RDIV, A_DIV, A_MOD };
+enum CompareOp { R_LT, R_LE, R_GT, R_GE, R_EQ, R_NE };
+
+inline double as_real(Value x) {
+    return x.tag == V_INT ? (double)x.i : x.r;
+}
+
+inline bool is_number(Value x) {
+    return x.tag == V_INT || x.tag == V_REAL;
+}
+
+inline bool truth(Value x) {
+    if (x.tag != V_BOOL)
+        value_error("condition is not a boolean");
+    return x.i != 0;
+}
+
+// x as it is stored where kind is declared
+inline Value as_kind(Value x, unsigned char kind) {
+    return kind == K_REAL && x.tag == V_INT ? real_value(x.i) : x;
+}
+
+inline void store(Value* at, Value x, unsigned char kind) {
+    *at = as_kind(x, kind);
+}
+
+inline Value arith(ArithOp op, Value x, Value y) {
+    if (!is_number(x) || !is_number(y))
+        value_error("arithmetic on a non-number");
+    if (x.tag == V_INT && y.tag == V_INT) {
+        // wraps around like the 32-bit machine integers PCAT assumes
+        unsigned a = (unsigned)x.i, b = (unsigned)y.i;
+        switch (op) {
+        case A_ADD: return int_value((int)(a + b));
+        case A_SUB: return int_value((int)(a - b));
+        case A_MUL: return int_value((int)(a * b));
+        case A_RDIV:
+            if (!y.i)
+                value_error("division by zero");
+            return real_value((double)x.i / y.i);
+        case A_DIV:
+            if (!y.i)
+                value_error("division by zero");
+            return int_value(y.i == -1 ? (int)(0u - a) : x.i / y.i);
+        default:
+            if (!y.i)
+                value_error("division by zero");
+            return int_value(y.i == -1 ? 0 : x.i % y.i);
+        }
+    }
+    double a = as_real(x), b = as_real(y);
+    switch (op) {
+    case A_ADD: return real_value(a + b);
+    case A_SUB: return real_value(a - b);
+    case A_MUL: return real_value(a * b);
+    case A_RDIV:
+        if (b == 0)
+            value_error("division by zero");
+        return real_value(a / b);
+    default:
+        value_error("DIV and MOD need integers");
+        return x;
+    }
+}
+
+inline Value negative(Value x) {
+    if (x.tag == V_INT)
+        return int_value((int)(0u - (unsigned)x.i));
+    if (x.tag == V_REAL)
+        return real_value(-x.r);
+    value_error("unary - of a non-number");
+    return x;
+}
+
+inline bool same(Value x, Value y) {
+    if (is_number(x) && is_number(y))
+        return as_real(x) == as_real(y);
+    if (x.tag == V_BOOL && y.tag == V_BOOL)
+        return x.i == y.i;
+    bool xref = x.tag == V_OBJECT || x.tag == V_NIL;
+    bool yref = y.tag == V_OBJECT || y.tag == V_NIL;
+    if (!xref || !yref)
+        value_error("comparing values of different types");
+    return (x.tag == V_NIL ? NULL : x.obj) == (y.tag == V_NIL ? NULL : y.obj);
+}
+
+inline Value compare(CompareOp op, Value x, Value y) {
+    if (op == R_EQ)
+        return bool_value(same(x, y));
+    if (op == R_NE)
+        return bool_value(!same(x, y));
+    if (!is_number(x) || !is_number(y))
+        value_error("ordering non-numbers");
+    if (x.tag == V_INT && y.tag == V_INT) {
+        switch (op) {
+        case R_LT: return bool_value(x.i < y.i);
+        case R_LE: return bool_value(x.i <= y.i);
+        case R_GT: return bool_value(x.i > y.i);
+        default:   return bool_value(x.i >= y.i);
+        }
+    }
+    double a = as_real(x), b = as_real(y);
+    switch (op) {
+    case R_LT: return bool_value(a < b);
+    case R_LE: return bool_value(a <= b);
+    case R_GT: return bool_value(a > b);
+    default:   return bool_value(a >= b);
+    }
+}
+
+inline char* item_bytes(const Object* o) {
+    return (char*)(o + 1);
+}
+
+inline Value* moved_items(const Object* o) {
+    return *(Value**)item_bytes(o);
+}
+
+// whether a slot can hold x
+inline bool fits(unsigned char slot, Value x) {
+    switch (slot) {
+    case S_INT:  return x.tag == V_INT;
+    case S_REAL: return x.tag == V_REAL;
+    case S_BOOL: return x.tag == V_BOOL;
+    case S_REF:  return x.tag == V_OBJECT || x.tag == V_NIL;
+    default:     return true;
+    }
+}
+
+inline Value load_slot(const char* at, unsigned char slot) {
+    switch (slot) {
+    case S_INT:  return int_value(*(const int*)at);
+    case S_REAL: return real_value(*(const double*)at);
+    case S_BOOL: return bool_value(*at != 0);
+    case S_REF: {
+        Object* o = *(Object* const*)at;
+        return o ? object_value(o) : nil_value();
+    }
+    default:     return *(const Value*)at;
+    }
+}
+
+inline void store_slot(char* at, unsigned char slot, Value x) {
+    switch (slot) {
+    case S_INT:  *(int*)at = x.i; break;
+    case S_REAL: *(double*)at = x.r; break;
+    case S_BOOL: *at = (char)(x.i != 0); break;
+    case S_REF:  *(Object**)at = x.tag == V_NIL ? NULL : x.obj; break;
+    default:     *(Value*)at = x;
+    }
+}
+
+// count copies of x from at, where slot holds x
+inline void fill_slots(char* at, unsigned char slot, Value x, size_t count) {
+    switch (slot) {
+    case S_INT:  std::fill_n((int*)at, count, x.i); break;
+    case S_REAL: std::fill_n((double*)at, count, x.r); break;
+    case S_BOOL: memset(at, x.i != 0, count); break;
+    case S_REF:  std::fill_n((Object**)at, count, x.tag == V_NIL ? NULL : x.obj); break;
+    default:     std::fill_n((Value*)at, count, x);
+    }
+}
+
+// where item i of an object that has not moved is, and its slot
+inline char* item_at(const Object* o, unsigned i, unsigned char& slot) {
+    if (o->record) {
+        slot = o->record->slots[i];
+        return item_bytes(o) + o->record->layout.offsets[i];
+    }
+    slot = o->slot;
+    return item_bytes(o) + (size_t)i * slot_size(slot);
+}
+
+inline Value load_item(const Object* o, unsigned i) {
+    if (o->moved)
+        return moved_items(o)[i];
+    unsigned char slot;
+    const char* at = item_at(o, i, slot);
+    return load_slot(at, slot);
+}
+
+// moves the items of o to Values, when one of its slots is given what it
+// cannot hold; the old slots are left to the arena
+inline void move_items(Arena& heap, Object* o) {
+    Value* items = (Value*)heap.alloc(sizeof(Value) * o->size);
+    for (unsigned i = 0; i < o->size; ++i)
+        items[i] = load_item(o, i);
+    *(Value**)item_bytes(o) = items;
+    o->moved = true;
+}
+
+inline void store_item(Arena& heap, Object* o, unsigned i, Value x) {
+    if (!o->moved) {
+        unsigned char slot;
+        char* at = item_at(o, i, slot);
+        if (fits(slot, x)) {
+            store_slot(at, slot, x);
+            return;
+        }
+        move_items(heap, o);
+    }
+    moved_items(o)[i] = x;
+}
+
+// an object with room for bytes of items, at least a pointer's worth
+inline Object* new_object(Arena& heap, const RecordInfo* record, unsigned size,
+                          size_t bytes) {
+    Object* o = (Object*)heap.alloc(sizeof(Object) + std::max(bytes, sizeof(Value*)));
+    o->record = record;
+    o->size = size;
+    o->slot = S_VALUE;
+    o->moved = false;
+    return o;
+}
+
+// a record with every field at the zero of its kind
+inline Object* new_record(Arena& heap, const RecordInfo* r) {
+    Object* o = new_object(heap, r, (unsigned)r->fields.size(), r->layout.size);
+    // zero is 0, 0.0, FALSE and NIL in the packed slots
+    memset(item_bytes(o), 0, r->layout.size);
+    for (unsigned i = 0; i < o->size; ++i)
+        if (r->slots[i] == S_VALUE)
+            *(Value*)(item_bytes(o) + r->layout.offsets[i]) = nil_value();
+    return o;
+}
+
+// an array holding counts[i] copies of vals[i] for each i, in slot if
+// every value fits
+inline Object* new_array(Arena& heap, const Value* vals, const unsigned* counts, unsigned n,
+                         unsigned char slot) {
+    unsigned long long size = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        size += counts[i];
+        if (counts[i] && !fits(slot, vals[i]))
+            slot = S_VALUE;
+    }
+    if (size > UINT_MAX / sizeof(Value))
+        value_error("array too large");
+    Object* o = new_object(heap, NULL, (unsigned)size, (size_t)size * slot_size(slot));
+    o->slot = slot;
+    char* at = item_bytes(o);
+    for (unsigned i = 0; i < n; ++i) {
+        fill_slots(at, slot, vals[i], counts[i]);
+        at += (size_t)counts[i] * slot_size(slot);
+    }
+    return o;
+}
+
+inline unsigned array_count(Value k) {
+    if (k.tag != V_INT || k.i < 0)
+        value_error("array count is not a non-negative integer");
+    return (unsigned)k.i;
+}
+
+// the element of the array a that i indexes
+inline unsigned element_index(Value a, Value i) {
+    if (a.tag != V_OBJECT || a.obj->record)
+        value_error(a.tag == V_NIL ? "indexing NIL" : "indexing a non-array");
+    if (i.tag != V_INT)
+        value_error("array index is not an integer");
+    if (i.i < 0 || (unsigned)i.i >= a.obj->size)
+        value_error("array index out of bounds");
+    return (unsigned)i.i;
+}
+
+// what a field access found the last time it ran, the same access nearly
+// always sees the same record type
+struct FieldCache {
+    const RecordInfo* seen;  // NULL before the first access
+    unsigned index;
+    unsigned offset;         // of the field's slot among the items
+    unsigned char slot;
+    unsigned char kind;
+};
+
+// the field of the record r refers to, looked up unless cache has it
+inline const FieldCache& find_field(Value r, Symbol field, FieldCache& cache) {
+    if (r.tag != V_OBJECT || !r.obj->record)
+        value_error(r.tag == V_NIL ? "field of NIL" : "field of a non-record");
+    const RecordInfo* info = r.obj->record;
+    if (cache.seen != info) {
+        int at = info->find(field);
+        if (at < 0)
+            value_error(name_of(info->name) + " has no field " + name_of(field));
+        cache.seen = info;
+        cache.index = (unsigned)at;
+        cache.offset = info->layout.offsets[at];
+        cache.slot = info->slots[at];
+        cache.kind = info->kinds[at];
+    }
+    return cache;
+}
+
+inline Value load_field(const Object* o, const FieldCache& f) {
+    if (o->moved)
+        return moved_items(o)[f.index];
+    return load_slot(item_bytes(o) + f.offset, f.slot);
+}
+
+inline void store_field(Arena& heap, Object* o, const FieldCache& f, Value x) {
+    x = as_kind(x, f.kind);
+    if (!o->moved && fits(f.slot, x))
+        store_slot(item_bytes(o) + f.offset, f.slot, x);
+    else
+        store_item(heap, o, f.index, x);
+}
+
+inline void write_value(FILE* out, Value x) {
+    switch (x.tag) {
+    case V_INT:
+        fprintf(out, "%d", x.i);
+        break;
+    case V_REAL: {
+        // always with a point or exponent so reals read as reals
+        char s[64];
+        snprintf(s, sizeof(s), "%g", x.r);
+        if (!strpbrk(s, ".eni"))
+            strcat(s, ".0");
+        fputs(s, out);
+        break;
+    }
+    case V_BOOL:
+        fputs(x.i ? "TRUE" : "FALSE", out);
+        break;
+    case V_NIL:
+        fputs("NIL", out);
+        break;
+    default:
+        value_error("WRITE of a record or array");
+    }
+}
+
+// reads a number into at: a real if it is declared or holds one
+inline void read_value(FILE* in, Value* at, unsigned char kind) {
+    if (kind == K_REAL || at->tag == V_REAL) {
+        double r;
+        if (fscanf(in, "%lf", &r) != 1)
+            value_error("READ: expected a real number");
+        *at = real_value(r);
+    } else {
+        int i;
+        if (fscanf(in, "%d", &i) != 1)
+            value_error("READ: expected an integer");
+        *at = int_value(i);
+    }
+}
+
+#endif
@@ -0,0 +1,380 @@
+// runs a bytecode Module. Dispatch is a computed goto to the next
+// instruction's handler where the compiler has labels as values (GCC,
+// Clang), a switch in a loop elsewhere. Calls do not recurse on the C++
+// stack: each one pushes a frame and jumps to the callee's entry.
+#ifndef VM_H
+#define VM_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+class VM {
+    struct Frame {
+        Value* regs;
+        Frame* up;           // frame of the enclosing procedure
+        const ProcCode* proc;
+        const Insn* ret;     // where the caller continues
+        unsigned dst;        // caller register for the result
+    };
+
+    static const unsigned stack_slots = 1 << 20;
+    static const unsigned max_frames = 1 << 16;
+
+    Arena heap;              // records and arrays made by the program
+    Value* stack;
+    Frame* frames;
+    std::vector<Value> vals;       // scratch for building arrays
+    std::vector<unsigned> counts;
+    unsigned long long steps;
+
+    VM(const VM&);
+    VM& operator=(const VM&);
+
+    Value make_array(const ArraySite& site, const Value* r) {
+        size_t n = site.of.size();
+        vals.resize(n);
+        counts.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            if (site.of[i]) {
+                counts[i] = array_count(*r++);
+                vals[i] = *r++;
+            } else {
+                counts[i] = 1;
+                vals[i] = *r++;
+            }
+        }
+        return object_value(new_array(heap, vals.data(), counts.data(), (unsigned)n, site.slot));
+    }
+
+    void execute(Module& m, FILE* in, FILE* out) {
+        const Insn* code = m.code.data();
+        const Value* K = m.constants.data();
+        const ProcCode& main = m.procs[0];
+        if (main.registers > stack_slots)
+            value_error("out of stack");
+
+        Frame* fp = frames;
+        fp->regs = stack;
+        fp->up = NULL;
+        fp->proc = &main;
+        fp->ret = NULL;
+        fp->dst = 0;
+        for (unsigned i = 0; i < main.slots; ++i)
+            stack[i] = nil_value();
+        Value* globals = stack;
+        Value* R = fp->regs;
+        const Insn* pc = code + main.entry;
+        unsigned long long n = 0;
+
+#ifdef VM_COMPUTED_GOTO
+#define VM_LABEL(name) &&L_##name,
+        static void* labels[] = { BYTECODE_OPS(VM_LABEL) };
+#undef VM_LABEL
+#define CASE(name) L_##name:
+#define DISPATCH() do { ++n; goto *labels[pc->op]; } while (0)
+        DISPATCH();
+#else
+#define CASE(name) case OP_##name:
+#define DISPATCH() do { ++n; goto dispatch; } while (0)
+        DISPATCH();
+    dispatch:
+        switch (pc->op) {
+#endif
+
+// integer and real fast paths, anything else goes through the shared code
+#define VM_ARITH(name, op, arith_op) \
+        CASE(name) { \
+            Value x = R[pc->b], y = R[pc->c]; \
+            if (x.tag == V_INT && y.tag == V_INT) \
+                R[pc->a] = int_value((int)((unsigned)x.i op (unsigned)y.i)); \
+            else if (x.tag == V_REAL && y.tag == V_REAL) \
+                R[pc->a] = real_value(x.r op y.r); \
+            else \
+                R[pc->a] = arith(arith_op, x, y); \
+            ++pc; \
+            DISPATCH(); \
+        }
+#define VM_COMPARE(name, op, compare_op) \
+        CASE(name) { \
+            Value x = R[pc->b], y = R[pc->c]; \
+            if (x.tag == V_INT && y.tag == V_INT) \
+                R[pc->a] = bool_value(x.i op y.i); \
+            else \
+                R[pc->a] = compare(compare_op, x, y); \
+            ++pc; \
+            DISPATCH(); \
+        }
+
+        CASE(LOADK)
+            R[pc->a] = K[pc->b];
+            ++pc;
+            DISPATCH();
+        CASE(MOVE)
+            R[pc->a] = R[pc->b];
+            ++pc;
+            DISPATCH();
+        CASE(GETG)
+            R[pc->a] = globals[pc->b];
+            ++pc;
+            DISPATCH();
+        CASE(SETG)
+            globals[pc->a] = R[pc->b];
+            ++pc;
+            DISPATCH();
+        CASE(GETO) {
+            Frame* f = fp;
+            for (unsigned h = pc->c; h; --h)
+                f = f->up;
+            R[pc->a] = f->regs[pc->b];
+            ++pc;
+            DISPATCH();
+        }
+        CASE(SETO) {
+            Frame* f = fp;
+            for (unsigned h = pc->c; h; --h)
+                f = f->up;
+            f->regs[pc->b] = R[pc->a];
+            ++pc;
+            DISPATCH();
+        }
+        CASE(REAL)
+            if (R[pc->a].tag == V_INT)
+                R[pc->a] = real_value(R[pc->a].i);
+            ++pc;
+            DISPATCH();
+        VM_ARITH(ADD, +, A_ADD)
+        VM_ARITH(SUB, -, A_SUB)
+        VM_ARITH(MUL, *, A_MUL)
+        CASE(RDIV)
+            R[pc->a] = arith(A_RDIV, R[pc->b], R[pc->c]);
+            ++pc;
+            DISPATCH();
+        CASE(DIV)
+            R[pc->a] = arith(A_DIV, R[pc->b], R[pc->c]);
+            ++pc;
+            DISPATCH();
+        CASE(MOD)
+            R[pc->a] = arith(A_MOD, R[pc->b], R[pc->c]);
+            ++pc;
+            DISPATCH();
+        VM_COMPARE(LT, <, R_LT)
+        VM_COMPARE(LE, <=, R_LE)
+        VM_COMPARE(GT, >, R_GT)
+        VM_COMPARE(GE, >=, R_GE)
+        VM_COMPARE(EQ, ==, R_EQ)
+        VM_COMPARE(NE, !=, R_NE)
+        CASE(NEG)
+            R[pc->a] = negative(R[pc->b]);
+            ++pc;
+            DISPATCH();
+        CASE(POS)
+            if (!is_number(R[pc->b]))
+                value_error("unary + of a non-number");
+            R[pc->a] = R[pc->b];
+            ++pc;
+            DISPATCH();
+        CASE(NOT)
+            R[pc->a] = bool_value(!truth(R[pc->b]));
+            ++pc;
+            DISPATCH();
+        CASE(TRUTH)
+            R[pc->a] = bool_value(truth(R[pc->b]));
+            ++pc;
+            DISPATCH();
+        CASE(JMP)
+            pc = code + pc->b;
+            DISPATCH();
+        CASE(JT)
+            pc = truth(R[pc->a]) ? code + pc->b : pc + 1;
+            DISPATCH();
+        CASE(JF)
+            pc = truth(R[pc->a]) ? pc + 1 : code + pc->b;
+            DISPATCH();
+        CASE(INDEX)
+            R[pc->a] = load_item(R[pc->b].obj, element_index(R[pc->b], R[pc->c]));
+            ++pc;
+            DISPATCH();
+        CASE(SETINDEX)
+            store_item(heap, R[pc->a].obj, element_index(R[pc->a], R[pc->b]), R[pc->c]);
+            ++pc;
+            DISPATCH();
+        CASE(FIELD) {
+            FieldSite& f = m.fields[pc->c];
+            Value r = R[pc->b];
+            R[pc->a] = load_field(r.obj, find_field(r, f.field, f.cache));
+            ++pc;
+            DISPATCH();
+        }
+        CASE(SETFIELD) {
+            FieldSite& f = m.fields[pc->b];
+            Value r = R[pc->a];
+            store_field(heap, r.obj, find_field(r, f.field, f.cache), R[pc->c]);
+            ++pc;
+            DISPATCH();
+        }
+        CASE(RECORD) {
+            const RecordSite& site = m.records[pc->b];
+            Object* o = new_record(heap, site.record);
+            const Value* r = R + pc->c;
+            for (size_t i = 0; i < site.fields.size(); ++i) {
+                unsigned at = site.fields[i];
+                store_item(heap, o, at, as_kind(r[i], site.record->kinds[at]));
+            }
+            R[pc->a] = object_value(o);
+            ++pc;
+            DISPATCH();
+        }
+        CASE(ARRAY)
+            R[pc->a] = make_array(m.arrays[pc->b], R + pc->c);
+            ++pc;
+            DISPATCH();
+        CASE(CALL) {
+            const CallSite& site = m.calls[pc->b];
+            const ProcCode* p = &m.procs[site.proc];
+            Value* regs = R + fp->proc->registers;
+            if (fp + 1 == frames + max_frames)
+                value_error("procedure calls nested too deeply");
+            if (p->registers > (unsigned)(stack + stack_slots - regs))
+                value_error("out of stack");
+            const Value* args = R + pc->c;
+            for (unsigned i = 0; i < p->params; ++i)
+                store(&regs[i], args[i], p->kinds[i]);
+            for (unsigned i = p->params; i < p->slots; ++i)
+                regs[i] = nil_value();
+            Frame* f = fp + 1;
+            f->regs = regs;
+            f->up = fp;
+            for (unsigned h = site.hops; h; --h)
+                f->up = f->up->up;
+            f->proc = p;
+            f->ret = pc + 1;
+            f->dst = pc->a;
+            fp = f;
+            R = regs;
+            pc = code + p->entry;
+            DISPATCH();
+        }
+        CASE(RET) {
+            Value x = R[pc->a];
+            if (fp->proc->result == K_REAL && x.tag == V_INT)
+                x = real_value(x.i);
+            if (fp == frames)
+                goto done;
+            pc = fp->ret;
+            unsigned dst = fp->dst;
+            --fp;
+            R = fp->regs;
+            R[dst] = x;
+            DISPATCH();
+        }
+        CASE(RETNIL) {
+            if (fp == frames)
+                goto done;
+            pc = fp->ret;
+            unsigned dst = fp->dst;
+            --fp;
+            R = fp->regs;
+            R[dst] = nil_value();
+            DISPATCH();
+        }
+        CASE(READ)
+            fflush(out);
+            read_value(in, &R[pc->a], (unsigned char)pc->b);
+            ++pc;
+            DISPATCH();
+        CASE(WRITE)
+            write_value(out, R[pc->a]);
+            ++pc;
+            DISPATCH();
+        CASE(WRITES) {
+            const std::string& s = m.strings[pc->b];
+            fwrite(s.data(), 1, s.size(), out);
+            ++pc;
+            DISPATCH();
+        }
+        CASE(WRITELN)
+            fputc('\n', out);
+            ++pc;
+            DISPATCH();
+        CASE(FORPREP) {
+            Value* r = R + pc->a;
+            if (r[0].tag != V_INT || r[1].tag != V_INT || r[2].tag != V_INT)
+                value_error("FOR bounds and step must be integers");
+            if (r[2].i == 0)
+                value_error("FOR step is zero");
+            bool enter = r[2].i > 0 ? r[0].i <= r[1].i : r[0].i >= r[1].i;
+            pc = enter ? pc + 1 : code + pc->b;
+            DISPATCH();
+        }
+        CASE(FORLOOP) {
+            // the counter was reloaded from the variable, which must still
+            // be an integer; bounds and step are fixed on entry
+            Value* r = R + pc->a;
+            if (r[0].tag != V_INT)
+                value_error("FOR variable assigned a non-integer");
+            long long i = (long long)r[0].i + r[2].i;
+            if (r[2].i > 0 ? i <= r[1].i : i >= r[1].i) {
+                r[0] = int_value((int)i);
+                pc = code + pc->b;
+            } else {
+                ++pc;
+            }
+            DISPATCH();
+        }
+#ifndef VM_COMPUTED_GOTO
+        default:
+            value_error("bad instruction");
+        }
+#endif
+#undef VM_ARITH
+#undef VM_COMPARE
+#undef CASE
+#undef DISPATCH
+    done:
+        steps = n;
+    }
+
+public:
+    VM() : stack(NULL), frames(NULL), steps(0) {}
+
+    ~VM() {
+        delete[] stack;
+        delete[] frames;
+    }
+
+    // runs m; READ and WRITE use the given streams
+    bool run(Module& m, std::string& error, FILE* input = stdin, FILE* output = stdout) {
+        if (!stack) {
+            stack = new Value[stack_slots];
+            frames = new Frame[max_frames];
+        }
+        steps = 0;
+        try {
+            execute(m, input, output);
+            fflush(output);
+            return true;
+        } catch (const InterpError& e) {
+            fflush(output);
+            error = e.message;
+            return false;
+        }
+    }
+
+    // instructions executed by the last run that finished
+    unsigned long long instructions() const {
+        return steps;
+    }
+
+    // bytes of the records and arrays the last run made
+    size_t heap_bytes() const {
+        return heap.bytes_allocated();
+    }
+};
+
+#endif
@@ -0,0 +1,1057 @@
+// x86-64 backend: turns a bytecode Module into GNU assembler text for
+// Linux, to be linked with src/runtime.c. Values stay dynamically typed
+// and NaN-boxed in 64 bits (see the runtime), so the compiled program
+// behaves exactly like the interpreter. The common cases, integer and real
+// arithmetic, comparisons and branches, array indexing and cached field
+// reads, are inline; the rest calls the runtime.
+//
+// Each procedure's bytecode registers are assigned machine registers by
+// linear scan over live intervals; those that get none, and variables
+// that nested procedures reach through the static link, live in the
+// frame (the main program's in pcat_globals).
+#ifndef X86_H
+#define X86_H
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "bytecode.h"
+
+class X86Backend {
+    enum {
+        INT_TAG = 0xFFF9,    // top 16 bits of a boxed value
+        BOOL_TAG = 0xFFFA,
+        NIL_TAG = 0xFFFB,
+        OBJ_TAG = 0xFFFC
+    };
+
+    // allocatable registers: the callee-saved ones first, kept across calls
+    static const int callee_saved = 4;
+    static const int registers = 8;
+
+    static const char* reg_name(int r) {
+        static const char* names[] = {
+            "%rbx", "%r12", "%r13", "%r14", "%r8", "%r9", "%r10", "%r11"
+        };
+        return names[r];
+    }
+
+    struct Interval {
+        unsigned v, start, end;
+    };
+
+    struct Block {
+        unsigned start, end;             // positions [start, end)
+        std::vector<unsigned> succ;
+        std::vector<unsigned long long> use, def, in, out;
+    };
+
+    Module* m;
+    std::string text;        // code of the current function
+    std::string stubs;       // its out-of-line slow paths
+    std::string data;
+    unsigned labels;
+
+    // the procedure being compiled
+    unsigned index;
+    const ProcCode* proc;
+    unsigned entry, length;
+    std::vector<int> reg;              // per bytecode register, -1 for memory
+    std::vector<bool> leader;
+    bool used[registers];
+    unsigned frame;
+    unsigned save_base;
+
+    // variables reached from nested procedures, per depth
+    std::vector<std::set<unsigned> > escaping;
+    std::set<unsigned> globals;        // main program slots used by procedures
+    std::unordered_map<const RecordInfo*, unsigned> record_infos;
+    std::unordered_map<Symbol, unsigned> field_ids;
+
+    X86Backend(const X86Backend&);
+    X86Backend& operator=(const X86Backend&);
+
+    static void append(std::string& s, const char* fmt, va_list ap) {
+        char buf[512];
+        int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        s.append(buf, n < (int)sizeof(buf) ? n : (int)sizeof(buf) - 1);
+    }
+
+    void put(const char* fmt, ...) {
+        va_list ap;
+        va_start(ap, fmt);
+        append(text, fmt, ap);
+        va_end(ap);
+        text += '\n';
+    }
+
+    void stub(const char* fmt, ...) {
+        va_list ap;
+        va_start(ap, fmt);
+        append(stubs, fmt, ap);
+        va_end(ap);
+        stubs += '\n';
+    }
+
+    void put_data(const char* fmt, ...) {
+        va_list ap;
+        va_start(ap, fmt);
+        append(data, fmt, ap);
+        va_end(ap);
+        data += '\n';
+    }
+
+    unsigned label() {
+        return labels++;
+    }
+
+    static unsigned long long boxed(unsigned tag, unsigned long long payload = 0) {
+        return ((unsigned long long)tag << 48) | payload;
+    }
+
+    static unsigned long long bits_of(const Value& k) {
+        switch (k.tag) {
+        case V_INT: return boxed(INT_TAG, (unsigned)k.i);
+        case V_BOOL: return boxed(BOOL_TAG, k.i ? 1 : 0);
+        case V_NIL: return boxed(NIL_TAG);
+        case V_REAL: {
+            unsigned long long bits;
+            memcpy(&bits, &k.r, sizeof(bits));
+            return bits;
+        }
+        default:
+            value_error("no constant objects in native code");
+            return 0;
+        }
+    }
+
+    // ---- analysis ----
+
+    static bool is_branch(unsigned op) {
+        return op == OP_JMP || op == OP_JT || op == OP_JF || op == OP_FORPREP || op == OP_FORLOOP;
+    }
+
+    // instructions that always call into the runtime or another procedure,
+    // clobbering the caller-saved registers
+    static bool is_call(unsigned op) {
+        switch (op) {
+        case OP_RDIV: case OP_DIV: case OP_MOD: case OP_SETFIELD: case OP_RECORD:
+        case OP_ARRAY: case OP_CALL: case OP_READ: case OP_WRITE: case OP_WRITES:
+        case OP_WRITELN:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void find_escaping() {
+        escaping.assign(1, std::set<unsigned>());
+        for (size_t p = 0; p < m->procs.size(); ++p) {
+            const ProcCode& pc = m->procs[p];
+            unsigned end = p + 1 < m->procs.size() ? m->procs[p+1].entry : (unsigned)m->code.size();
+            for (unsigned i = pc.entry; i < end; ++i) {
+                const Insn& in = m->code[i];
+                if (in.op == OP_GETG)
+                    globals.insert(in.b);
+                else if (in.op == OP_SETG)
+                    globals.insert(in.a);
+                else if (in.op == OP_GETO || in.op == OP_SETO) {
+                    // every procedure at that depth, to be safe
+                    unsigned depth = pc.depth - in.c;
+                    if (escaping.size() <= depth)
+                        escaping.resize(depth + 1);
+                    escaping[depth].insert(in.b);
+                }
+            }
+        }
+    }
+
+    bool memory_only(unsigned v) const {
+        if (index == 0)
+            return globals.count(v) != 0;
+        return proc->depth < escaping.size() && escaping[proc->depth].count(v) != 0;
+    }
+
+    std::vector<Block> blocks() {
+        std::vector<unsigned> uses, defs;
+        leader.assign(length + 1, false);
+        leader[0] = true;
+        for (unsigned p = 0; p < length; ++p) {
+            const Insn& in = m->code[entry + p];
+            if (is_branch(in.op))
+                leader[in.b - entry] = true;
+            if (is_branch(in.op) || in.op == OP_RET || in.op == OP_RETNIL)
+                leader[p + 1] = true;
+        }
+        std::vector<unsigned> block_of(length + 1, 0);
+        std::vector<Block> bs;
+        for (unsigned p = 0; p < length; ++p) {
+            if (leader[p]) {
+                if (!bs.empty())
+                    bs.back().end = p;
+                bs.push_back(Block());
+                bs.back().start = p;
+            }
+            block_of[p] = (unsigned)bs.size() - 1;
+        }
+        bs.back().end = length;
+        size_t words = (proc->registers + 63) / 64;
+        for (size_t b = 0; b < bs.size(); ++b) {
+            Block& blk = bs[b];
+            blk.use.assign(words, 0);
+            blk.def.assign(words, 0);
+            blk.in.assign(words, 0);
+            blk.out.assign(words, 0);
+            const Insn& last = m->code[entry + blk.end - 1];
+            if (is_branch(last.op))
+                blk.succ.push_back(block_of[last.b - entry]);
+            if (last.op != OP_JMP && last.op != OP_RET && last.op != OP_RETNIL && blk.end < length)
+                blk.succ.push_back(block_of[blk.end]);
+            for (unsigned p = blk.start; p < blk.end; ++p) {
+                m->operands(m->code[entry + p], uses, defs);
+                for (size_t i = 0; i < uses.size(); ++i)
+                    if (!(blk.def[uses[i] / 64] >> (uses[i] % 64) & 1))
+                        blk.use[uses[i] / 64] |= 1ull << (uses[i] % 64);
+                for (size_t i = 0; i < defs.size(); ++i)
+                    blk.def[defs[i] / 64] |= 1ull << (defs[i] % 64);
+            }
+        }
+        // live variables, backwards to a fixed point
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t b = bs.size(); b > 0; --b) {
+                Block& blk = bs[b-1];
+                for (size_t w = 0; w < words; ++w) {
+                    unsigned long long out = 0;
+                    for (size_t s = 0; s < blk.succ.size(); ++s)
+                        out |= bs[blk.succ[s]].in[w];
+                    unsigned long long in = blk.use[w] | (out & ~blk.def[w]);
+                    if (out != blk.out[w] || in != blk.in[w]) {
+                        blk.out[w] = out;
+                        blk.in[w] = in;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return bs;
+    }
+
+    // one interval per bytecode register, from its first to its last
+    // live position, then linear scan
+    void allocate() {
+        unsigned n = proc->registers;
+        std::vector<unsigned> start(n, ~0u), end(n, 0);
+        std::vector<unsigned> uses, defs;
+        // variables are set at entry
+        for (unsigned v = 0; v < proc->slots; ++v)
+            start[v] = 0;
+        std::vector<Block> bs = blocks();
+        for (size_t b = 0; b < bs.size(); ++b) {
+            for (unsigned v = 0; v < n; ++v) {
+                if (bs[b].in[v / 64] >> (v % 64) & 1) {
+                    start[v] = std::min(start[v], bs[b].start);
+                    end[v] = std::max(end[v], bs[b].start);
+                }
+                if (bs[b].out[v / 64] >> (v % 64) & 1) {
+                    start[v] = std::min(start[v], bs[b].end - 1);
+                    end[v] = std::max(end[v], bs[b].end - 1);
+                }
+            }
+        }
+        std::vector<unsigned> calls(length + 1, 0);  // call points before a position
+        for (unsigned p = 0; p < length; ++p) {
+            m->operands(m->code[entry + p], uses, defs);
+            for (size_t i = 0; i < uses.size(); ++i) {
+                start[uses[i]] = std::min(start[uses[i]], p);
+                end[uses[i]] = std::max(end[uses[i]], p);
+            }
+            for (size_t i = 0; i < defs.size(); ++i) {
+                start[defs[i]] = std::min(start[defs[i]], p);
+                end[defs[i]] = std::max(end[defs[i]], p);
+            }
+            calls[p + 1] = calls[p] + (is_call(m->code[entry + p].op) ? 1 : 0);
+        }
+
+        std::vector<Interval> intervals;
+        for (unsigned v = 0; v < n; ++v) {
+            if (start[v] == ~0u || memory_only(v))
+                continue;
+            Interval i = { v, start[v], end[v] };
+            intervals.push_back(i);
+        }
+        std::stable_sort(intervals.begin(), intervals.end(),
+                         [](const Interval& a, const Interval& b) { return a.start < b.start; });
+
+        reg.assign(n, -1);
+        memset(used, 0, sizeof(used));
+        std::vector<Interval> active;
+        int owner[registers];
+        for (int r = 0; r < registers; ++r)
+            owner[r] = -1;
+        for (size_t k = 0; k < intervals.size(); ++k) {
+            const Interval& cur = intervals[k];
+            for (size_t a = 0; a < active.size(); ) {
+                if (active[a].end < cur.start) {
+                    owner[reg[active[a].v]] = -1;
+                    active.erase(active.begin() + a);
+                } else {
+                    ++a;
+                }
+            }
+            bool crosses = cur.end > cur.start + 1 && calls[cur.end] - calls[cur.start + 1] > 0;
+            int limit = crosses ? callee_saved : registers;
+            int chosen = -1;
+            // caller-saved first, they cost nothing to save
+            for (int r = limit - 1; r >= 0 && chosen < 0; --r)
+                if (owner[r] < 0)
+                    chosen = r;
+            if (chosen < 0) {
+                // spill whichever ends last
+                size_t victim = active.size();
+                for (size_t a = 0; a < active.size(); ++a)
+                    if (reg[active[a].v] < limit &&
+                        (victim == active.size() || active[a].end > active[victim].end))
+                        victim = a;
+                if (victim == active.size() || active[victim].end <= cur.end)
+                    continue;
+                chosen = reg[active[victim].v];
+                reg[active[victim].v] = -1;
+                active.erase(active.begin() + victim);
+            }
+            reg[cur.v] = chosen;
+            owner[chosen] = (int)cur.v;
+            used[chosen] = true;
+            active.push_back(cur);
+        }
+    }
+
+    // ---- code ----
+
+    std::string loc(unsigned v) const {
+        char s[64];
+        if (reg[v] >= 0)
+            return reg_name(reg[v]);
+        if (index == 0)
+            snprintf(s, sizeof(s), "pcat_globals+%u(%%rip)", 8 * v);
+        else
+            snprintf(s, sizeof(s), "-%u(%%rbp)", 16 + 8 * v);
+        return s;
+    }
+
+    void load(unsigned v, const char* r) {
+        put("\tmov %s, %s", loc(v).c_str(), r);
+    }
+
+    void store(const char* r, unsigned v) {
+        put("\tmov %s, %s", r, loc(v).c_str());
+    }
+
+    std::string target(unsigned code_index) const {
+        char s[32];
+        snprintf(s, sizeof(s), ".Lp%u_%u", index, code_index - entry);
+        return s;
+    }
+
+    // jumps to fail unless the value in r has the given tag in its top 32
+    // bits (integers) or 16 bits (the rest); clobbers scratch
+    void check_int(const char* r, const char* scratch, const char* scratch32, const char* fail) {
+        put("\tmov %s, %s", r, scratch);
+        put("\tshr $32, %s", scratch);
+        put("\tcmp $0x%x, %s", INT_TAG << 16, scratch32);
+        put("\tjne %s", fail);
+    }
+
+    void check_object(const char* r, const char* fail) {
+        put("\tmov %s, %%rdx", r);
+        put("\tshr $48, %%rdx");
+        put("\tcmp $0x%x, %%edx", OBJ_TAG);
+        put("\tjne %s", fail);
+        put("\tmov %s, %%rdx", r);
+        put("\tshl $16, %%rdx");
+        put("\tshr $16, %%rdx");
+    }
+
+    // an int in rax becomes a real
+    void to_real() {
+        put("\tmov %%rax, %%rdx");
+        put("\tshr $32, %%rdx");
+        put("\tcmp $0x%x, %%edx", INT_TAG << 16);
+        put("\tjne 1f");
+        put("\tcvtsi2sd %%eax, %%xmm0");
+        put("\tmovq %%xmm0, %%rax");
+        put("1:");
+    }
+
+    // a boolean in rax is checked and turned into 0 or 1
+    void unbox_bool() {
+        put("\tmovabs $0x%llx, %%rdx", boxed(BOOL_TAG));
+        put("\txor %%rdx, %%rax");
+        put("\tcmp $1, %%rax");
+        put("\tja .Lnot_boolean");
+    }
+
+    std::string new_label() {
+        char s[32];
+        snprintf(s, sizeof(s), ".Ls%u", label());
+        return s;
+    }
+
+    void save_caller_saved() {
+        stub("\tpush %%r8\n\tpush %%r9\n\tpush %%r10\n\tpush %%r11");
+    }
+
+    void restore_caller_saved() {
+        stub("\tpop %%r11\n\tpop %%r10\n\tpop %%r9\n\tpop %%r8");
+    }
+
+    static const char* condition(unsigned op, bool negate) {
+        static const char* yes[] = { "l", "le", "g", "ge", "e", "ne" };
+        static const char* no[] = { "ge", "g", "le", "l", "ne", "e" };
+        return negate ? no[op - OP_LT] : yes[op - OP_LT];
+    }
+
+    // in a stub: the numbers in rax and rcx as doubles in xmm0 and xmm1,
+    // on to otherwise if either is something else
+    void stub_doubles(const std::string& otherwise) {
+        std::string a_int = new_label(), b = new_label(), b_int = new_label(), both = new_label();
+        stub("\tcmp %%r15, %%rax\n\tjae %s\n\tmovq %%rax, %%xmm0\n\tjmp %s", a_int.c_str(), b.c_str());
+        stub("%s:\n\tmov %%rax, %%rdx\n\tshr $48, %%rdx\n\tcmp $0x%x, %%edx\n\tjne %s",
+             a_int.c_str(), INT_TAG, otherwise.c_str());
+        stub("\tcvtsi2sd %%eax, %%xmm0");
+        stub("%s:\n\tcmp %%r15, %%rcx\n\tjae %s\n\tmovq %%rcx, %%xmm1\n\tjmp %s",
+             b.c_str(), b_int.c_str(), both.c_str());
+        stub("%s:\n\tmov %%rcx, %%rdx\n\tshr $48, %%rdx\n\tcmp $0x%x, %%edx\n\tjne %s",
+             b_int.c_str(), INT_TAG, otherwise.c_str());
+        stub("\tcvtsi2sd %%ecx, %%xmm1");
+        stub("%s:", both.c_str());
+    }
+
+    // the slow path of a comparison: rax and rcx hold the operands, rax
+    // gets the boxed result; numbers and same-typed references inline
+    void compare_stub(unsigned op, const std::string& slow, const std::string& done) {
+        static const char* real_set[] = { "seta", "setae", "seta", "setae", "sete", "setne" };
+        std::string call = new_label(), refs = new_label(), boxit = new_label();
+        stub("%s:", slow.c_str());
+        stub_doubles(refs);
+        if (op == OP_LT || op == OP_LE)
+            stub("\tucomisd %%xmm0, %%xmm1");
+        else
+            stub("\tucomisd %%xmm1, %%xmm0");
+        stub("\t%s %%al", real_set[op - OP_LT]);
+        if (op == OP_EQ)
+            stub("\tsetnp %%dl\n\tand %%dl, %%al");
+        else if (op == OP_NE)
+            stub("\tsetp %%dl\n\tor %%dl, %%al");
+        stub("\tjmp %s", boxit.c_str());
+        stub("%s:", refs.c_str());
+        if (op == OP_EQ || op == OP_NE) {
+            // booleans with booleans, NIL and objects with each other
+            stub("\tmovabs $0x%llx, %%rdx\n\tcmp %%rdx, %%rax\n\tjb %s", boxed(BOOL_TAG), call.c_str());
+            stub("\tcmp %%rdx, %%rcx\n\tjb %s", call.c_str());
+            stub("\tmov %%rax, %%rdx\n\tmov %%rcx, %%rsi\n\tshr $48, %%rdx\n\tshr $48, %%rsi");
+            stub("\tcmp $0x%x, %%edx\n\tsete %%dl\n\tcmp $0x%x, %%esi\n\tsete %%sil\n\tcmp %%sil, %%dl",
+                 BOOL_TAG, BOOL_TAG);
+            stub("\tjne %s", call.c_str());
+            stub("\tcmp %%rcx, %%rax\n\tset%s %%al", op == OP_EQ ? "e" : "ne");
+            stub("\tjmp %s", boxit.c_str());
+        }
+        stub("%s:", call.c_str());
+        save_caller_saved();
+        stub("\tmov %%rcx, %%rdx\n\tmov %%rax, %%rsi\n\tmov $%u, %%edi", op - OP_LT);
+        stub("\tcall pcat_compare");
+        restore_caller_saved();
+        stub("\tjmp %s", done.c_str());
+        stub("%s:", boxit.c_str());
+        stub("\tmovzbl %%al, %%eax\n\tmovabs $0x%llx, %%rdx\n\tor %%rdx, %%rax", boxed(BOOL_TAG));
+        stub("\tjmp %s", done.c_str());
+    }
+
+    void arith(const Insn& in) {
+        static const char* int_op[] = { "addl", "subl", "imull" };
+        static const char* real_op[] = { "addsd", "subsd", "mulsd" };
+        unsigned k = in.op - OP_ADD;
+        load(in.b, "%rax");
+        load(in.c, "%rcx");
+        std::string slow = new_label(), done = new_label(), call = new_label();
+        check_int("%rax", "%rdx", "%edx", slow.c_str());
+        check_int("%rcx", "%rdx", "%edx", slow.c_str());
+        put("\t%s %%ecx, %%eax", int_op[k]);
+        put("\tor %%r15, %%rax");
+        put("%s:", done.c_str());
+        store("%rax", in.a);
+        stub("%s:", slow.c_str());
+        stub_doubles(call);
+        stub("\t%s %%xmm1, %%xmm0\n\tmovq %%xmm0, %%rax", real_op[k]);
+        stub("\tjmp %s", done.c_str());
+        stub("%s:", call.c_str());
+        save_caller_saved();
+        stub("\tmov %%rcx, %%rdx\n\tmov %%rax, %%rsi\n\tmov $%u, %%edi\n\tcall pcat_arith", k);
+        restore_caller_saved();
+        stub("\tjmp %s", done.c_str());
+    }
+
+    // a comparison; fused with the JT or JF after it when that is the only
+    // reader of the result
+    void compare(unsigned p, const Insn& in) {
+        const Insn* next = p + 1 < length ? &m->code[entry + p + 1] : NULL;
+        bool fuse = next && (next->op == OP_JF || next->op == OP_JT) && next->a == in.a &&
+                    !leader[p + 1] && in.a >= proc->slots && !live_after(in.a, p + 1);
+        load(in.b, "%rax");
+        load(in.c, "%rcx");
+        std::string slow = new_label(), done = new_label();
+        check_int("%rax", "%rdx", "%edx", slow.c_str());
+        check_int("%rcx", "%rdx", "%edx", slow.c_str());
+        put("\tcmp %%ecx, %%eax");
+        if (fuse) {
+            bool jf = next->op == OP_JF;
+            std::string to = target(next->b), after = new_label();
+            put("\tj%s %s", condition(in.op, jf), to.c_str());
+            put("%s:", after.c_str());
+            compare_stub(in.op, slow, done);
+            stub("%s:", done.c_str());
+            stub("\tmovabs $0x%llx, %%rdx\n\tcmp %%rdx, %%rax", boxed(BOOL_TAG, 1));
+            stub("\tj%s %s\n\tjmp %s", jf ? "ne" : "e", to.c_str(), after.c_str());
+            skip = true;
+            return;
+        }
+        put("\tset%s %%al", condition(in.op, false));
+        put("\tmovzbl %%al, %%eax");
+        put("\tmovabs $0x%llx, %%rdx", boxed(BOOL_TAG));
+        put("\tor %%rdx, %%rax");
+        put("%s:", done.c_str());
+        store("%rax", in.a);
+        compare_stub(in.op, slow, done);
+    }
+
+    std::vector<unsigned> last_use;    // per bytecode register, the last position it is live
+    bool skip;                         // the next instruction was fused into this one
+
+    bool live_after(unsigned v, unsigned p) const {
+        return last_use[v] > p;
+    }
+
+    void index_checks(const std::string& fail) {
+        // rax the array, rcx the index; rdx the object, rsi the index
+        check_object("%rax", fail.c_str());
+        put("\tcmpq $0, (%%rdx)");
+        put("\tjne %s", fail.c_str());
+        check_int("%rcx", "%rsi", "%esi", fail.c_str());
+        put("\tmov %%ecx, %%esi");
+        put("\tcmp 8(%%rdx), %%esi");
+        put("\tjae %s", fail.c_str());
+        stub("%s:", fail.c_str());
+        stub("\tmov %%rax, %%rdi\n\tmov %%rcx, %%rsi\n\tand $-16, %%rsp\n\tcall pcat_index_fail");
+    }
+
+    unsigned field_id(Symbol field) {
+        std::unordered_map<Symbol, unsigned>::iterator it = field_ids.find(field);
+        if (it != field_ids.end())
+            return it->second;
+        unsigned id = (unsigned)field_ids.size();
+        field_ids[field] = id;
+        put_data(".Lfield%u:", id);
+        put_data("\t.asciz \"%s\"", name_of(field).c_str());
+        return id;
+    }
+
+    unsigned record_info(const RecordInfo* r) {
+        std::unordered_map<const RecordInfo*, unsigned>::iterator it = record_infos.find(r);
+        if (it != record_infos.end())
+            return it->second;
+        unsigned k = (unsigned)record_infos.size();
+        record_infos[r] = k;
+        std::vector<unsigned> ids;
+        for (size_t i = 0; i < r->fields.size(); ++i)
+            ids.push_back(field_id(r->fields[i]));
+        put_data("\t.p2align 3");
+        put_data(".Lri%u:", k);
+        put_data("\t.quad .Lrn%u, %u, .Lrk%u, .Lrf%u", k, (unsigned)r->fields.size(), k, k);
+        put_data(".Lrn%u:", k);
+        put_data("\t.asciz \"%s\"", name_of(r->name).c_str());
+        put_data(".Lrk%u:", k);
+        for (size_t i = 0; i < r->kinds.size(); ++i)
+            put_data("\t.byte %u", r->kinds[i]);
+        put_data("\t.p2align 3");
+        put_data(".Lrf%u:", k);
+        for (size_t i = 0; i < ids.size(); ++i)
+            put_data("\t.quad %u", ids[i]);
+        return k;
+    }
+
+    // the field, record and array sites the code refers to
+    void tables() {
+        for (size_t f = 0; f < m->fields.size(); ++f) {
+            // a cached record type of 1 never matches
+            unsigned id = field_id(m->fields[f].field);
+            put_data("\t.p2align 3");
+            put_data(".Lfs%u:", (unsigned)f);
+            put_data("\t.quad 1, 0, %u, .Lfield%u", id, id);
+        }
+        for (size_t k = 0; k < m->records.size(); ++k) {
+            const RecordSite& site = m->records[k];
+            unsigned info = record_info(site.record);
+            put_data("\t.p2align 3");
+            put_data(".Lrs%u:", (unsigned)k);
+            put_data("\t.quad .Lri%u, %u, .Lrsf%u", info, (unsigned)site.fields.size(), (unsigned)k);
+            put_data(".Lrsf%u:", (unsigned)k);
+            for (size_t i = 0; i < site.fields.size(); ++i)
+                put_data("\t.quad %u", site.fields[i]);
+        }
+        for (size_t k = 0; k < m->arrays.size(); ++k) {
+            const ArraySite& site = m->arrays[k];
+            put_data("\t.p2align 3");
+            put_data(".Las%u:", (unsigned)k);
+            put_data("\t.quad %u, .Laso%u", (unsigned)site.of.size(), (unsigned)k);
+            put_data(".Laso%u:", (unsigned)k);
+            for (size_t i = 0; i < site.of.size(); ++i)
+                put_data("\t.byte %u", site.of[i] ? 1 : 0);
+            put_data("\t.p2align 3");
+        }
+    }
+
+    // values for a call, record or array go to the bottom of the frame
+    void outgoing(unsigned base, unsigned n) {
+        for (unsigned i = 0; i < n; ++i) {
+            if (reg[base + i] >= 0) {
+                put("\tmov %s, %u(%%rsp)", reg_name(reg[base + i]), 8 * i);
+            } else {
+                load(base + i, "%rax");
+                put("\tmov %%rax, %u(%%rsp)", 8 * i);
+            }
+        }
+    }
+
+    void instruction(unsigned p) {
+        const Insn& in = m->code[entry + p];
+        switch (in.op) {
+        case OP_LOADK: {
+            unsigned long long bits = bits_of(m->constants[in.b]);
+            if (reg[in.a] >= 0) {
+                put("\tmovabs $0x%llx, %s", bits, reg_name(reg[in.a]));
+            } else {
+                put("\tmovabs $0x%llx, %%rax", bits);
+                store("%rax", in.a);
+            }
+            break;
+        }
+        case OP_MOVE:
+            if (reg[in.a] >= 0) {
+                load(in.b, reg_name(reg[in.a]));
+            } else if (reg[in.b] >= 0) {
+                store(reg_name(reg[in.b]), in.a);
+            } else {
+                load(in.b, "%rax");
+                store("%rax", in.a);
+            }
+            break;
+        case OP_GETG:
+            put("\tmov pcat_globals+%u(%%rip), %%rax", 8 * in.b);
+            store("%rax", in.a);
+            break;
+        case OP_SETG:
+            load(in.b, "%rax");
+            put("\tmov %%rax, pcat_globals+%u(%%rip)", 8 * in.a);
+            break;
+        case OP_GETO:
+        case OP_SETO:
+            put("\tmov -8(%%rbp), %%rdx");
+            for (unsigned h = 1; h < in.c; ++h)
+                put("\tmov -8(%%rdx), %%rdx");
+            if (in.op == OP_GETO) {
+                put("\tmov -%u(%%rdx), %%rax", 16 + 8 * in.b);
+                store("%rax", in.a);
+            } else {
+                load(in.a, "%rax");
+                put("\tmov %%rax, -%u(%%rdx)", 16 + 8 * in.b);
+            }
+            break;
+        case OP_REAL:
+            load(in.a, "%rax");
+            to_real();
+            store("%rax", in.a);
+            break;
+        case OP_ADD: case OP_SUB: case OP_MUL:
+            arith(in);
+            break;
+        case OP_RDIV: case OP_DIV: case OP_MOD:
+            load(in.b, "%rsi");
+            load(in.c, "%rdx");
+            put("\tmov $%u, %%edi", in.op - OP_ADD);
+            put("\tcall pcat_arith");
+            store("%rax", in.a);
+            break;
+        case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+            compare(p, in);
+            break;
+        case OP_NEG: {
+            std::string slow = new_label(), done = new_label(), call = new_label();
+            load(in.b, "%rax");
+            check_int("%rax", "%rdx", "%edx", slow.c_str());
+            put("\tnegl %%eax");
+            put("\tor %%r15, %%rax");
+            put("%s:", done.c_str());
+            store("%rax", in.a);
+            stub("%s:", slow.c_str());
+            stub("\tcmp %%r15, %%rax\n\tjae %s\n\tbtc $63, %%rax\n\tjmp %s", call.c_str(), done.c_str());
+            stub("%s:", call.c_str());
+            stub("\tmov %%rax, %%rdi\n\tand $-16, %%rsp\n\tcall pcat_negative");
+            break;
+        }
+        case OP_POS:
+            load(in.b, "%rax");
+            put("\tmovabs $0x%llx, %%rdx", boxed(BOOL_TAG));
+            put("\tcmp %%rdx, %%rax");
+            put("\tjae .Lnot_number");
+            store("%rax", in.a);
+            break;
+        case OP_NOT:
+            load(in.b, "%rax");
+            unbox_bool();
+            put("\txor $1, %%rax");
+            put("\tor %%rdx, %%rax");
+            store("%rax", in.a);
+            break;
+        case OP_TRUTH:
+            load(in.b, "%rax");
+            unbox_bool();
+            put("\tor %%rdx, %%rax");
+            store("%rax", in.a);
+            break;
+        case OP_JMP:
+            put("\tjmp %s", target(in.b).c_str());
+            break;
+        case OP_JT:
+        case OP_JF:
+            load(in.a, "%rax");
+            unbox_bool();
+            put("\ttest %%rax, %%rax");
+            put("\tj%s %s", in.op == OP_JT ? "nz" : "z", target(in.b).c_str());
+            break;
+        case OP_INDEX: {
+            load(in.b, "%rax");
+            load(in.c, "%rcx");
+            index_checks(new_label());
+            put("\tmov 16(%%rdx,%%rsi,8), %%rax");
+            store("%rax", in.a);
+            break;
+        }
+        case OP_SETINDEX: {
+            load(in.a, "%rax");
+            load(in.b, "%rcx");
+            index_checks(new_label());
+            load(in.c, "%rdi");
+            put("\tmov %%rdi, 16(%%rdx,%%rsi,8)");
+            break;
+        }
+        case OP_FIELD: {
+            unsigned f = in.c;
+            std::string slow = new_label(), done = new_label();
+            load(in.b, "%rax");
+            check_object("%rax", slow.c_str());
+            put("\tmov (%%rdx), %%rsi");
+            put("\tcmp .Lfs%u(%%rip), %%rsi", f);
+            put("\tjne %s", slow.c_str());
+            put("\tmov .Lfs%u+8(%%rip), %%rsi", f);
+            put("\tmov (%%rdx,%%rsi), %%rax");
+            put("%s:", done.c_str());
+            store("%rax", in.a);
+            stub("%s:", slow.c_str());
+            save_caller_saved();
+            stub("\tlea .Lfs%u(%%rip), %%rdi\n\tmov %%rax, %%rsi\n\tcall pcat_field", f);
+            restore_caller_saved();
+            stub("\tmov (%%rax), %%rax\n\tjmp %s", done.c_str());
+            break;
+        }
+        case OP_SETFIELD: {
+            unsigned f = in.b;
+            load(in.a, "%rsi");
+            load(in.c, "%rdx");
+            put("\tlea .Lfs%u(%%rip), %%rdi", f);
+            put("\tcall pcat_set_field");
+            break;
+        }
+        case OP_RECORD: {
+            outgoing(in.c, (unsigned)m->records[in.b].fields.size());
+            put("\tlea .Lrs%u(%%rip), %%rdi", in.b);
+            put("\tmov %%rsp, %%rsi");
+            put("\tcall pcat_new_record");
+            store("%rax", in.a);
+            break;
+        }
+        case OP_ARRAY: {
+            outgoing(in.c, m->arrays[in.b].registers);
+            put("\tlea .Las%u(%%rip), %%rdi", in.b);
+            put("\tmov %%rsp, %%rsi");
+            put("\tcall pcat_new_array");
+            store("%rax", in.a);
+            break;
+        }
+        case OP_CALL: {
+            const CallSite& site = m->calls[in.b];
+            outgoing(in.c, m->procs[site.proc].params);
+            // the static link: this frame, or the one hops levels out
+            if (site.hops == 0) {
+                put("\tmov %%rbp, %%rdi");
+            } else {
+                put("\tmov -8(%%rbp), %%rdi");
+                for (unsigned h = 1; h < site.hops; ++h)
+                    put("\tmov -8(%%rdi), %%rdi");
+            }
+            put("\tcall pcat_p%u", site.proc);
+            store("%rax", in.a);
+            break;
+        }
+        case OP_RET:
+            load(in.a, "%rax");
+            if (proc->result == K_REAL)
+                to_real();
+            put("\tjmp .Lret%u", index);
+            break;
+        case OP_RETNIL:
+            put("\tmovabs $0x%llx, %%rax", boxed(NIL_TAG));
+            put("\tjmp .Lret%u", index);
+            break;
+        case OP_READ:
+            put("\tmov $%u, %%edi", in.b);
+            load(in.a, "%rsi");
+            put("\tcall pcat_read");
+            store("%rax", in.a);
+            break;
+        case OP_WRITE:
+            load(in.a, "%rdi");
+            put("\tcall pcat_write");
+            break;
+        case OP_WRITES:
+            put("\tlea .Lstr%u(%%rip), %%rdi", in.b);
+            put("\tmov $%u, %%esi", (unsigned)m->strings[in.b].size());
+            put("\tcall pcat_write_string");
+            break;
+        case OP_WRITELN:
+            put("\tcall pcat_writeln");
+            break;
+        case OP_FORPREP: {
+            std::string fail = new_label();
+            load(in.a, "%rax");
+            load(in.a + 1, "%rcx");
+            load(in.a + 2, "%rdx");
+            check_int("%rax", "%rsi", "%esi", fail.c_str());
+            check_int("%rcx", "%rsi", "%esi", fail.c_str());
+            check_int("%rdx", "%rsi", "%esi", fail.c_str());
+            put("\ttest %%edx, %%edx");
+            put("\tje %s", fail.c_str());
+            put("\tjs 1f");
+            put("\tcmp %%ecx, %%eax");
+            put("\tjg %s", target(in.b).c_str());
+            put("\tjmp 2f");
+            put("1:");
+            put("\tcmp %%ecx, %%eax");
+            put("\tjl %s", target(in.b).c_str());
+            put("2:");
+            stub("%s:", fail.c_str());
+            stub("\tmov %%rax, %%rdi\n\tmov %%rcx, %%rsi\n\tand $-16, %%rsp\n\tcall pcat_for_fail");
+            break;
+        }
+        case OP_FORLOOP:
+            // bounds and step were checked by FORPREP, the counter was
+            // reloaded from the variable
+            load(in.a, "%rax");
+            check_int("%rax", "%rsi", "%esi", ".Lfor_variable");
+            load(in.a + 1, "%rcx");
+            load(in.a + 2, "%rdx");
+            put("\tmovslq %%eax, %%rax");
+            put("\tmovslq %%ecx, %%rcx");
+            put("\tmovslq %%edx, %%rdx");
+            put("\tadd %%rdx, %%rax");
+            put("\ttest %%rdx, %%rdx");
+            put("\tjs 1f");
+            put("\tcmp %%rcx, %%rax");
+            put("\tjg 2f");
+            put("\tjmp 3f");
+            put("1:");
+            put("\tcmp %%rcx, %%rax");
+            put("\tjl 2f");
+            put("3:");
+            put("\tmov %%eax, %%eax");
+            put("\tor %%r15, %%rax");
+            store("%rax", in.a);
+            put("\tjmp %s", target(in.b).c_str());
+            put("2:");
+            break;
+        default:
+            value_error("bad instruction");
+        }
+    }
+
+    void function(unsigned p) {
+        index = p;
+        proc = &m->procs[p];
+        entry = proc->entry;
+        unsigned end = p + 1 < m->procs.size() ? m->procs[p+1].entry : (unsigned)m->code.size();
+        length = end - entry;
+        text.clear();
+        stubs.clear();
+        allocate();
+
+        // last live position per register, for fusing compares and branches
+        last_use.assign(proc->registers, 0);
+        std::vector<unsigned> uses, defs;
+        std::vector<Block> bs = blocks();
+        for (unsigned q = 0; q < length; ++q) {
+            m->operands(m->code[entry + q], uses, defs);
+            for (size_t i = 0; i < uses.size(); ++i)
+                last_use[uses[i]] = std::max(last_use[uses[i]], q);
+        }
+        for (size_t b = 0; b < bs.size(); ++b)
+            for (unsigned v = 0; v < proc->registers; ++v)
+                if (bs[b].out[v / 64] >> (v % 64) & 1)
+                    last_use[v] = std::max(last_use[v], bs[b].end);
+
+        unsigned out = 0;
+        for (unsigned q = entry; q < end; ++q) {
+            const Insn& in = m->code[q];
+            if (in.op == OP_CALL)
+                out = std::max(out, m->procs[m->calls[in.b].proc].params);
+            else if (in.op == OP_RECORD)
+                out = std::max(out, (unsigned)m->records[in.b].fields.size());
+            else if (in.op == OP_ARRAY)
+                out = std::max(out, m->arrays[in.b].registers);
+        }
+        // static link, homes (the main program's are in pcat_globals),
+        // five saved registers and the outgoing values
+        save_base = index == 0 ? 8 : 8 + 8 * proc->registers;
+        frame = (save_base + 8 * 5 + 8 * out + 15) & ~15u;
+
+        const char* name = index == 0 ? "pcat_main" : NULL;
+        char buf[32];
+        if (!name) {
+            snprintf(buf, sizeof(buf), "pcat_p%u", index);
+            name = buf;
+        }
+        put("\t.p2align 4");
+        if (index == 0)
+            put("\t.globl pcat_main");
+        put("%s:", name);
+        put("\tpush %%rbp");
+        put("\tmov %%rsp, %%rbp");
+        put("\tsub $%u, %%rsp", frame);
+        put("\tcmp pcat_stack_limit(%%rip), %%rsp");
+        put("\tjb .Ltoo_deep");
+        put("\tmov %%rdi, -8(%%rbp)");
+        for (int r = 0; r < callee_saved; ++r)
+            if (used[r])
+                put("\tmov %s, -%u(%%rbp)", reg_name(r), save_base + 8 * (r + 1));
+        if (index == 0) {
+            put("\tmov %%r15, -%u(%%rbp)", save_base + 8 * 5);
+            put("\tmovabs $0x%llx, %%r15", boxed(INT_TAG));
+        }
+        // locals start as NIL
+        unsigned locals = proc->slots - proc->params;
+        if (locals) {
+            if (index == 0)
+                put("\tlea pcat_globals(%%rip), %%rdi");
+            else
+                put("\tlea -%u(%%rbp), %%rdi", 16 + 8 * (proc->slots - 1));
+            put("\tmov $%u, %%ecx", locals);
+            put("\tmovabs $0x%llx, %%rax", boxed(NIL_TAG));
+            put("\trep stosq");
+            for (unsigned v = proc->params; v < proc->slots; ++v)
+                if (reg[v] >= 0)
+                    put("\tmov %%rax, %s", reg_name(reg[v]));
+        }
+        for (unsigned i = 0; i < proc->params; ++i) {
+            put("\tmov %u(%%rbp), %%rax", 16 + 8 * i);
+            if (proc->kinds[i] == K_REAL)
+                to_real();
+            store("%rax", i);
+        }
+
+        skip = false;
+        for (unsigned q = 0; q < length; ++q) {
+            if (leader[q])
+                put(".Lp%u_%u:", index, q);
+            if (skip) {
+                skip = false;
+                continue;
+            }
+            instruction(q);
+        }
+
+        put(".Lret%u:", index);
+        for (int r = 0; r < callee_saved; ++r)
+            if (used[r])
+                put("\tmov -%u(%%rbp), %s", save_base + 8 * (r + 1), reg_name(r));
+        if (index == 0)
+            put("\tmov -%u(%%rbp), %%r15", save_base + 8 * 5);
+        put("\tleave");
+        put("\tret");
+    }
+
+    static std::string escape(const std::string& s) {
+        std::string e;
+        for (size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = (unsigned char)s[i];
+            if (c == '"' || c == '\\') {
+                e += '\\';
+                e += (char)c;
+            } else if (c < 32 || c > 126) {
+                char oct[8];
+                snprintf(oct, sizeof(oct), "\\%03o", c);
+                e += oct;
+            } else {
+                e += (char)c;
+            }
+        }
+        return e;
+    }
+
+public:
+    X86Backend() : m(NULL), labels(0), index(0), proc(NULL), entry(0), length(0),
+                   frame(0), save_base(0), skip(false) {}
+
+    // the assembly for m; false with error set if it cannot be compiled
+    bool compile(Module& module, std::string& out, std::string& error) {
+        m = &module;
+        try {
+            find_escaping();
+            tables();
+            out = "\t.text\n";
+            for (unsigned p = 0; p < m->procs.size(); ++p) {
+                function(p);
+                out += text;
+                out += stubs;
+            }
+            // shared failure paths; they do not return
+            out += ".Lnot_boolean:\n\tand $-16, %rsp\n\tcall pcat_not_boolean\n";
+            out += ".Lnot_number:\n\tand $-16, %rsp\n\tcall pcat_not_number\n";
+            out += ".Lfor_variable:\n\tand $-16, %rsp\n\tcall pcat_for_variable\n";
+            out += ".Ltoo_deep:\n\tand $-16, %rsp\n\tcall pcat_too_deep\n";
+
+            out += "\t.section .rodata\n";
+            for (size_t i = 0; i < m->strings.size(); ++i) {
+                char s[32];
+                snprintf(s, sizeof(s), ".Lstr%u:\n", (unsigned)i);
+                out += s;
+                out += "\t.ascii \"" + escape(m->strings[i]) + "\"\n";
+            }
+            out += "\t.data\n\t.p2align 3\n";
+            out += data;
+            char bss[96];
+            snprintf(bss, sizeof(bss), "\t.bss\n\t.p2align 4\npcat_globals:\n\t.zero %u\n",
+                     8 * (m->procs[0].registers ? m->procs[0].registers : 1));
+            out += bss;
+            out += "\t.section .note.GNU-stack,\"\",@progbits\n";
+            return true;
+        } catch (const InterpError& e) {
+            error = e.message;
+            return false;
+        }
+    }
+};
+
+#endif
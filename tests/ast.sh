@@ -0,0 +1,88 @@
+#!/bin/sh
+# checks --emit-ast and --load-ast: a saved tree prints as the parse it
+# came from, and a saved tree damaged in one place, a node's kind or one
+# of its children, is either printed or refused as not a saved tree,
+# quickly and without a crash. One with its numbers misaligned is refused.
+#
+#   tests/ast.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+status=0
+# the unsigned at byte offset $2 of file $1
+get32() {
+    od -An -tu4 -j "$2" -N4 "$1" | tr -d " "
+}
+
+# writes the $3 bytes of number $4, little endian, at byte offset $2 of $1
+put() {
+    i=0
+    v=$4
+    while [ $i -lt "$3" ]; do
+        printf "\\$(printf %o $((v % 256)))"
+        v=$((v / 256))
+        i=$((i + 1))
+    done | dd of="$1" bs=1 seek="$2" conv=notrunc 2> /dev/null
+}
+
+# loads the damaged copy $DIR/bad.ast; what was changed is in $1
+load_damaged() {
+    timeout 10 "$MAIN" --load-ast "$DIR/bad.ast" > /dev/null 2>&1
+    rc=$?
+    # printed, or refused with -1
+    if [ $rc != 0 ] && [ $rc != 255 ]; then
+        echo "$f: $1: --load-ast exits with $rc"
+        status=1
+    fi
+}
+
+for f in tests/test05.pcat tests/test17.pcat bench/interp/records.pcat; do
+    "$MAIN" "$f" > "$DIR/parsed.out"
+    "$MAIN" --emit-ast "$DIR/good.ast" "$f" > /dev/null
+    "$MAIN" --load-ast "$DIR/good.ast" > "$DIR/loaded.out"
+    if ! cmp -s "$DIR/parsed.out" "$DIR/loaded.out"; then
+        echo "$f: the saved tree prints differently"
+        status=1
+        continue
+    fi
+    # the header: nodes, then where the kinds and the children are
+    nodes=$(get32 "$DIR/good.ast" 8)
+    kid_count=$(get32 "$DIR/good.ast" 12)
+    kind_at=$(get32 "$DIR/good.ast" 32)
+    kids_at=$(get32 "$DIR/good.ast" 48)
+    # the numbers half an 8-byte word off, where a double can't be read
+    literals_at=$(get32 "$DIR/good.ast" 60)
+    cp "$DIR/good.ast" "$DIR/bad.ast"
+    put "$DIR/bad.ast" 60 4 $((literals_at + 4))
+    timeout 10 "$MAIN" --load-ast "$DIR/bad.ast" > /dev/null 2>&1
+    rc=$?
+    if [ $rc != 255 ]; then
+        echo "$f: numbers at a misaligned offset: --load-ast exits with $rc"
+        status=1
+    fi
+    n=0
+    while [ $n -lt "$nodes" ]; do
+        # a list, a body, a call expression
+        for kind in 0 6 35; do
+            cp "$DIR/good.ast" "$DIR/bad.ast"
+            put "$DIR/bad.ast" $((kind_at + n)) 1 $kind
+            load_damaged "node $n made kind $kind"
+        done
+        n=$((n + 1))
+    done
+    k=0
+    while [ $k -lt "$kid_count" ]; do
+        child=$(get32 "$DIR/good.ast" $((kids_at + 4 * k)))
+        # another node, the one before, absent
+        for to in $(((child + 1) % nodes)) $(((child + nodes - 1) % nodes)) 4294967295; do
+            cp "$DIR/good.ast" "$DIR/bad.ast"
+            put "$DIR/bad.ast" $((kids_at + 4 * k)) 4 $to
+            load_damaged "child $k made $to"
+        done
+        k=$((k + 1))
+    done
+done
+
+[ $status = 0 ] && echo "saved trees load, damaged ones are refused"
+exit $status
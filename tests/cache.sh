@@ -0,0 +1,54 @@
+#!/bin/sh
+# checks --cache: the second run of a program is a hit and prints the tree
+# the first parsed, and an entry damaged in one byte, anywhere, is a miss
+# that parses the program again.
+#
+#   tests/cache.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+status=0
+# writes byte $3 at byte offset $2 of file $1
+put8() {
+    printf "\\$(printf %o "$3")" | dd of="$1" bs=1 seek="$2" conv=notrunc 2> /dev/null
+}
+
+for f in tests/test05.pcat tests/test17.pcat bench/interp/records.pcat; do
+    rm -rf "$DIR/cache"
+    "$MAIN" "$f" > "$DIR/plain.out"
+    "$MAIN" --cache "$DIR/cache" "$f" > /dev/null 2>&1
+    "$MAIN" --cache "$DIR/cache" "$f" > "$DIR/hit.out" 2> "$DIR/hit.err"
+    if ! grep -q "^cache: 1 hits, 0 misses" "$DIR/hit.err" ||
+       ! cmp -s "$DIR/plain.out" "$DIR/hit.out"; then
+        echo "$f: the second run is not the same tree from the cache"
+        status=1
+        continue
+    fi
+    entry=$(ls "$DIR"/cache/*.ast)
+    cp "$entry" "$DIR/good.ast"
+    size=$(wc -c < "$DIR/good.ast" | tr -d " ")
+    at=0
+    while [ $at -lt "$size" ]; do
+        cp "$DIR/good.ast" "$entry"
+        byte=$(od -An -tu1 -j $at -N1 "$DIR/good.ast" | tr -d " ")
+        put8 "$entry" $at $(((byte + 1) % 256))
+        timeout 10 "$MAIN" --cache "$DIR/cache" "$f" > "$DIR/out" 2> "$DIR/err"
+        rc=$?
+        if [ $rc != 0 ]; then
+            echo "$f: byte $at damaged: exits with $rc"
+            status=1
+        elif ! grep -q "^cache: 0 hits, 1 misses" "$DIR/err"; then
+            echo "$f: byte $at damaged: still a hit"
+            status=1
+        elif ! cmp -s "$DIR/plain.out" "$DIR/out"; then
+            echo "$f: byte $at damaged: prints another tree"
+            status=1
+        fi
+        # a byte in 7 reaches every array without a run per byte
+        at=$((at + 7))
+    done
+done
+
+[ $status = 0 ] && echo "cached trees are the parsed trees, damaged ones are misses"
+exit $status
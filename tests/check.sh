@@ -0,0 +1,108 @@
+#!/bin/sh
+# runs --check on small programs and compares what it reports with the
+# problem each one has, at the ln:col it starts, or nothing for the correct
+# ones; then checks that the programs the engines are compared on pass,
+# that a tree from the cache reports the same and that batches report the
+# first problem of each file.
+#
+#   tests/check.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+status=0
+# declarations, statements, then the expected report
+while IFS='|' read -r decls stats want; do
+    printf 'PROGRAM IS\n%s\nBEGIN\n%s\nEND;\n' "$decls" "$stats" > "$DIR/prog.pcat"
+    got=$("$MAIN" --check "$DIR/prog.pcat")
+    if [ "$got" != "$want" ]; then
+        echo "PROGRAM IS $decls BEGIN $stats END;"
+        echo "  expected: $want"
+        echo "  got:      $got"
+        status=1
+    fi
+done <<'END'
+VAR X : INTEGER := 1; VAR R : REAL := X;|R := X * 2 + R / X; X := X DIV 2 MOD 3;|
+VAR R : REAL := 1;|WRITE(R + 1, 1 = 1.0, 2 < R, -R, +1);|
+VAR X : INTEGER := 1.5;||2:20 program: initial value is REAL, not INTEGER
+VAR X := NIL;||2:5 program: a variable initialized to NIL needs a declared type
+VAR X := 1; VAR Y := X + 0.5;|X := Y;|4:6 program: assigned value is REAL, not INTEGER
+VAR X : INTEGER := 0;|Y := 1;|4:1 program: Y is not declared
+VAR X : INTEGER := 0;|X := 1; X := 2; WRITE(X + Z);|4:27 program: Z is not declared
+VAR X : INTEGER := 0; VAR X : REAL := 0.0;||2:27 program: X is declared twice in the same scope
+VAR X : INTEGER := 0; PROCEDURE P() IS VAR X : REAL := 1.0; BEGIN X := 0.5; END;|X := 1;|
+VAR B : BOOLEAN := TRUE;|B := (1 < 2) AND B OR NOT B; B := B = FALSE;|
+VAR B : BOOLEAN := TRUE;|B := B + 1;|4:8 program: + of BOOLEAN and INTEGER, not numbers
+VAR B : BOOLEAN := 1;||2:20 program: initial value is INTEGER, not BOOLEAN
+VAR X : INTEGER := 0;|X := 7 DIV 2.0;|4:8 program: DIV of INTEGER and REAL, not INTEGER
+VAR X : INTEGER := 0;|X := 7 / 2;|4:6 program: assigned value is REAL, not INTEGER
+VAR X : INTEGER := 0;|IF X THEN X := 1; ELSIF X > 0 THEN X := 2; END;|4:4 program: condition is INTEGER, not BOOLEAN
+VAR X : INTEGER := 0;|WHILE NOT X DO END;|4:7 program: NOT of INTEGER
+VAR X : INTEGER := 0;|TRUE := FALSE;|4:1 program: TRUE is not a variable
+VAR X : INTEGER := 0;|EXIT;|4:1 program: EXIT outside a loop
+VAR X : INTEGER := 0;|LOOP IF X > 3 THEN EXIT; END; X := X + 1; END;|
+VAR R : REAL := 0.0;|FOR R := 1 TO 3 DO END;|4:5 program: FOR variable R is not an INTEGER variable
+VAR I : INTEGER := 0;|FOR I := 1 TO 3.5 DO EXIT; END;|4:15 program: FOR bound is REAL, not INTEGER
+PROCEDURE F(X : INTEGER; Y : REAL) : REAL IS BEGIN RETURN X + Y; END;|WRITE(F(1, 2), F(1, 2.5));|
+PROCEDURE F(X : INTEGER) : REAL IS BEGIN RETURN X; END;|WRITE(F(1.5));|4:9 program: argument 1 of F is REAL, not INTEGER
+PROCEDURE F(X : INTEGER) : REAL IS BEGIN RETURN X; END;|WRITE(F());|4:7 program: F takes 1 arguments, not 0
+PROCEDURE P() IS BEGIN END;|WRITE(P());|4:7 program: P does not return a value
+PROCEDURE P() IS BEGIN RETURN 1; END;|P();|2:24 procedure P: RETURN with a value from a procedure without a result
+PROCEDURE F() : INTEGER IS BEGIN RETURN; END;|F();|2:34 procedure F: RETURN without a value
+VAR X : INTEGER := 0;|X();|4:1 program: X is not a procedure
+VAR X : INTEGER := 0;|Q(X);|4:1 program: procedure Q is not declared
+PROCEDURE P() IS BEGIN Q(); END; PROCEDURE Q() IS BEGIN P(); END;|P();|
+PROCEDURE P() IS PROCEDURE Q() IS BEGIN END; BEGIN Q(); END;|Q();|4:1 program: procedure Q is not declared
+TYPE R IS RECORD X : REAL; NEXT : R; END; VAR Q : R := R { X := 1; NEXT := NIL };|Q.NEXT := Q; Q.NEXT.X := Q.X + 1; WRITE(Q.X, Q = NIL, Q <> Q.NEXT);|
+TYPE R IS RECORD X : REAL; END; VAR Q : R := R { Y := 1 };||2:50 program: R has no field Y
+TYPE R IS RECORD X : REAL; END; VAR Q : R := NIL;|Q.Y := 1;|4:3 program: R has no field Y
+TYPE R IS RECORD X : REAL; X : INTEGER; END;||2:28 program: R has two fields named X
+TYPE R IS RECORD X : BOOLEAN; END; VAR Q : R := R { X := 1 };||2:58 program: field X is INTEGER, not BOOLEAN
+TYPE R IS RECORD X : REAL; END; VAR Q : R := NIL;|WRITE(Q);|4:7 program: WRITE of R
+TYPE R IS RECORD X : REAL; END; VAR Q : R := NIL;|READ(Q.X, Q);|4:11 program: READ into R, not a number
+VAR X : INTEGER := 0;|X.Y := 1;|4:3 program: field Y of INTEGER, not a record
+TYPE A IS ARRAY OF REAL; VAR V : A := A [< 2 OF 0, 1.5 >];|V[1] := V[0] + 1; V := NIL;|
+TYPE A IS ARRAY OF INTEGER; VAR V : A := A [< 2.5 OF 0 >];||2:47 program: array count is REAL, not INTEGER
+TYPE A IS ARRAY OF INTEGER; VAR V : A := A [< TRUE >];||2:47 program: array element is BOOLEAN, not INTEGER
+TYPE A IS ARRAY OF INTEGER; VAR V : A := NIL;|V[TRUE] := 1;|4:3 program: array index is BOOLEAN, not INTEGER
+VAR X : INTEGER := 0;|X[0] := 1;|4:1 program: indexing INTEGER, not an array
+TYPE A IS ARRAY OF INTEGER; TYPE B IS ARRAY OF INTEGER; VAR X : A := NIL; VAR Y : B := NIL;|X := Y;|4:6 program: assigned value is B, not A
+TYPE A IS ARRAY OF INTEGER; TYPE B IS A; VAR X : A := NIL; VAR Y : B := NIL;|X := Y; WRITE(X = Y);|
+TYPE A IS ARRAY OF INTEGER; TYPE R IS RECORD X : A; END; VAR Q : R := NIL;|WRITE(Q = Q.X);|4:9 program: comparing R and A
+TYPE A IS B; TYPE B IS A;||2:11 program: type A is defined in terms of itself
+VAR X : T := NIL;||2:9 program: type T is not declared
+VAR X : INTEGER := 0; VAR Y : X := 0;||2:31 program: X is not a type
+TYPE R IS RECORD X : REAL; END;|WRITE(R [< 1 >]);|4:7 program: R is not an array type
+END
+
+# the programs the execution engines run are correct
+for f in tests/semantics.pcat tests/test05.pcat bench/interp/*.pcat; do
+    out=$("$MAIN" --check "$f")
+    if [ $? != 0 ] || [ -n "$out" ]; then
+        echo "$f: $out"
+        status=1
+    fi
+done
+
+# the positions are saved with the tree
+printf 'PROGRAM IS\n  VAR X : INTEGER := 0;\nBEGIN\n  X := 1; EXIT;\nEND;\n' > "$DIR/prog.pcat"
+"$MAIN" --check --cache "$DIR/cache" "$DIR/prog.pcat" > /dev/null 2>&1
+got=$("$MAIN" --check --cache "$DIR/cache" "$DIR/prog.pcat" 2> /dev/null)
+if [ "$got" != "4:11 program: EXIT outside a loop" ]; then
+    echo "--check from the cache: $got"
+    status=1
+fi
+
+# a batch reports the first problem and how many more there are
+printf 'PROGRAM IS BEGIN X := 1; Y := 2; END;\n' > "$DIR/bad.pcat"
+printf 'PROGRAM IS VAR X := 1; BEGIN X := 2; END;\n' > "$DIR/good.pcat"
+"$MAIN" --check -j 2 "$DIR" > "$DIR/batch.out"
+if [ $? = 0 ] || ! grep -q "bad.pcat: 1:18 program: X is not declared (and 1 more)$" "$DIR/batch.out" ||
+   ! grep -q "good.pcat: ok$" "$DIR/batch.out"; then
+    echo "--check on a batch:"
+    cat "$DIR/batch.out"
+    status=1
+fi
+
+[ $status = 0 ] && echo "semantic checks report what they should"
+exit $status
@@ -0,0 +1,104 @@
+#!/bin/sh
+# parses programs with syntax and lexical errors and checks that one run
+# reports every error, each at the line and column of the token at fault,
+# after comments and strings over several lines, tabs, stray characters
+# and numbers out of range; and that a batch reports the first error of
+# each file and how many more there are.
+#
+#   tests/errors.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+status=0
+# program (printf escapes), then the errors expected as "ln:col message"
+expect() {
+    printf "$1" > "$DIR/prog.pcat"
+    got=$("$MAIN" "$DIR/prog.pcat" |
+          sed -n 's/^EEK, parse error! Position: \([0-9]*:[0-9]*\) token: .*  Message: /\1 /p')
+    if [ "$got" != "$2" ]; then
+        printf "%s\n" "$1"
+        echo "  expected: $2" | sed '2,$s/^/            /'
+        echo "  got:      $got" | sed '2,$s/^/            /'
+        status=1
+    fi
+}
+
+# a ';' missing after END is one error, the loop or procedure is closed
+expect 'PROGRAM IS\nBEGIN\n    WHILE X DO X := 1; END\n    WRITE(X);\nEND;\n' \
+'4:5 syntax error, unexpected WRITE, expecting ;'
+expect 'PROGRAM IS
+    PROCEDURE P() IS BEGIN EXIT; END
+    VAR X : INTEGER := 1;
+BEGIN
+    LOOP EXIT; END
+    X := 1 +;
+    P();
+END;
+' '3:5 syntax error, unexpected VAR, expecting ;
+6:5 syntax error, unexpected IDENTIFIER, expecting ;
+6:13 syntax error, unexpected ;'
+
+# one per statement, declaration and bracketed expression
+expect 'PROGRAM IS
+    VAR X : INTEGER := 1 +;
+    VAR Y : INTEGER := 2;
+    TYPE T IS ARRAY INTEGER;
+    PROCEDURE P(A : ) IS BEGIN X := A; END;
+BEGIN
+    X := (1 + ) * 2;
+    IF X + THEN Y := 1; ELSIF Y > 1 THEN Y := 2; END;
+    WHILE X < DO X := X - 1; END;
+    Y := X;; WRITE(Z 1);
+    F(1, ,2);
+    Y := X [< 1 OF >];
+END;
+' '2:27 syntax error, unexpected ;
+4:21 syntax error, unexpected TYPES, expecting OF
+5:21 syntax error, unexpected ), expecting TYPES or IDENTIFIER or ARRAY or RECORD
+7:15 syntax error, unexpected )
+8:12 syntax error, unexpected THEN
+9:15 syntax error, unexpected DO
+10:12 syntax error, unexpected ;
+10:22 syntax error, unexpected INTEGER, expecting "," or )
+11:10 syntax error, unexpected ","
+12:20 syntax error, unexpected >]'
+
+# positions after comments and strings spanning lines and after tabs
+expect '(* a comment\n   over (* three *\n   lines *) PROGRAM IS BEGIN\n\tX := 1 (* *) Y := 2;\n    WRITE("a\nb", 1 2); END;\n' \
+'4:22 syntax error, unexpected IDENTIFIER
+6:7 syntax error, unexpected INTEGER, expecting "," or )'
+
+# a comment ends at the first *), code between two comments is code
+expect 'PROGRAM IS (* a *) BEGIN X := 1; (* b *) X := 2 END;\n' \
+'1:49 syntax error, unexpected END'
+
+expect 'PROGRAM IS BEGIN\n  X := 1 @ 2; Y := 3 $;\nEND;\n' \
+'2:10 unexpected character
+2:12 syntax error, unexpected INTEGER
+2:22 unexpected character'
+
+expect 'PROGRAM IS BEGIN\n  X := 1;\n  (* never closed\nEND;\n' \
+'3:3 unterminated comment
+5:1 syntax error, unexpected end of file'
+
+# a literal out of range, at the literal; the largest integer is not
+expect 'PROGRAM IS BEGIN\n  X := 2147483647;\n  X := 2147483648 + 1.0;\nEND;\n' \
+'3:8 integer out of range'
+
+# a correct program reports nothing
+expect 'PROGRAM IS\r\n(* a\r\n *) BEGIN\r\n  WRITE("ok");\r\nEND;\r\n' ''
+
+# a batch reports the first error and how many more there are
+printf 'PROGRAM IS BEGIN X := ; Y := ; END;\n' > "$DIR/bad.pcat"
+printf 'PROGRAM IS BEGIN X := 1; END;\n' > "$DIR/good.pcat"
+"$MAIN" -j 2 "$DIR" > "$DIR/batch.out"
+if [ $? = 0 ] || ! grep -q "bad.pcat: EEK, parse error! Position: 1:23 .* (and 1 more)$" "$DIR/batch.out" ||
+   ! grep -q "good.pcat: ok$" "$DIR/batch.out"; then
+    echo "a batch:"
+    cat "$DIR/batch.out"
+    status=1
+fi
+
+[ $status = 0 ] && echo "syntax errors are all reported where they are"
+exit $status
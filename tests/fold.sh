@@ -0,0 +1,122 @@
+#!/bin/sh
+# checks --fold: arithmetic on numbers becomes the number it gives, what
+# run time would refuse is left alone, and overflow is reported at the
+# operator. Folding changes no result: every benchmark prints the same on
+# the VM, every program checks the same, and the class tree, a streamed
+# and a parallel parse fold the same.
+#
+#   tests/fold.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+status=0
+# program (printf escapes), then the initializers of its variables as
+# the folded tree prints them, one line each
+expect() {
+    printf "$1" > "$DIR/prog.pcat"
+    got=$("$MAIN" --fold "$DIR/prog.pcat" | awk '
+        /initializer/ { getline; sub(/^ */, ""); print }')
+    if [ "$got" != "$2" ]; then
+        printf "%s\n" "$1"
+        echo "  expected: $2" | sed '2,$s/^/            /'
+        echo "  got:      $got" | sed '2,$s/^/            /'
+        status=1
+    fi
+}
+
+expect 'PROGRAM IS
+    VAR A := 2 * 3 + 4;
+    VAR B := ((1 + 2) * 3 - 4) DIV 5;
+    VAR C := -7 MOD 3 - -(7 DIV -2);
+    VAR D := 1 / 4 + 0.5;
+    VAR E := 2 * 0.25;
+    VAR F := 0.1 + 0.2;
+    VAR G := +-2147483647 - 1;
+BEGIN END;
+' 'number 10
+number 1
+number -4
+number 0.75
+number 0.5
+number 0.30000000000000004
+number -2147483648'
+
+# run time errors and what makes no number stay as they are
+expect 'PROGRAM IS
+    VAR A := 1 DIV 0;
+    VAR B := 1.5 MOD 2;
+    VAR C := 2 / 0;
+    VAR D := 1 + X;
+    VAR E := NOT 1;
+    VAR F := 1 < 2;
+BEGIN END;
+' 'binary operator expression
+binary operator expression
+binary operator expression
+binary operator expression
+unary operator expression
+binary operator expression'
+
+# overflow at the operator, of a literal at the literal
+printf 'PROGRAM IS\n    VAR A := 2147483647 + 1;\nBEGIN\n    A := 3 * (-2147483647 - 1 - 1);\n    A := 2147483648;\nEND;\n' \
+    > "$DIR/over.pcat"
+got=$("$MAIN" --fold "$DIR/over.pcat" |
+      sed -n 's/^EEK, parse error! Position: \([0-9]*:[0-9]*\) token: .*  Message: /\1 /p')
+if [ "$got" != "2:25 constant out of range
+4:31 constant out of range
+5:10 integer out of range" ]; then
+    echo "overflow reported as: $got"
+    status=1
+fi
+
+# an array of constants folds to one number for each count and value
+awk 'BEGIN {
+    print "PROGRAM IS"
+    print "    TYPE T IS ARRAY OF INTEGER;"
+    printf "    VAR A := T [< 10 * 10 OF -1"
+    for (i = 0; i < 200; i++) printf ", (%d + 1) * 2 - %d", i, i
+    print " >];"
+    print "BEGIN WRITE(A[0], A[150]); END;"
+}' > "$DIR/table.pcat"
+"$MAIN" --fold --stats-json "$DIR/fold.json" "$DIR/table.pcat" > /dev/null
+classes=$(grep '"node_classes"' "$DIR/fold.json")
+if echo "$classes" | grep -q 'OpExpr' || ! echo "$classes" | grep -q '"NumberExpr": 204,'; then
+    echo "a table of constants did not fold to its numbers: $classes"
+    status=1
+fi
+if [ "$("$MAIN" --vm "$DIR/table.pcat")" != "$("$MAIN" --fold --vm "$DIR/table.pcat")" ]; then
+    echo "a folded table holds other values"
+    status=1
+fi
+
+for f in tests/*.pcat bench/interp/*.pcat "$DIR/table.pcat"; do
+    "$MAIN" --fold "$f" > "$DIR/flat.out" 2>&1
+    for how in --tree --stream "-j 2 --parallel"; do
+        "$MAIN" --fold $how "$f" > "$DIR/other.out" 2>&1
+        grep -q "^EEK" "$DIR/flat.out" && [ "$how" = --stream ] && continue
+        if ! cmp -s "$DIR/flat.out" "$DIR/other.out"; then
+            echo "$f: --fold $how folds otherwise"
+            diff "$DIR/flat.out" "$DIR/other.out" | head -6
+            status=1
+        fi
+    done
+    "$MAIN" --check "$f" > "$DIR/plain.out" 2>&1
+    "$MAIN" --fold --check "$f" > "$DIR/folded.out" 2>&1
+    if ! cmp -s "$DIR/plain.out" "$DIR/folded.out"; then
+        echo "$f: --fold checks otherwise"
+        diff "$DIR/plain.out" "$DIR/folded.out" | head -6
+        status=1
+    fi
+done
+for f in bench/interp/*.pcat; do
+    "$MAIN" --vm "$f" < /dev/null > "$DIR/plain.out" 2>&1
+    "$MAIN" --fold --vm "$f" < /dev/null > "$DIR/folded.out" 2>&1
+    if ! cmp -s "$DIR/plain.out" "$DIR/folded.out"; then
+        echo "$f: --fold runs otherwise"
+        status=1
+    fi
+done
+
+[ $status = 0 ] && echo "folded constants are the values they stand for"
+exit $status
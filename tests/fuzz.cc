@@ -0,0 +1,731 @@
+// fuzzing harness for the scanner and the parser, in the manner of
+// libFuzzer. LLVMFuzzerTestOneInput runs one input through the target
+// FUZZ_TARGET names (lexer or parser, the parser by default); built with
+// -DFUZZ_LIBFUZZER and -fsanitize=fuzzer it is libFuzzer's entry point:
+//
+//   clang++ -std=c++11 -g -O1 -fsanitize=fuzzer,address -DFUZZ_LIBFUZZER
+//       -I src -I build build/main.cc src/lexer.cpp tests/fuzz.cc -o fuzz
+//
+// Built without, main() fuzzes offline. It mutates the seeds with a
+// mutator that knows PCAT's tokens and brackets and runs every input in
+// this process under a time limit and a limit on the memory each input
+// may take, both enforced while it runs. It keeps the inputs that
+// crash, time out, run out of memory or disagree, and those that take far
+// longer per token or byte than the seeds do. Each target checks two ways
+// of doing the same thing: the lexer scans the input in place and through
+// stdio, and the parser parses it whole and as a Document of pieces (see
+// document.h). Both must give the same result.
+//
+//   fuzz [-target=lexer|parser] [-runs=N] [-seed=S] [-max_len=BYTES]
+//        [-timeout=SECONDS] [-rss_limit_mb=MB] [-slow_factor=F]
+//        [-artifact_prefix=DIR/] seed files or directories...
+//
+// Directories give their .pcat files.
+// With -runs=0 only the seeds are run, which replays a saved input.
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "syntax.h"
+#define YYSTYPE SemValue
+#include "main.tab.h"
+#include "flat_dump.h"
+#include "document.h"
+
+using namespace std;
+
+// what one input did
+struct Outcome {
+    unsigned long long tokens;
+    double seconds;      // of the timed pass: scanning, or the whole parse
+    string signature;    // the first error without its position, "ok" if none
+    string problem;      // how the two ways disagree, empty if they agree
+};
+
+// the message of a parse error without where it is
+static string message_of(const string& error) {
+    size_t at = error.find("Message: ");
+    return at == string::npos ? error : error.substr(at + 9);
+}
+
+static string signature_of(const vector<string>& errors) {
+    return errors.empty() ? "ok" : message_of(errors[0]);
+}
+
+// the tokens of one scan, one line each, then its errors
+static string scan(ParseContext& ctx, unsigned long long& tokens) {
+    ostringstream out;
+    SemValue value;
+    int code;
+    while ((code = yylex(&value, ctx.scanner)) != 0) {
+        ++tokens;
+        out << ctx.tok_ln << ":" << ctx.tok_col << " " << code << " "
+            << yyget_text(ctx.scanner) << "\n";
+    }
+    for (size_t i = 0; i < ctx.errors.size(); ++i)
+        out << ctx.errors[i] << "\n";
+    return out.str();
+}
+
+static Outcome run_lexer(const char* data, size_t size) {
+    Outcome o;
+    o.tokens = 0;
+    string text(data, size);
+    text.append(2, '\0');
+    string in_place;
+    {
+        ParseContext ctx;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        scan_in_place(ctx.scanner, &text[0], size);
+        in_place = scan(ctx, o.tokens);
+        o.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        o.signature = signature_of(ctx.errors);
+    }
+    FILE* f = tmpfile();
+    if (!f || fwrite(data, 1, size, f) != size) {
+        o.problem = "can't write a temporary file";
+        if (f)
+            fclose(f);
+        return o;
+    }
+    rewind(f);
+    ParseContext ctx;
+    scan_file(ctx.scanner, f);
+    unsigned long long tokens = 0;
+    string through_stdio = scan(ctx, tokens);
+    fclose(f);
+    if (in_place != through_stdio)
+        o.problem = "scanned in place and through stdio, the tokens differ";
+    return o;
+}
+
+static string dump(const FlatView& v) {
+    Dumper out;
+    dump_flat(v, out);
+    return out.str();
+}
+
+static Outcome run_parser(const char* data, size_t size) {
+    Outcome o;
+    o.tokens = 0;
+    string text(data, size);
+    text.append(2, '\0');
+    {
+        // the throughput is per token, counted apart from the timed parse
+        ParseContext ctx;
+        ctx.scan_only = true;
+        scan_in_place(ctx.scanner, &text[0], size);
+        SemValue value;
+        while (yylex(&value, ctx.scanner) != 0)
+            ++o.tokens;
+    }
+    ParseContext ctx;
+    bool ok;
+    {
+        ArenaScope scope(ctx.arena);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        scan_in_place(ctx.scanner, &text[0], size);
+        yyparse(ctx.scanner);
+        o.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ok = ctx.error.empty() && ctx.flat.has_root();
+    }
+    o.signature = signature_of(ctx.errors);
+    Document doc;
+    doc.set(string(data, size));
+    FlatAst pieces;
+    if (doc.tree(pieces) != ok)
+        o.problem = ok ? "parsed whole it has a tree, as a document it has none"
+                       : "parsed whole it has errors, as a document it has a tree";
+    else if (ok && dump(ctx.flat.view()) != dump(pieces.view()))
+        o.problem = "parsed whole and as a document, the trees differ";
+    return o;
+}
+
+static bool parser_target() {
+    const char* t = getenv("FUZZ_TARGET");
+    return !t || strcmp(t, "lexer") != 0;
+}
+
+static Outcome run_target(bool parser, const char* data, size_t size) {
+    return parser ? run_parser(data, size) : run_lexer(data, size);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static bool parser = parser_target();
+    Outcome o = run_target(parser, (const char*)data, size);
+    if (!o.problem.empty()) {
+        fprintf(stderr, "%s\n", o.problem.c_str());
+        abort();
+    }
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+// ---- the mutator ----
+
+// a token of an input, as the scanner spells it; code 0 for text of the
+// mutator's that the scanner need not take as one token
+struct Token {
+    int code;
+    string text;
+};
+typedef vector<Token> Tokens;
+
+static Tokens tokenize(const string& input) {
+    Tokens out;
+    string text = input;
+    text.append(2, '\0');
+    ParseContext ctx;
+    ctx.scan_only = true;
+    scan_in_place(ctx.scanner, &text[0], input.size());
+    SemValue value;
+    int code;
+    while ((code = yylex(&value, ctx.scanner)) != 0) {
+        Token t = { code, yyget_text(ctx.scanner) };
+        out.push_back(t);
+    }
+    return out;
+}
+
+// the closing bracket or END that goes with an opening one, NULL if none
+static const char* closer(const string& s) {
+    static const char* const pairs[][2] = {
+        { "(", ")" }, { "[", "]" }, { "{", "}" }, { "[<", ">]" },
+        { "BEGIN", "END" }, { "IF", "END" }, { "WHILE", "END" }, { "LOOP", "END" },
+        { "FOR", "END" }, { "RECORD", "END" }
+    };
+    for (size_t i = 0; i < sizeof(pairs) / sizeof(pairs[0]); ++i)
+        if (s == pairs[i][0])
+            return pairs[i][1];
+    return NULL;
+}
+
+class Mutator {
+    mt19937 rng;
+    vector<Tokens> pool;               // seeds, then inputs that did something new
+    map<int, vector<string> > spellings;  // per token code, as the seeds spell them
+    vector<Token> every;               // one of each spelling, to insert anywhere
+    size_t max_len;
+
+    size_t pick(size_t n) {
+        return n ? (size_t)(rng() % n) : 0;
+    }
+
+    bool chance(unsigned percent) {
+        return rng() % 100 < percent;
+    }
+
+    // where the bracket at i closes, or i if it does not
+    size_t match(const Tokens& t, size_t i) {
+        const char* close = closer(t[i].text);
+        if (!close)
+            return i;
+        // brackets of other kinds are not counted, every opener that END
+        // closes is
+        int depth = 0;
+        for (size_t j = i; j < t.size(); ++j) {
+            const char* c = closer(t[j].text);
+            if (c && !strcmp(c, close))
+                ++depth;
+            else if (t[j].text == close && --depth == 0)
+                return j;
+        }
+        return i;
+    }
+
+    Token literal(const string& text) {
+        Token t = { 0, text };
+        return t;
+    }
+
+    string run_of(const char* unit, size_t n) {
+        string s;
+        for (size_t i = 0; i < n; ++i)
+            s += unit;
+        return s;
+    }
+
+    // a fragment scanners and parsers are known to be slow or fragile on
+    Token pathological() {
+        size_t n = 1 + pick(max_len / 4);
+        switch (pick(8)) {
+        case 0: return literal("\"" + string(n, 'x'));               // unterminated string
+        case 1: return literal("(*" + run_of("* (", n / 3));         // unterminated comment
+        case 2: return literal(string(n, '9'));                       // integer far out of range
+        case 3: return literal(string(n, '7') + "." + string(n, '1'));
+        case 4: return literal("X" + string(n, 'A'));                // a long identifier
+        case 5: return literal(run_of("(* *)", n / 5));               // many comments
+        case 6: return literal(run_of("\"\"", n / 2));                // many empty strings
+        default: return literal(string(n, pick(2) ? '\n' : '\t'));
+        }
+    }
+
+    void mutate_once(Tokens& t) {
+        size_t at = pick(t.size() + 1);
+        switch (pick(10)) {
+        case 0: {
+            // the same kind of token, spelled otherwise
+            if (at == t.size())
+                return;
+            const vector<string>& same = spellings[t[at].code];
+            if (!same.empty())
+                t[at].text = same[pick(same.size())];
+            return;
+        }
+        case 1:
+            // any token the seeds have
+            if (!every.empty())
+                t.insert(t.begin() + at, every[pick(every.size())]);
+            return;
+        case 2: {
+            size_t n = 1 + pick(8);
+            t.erase(t.begin() + at, t.begin() + min(t.size(), at + n));
+            return;
+        }
+        case 3: {
+            // a bracketed stretch or a few tokens, repeated
+            if (at == t.size())
+                return;
+            size_t end = match(t, at);
+            if (end == at)
+                end = min(t.size() - 1, at + pick(6));
+            Tokens span(t.begin() + at, t.begin() + end + 1);
+            size_t times = 1 + pick(chance(10) ? 2000 : 8);
+            for (size_t i = 0; i < times && t.size() < max_len; ++i)
+                t.insert(t.begin() + end + 1, span.begin(), span.end());
+            return;
+        }
+        case 4: {
+            // a stretch of another input
+            const Tokens& other = pool[pick(pool.size())];
+            if (other.empty())
+                return;
+            size_t from = pick(other.size());
+            size_t n = 1 + pick(min<size_t>(other.size() - from, 64));
+            t.insert(t.begin() + at, other.begin() + from, other.begin() + from + n);
+            return;
+        }
+        case 5: {
+            // nesting: a bracketed stretch, or one token, in many parentheses
+            if (at == t.size())
+                return;
+            size_t end = match(t, at);
+            size_t depth = 1 + pick(chance(20) ? 20000 : 16);
+            Tokens open(depth, literal("(")), close(depth, literal(")"));
+            t.insert(t.begin() + end + 1, close.begin(), close.end());
+            t.insert(t.begin() + at, open.begin(), open.end());
+            return;
+        }
+        case 6: {
+            // statements nested in statements
+            size_t depth = 1 + pick(chance(20) ? 20000 : 16);
+            Tokens nest;
+            for (size_t i = 0; i < depth; ++i) {
+                const char* heads[] = { "IF TRUE THEN", "WHILE FALSE DO", "LOOP" };
+                nest.push_back(literal(heads[pick(3)]));
+            }
+            for (size_t i = 0; i < depth; ++i)
+                nest.push_back(literal("END;"));
+            t.insert(t.begin() + at, nest.begin(), nest.end());
+            return;
+        }
+        case 7:
+            t.insert(t.begin() + at, pathological());
+            return;
+        case 8: {
+            // a byte of a token changed, to anything but NUL
+            if (at == t.size() || t[at].text.empty())
+                return;
+            t[at].text[pick(t[at].text.size())] = (char)(1 + pick(255));
+            t[at].code = 0;
+            return;
+        }
+        default:
+            // cut off, also inside what is open
+            t.resize(at);
+            return;
+        }
+    }
+
+public:
+    Mutator(unsigned seed, size_t _max_len) : rng(seed), max_len(_max_len) {}
+
+    void add(const string& input) {
+        Tokens t = tokenize(input);
+        for (size_t i = 0; i < t.size(); ++i) {
+            vector<string>& same = spellings[t[i].code];
+            if (find(same.begin(), same.end(), t[i].text) == same.end()) {
+                same.push_back(t[i].text);
+                every.push_back(t[i]);
+            }
+        }
+        pool.push_back(t);
+    }
+
+    size_t size() const {
+        return pool.size();
+    }
+
+    // a new input from one in the pool, with one mutation or several
+    string next() {
+        Tokens t = pool[pick(pool.size())];
+        for (size_t n = 1 + pick(4); n; --n)
+            mutate_once(t);
+        string out;
+        for (size_t i = 0; i < t.size() && out.size() < max_len; ++i) {
+            if (i)
+                out += chance(10) ? '\n' : ' ';
+            out += t[i].text;
+        }
+        if (out.size() > max_len)
+            out.resize(max_len);
+        return out;
+    }
+};
+
+// ---- the driver ----
+
+static const char* artifact_prefix = "";
+// the input being run, and where the signal handlers save it
+static const string* current = NULL;
+static string crash_path, timeout_path, oom_path;
+static int timeout_seconds = 10;
+static long rss_limit_mb = 2048;
+
+// writes what the handlers save without anything that is not
+// async-signal-safe
+static void save_raw(const char* path, const char* what) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0 && current) {
+        ssize_t n = write(fd, current->data(), current->size());
+        (void)n;
+        close(fd);
+    }
+    ssize_t n = write(2, what, strlen(what));
+    n = write(2, path, strlen(path));
+    n = write(2, "\n", 1);
+    (void)n;
+}
+
+static void on_timeout(int) {
+    save_raw(timeout_path.c_str(), "==fuzz== the input ran past -timeout, saved to ");
+    _exit(70);
+}
+
+static void on_crash(int sig) {
+    save_raw(crash_path.c_str(), "==fuzz== the input crashed, saved to ");
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void install_handlers() {
+    // deep recursion overflows the stack, the handler needs one of its own
+    static char alt[1 << 16];
+    stack_t ss;
+    ss.ss_sp = alt;
+    ss.ss_size = sizeof(alt);
+    ss.ss_flags = 0;
+    sigaltstack(&ss, NULL);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_crash;
+    sa.sa_flags = SA_ONSTACK;
+    int crashes[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+    for (size_t i = 0; i < sizeof(crashes) / sizeof(crashes[0]); ++i)
+        sigaction(crashes[i], &sa, NULL);
+    sa.sa_handler = on_timeout;
+    sigaction(SIGALRM, &sa, NULL);
+}
+
+static void arm_timer(int seconds) {
+    struct itimerval t;
+    memset(&t, 0, sizeof(t));
+    t.it_value.tv_sec = seconds;
+    setitimer(ITIMER_REAL, &t, NULL);
+}
+
+// the peak resident memory of this process so far
+static long peak_rss_mb() {
+    struct rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    return u.ru_maxrss / 1024;
+}
+
+// the resident memory of this process now. The peak only grows, so it
+// would blame every input after the first large one; an input is charged
+// for what it adds to what was resident when it started.
+static long rss_mb() {
+    char buf[64];
+    int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0)
+        return 0;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+        return 0;
+    buf[n] = 0;
+    char* p = buf;
+    strtol(p, &p, 10);                  // the size, then what is resident
+    return strtol(p, NULL, 10) * sysconf(_SC_PAGESIZE) >> 20;
+}
+
+// the input being run: what was resident when it started, -1 between
+// inputs, and the most it has added since
+static mutex rss_lock;
+static long rss_base = -1, rss_grown = 0;
+
+// samples the memory every 10 ms while an input runs and stops the fuzzer,
+// the input saved, as soon as it takes more than -rss_limit_mb
+static void watch_rss() {
+    for (;;) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        lock_guard<mutex> hold(rss_lock);
+        if (rss_base < 0)
+            continue;
+        rss_grown = max(rss_grown, rss_mb() - rss_base);
+        if (rss_grown > rss_limit_mb) {
+            save_raw(oom_path.c_str(), "==fuzz== the input took more than -rss_limit_mb, saved to ");
+            _exit(1);
+        }
+    }
+}
+
+static void begin_input(const string& input) {
+    lock_guard<mutex> hold(rss_lock);
+    current = &input;
+    rss_base = rss_mb();
+    rss_grown = 0;
+    arm_timer(timeout_seconds);
+}
+
+// what the input added to the resident memory, at the most
+static long end_input() {
+    arm_timer(0);
+    lock_guard<mutex> hold(rss_lock);
+    long grown = max(rss_grown, rss_mb() - rss_base);
+    rss_base = -1;
+    return grown;
+}
+
+static bool save(const string& name, const string& input) {
+    string path = artifact_prefix + name;
+    ofstream out(path.c_str(), ios::binary);
+    out << input;
+    cerr << "==fuzz== saved to " << path << endl;
+    return (bool)out;
+}
+
+static void collect(const string& path, vector<string>& files) {
+    DIR* d = opendir(path.c_str());
+    if (!d) {
+        files.push_back(path);
+        return;
+    }
+    while (struct dirent* e = readdir(d)) {
+        string name = e->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".pcat") == 0)
+            files.push_back(path + "/" + name);
+    }
+    closedir(d);
+    sort(files.begin(), files.end());
+}
+
+// the least of a few runs, so a slow input is not just a busy machine
+static double best_seconds(bool parser, const string& input, double first) {
+    double best = first;
+    for (int i = 0; i < 3; ++i)
+        best = min(best, run_target(parser, input.data(), input.size()).seconds);
+    return best;
+}
+
+struct Slow {
+    double seconds;
+    unsigned long long tokens;
+    size_t bytes;
+    unsigned run;
+};
+
+int main(int argc, char** argv) {
+    bool parser = parser_target();
+    unsigned runs = 2000, seed = 1;
+    size_t max_len = 1 << 16;
+    double slow_factor = 50;
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        string value = a.find('=') == string::npos ? "" : a.substr(a.find('=') + 1);
+        if (a == "-target=lexer" || a == "-target=parser")
+            parser = value == "parser";
+        else if (!a.compare(0, 6, "-runs="))
+            runs = (unsigned)atoi(value.c_str());
+        else if (!a.compare(0, 6, "-seed="))
+            seed = (unsigned)atoi(value.c_str());
+        else if (!a.compare(0, 9, "-max_len="))
+            max_len = (size_t)atol(value.c_str());
+        else if (!a.compare(0, 9, "-timeout="))
+            timeout_seconds = atoi(value.c_str());
+        else if (!a.compare(0, 14, "-rss_limit_mb="))
+            rss_limit_mb = atol(value.c_str());
+        else if (!a.compare(0, 13, "-slow_factor="))
+            slow_factor = atof(value.c_str());
+        else if (!a.compare(0, 17, "-artifact_prefix="))
+            artifact_prefix = argv[i] + 17;
+        else if (a[0] == '-') {
+            cerr << "fuzz: unknown option " << a << endl;
+            return 2;
+        } else
+            collect(a, files);
+    }
+    if (files.empty()) {
+        cerr << "usage: fuzz [-target=lexer|parser] [-runs=N] [-seed=S] [-max_len=BYTES]\n"
+                "            [-timeout=SECONDS] [-rss_limit_mb=MB] [-slow_factor=F]\n"
+                "            [-artifact_prefix=DIR/] seed files or directories..." << endl;
+        return 2;
+    }
+    crash_path = string(artifact_prefix) + "crash";
+    timeout_path = string(artifact_prefix) + "timeout";
+    oom_path = string(artifact_prefix) + "oom";
+    install_handlers();
+    thread(watch_rss).detach();
+
+    int status = 0;
+    Mutator mutator(seed, max_len);
+    set<string> seen;          // signatures of the inputs in the pool
+    // per token and per byte, the seeds' median
+    vector<double> per_token, per_byte;
+    for (size_t i = 0; i < files.size(); ++i) {
+        ifstream in(files[i].c_str(), ios::binary);
+        if (!in) {
+            cerr << files[i] << ": can't read" << endl;
+            return 2;
+        }
+        ostringstream text;
+        text << in.rdbuf();
+        string input = text.str();
+        begin_input(input);
+        Outcome o = run_target(parser, input.data(), input.size());
+        long grown = end_input();
+        if (!o.problem.empty()) {
+            cerr << files[i] << ": " << o.problem << endl;
+            status = 1;
+        }
+        if (grown > rss_limit_mb) {
+            cerr << files[i] << ": took " << grown << " MB, more than -rss_limit_mb="
+                 << rss_limit_mb << endl;
+            status = 1;
+        }
+        double s = best_seconds(parser, input, o.seconds);
+        if (o.tokens)
+            per_token.push_back(s / o.tokens);
+        if (!input.empty())
+            per_byte.push_back(s / input.size());
+        seen.insert(o.signature);
+        mutator.add(input);
+    }
+    sort(per_token.begin(), per_token.end());
+    sort(per_byte.begin(), per_byte.end());
+    double token_time = per_token.empty() ? 0 : per_token[per_token.size() / 2];
+    double byte_time = per_byte.empty() ? 0 : per_byte[per_byte.size() / 2];
+
+    const char* target = parser ? "parser" : "lexer";
+    cerr << "==fuzz== " << target << ": " << files.size() << " seeds, "
+         << (token_time > 0 ? 1 / token_time : 0) << " tokens/sec" << endl;
+
+    vector<Slow> slowest;      // the inputs slowest per token, slowest first
+    unsigned slow = 0, kept = 0;
+    long most_grown = 0;       // the most memory one input took
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned run = 1; run <= runs; ++run) {
+        string input = mutator.next();
+        Outcome o;
+        begin_input(input);
+        try {
+            o = run_target(parser, input.data(), input.size());
+        } catch (const bad_alloc&) {
+            end_input();
+            cerr << "==fuzz== run " << run << " ran out of memory" << endl;
+            save("oom", input);
+            return 1;
+        }
+        long grown = end_input();
+        if (!o.problem.empty()) {
+            cerr << "==fuzz== run " << run << ": " << o.problem << endl;
+            save("differ-" + to_string(run), input);
+            status = 1;
+        }
+        // past the limit between the watchdog's samples
+        if (grown > rss_limit_mb) {
+            cerr << "==fuzz== run " << run << " took " << grown
+                 << " MB, more than -rss_limit_mb=" << rss_limit_mb << endl;
+            save("oom", input);
+            return 1;
+        }
+        most_grown = max(most_grown, grown);
+        // what the seeds would take for as many tokens and bytes, the
+        // more of the two; a millisecond is below what is worth timing
+        double expected = max(token_time * o.tokens, byte_time * input.size());
+        if (o.seconds > 1e-3 && o.seconds > slow_factor * expected) {
+            double s = best_seconds(parser, input, o.seconds);
+            if (s > 1e-3 && s > slow_factor * expected) {
+                cerr << "==fuzz== run " << run << " is slow: " << s << " s for "
+                     << o.tokens << " tokens, " << input.size() << " bytes, "
+                     << s / expected << " times the seeds' time" << endl;
+                save("slow-" + to_string(run), input);
+                ++slow;
+                status = 1;
+            }
+        }
+        if (o.tokens >= 64) {
+            Slow s = { o.seconds, o.tokens, input.size(), run };
+            slowest.push_back(s);
+            sort(slowest.begin(), slowest.end(), [](const Slow& a, const Slow& b) {
+                return a.seconds / a.tokens > b.seconds / b.tokens;
+            });
+            if (slowest.size() > 5)
+                slowest.pop_back();
+        }
+        // an outcome not seen before stands in for new coverage
+        if (seen.insert(o.signature).second && input.size() <= max_len) {
+            mutator.add(input);
+            ++kept;
+        }
+        if ((run & (run - 1)) == 0 || run == runs) {
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cerr << "#" << run << "\tpool: " << mutator.size() << " rss: " << peak_rss_mb()
+                 << " MB, most per input: " << most_grown
+                 << " MB exec/s: " << (unsigned)(seconds > 0 ? run / seconds : 0) << endl;
+        }
+    }
+
+    if (runs) {
+        cerr << "==fuzz== " << runs << " runs, " << kept << " inputs kept, "
+             << slow << " slow; slowest per token:" << endl;
+        for (size_t i = 0; i < slowest.size(); ++i) {
+            const Slow& s = slowest[i];
+            cerr << "  run " << s.run << ": " << (unsigned long long)(s.tokens / s.seconds)
+                 << " tokens/sec, " << s.tokens << " tokens, " << s.bytes << " bytes" << endl;
+        }
+    }
+    return status;
+}
+
+#endif
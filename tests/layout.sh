@@ -0,0 +1,94 @@
+#!/bin/sh
+# checks the packed records and arrays: fields and elements read back what
+# was stored, also when a slot is given a value of another type (which
+# moves the object to plain values) or READ into, the same by walking the
+# tree, on the VM and optimized; and arrays of scalars and records of
+# scalars take the bytes their slots do.
+#
+#   tests/layout.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+cat > "$DIR/slots.pcat" <<'END'
+PROGRAM IS
+    TYPE R IS ARRAY OF REAL;
+    TYPE I IS ARRAY OF INTEGER;
+    TYPE B IS ARRAY OF BOOLEAN;
+    TYPE P IS RECORD X : INTEGER; F : BOOLEAN; Y : REAL; N : P; A : I; END;
+    TYPE PS IS ARRAY OF P;
+    VAR X : R := R [< 3 OF 1.5, 2 OF 0.0 >];
+    VAR Y : I := I [< 4 OF 7 >];
+    VAR Z : B := B [< 2 OF TRUE, FALSE >];
+    VAR Q : P := P { X := 3; Y := 2; N := NIL };
+    VAR QS : PS := PS [< 3 OF NIL >];
+    VAR M : R := R [< 2 OF 1, 0 OF TRUE >];
+BEGIN
+    WRITE (X[0], " ", X[4], " ", Y[3], " ", Z[1], " ", Z[2]);
+    X[1] := 4;
+    WRITE (X[0], " ", X[1], " ", X[2]);
+    Y[2] := TRUE;
+    WRITE (Y[1], " ", Y[2]);
+    WRITE (Q.X, " ", Q.F, " ", Q.Y, " ", Q.N = NIL, " ", Q.A = NIL);
+    Q.N := Q;
+    Q.A := Y;
+    WRITE (Q.N.X, " ", Q.A[2]);
+    Q.X := 1.5;
+    WRITE (Q.X, " ", Q.F, " ", Q.Y, " ", Q.N.X);
+    QS[1] := Q;
+    WRITE (QS[1].X, " ", QS[0] = NIL);
+    QS[2] := 5;
+    WRITE (QS[2], " ", QS[1].Y, " ", M[0]);
+    READ (X[3], Y[0], Q.Y, Z[0]);
+    WRITE (X[3], " ", Y[0], " ", Q.Y, " ", Z[0], " ", Z[1]);
+END;
+END
+cat > "$DIR/slots.expected" <<'END'
+1.5 0.0 7 TRUE FALSE
+1.5 4 1.5
+7 TRUE
+3 FALSE 2.0 TRUE TRUE
+3 TRUE
+1.5 FALSE 2.0 1.5
+1.5 TRUE
+5 2.0 1
+1.0 2 3.0 4 TRUE
+END
+
+status=0
+for how in --run --vm "-O2 --vm"; do
+    echo "1 2 3 4" | "$MAIN" $how "$DIR/slots.pcat" > "$DIR/slots.out" 2>&1
+    if ! cmp -s "$DIR/slots.expected" "$DIR/slots.out"; then
+        echo "$how: slots hold other values"
+        diff "$DIR/slots.expected" "$DIR/slots.out" | head -6
+        status=1
+    fi
+done
+
+# the bytes a program's records and arrays take, from --exec-stats
+bytes() {
+    printf "PROGRAM IS\n%s\nBEGIN END;\n" "$2" > "$DIR/size.pcat"
+    "$MAIN" $1 --exec-stats "$DIR/size.pcat" 2>&1 >/dev/null |
+        awk '/bytes of records/ { print $(NF - 5) }'
+}
+
+# each line: the most bytes, then declarations
+while IFS='|' read -r most decls; do
+    for how in --run --vm; do
+        got=$(bytes $how "$decls")
+        if [ -z "$got" ] || [ "$got" -gt "$most" ]; then
+            echo "$how: $decls takes ${got:-no} bytes, more than $most"
+            status=1
+        fi
+    done
+done <<'END'
+400032|TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 100000 OF 0 >];
+800032|TYPE T IS ARRAY OF REAL; VAR A : T := T [< 100000 OF 0.5 >];
+100032|TYPE T IS ARRAY OF BOOLEAN; VAR A : T := T [< 99999 OF TRUE, FALSE >];
+800032|TYPE T IS ARRAY OF T; VAR A : T := T [< 100000 OF NIL >];
+1600032|TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 50000 OF 0, 50000 OF 0.5 >];
+32|TYPE N IS RECORD V : INTEGER; F : BOOLEAN; NEXT : N; END; VAR A : N := N { V := 1 };
+END
+
+[ $status = 0 ] && echo "records and arrays are laid out in their slots"
+exit $status
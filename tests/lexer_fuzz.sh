@@ -0,0 +1,98 @@
+#!/bin/sh
+# differential test of the hand-written scanner against the flex one:
+# mutates tests/*.pcat with the fragments scanners get wrong (comment and
+# string delimiters, tabs, CRs, newlines, two-character operators, bytes
+# above 0x7f, runs longer than a vector) and checks both binaries list the
+# same tokens at the same positions, with the same errors, mapped and read
+# through stdio, and then print the same tree, parsed whole and cut into
+# pieces by --parallel. Inputs that differ are kept in a directory named
+# at the end.
+#
+#   tests/lexer_fuzz.sh build/bin/main_flex build/bin/main_simd [CASES] [SEED]
+FLEX=${1:-build/bin/main_flex}
+SIMD=${2:-build/bin/main_simd}
+CASES=${3:-300}
+SEED=${4:-1}
+DIR=$(mktemp -d)
+FAILED=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+# the seeds, the test programs themselves first
+set -- tests/*.pcat bench/interp/*.pcat
+for f in "$@"; do
+    cp "$f" "$DIR/seed_$(basename "$f")"
+done
+
+mutate() {
+    awk -v seed="$1" '
+    { text = text $0 "\n" }
+    END {
+        srand(seed)
+        n = split("(*|*)|*|(|)|\"|\n|\t|\r| |:=|:|[<|>]|<|>|=|<=|>=|<>|.|1.|12.5|007|" \
+                  "X1|BEGIN|END|;|,|@|$|{|}|\\|(**)|(* x *)|\"s\"", frag, "|")
+        frag[++n] = sprintf("%c%c", 195, 169)
+        frag[++n] = sprintf("%c", 255)
+        frag[++n] = sprintf("%40s", "")
+        frag[++n] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789"
+        frag[++n] = "1234567890123456789012345678901234567890.1234567890123456789"
+        frag[++n] = "(* a comment running past one vector of bytes, \t with *s **\n *)"
+        ops = 1 + int(rand() * 8)
+        for (i = 0; i < ops; i++) {
+            at = int(rand() * (length(text) + 1))
+            r = rand()
+            if (r < 0.6) {
+                text = substr(text, 1, at) frag[1 + int(rand() * n)] substr(text, at + 1)
+            } else if (r < 0.8) {
+                text = substr(text, 1, at) substr(text, at + 1 + int(rand() * 20))
+            } else {
+                text = substr(text, 1, at) substr(text, at + 1, int(rand() * 40)) substr(text, at + 1)
+            }
+        }
+        # the cut may fall anywhere, also inside a token
+        if (rand() < 0.2)
+            text = substr(text, 1, int(rand() * length(text)))
+        printf "%s", text
+    }' "$2"
+}
+
+differ() {
+    for how in "--tokens" "--no-mmap --tokens" "" "-j 2 --parallel"; do
+        "$FLEX" $how "$1" > "$DIR/flex.out" 2>&1
+        a=$?
+        "$SIMD" $how "$1" > "$DIR/simd.out" 2>&1
+        b=$?
+        if [ $a != $b ] || ! cmp -s "$DIR/flex.out" "$DIR/simd.out"; then
+            echo "${how:-parse}"
+            return 0
+        fi
+    done
+    return 1
+}
+
+status=0
+i=0
+for f in "$DIR"/seed*; do
+    if how=$(differ "$f"); then
+        echo "$f: $how differs"
+        cp "$f" "$FAILED/"
+        status=1
+    fi
+done
+while [ $i -lt "$CASES" ]; do
+    i=$((i + 1))
+    eval "seedfile=\${$((i % $# + 1))}"
+    mutate $((SEED * 100003 + i)) "$seedfile" > "$DIR/case.pcat"
+    if how=$(differ "$DIR/case.pcat"); then
+        echo "case $i (from $seedfile): $how differs"
+        cp "$DIR/case.pcat" "$FAILED/case$i.pcat"
+        status=1
+    fi
+done
+
+if [ $status = 0 ]; then
+    rmdir "$FAILED"
+    echo "the scanners agree on $CASES mutated inputs"
+else
+    echo "inputs they disagree on are in $FAILED"
+fi
+exit $status
@@ -0,0 +1,65 @@
+#!/bin/sh
+# compiles programs to x86-64 with --emit-asm, links them with
+# src/runtime.c and checks each prints the same, on stdout and stderr,
+# and exits the same as when the tree interpreter runs it: tests/*.pcat,
+# the kernels in bench/interp and one small program per runtime error.
+# The compiled programs run with a 4 MB stack.
+#
+#   tests/native.sh build/bin/main [CC]
+MAIN=${1:-build/bin/main}
+CC=${2:-cc}
+INPUT="12 3 4 5.5"
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+# one runtime error each: declarations, then statements
+i=0
+while IFS='|' read -r decls stats; do
+    i=$((i + 1))
+    printf 'PROGRAM IS\n%s\nBEGIN\n%s\nEND;\n' "$decls" "$stats" > "$DIR/error$i.pcat"
+done <<'END'
+VAR A : ARRAY OF INTEGER := NIL;|A[0] := 1;
+TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 3 OF 1 >];|WRITE(A[3]);
+TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 3 OF 1 >];|WRITE(A[-1]);
+TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 3 OF 1 >];|WRITE(A[1.0]);
+TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 3 OF 1 >];|WRITE(A);
+TYPE R IS RECORD X : INTEGER; END; VAR Q : R := NIL;|WRITE(Q.X);
+TYPE R IS RECORD X : INTEGER; END; VAR Q : R := NIL;|Q.X := 3;
+VAR X : INTEGER := 0;|WRITE(1 DIV X);
+VAR X : REAL := 0.0;|WRITE(1.5 / X);
+VAR X : INTEGER := 0;|IF X THEN WRITE(1); END;
+VAR X : INTEGER := 0;|WRITE(NOT X);
+VAR X : BOOLEAN := TRUE;|WRITE(X + 1);
+VAR X : BOOLEAN := TRUE;|WRITE(X < 1);
+VAR X : BOOLEAN := TRUE;|WRITE(X = 1);
+VAR X : BOOLEAN := TRUE;|WRITE(-X);
+VAR X : BOOLEAN := TRUE;|WRITE(+X);
+VAR X : INTEGER := 0;|FOR X := 1 TO 3 BY 0 DO WRITE(X); END;
+VAR X : INTEGER := 0; VAR R : REAL := 1.0;|FOR X := 1 TO R DO WRITE(X); END;
+VAR X : INTEGER := 0;|FOR X := 1 TO 3 DO X := 0.5; END;
+VAR X : INTEGER := 0;|READ(X, X, X, X, X);
+VAR N : INTEGER := 0; PROCEDURE P(D : INTEGER) IS BEGIN N := N + 1; P(D + 1); END;|P(0);
+END
+
+status=0
+for f in tests/*.pcat bench/interp/*.pcat "$DIR"/error*.pcat; do
+    # programs that do not compile are not run either way
+    "$MAIN" --emit-asm "$DIR/prog.s" "$f" > /dev/null 2>&1 || continue
+    if ! $CC "$DIR/prog.s" src/runtime.c -o "$DIR/prog"; then
+        echo "$f: the assembly does not build"
+        status=1
+        continue
+    fi
+    echo "$INPUT" | "$MAIN" --run "$f" > "$DIR/tree.out" 2>&1
+    echo "exit $?" >> "$DIR/tree.out"
+    # half the usual stack: running out of it is an error, not a crash
+    (ulimit -s 4096; echo "$INPUT" | "$DIR/prog") > "$DIR/native.out" 2>&1
+    echo "exit $?" >> "$DIR/native.out"
+    if ! cmp -s "$DIR/tree.out" "$DIR/native.out"; then
+        echo "$f: the compiled program prints something else"
+        diff "$DIR/tree.out" "$DIR/native.out" | head -5
+        status=1
+    fi
+done
+[ $status = 0 ] && echo "native code agrees with the interpreter"
+exit $status
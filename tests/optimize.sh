@@ -0,0 +1,105 @@
+#!/bin/sh
+# runs programs on the VM and compiled to x86-64 with the bytecode
+# optimized at -O1 and -O2 and checks each prints the same, on stdout and
+# stderr, and exits the same as when the tree interpreter runs it:
+# tests/*.pcat, the kernels in bench/interp and small programs that give
+# the passes something to fold, share, hoist or must leave alone. Then
+# checks --opt-stats counts what the passes removed.
+#
+#   tests/optimize.sh build/bin/main [CC]
+MAIN=${1:-build/bin/main}
+CC=${2:-cc}
+INPUT="12 3 4 5.5"
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+# declarations, then statements
+i=0
+while IFS='|' read -r decls stats; do
+    i=$((i + 1))
+    printf 'PROGRAM IS\n%s\nBEGIN\n%s\nEND;\n' "$decls" "$stats" > "$DIR/opt$i.pcat"
+done <<'END'
+VAR X : INTEGER := 0;|WRITE(1 DIV X);
+VAR X : INTEGER := 0;|IF X > 1 THEN WRITE(1 DIV X); END; WRITE(2 MOD (X + 1));
+VAR X : BOOLEAN := TRUE;|IF FALSE THEN WRITE(X + 1); END; WRITE(X + 1);
+VAR X : INTEGER := 0;|IF X THEN WRITE(1); END;
+VAR X : INTEGER := 2147483647;|WRITE(X + 1, " ", -X - 2, " ", X * X);
+VAR X : REAL := 0.0;|WRITE(1 / 2, " ", 7.0 / 2, " ", X * 0, " ", 0 - X);
+VAR I, S : INTEGER := 0; VAR K : INTEGER := 7;|FOR I := 1 TO 10 DO S := S + K * 3 + I; END; WRITE(S, " ", I);
+VAR I, S : INTEGER := 0; VAR K : INTEGER := 0;|WHILE I < 5 DO IF I > 2 THEN S := S + 10 DIV K; END; I := I + 1; END;
+VAR I, J, S : INTEGER := 0;|FOR I := 1 TO 3 DO FOR J := I TO 3 DO S := S * 2 + I - J; END; END; WRITE(S, I, J);
+VAR I, J : INTEGER := 0;|FOR I := 1 TO 5 DO J := I; I := I + 1; WRITE(I, J); END;
+VAR A, B, T : INTEGER := 1; VAR N : INTEGER := 0;|LOOP T := A; A := B; B := T + B; N := N + 1; IF N = 10 THEN EXIT; END; END; WRITE(A, " ", B);
+VAR A, B : INTEGER := 1;|WHILE (A < 100) AND (B > 0) DO A := A * 2; B := B - (A = A * 1) * 0; END; WRITE(A);
+TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 4 OF 1 >]; VAR I : INTEGER := 0;|FOR I := 0 TO 3 DO A[I] := A[I] + A[0]; END; WRITE(A[0], A[1], A[3]);
+TYPE T IS ARRAY OF INTEGER; VAR A : T := T [< 4 OF 1 >]; VAR I : INTEGER := 0;|FOR I := 0 TO 4 DO WRITE(A[I] + A[I]); END;
+TYPE R IS RECORD X : REAL; N : INTEGER; END; VAR Q : R := R { X := 1; N := 2 };|Q.X := Q.N; Q.N := Q.N + Q.N; WRITE(Q.X, " ", Q.N, " ", Q.X + Q.X);
+TYPE R IS RECORD X : INTEGER; END; VAR Q, P : R := NIL; VAR I : INTEGER := 0;|Q := R { X := 1 }; FOR I := 1 TO 3 DO WRITE(Q.X); IF I = 2 THEN Q := P; END; END;
+VAR G : INTEGER := 1; PROCEDURE P() IS BEGIN G := G * 3; END;|WRITE(G + G); P(); WRITE(G + G); P(); WRITE(G);
+VAR I : INTEGER := 0; PROCEDURE F(X : INTEGER) : INTEGER IS VAR Y : INTEGER := X; PROCEDURE G() IS BEGIN Y := Y + 1; END; BEGIN G(); Y := Y + Y; G(); RETURN Y + Y; END;|FOR I := 1 TO 3 DO WRITE(F(I)); END;
+VAR I : INTEGER := 0; PROCEDURE F(X, Y : INTEGER) : INTEGER IS BEGIN RETURN X - Y; END;|FOR I := 1 TO 3 DO WRITE(F(I, I + 1), F(I + 1, I), F(F(I, 1), F(1, I))); END;
+VAR I, S : INTEGER := 0; PROCEDURE P() IS BEGIN S := S + I; END;|FOR I := 1 TO 4 DO P(); END; WRITE(S);
+VAR B : BOOLEAN := TRUE; VAR I : INTEGER := 3;|WHILE B DO I := I - 1; B := I > 0; END; WRITE(I, NOT B, B OR (1 < 2), B AND (2 = 2));
+VAR X : INTEGER := 0; VAR R : REAL := 0.0;|READ(X, R); R := R + X; X := X + X; WRITE(X, " ", R, " ", X / 2);
+END
+
+status=0
+native=1
+echo 'PROGRAM IS BEGIN END;' > "$DIR/empty.pcat"
+"$MAIN" --emit-asm "$DIR/prog.s" "$DIR/empty.pcat" > /dev/null 2>&1 &&
+    $CC "$DIR/prog.s" src/runtime.c -o "$DIR/prog" 2> /dev/null || native=0
+for f in tests/*.pcat bench/interp/*.pcat "$DIR"/opt*.pcat; do
+    # programs that do not compile are not run either way
+    "$MAIN" -O --bytecode "$f" > /dev/null 2>&1 || continue
+    echo "$INPUT" | "$MAIN" --run "$f" > "$DIR/tree.out" 2>&1
+    echo "exit $?" >> "$DIR/tree.out"
+    for level in -O1 -O2; do
+        echo "$INPUT" | "$MAIN" $level --vm "$f" > "$DIR/vm.out" 2>&1
+        echo "exit $?" >> "$DIR/vm.out"
+        if ! cmp -s "$DIR/tree.out" "$DIR/vm.out"; then
+            echo "$f: $level on the VM prints something else"
+            diff "$DIR/tree.out" "$DIR/vm.out" | head -5
+            status=1
+        fi
+        [ $native = 1 ] || continue
+        "$MAIN" $level --emit-asm "$DIR/prog.s" "$f" > /dev/null 2>&1
+        if ! $CC "$DIR/prog.s" src/runtime.c -o "$DIR/prog"; then
+            echo "$f: $level assembly does not build"
+            status=1
+            continue
+        fi
+        echo "$INPUT" | "$DIR/prog" > "$DIR/native.out" 2>&1
+        echo "exit $?" >> "$DIR/native.out"
+        if ! cmp -s "$DIR/tree.out" "$DIR/native.out"; then
+            echo "$f: $level compiled prints something else"
+            diff "$DIR/tree.out" "$DIR/native.out" | head -5
+            status=1
+        fi
+    done
+done
+
+# every pass has something to do here
+cat > "$DIR/stats.pcat" <<'END'
+PROGRAM IS
+    VAR I, S, K : INTEGER := 0;
+    VAR X : REAL := 0.0;
+BEGIN
+    K := 2 * 3 + 4;
+    FOR I := 1 TO 100 DO
+        S := S + (K * K + 1) + (K * K + 1);
+        X := 1.5 * 2;
+    END;
+    IF K < 0 THEN WRITE("never"); END;
+    WRITE(S, " ", X);
+END;
+END
+"$MAIN" -O --opt-stats --vm "$DIR/stats.pcat" > "$DIR/stats.out" 2>&1
+for pass in fold cse licm dce; do
+    if ! grep -q "^$pass .*[1-9]" "$DIR/stats.out"; then
+        echo "--opt-stats: $pass did nothing"
+        cat "$DIR/stats.out"
+        status=1
+    fi
+done
+[ $status = 0 ] && echo "optimized code agrees with the interpreter"
+exit $status
@@ -0,0 +1,52 @@
+#!/bin/sh
+# checks that --parallel changes nothing but how the parse is done: on
+# every test program and on generated ones of each shape, on one thread
+# and on three, it prints the same tree or the same errors as a plain
+# parse, --check and --vm say the same, --emit-ast saves the same bytes,
+# positions too, and --stats-json counts the same nodes of every class.
+#
+#   tests/parallel.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+for shape in expr block procs literals mixed; do
+    sh bench/gen_pcat.sh $shape 300 > "$DIR/$shape.pcat"
+done
+# a broken procedure in the middle of many
+sed '200s/:=/:/' "$DIR/procs.pcat" > "$DIR/broken.pcat"
+
+status=0
+for f in tests/*.pcat bench/interp/*.pcat "$DIR"/*.pcat; do
+    for j in 1 3; do
+        for how in "" --check --vm; do
+            # --vm only runs the interpreter benchmarks, which end and read nothing
+            [ "$how" = --vm ] && case "$f" in bench/*) ;; *) continue ;; esac
+            "$MAIN" $how "$f" < /dev/null > "$DIR/plain.out" 2>&1
+            "$MAIN" -j $j --parallel $how "$f" < /dev/null > "$DIR/parallel.out" 2>&1
+            if ! cmp -s "$DIR/plain.out" "$DIR/parallel.out"; then
+                echo "$f: -j $j --parallel $how differs"
+                diff "$DIR/plain.out" "$DIR/parallel.out" | head -10
+                status=1
+            fi
+        done
+        grep -q "^EEK" "$DIR/plain.out" && continue
+        "$MAIN" --emit-ast "$DIR/plain.ast" "$f" > /dev/null
+        "$MAIN" -j $j --parallel --emit-ast "$DIR/parallel.ast" "$f" > /dev/null
+        if ! cmp -s "$DIR/plain.ast" "$DIR/parallel.ast"; then
+            echo "$f: -j $j --parallel --emit-ast saves another tree"
+            cmp -l "$DIR/plain.ast" "$DIR/parallel.ast" | head -5
+            status=1
+        fi
+        "$MAIN" --stats-json "$DIR/plain.json" "$f" > /dev/null
+        "$MAIN" -j $j --parallel --stats-json "$DIR/parallel.json" "$f" > /dev/null
+        if [ "$(grep '"node_classes"' "$DIR/plain.json")" != \
+             "$(grep '"node_classes"' "$DIR/parallel.json")" ]; then
+            echo "$f: -j $j --parallel makes other nodes"
+            status=1
+        fi
+    done
+done
+
+[ $status = 0 ] && echo "parallel parses are plain parses"
+exit $status
@@ -0,0 +1,213 @@
+#!/bin/sh
+# checks --serve against whole parses: the tree it prints for every test
+# program, then after each of STEPS random edits to them, is the one main
+# prints for the edited text, or starts with the same parse error. Also
+# checks the outline of a small program, that errors move with the lines
+# above them and that an edit to one statement of a long program parses
+# no more than the units around it, and that the names edited away are
+# freed without the trees still in use losing theirs.
+#
+#   tests/serve.sh build/bin/main [STEPS]
+MAIN=${1:-build/bin/main}
+STEPS=${2:-40}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+# the answers of a --serve session, one file each: $DIR/answer.1, ...
+answers() {
+    rm -f "$DIR"/answer.*
+    "$MAIN" --serve < "$DIR/session" | awk -v dir="$DIR" '
+        { print > (dir "/answer." (n + 1)) }
+        /^(ok|error) / { close(dir "/answer." (n + 1)); n++ }'
+}
+
+# whether answer file $1, without its status line, is what main prints
+# for file $2: the same tree, or the same first error
+same_as_main() {
+    sed '$d' "$1" > "$DIR/served"
+    "$MAIN" "$2" > "$DIR/whole"
+    if grep -q "^EEK" "$DIR/whole"; then
+        [ "$(head -1 "$DIR/whole")" = "$(head -1 "$DIR/served")" ]
+    else
+        cmp -s "$DIR/whole" "$DIR/served"
+    fi
+}
+
+status=0
+for f in tests/*.pcat bench/interp/*.pcat; do
+    printf "open %s\ntree\n" "$f" > "$DIR/session"
+    answers
+    if ! same_as_main "$DIR/answer.2" "$f"; then
+        echo "$f: served tree differs"
+        diff "$DIR/whole" "$DIR/served" | head -10
+        status=1
+    fi
+done
+
+# random edits: cuts, pastes of another part of the text or of a whole
+# line, typing of bits of PCAT, each followed by the edit that undoes it;
+# a few are sent as whole texts. Each edited text is kept in step.K to
+# compare with
+seed=1
+for f in tests/test03.pcat tests/test05.pcat tests/semantics.pcat bench/interp/records.pcat; do
+    [ -f "$f" ] || continue
+    printf "open %s\n" "$f" > "$DIR/session"
+    awk -v steps="$STEPS" -v seed="$seed" -v dir="$DIR" -v session="$DIR/session" '
+        { text = text $0 "\n"; line[NR] = $0 }
+        # line and byte column of offset p, from 0
+        function position(p,    before, l) {
+            before = substr(text, 1, p)
+            l = gsub(/\n/, "\n", before)
+            sub(/.*\n/, "", before)
+            return (l + 1) " " (length(before) + 1)
+        }
+        # the offset where a random line starts
+        function line_start(    p) {
+            p = int(rand() * length(text))
+            while (p > 0 && substr(text, p, 1) != "\n")
+                p--
+            return p
+        }
+        END {
+            srand(seed)
+            split("|;| END;|X := 1;|IF X > 0 THEN |(* note *)|\n|VAR Q : INTEGER := 2;\n|" \
+                  "WRITE(1);|BEGIN|PROCEDURE P() IS BEGIN END;|[< 2 OF 0 >]|\t", bits, "|")
+            for (k = 1; k <= steps; k++) {
+                if (k % 2 == 0) {
+                    # undo
+                    b = a + length(s)
+                    s = cut
+                } else {
+                    r = rand()
+                    a = r < 0.4 ? line_start() : int(rand() * (length(text) + 1))
+                    b = a + (r < 0.4 ? 0 : int(rand() * 12))
+                    if (b > length(text))
+                        b = length(text)
+                    if (r < 0.4)
+                        s = line[1 + int(rand() * NR)] "\n"
+                    else if (r < 0.6)
+                        s = ""
+                    else if (r < 0.8)
+                        s = substr(text, int(rand() * length(text)) + 1, int(rand() * 40))
+                    else
+                        s = bits[1 + int(rand() * 13)]
+                }
+                cut = substr(text, a + 1, b - a)
+                edited = substr(text, 1, a) s substr(text, b + 1)
+                if (k % 10 == 5)
+                    printf "text %d\n%s", length(edited), edited >> session
+                else
+                    printf "edit %s %s %d\n%s", position(a), position(b), length(s), s >> session
+                print "tree" >> session
+                text = edited
+                printf "%s", text > (dir "/step." k)
+                close(dir "/step." k)
+            }
+        }' "$f"
+    answers
+    k=1
+    while [ $k -le "$STEPS" ]; do
+        if ! same_as_main "$DIR/answer.$((2 * k + 1))" "$DIR/step.$k"; then
+            echo "$f: after edit $k (seed $seed) served tree differs"
+            diff "$DIR/whole" "$DIR/served" | head -10
+            status=1
+            break
+        fi
+        k=$((k + 1))
+    done
+    seed=$((seed + 1))
+done
+
+cat > "$DIR/small.pcat" <<'EOF'
+PROGRAM IS
+    VAR X, Y : INTEGER := 1;
+    TYPE R IS RECORD A : INTEGER; END;
+    PROCEDURE P(N : INTEGER) IS
+        VAR Z := N;
+        PROCEDURE Q() IS BEGIN END;
+    BEGIN
+        Z := Z + 1;
+    END;
+    F() IS BEGIN END;
+BEGIN
+    X := Y;
+    Y := ;
+END;
+EOF
+cat > "$DIR/outline.expected" <<'EOF'
+2:9 var X
+2:12 var Y
+3:10 type R
+4:15 procedure P
+  5:13 var Z
+  6:19 procedure Q
+10:5 procedure F
+EOF
+# an error, then three lines more above it
+printf "open %s\noutline\ndiagnostics\nedit 2 1 2 1 3\n\n\n\ndiagnostics\n" "$DIR/small.pcat" \
+    > "$DIR/session"
+answers
+sed '$d' "$DIR/answer.2" > "$DIR/outline"
+if ! cmp -s "$DIR/outline" "$DIR/outline.expected"; then
+    echo "outline differs"
+    diff "$DIR/outline.expected" "$DIR/outline"
+    status=1
+fi
+if ! grep -q "Position: 13:10 " "$DIR/answer.3" || ! grep -q "Position: 16:10 " "$DIR/answer.5"
+then
+    echo "diagnostics did not move with the edit:"
+    cat "$DIR/answer.3" "$DIR/answer.5"
+    status=1
+fi
+
+# one statement of 5000 changed: the units around it are parsed, no others
+awk 'BEGIN {
+    print "PROGRAM IS"
+    for (i = 0; i < 5000; i++) print "    VAR X" i " : INTEGER := " i ";"
+    print "BEGIN"
+    for (i = 0; i < 5000; i++) print "    IF X" i " > 0 THEN X" i " := X" i " - 1; END;"
+    print "END;"
+}' > "$DIR/big.pcat"
+printf "open %s\nedit 7000 9 7000 13 4\n9999edit 2000 32 2000 32 4\n + 1tree\n" "$DIR/big.pcat" \
+    > "$DIR/session"
+answers
+for a in 2 3; do
+    parsed=$(sed -n 's/^ok [0-9]* units, \([0-9]*\) parsed.*/\1/p' "$DIR/answer.$a")
+    if [ -z "$parsed" ] || [ "$parsed" -gt 3 ]; then
+        echo "an edit of one unit parsed: $(cat "$DIR/answer.$a")"
+        status=1
+    fi
+done
+sed 's/^\(    IF X\)1997\( > 0\)/\19999\2/; s/^\(    VAR X1998 : INTEGER := 1998\)/\1 + 1/' \
+    "$DIR/big.pcat" > "$DIR/big.edited"
+if ! same_as_main "$DIR/answer.4" "$DIR/big.edited"; then
+    echo "edited long program: served tree differs"
+    diff "$DIR/whole" "$DIR/served" | head -10
+    status=1
+fi
+
+# the statement on line 7000 replaced 30 times by one naming 1000 new
+# variables: the names edited away are freed along the way, not those the
+# other units of the long program still have
+awk -v big="$DIR/big.pcat" -v last="$DIR/big.renamed" 'BEGIN {
+    print "open " big
+    for (k = 0; k < 30; k++) {
+        line = "    WRITE(Y" k "N0"
+        for (i = 1; i < 1000; i++) line = line ", Y" k "N" i
+        line = line ");"
+        print "edit 7000 1 7001 1 " (length(line) + 1)
+        print line
+    }
+    print "tree"
+    while ((getline l < big) > 0)
+        print (++n == 7000 ? line : l) > last
+}' > "$DIR/session"
+answers
+if ! same_as_main "$DIR/answer.32" "$DIR/big.renamed"; then
+    echo "long program after many new names: served tree differs"
+    diff "$DIR/whole" "$DIR/served" | head -10
+    status=1
+fi
+
+[ $status = 0 ] && echo "served trees are the whole trees"
+exit $status
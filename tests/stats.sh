@@ -0,0 +1,52 @@
+#!/bin/sh
+# checks --stats and --stats-json on the test programs: the printed tree
+# stays the same, the token count is what --tokens lists, the node classes
+# add up to the node count, and every phase that ran has a time.
+#
+#   tests/stats.sh build/bin/main
+MAIN=${1:-build/bin/main}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+status=0
+# the value of a number field in the JSON
+field() {
+    sed -n "s/.*\"$1\": \([0-9.]*\).*/\1/p" "$DIR/stats.json" | head -1
+}
+
+for f in tests/*.pcat bench/interp/*.pcat; do
+    "$MAIN" "$f" > "$DIR/plain.out"
+    grep -q "^EEK" "$DIR/plain.out" && continue
+    "$MAIN" --stats --stats-json "$DIR/stats.json" "$f" > "$DIR/stats.out" 2> "$DIR/stats.err"
+    tokens=$("$MAIN" --tokens "$f" | awk '$1 ~ /^[0-9]+:[0-9]+$/ && $2 > 0' | wc -l | tr -d " ")
+    sum=$(sed -n 's/.*"node_classes": {\(.*\)},$/\1/p' "$DIR/stats.json" |
+          tr ',' '\n' | awk -F': ' '{ n += $2 } END { print n }')
+    if ! cmp -s "$DIR/plain.out" "$DIR/stats.out"; then
+        echo "$f: the tree printed with --stats differs"
+        status=1
+    elif [ "$(field tokens)" != "$tokens" ]; then
+        echo "$f: $(field tokens) tokens counted, --tokens lists $tokens"
+        status=1
+    elif [ "$(field nodes)" != "$sum" ]; then
+        echo "$f: $(field nodes) nodes but the classes add up to $sum"
+        status=1
+    elif [ -z "$(field lex)" ] || [ -z "$(field parse)" ] || [ -z "$(field print)" ] ||
+         ! grep -q "^  total " "$DIR/stats.err"; then
+        echo "$f: phases missing"
+        cat "$DIR/stats.json" "$DIR/stats.err"
+        status=1
+    fi
+done
+
+# later passes are timed too
+"$MAIN" --stats-json "$DIR/stats.json" -O2 --vm bench/interp/fib.pcat > /dev/null
+for phase in lower bytecode optimize run; do
+    if [ -z "$(field $phase)" ]; then
+        echo "--vm -O2: no time for $phase"
+        cat "$DIR/stats.json"
+        status=1
+    fi
+done
+
+[ $status = 0 ] && echo "stats add up"
+exit $status
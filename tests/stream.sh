@@ -0,0 +1,45 @@
+#!/bin/sh
+# checks that --stream prints the same tree as a whole parse for every
+# correct test program, and that it parses a generated program of N
+# declarations and N statements in an address space far too small to hold
+# its tree, so that what it keeps is bounded by the largest construct. The
+# program spells few distinct names and numbers: those are kept to the end.
+#
+#   tests/stream.sh build/bin/main [N]
+MAIN=${1:-build/bin/main}
+N=${2:-300000}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+status=0
+for f in tests/*.pcat bench/interp/*.pcat; do
+    "$MAIN" "$f" > "$DIR/whole.out"
+    # programs with errors print a partial tree when streamed
+    grep -q "^EEK" "$DIR/whole.out" && continue
+    "$MAIN" --stream "$f" > "$DIR/stream.out"
+    if ! cmp -s "$DIR/whole.out" "$DIR/stream.out"; then
+        echo "$f: streamed tree differs"
+        diff "$DIR/whole.out" "$DIR/stream.out" | head -10
+        status=1
+    fi
+done
+
+awk -v n="$N" 'BEGIN {
+    print "PROGRAM IS"
+    for (i = 0; i < n; i++) print "    VAR X" i % 100 " : INTEGER := " i % 1000 " * 2 + 1;"
+    print "    PROCEDURE P(A : INTEGER) IS BEGIN WRITE(A); END;"
+    print "BEGIN"
+    for (i = 0; i < n; i++) print "    IF X" i % 100 " > 0 THEN P(X" i % 97 " + " i % 1000 "); END;"
+    print "END;"
+}' > "$DIR/big.pcat"
+
+# 64 MB: the whole tree of big.pcat takes several times that
+(ulimit -v 65536; "$MAIN" --stream "$DIR/big.pcat") > "$DIR/big.out" 2>&1
+if [ $? != 0 ] || [ $(grep -c "^      variable declaration$" "$DIR/big.out") != "$N" ]; then
+    echo "streaming $N declarations and statements:"
+    tail -5 "$DIR/big.out"
+    status=1
+fi
+
+[ $status = 0 ] && echo "streamed trees are the whole trees"
+exit $status
@@ -0,0 +1,59 @@
+#!/bin/sh
+# parses generated programs with very long lists: a main body and a
+# procedure body of N statements each, a declaration list, an identifier
+# list, an argument list and an array value list of N entries. Checks
+# they all parse and that statements come out in source order.
+#
+#   tests/stress.sh build/bin/main [N]
+MAIN=${1:-build/bin/main}
+N=${2:-1000000}
+DIR=$(mktemp -d)
+trap "rm -rf $DIR" EXIT
+
+awk -v n="$N" 'BEGIN {
+    print "PROGRAM IS BEGIN"
+    for (i = 0; i < n; i++) print "X := " i ";"
+    print "END;"
+}' > "$DIR/statements.pcat"
+
+awk -v n="$N" 'BEGIN {
+    print "PROGRAM IS PROCEDURE P() IS VAR X : INTEGER := 0; BEGIN WHILE X < 1 DO"
+    for (i = 0; i < n; i++) print "X := X + 1;"
+    print "END; END; BEGIN P(); END;"
+}' > "$DIR/nested.pcat"
+
+awk -v n="$N" 'BEGIN {
+    print "PROGRAM IS VAR"
+    for (i = 0; i < n; i++) print "X" i " := " i ";"
+    print "BEGIN END;"
+}' > "$DIR/declarations.pcat"
+
+awk -v n="$N" 'BEGIN {
+    printf "PROGRAM IS VAR X0"
+    for (i = 1; i < n; i++) printf ", X%d", i
+    print " : INTEGER := 0; BEGIN END;"
+}' > "$DIR/identifiers.pcat"
+
+awk -v n="$N" 'BEGIN {
+    printf "PROGRAM IS BEGIN P(0"
+    for (i = 1; i < n; i++) printf ", %d", i
+    print "); END;"
+}' > "$DIR/arguments.pcat"
+
+awk -v n="$N" 'BEGIN {
+    printf "PROGRAM IS TYPE A IS ARRAY OF INTEGER; VAR X := A [< 0"
+    for (i = 1; i < n; i++) printf ", %d", i
+    print " >]; BEGIN END;"
+}' > "$DIR/array_values.pcat"
+
+status=0
+"$MAIN" -j 1 "$DIR" | grep -v ": ok$" | grep -v " 0 with errors$" && status=1
+
+# the dump lists the assigned numbers 0, 1, ... N-1 in that order
+"$MAIN" "$DIR/statements.pcat" | awk -v n="$N" '
+    $1 == "number" { if ($2 != seen) bad = 1; seen++ }
+    END { if (bad || seen != n) { print "statements out of order"; exit 1 } }
+' || status=1
+
+[ $status = 0 ] && echo "stress: ok ($N entries per list)"
+exit $status